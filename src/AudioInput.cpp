@@ -1,40 +1,79 @@
 #include "AudioInput.hpp"
+#include <unistd.h>
 
 /* static member declarations and initializations */
 const unsigned int AudioInput::VERBOSITY = 2;
 // TODO needs to be dynamically set to fftLength / 2 once class organization is cleaned up.
 const unsigned int AudioInput::N_FREQUENCIES = 2048; // 560
 const unsigned int AudioInput::N_TIME_WINDOWS = 940; // default: 940windows @2048samples (46ms) => 43.65s
-
-AudioInput::AudioInput() {
+const float AudioInput::SELF_TEST_CLICK_INTERVAL_SECONDS = 1.0f;
+const float AudioInput::SELF_TEST_CLICK_AMPLITUDE = 1.0f;
+// TODO change how class receives value for windowSizeExponent
+const unsigned int AudioInput::FFT_LENGTH = (unsigned int) 1 << 12;
+const unsigned int AudioInput::DEFAULT_HOP_SIZE = 512;
+const unsigned int AudioInput::MULTITAPER_WINDOW = 3;
+const unsigned int AudioInput::POLYPHASE_WINDOW = 9;
+const unsigned int AudioInput::MULTIRESOLUTION_WINDOW = 10;
+const float AudioInput::DSP_BUDGET_FRACTION = 0.5f;
+const unsigned int AudioInput::MAX_LISTENERS = 16;
+const unsigned int AudioInput::CAPTURED_BLOCK_QUEUE = 64;
+
+AudioInput::AudioInput()
+  : capturedBlocks(CAPTURED_BLOCK_QUEUE), dspScheduled(false)
+{
     quit = false;
     pause = false;
 
     bufferIndex = -2;
-
-    // TODO change how class receives value for windowSizeExponent
-    unsigned int twowinsize = 12;
-    fftLength = (unsigned int) 1 << twowinsize;
+    audioBuffer = nullptr;
+    spectrogramSliceTime = 0.0;
+    latencySelfTest = false;
+    clickAdcTime = 0.0;
+    samplesUntilClick = 0;
+    hopSize = DEFAULT_HOP_SIZE;
+    samplesSinceHop = 0;
+    dspSecondsPerHop = 0.0f;
+    inputOverflows = 0;
+    inputUnderflows = 0;
+    droppedHops = 0;
+    columnsProduced = 0;
+    capturedSamples = 0;
+    nListeners = 0;
+
+    fftLength = FFT_LENGTH;
     Log::getInstance()->logger() << "FFT Length: " << fftLength << std::endl;
-    windowedAudioFrame = new float[fftLength];
-    fftFrame = new float[fftLength];
-    windowingFunction = new float[fftLength];
-    initializeWindow(windowingFunction, fftLength, 2);
-
-    /* set up in-place single-precision real-to-half-complex FFT */
-    fftPlan = fftwf_plan_r2r_1d(fftLength, windowedAudioFrame, fftFrame, FFTW_R2HC, FFTW_MEASURE);
+    windowedAudioFrame = fftwf_alloc_real(fftLength);
+    fftFrame = fftwf_alloc_real(fftLength);
+    multitaper = nullptr;
+    reducedMultitaper = nullptr;
+    polyphase = nullptr;
+    reducedPolyphase = nullptr;
+    polyphaseFrame = nullptr;
+    multiResolution = nullptr;
+    reducedMultiResolution = nullptr;
+    calibrationSum = WindowLibrary::getInstance()->get(WindowLibrary::GAUSSIAN, fftLength)->coherentGain * fftLength;
+    setWindow(WindowLibrary::GAUSSIAN);
+
+    /* single-precision real-to-half-complex FFTs, planned once for all sources */
+    fftPlan = FftPlanCache::getInstance()->r2hc(fftLength);
+    reducedFftPlan = FftPlanCache::getInstance()->r2hc(fftLength / 2);
     spectrogramSlice = new float[N_FREQUENCIES];
     spectrogramSize = N_FREQUENCIES * N_TIME_WINDOWS;
     Log::getInstance()->logger() << "Finished creating AudioInput" << std::endl;
 }
 
 AudioInput::AudioInput(const AudioInput& other)
+  : capturedBlocks(CAPTURED_BLOCK_QUEUE), dspScheduled(false)
 {
     this->bufferSizeFrames = other.bufferSizeFrames;
     this->bufferSizeSamples = other.bufferSizeSamples;
     this->bufferIndex = other.bufferIndex;
     this->spectrogramSize = other.spectrogramSize;
     this->fftLength = other.fftLength;
+    this->windowType = other.windowType;
+    this->window = other.window.load();
+    this->reducedWindow = other.reducedWindow.load();
+    this->calibrationSum = other.calibrationSum;
     this->bufferMemorySeconds = other.bufferMemorySeconds;
     this->nChannels = other.nChannels;
     this->samplingRate = other.samplingRate;
@@ -42,19 +81,38 @@ AudioInput::AudioInput(const AudioInput& other)
     this->quit = other.quit;
     this->pause = other.pause;
     this->fftPlan = other.fftPlan;
+    this->reducedFftPlan = other.reducedFftPlan;
+    this->multitaper = other.multitaper ? new MultitaperEstimator(fftLength) : nullptr;
+    this->reducedMultitaper = other.reducedMultitaper ? new MultitaperEstimator(fftLength / 2) : nullptr;
+    this->polyphase = other.polyphase ? new PolyphaseFilterbank(fftLength) : nullptr;
+    this->reducedPolyphase = other.reducedPolyphase ? new PolyphaseFilterbank(fftLength / 2) : nullptr;
+    this->polyphaseFrame = other.polyphase ? fftwf_alloc_real(other.polyphase->getSpan()) : nullptr;
+    this->multiResolution = other.multiResolution ? other.newMultiResolution(fftLength) : nullptr;
+    this->reducedMultiResolution = other.reducedMultiResolution ? other.newMultiResolution(fftLength / 2) : nullptr;
+    this->hopSize = other.hopSize;
+    this->samplesSinceHop = other.samplesSinceHop;
+    this->dspSecondsPerHop = other.dspSecondsPerHop;
+    this->inputOverflows = other.inputOverflows.load();
+    this->inputUnderflows = other.inputUnderflows.load();
+    this->droppedHops = other.droppedHops.load();
+    this->columnsProduced = other.columnsProduced.load();
+    this->capturedSamples = other.capturedSamples;
+    this->nListeners = other.nListeners.load();
+    for (unsigned int i = 0; i < nListeners; i++) this->listeners[i] = other.listeners[i];
+    this->spectrogramSliceTime = other.spectrogramSliceTime.load();
+    this->latencySelfTest = other.latencySelfTest;
+    this->clickAdcTime = other.clickAdcTime.load();
+    this->samplesUntilClick = other.samplesUntilClick;
     //*captureThread = *other.captureThread;
-    windowedAudioFrame = new float[fftLength];
+    windowedAudioFrame = fftwf_alloc_real(fftLength);
 
     spectrogramSlice = new float[N_FREQUENCIES];
     for (int i = 0; i < bufferSizeSamples; i++) this->audioBuffer[i] = other.audioBuffer[i];
 
-    for (int i = 0; i < N_FREQUENCIES; i++) this->spectrogramSlice[i] = other.spectrogramSlice[i];
-
-    windowingFunction = new float[fftLength];
-    for (int i = 0; i < fftLength; i++) this->windowingFunction[i] = other.windowingFunction[i];
+    for (unsigned int i = 0; i < N_FREQUENCIES; i++) this->spectrogramSlice[i] = other.spectrogramSlice[i];
 
-    fftFrame = new float[fftLength];
-    for (int i = 0; i < fftLength; i++) this->fftFrame[i] = other.fftFrame[i];
+    fftFrame = fftwf_alloc_real(fftLength);
+    for (unsigned int i = 0; i < fftLength; i++) this->fftFrame[i] = other.fftFrame[i];
 }
 
 AudioInput& AudioInput::operator=(const AudioInput& other)
@@ -64,6 +122,10 @@ AudioInput& AudioInput::operator=(const AudioInput& other)
     this->bufferIndex = other.bufferIndex;
     this->spectrogramSize = other.spectrogramSize;
     this->fftLength = other.fftLength;
+    this->windowType = other.windowType;
+    this->window = other.window.load();
+    this->reducedWindow = other.reducedWindow.load();
+    this->calibrationSum = other.calibrationSum;
     this->bufferMemorySeconds = other.bufferMemorySeconds;
     this->nChannels = other.nChannels;
     this->samplingRate = other.samplingRate;
@@ -71,91 +133,256 @@ AudioInput& AudioInput::operator=(const AudioInput& other)
     this->quit = other.quit;
     this->pause = other.pause;
     this->fftPlan = other.fftPlan;
+    this->reducedFftPlan = other.reducedFftPlan;
+    delete this->multitaper;
+    delete this->reducedMultitaper;
+    delete this->polyphase;
+    delete this->reducedPolyphase;
+    fftwf_free(this->polyphaseFrame);
+    delete this->multiResolution;
+    delete this->reducedMultiResolution;
+    this->multitaper = other.multitaper ? new MultitaperEstimator(fftLength) : nullptr;
+    this->reducedMultitaper = other.reducedMultitaper ? new MultitaperEstimator(fftLength / 2) : nullptr;
+    this->polyphase = other.polyphase ? new PolyphaseFilterbank(fftLength) : nullptr;
+    this->reducedPolyphase = other.reducedPolyphase ? new PolyphaseFilterbank(fftLength / 2) : nullptr;
+    this->polyphaseFrame = other.polyphase ? fftwf_alloc_real(other.polyphase->getSpan()) : nullptr;
+    this->multiResolution = other.multiResolution ? other.newMultiResolution(fftLength) : nullptr;
+    this->reducedMultiResolution = other.reducedMultiResolution ? other.newMultiResolution(fftLength / 2) : nullptr;
+    this->hopSize = other.hopSize;
+    this->samplesSinceHop = other.samplesSinceHop;
+    this->dspSecondsPerHop = other.dspSecondsPerHop;
+    this->inputOverflows = other.inputOverflows.load();
+    this->inputUnderflows = other.inputUnderflows.load();
+    this->droppedHops = other.droppedHops.load();
+    this->columnsProduced = other.columnsProduced.load();
+    this->capturedSamples = other.capturedSamples;
+    this->nListeners = other.nListeners.load();
+    for (unsigned int i = 0; i < nListeners; i++) this->listeners[i] = other.listeners[i];
+    this->spectrogramSliceTime = other.spectrogramSliceTime.load();
+    this->latencySelfTest = other.latencySelfTest;
+    this->clickAdcTime = other.clickAdcTime.load();
+    this->samplesUntilClick = other.samplesUntilClick;
     //*captureThread = *other.captureThread;
-    windowedAudioFrame = new float[fftLength];
+    windowedAudioFrame = fftwf_alloc_real(fftLength);
 
     spectrogramSlice = new float[N_FREQUENCIES];
     for (int i = 0; i < bufferSizeSamples; i++) this->audioBuffer[i] = other.audioBuffer[i];
 
-    for (int i = 0; i < N_FREQUENCIES; i++) this->spectrogramSlice[i] = other.spectrogramSlice[i];
+    for (unsigned int i = 0; i < N_FREQUENCIES; i++) this->spectrogramSlice[i] = other.spectrogramSlice[i];
 
-    windowingFunction = new float[fftLength];
-    for (int i = 0; i < fftLength; i++) this->windowingFunction[i] = other.windowingFunction[i];
-
-    fftFrame = new float[fftLength];
-    for (int i = 0; i < fftLength; i++) this->fftFrame[i] = other.fftFrame[i];
+    fftFrame = fftwf_alloc_real(fftLength);
+    for (unsigned int i = 0; i < fftLength; i++) this->fftFrame[i] = other.fftFrame[i];
 
     return *this;
 }
 
 AudioInput::~AudioInput() {
-    fftwf_destroy_plan(fftPlan);
     delete[] audioBuffer;
     delete[] spectrogramSlice;
-    delete[] windowedAudioFrame;
-    delete[] windowingFunction;
-}
-
-void AudioInput::initializeWindow(float *window, int windowSize, unsigned int windowType) {
-    float W;
-    int i;
-
-    switch (windowType) {
-        case 0:
-            /* no window (crappy frequency spillover) */
-            for (i = 0; i < windowSize; ++i)
-                window[i] = 1.0F;
-            break;
-        case 1:
-            /* Hann window (C^1 cont, so third-order tails) */
-            W = windowSize / 2.0F;
-            for (i = 0; i < windowSize; ++i)
-                window[i] = (float) (1.0f + cos(M_PI * (i - W) / W)) / 2;
-            break;
-        case 2:
-            /* truncated Gaussian window (Gaussian tails + exp small error) */
-            /* width: keep small truncation but wide to not waste FFT */
-            W = windowSize / 5.0F;
-            for (i = 0; i < windowSize; ++i) {
-                window[i] = (float) exp(-(i - windowSize / 2) * (i - windowSize / 2) / (2 * W * W));
-            }
-            break;
-        default:
-            fprintf(stderr, "unknown windowType!\n");
+    fftwf_free(windowedAudioFrame);
+    fftwf_free(fftFrame);
+    delete multitaper;
+    delete reducedMultitaper;
+    delete polyphase;
+    delete reducedPolyphase;
+    fftwf_free(polyphaseFrame);
+    delete multiResolution;
+    delete reducedMultiResolution;
+}
+
+unsigned int AudioInput::computeSpectrogramSlice(AudioInput *audioInput, int frameEnd) {
+    TraceScope traceScope("dsp frame");
+    unsigned int divisor = audioInput->governor.current().fftDivisor;
+    int nfft = audioInput->fftLength / divisor;   // transform length
+    int nf = audioInput->N_FREQUENCIES;              // # freqs to fill in powerspec
+    const WindowLibrary::Table* window = (divisor > 1 ? audioInput->reducedWindow : audioInput->window).load();
+    MultitaperEstimator* estimator = divisor > 1 ? audioInput->reducedMultitaper : audioInput->multitaper;
+    PolyphaseFilterbank* filterbank = divisor > 1 ? audioInput->reducedPolyphase : audioInput->polyphase;
+    MultiResolutionStft* stft = divisor > 1 ? audioInput->reducedMultiResolution : audioInput->multiResolution;
+
+    /* the bands read the ring themselves and are rescaled to the full length Gaussian like the windows below */
+    if (stft) {
+        stft->compute(audioInput->audioBuffer, audioInput->bufferSizeSamples, frameEnd, audioInput->spectrogramSlice);
+        return 0;
     }
-}
 
-void AudioInput::computeSpectrogramSlice(AudioInput *audioInput) {
-    int nfft = audioInput->fftLength;             // transform length
-    int nf = audioInput->N_FREQUENCIES;              // # freqs to fill in powerspec
-    int ind;
+    /* copy the most recent samples out of the ring & multiply by the window, unless the estimator tapers them or the
+     * filterbank folds them */
+    int span = filterbank ? (int) filterbank->getSpan() : nfft;
+    float* frame = filterbank ? audioInput->polyphaseFrame : audioInput->windowedAudioFrame;
+    int start = mod(frameEnd - span, audioInput->bufferSizeSamples);
+    int head = std::min(span, audioInput->bufferSizeSamples - start);
+    memcpy(frame, audioInput->audioBuffer + start, head * sizeof(float));
+    memcpy(frame + head, audioInput->audioBuffer, (span - head) * sizeof(float));
+    if (filterbank) {
+        filterbank->fold(frame, audioInput->windowedAudioFrame);
+    } else if (!estimator) {
+        VectorOps::multiply(audioInput->windowedAudioFrame, window->coefficients.data(),
+                            audioInput->windowedAudioFrame, nfft);
+    }
 
-    /* copy the nfft most recent samples & multiply by the window */
-    //Log::getInstance()->logger() << "BufferSizeSamples: " << audioInput->bufferSizeSamples << std::endl;
-    for (int i = 0; i < nfft; ++i) {
-        ind = mod(audioInput->bufferIndex - nfft + i, audioInput->bufferSizeSamples);
-        audioInput->windowedAudioFrame[i] = audioInput->windowingFunction[i] * audioInput->audioBuffer[ind];
+    /* the tapers replace the window; their coherent gain is rescaled like the windows' below */
+    if (estimator) {
+        const float* power = estimator->estimate(audioInput->windowedAudioFrame);
+        float coherentSum = (float) estimator->getCoherentSum();
+        float gain = (float) (audioInput->calibrationSum * audioInput->calibrationSum) / (coherentSum * coherentSum);
+        for (int i = 0; i < nf / (int) divisor; ++i) {
+            for (int j = 0; j < (int) divisor; ++j) audioInput->spectrogramSlice[i * divisor + j] = gain * power[i];
+        }
+        return 0;
     }
 
-    /* execute the configured FFT */
-    fftwf_execute(audioInput->fftPlan);
+    /* execute the configured FFT on this source's arrays; the plans are shared */
+    fftwf_execute_r2r(divisor > 1 ? audioInput->reducedFftPlan : audioInput->fftPlan,
+                      audioInput->windowedAudioFrame, audioInput->fftFrame);
 
-    if (nf > nfft / 2) {
+    if (nf > nfft / 2 * (int) divisor) {
         fprintf(stderr, "window too short cf n_f!\n");
-        return;
+        return 0;
     }
 
+    /* rescale by the coherent gain, so that tone levels match those of the full length Gaussian whatever the window */
+    float coherentSum = (float) (filterbank ? filterbank->getCoherentSum() : window->coherentGain * nfft);
+    float gain = (float) (audioInput->calibrationSum * audioInput->calibrationSum) / (coherentSum * coherentSum);
+
     /* zero-frequency has no imaginary part */
-    audioInput->spectrogramSlice[0] = audioInput->fftFrame[0] * audioInput->fftFrame[0];
+    for (int j = 0; j < (int) divisor; ++j) {
+        audioInput->spectrogramSlice[j] = gain * audioInput->fftFrame[0] * audioInput->fftFrame[0];
+    }
+
+    /* compute power spectrum from hc dft, each bin filling divisor slice entries */
+    for (int i = 1; i < nf / (int) divisor; ++i) {
+        float power = audioInput->fftFrame[i] * audioInput->fftFrame[i] +
+                      audioInput->fftFrame[nfft - i] * audioInput->fftFrame[nfft - i];
+        for (int j = 0; j < (int) divisor; ++j) {
+            audioInput->spectrogramSlice[i * divisor + j] = gain * power;
+        }
+    }
+    return (unsigned int) nfft;
+}
+
+void AudioInput::processHops(const CapturedBlock& block) {
+    uint64_t start = Trace::now();
+    unsigned long numSamples = block.numSamples;
+    unsigned long hop = hopSize * governor.current().hopMultiplier;
+    samplesSinceHop += numSamples;
+    unsigned long nHops = samplesSinceHop / hop;
+    samplesSinceHop %= hop;
+
+    /* hand the block to the listeners' per-sample work on this thread, in at most two runs of the ring */
+    int blockStart = mod(block.endIndex - (int) numSamples, bufferSizeSamples);
+    unsigned long head = std::min(numSamples, (unsigned long) (bufferSizeSamples - blockStart));
+    uint64_t firstSampleIndex = block.endSampleIndex - numSamples;
+    double firstAdcTime = block.lastAdcTime - (numSamples - 1) * samplingPeriod;
+    for (unsigned int i = 0; i < nListeners.load(std::memory_order_acquire); ++i) {
+        listeners[i]->samplesProcessed(audioBuffer + blockStart, head, firstSampleIndex, firstAdcTime);
+        if (head < numSamples) {
+            listeners[i]->samplesProcessed(audioBuffer, numSamples - head, firstSampleIndex + head,
+                                           firstAdcTime + head * samplingPeriod);
+        }
+    }
+
+    if (nHops > 0) {
+        /* only compute as many of the completed hops as fit the DSP budget, always including the newest */
+        unsigned long affordable = nHops;
+        if (dspSecondsPerHop > 0.0f) {
+            affordable = (unsigned long) (DSP_BUDGET_FRACTION * numSamples * samplingPeriod / dspSecondsPerHop);
+            affordable = std::max(1UL, std::min(affordable, nHops));
+        }
+        droppedHops += nHops - affordable;
+
+        for (unsigned long h = nHops - affordable; h < nHops; ++h) {
+            /* number of samples between the end of this hop's frame and the newest captured sample */
+            unsigned long lag = samplesSinceHop + (nHops - 1 - h) * hop;
+            uint64_t hopStart = Trace::now();
+            unsigned int spectrumLength = computeSpectrogramSlice(this, block.endIndex - (int) lag);
+            double sliceTime = block.lastAdcTime - lag * samplingPeriod;
+            spectrogramSliceTime.store(sliceTime, std::memory_order_relaxed);
+            ++columnsProduced;
+            for (unsigned int i = 0; i < nListeners.load(std::memory_order_acquire); ++i) {
+                if (spectrumLength) {
+                    listeners[i]->spectrumComputed(fftFrame, spectrumLength, block.endSampleIndex - lag, sliceTime);
+                }
+                listeners[i]->sliceComputed(spectrogramSlice, N_FREQUENCIES, block.endSampleIndex - lag, sliceTime);
+            }
+            float hopSeconds = (Trace::now() - hopStart) * 1e-9f;
+            dspSecondsPerHop = dspSecondsPerHop > 0.0f ? 0.9f * dspSecondsPerHop + 0.1f * hopSeconds : hopSeconds;
+        }
+    }
 
-    /* compute power spectrum from hc dft */
-    for (int i = 1; i < nf; ++i) {
-        audioInput->spectrogramSlice[i] =
-                audioInput->fftFrame[i] * audioInput->fftFrame[i] +
-                audioInput->fftFrame[nfft - i] * audioInput->fftFrame[nfft - i];
+    governor.reportDspLoad((Trace::now() - start) * 1e-9f / (numSamples * samplingPeriod));
+}
+
+void AudioInput::submitHops(unsigned long numSamples, double lastAdcTime) {
+    CapturedBlock block = {numSamples, lastAdcTime, bufferIndex, capturedSamples};
+    if (!capturedBlocks.push(block)) {
+        /* the pool is far behind; the hops of this block are lost */
+        droppedHops += numSamples / (hopSize * governor.current().hopMultiplier);
+        return;
+    }
+    if (!dspScheduled.exchange(true)) {
+        /* if the pool is full, the block stays queued for the task submitted with the next block */
+        if (!DspThreadPool::getInstance()->submit({&AudioInput::runHops, this})) dspScheduled = false;
+    }
+}
+
+void AudioInput::runHops(void *argument) {
+    AudioInput *audioInput = (AudioInput *) argument;
+    CapturedBlock block;
+    do {
+        while (audioInput->capturedBlocks.pop(block)) audioInput->processHops(block);
+        audioInput->dspScheduled = false;
+        /* a block queued after the last pop saw the task still scheduled, so pick it up here */
+    } while (audioInput->capturedBlocks.size() > 0 && !audioInput->dspScheduled.exchange(true));
+}
+
+void AudioInput::waitForDsp() {
+    while (dspScheduled) usleep(1000);
+}
+
+bool AudioInput::addListener(AudioListener *listener) {
+    unsigned int n = nListeners.load(std::memory_order_relaxed);
+    if (n >= MAX_LISTENERS) {
+        Log::getInstance()->logger() << "Too many audio listeners." << std::endl;
+        return false;
+    }
+    listeners[n] = listener;
+    nListeners.store(n + 1, std::memory_order_release);
+    return true;
+}
+
+void AudioInput::notifySamplesCaptured(const float *samples, unsigned long numSamples, double firstAdcTime) {
+    for (unsigned int i = 0; i < nListeners.load(std::memory_order_acquire); ++i) {
+        listeners[i]->samplesCaptured(samples, numSamples, capturedSamples, firstAdcTime);
+    }
+    capturedSamples += numSamples;
+}
+
+void AudioInput::reportStatus(bool inputOverflow, bool inputUnderflow) {
+    if (inputOverflow) {
+        ++inputOverflows;
+        governor.reportOverflow();
+    }
+    if (inputUnderflow) {
+        ++inputUnderflows;
     }
 }
 
+void AudioInput::injectSelfTestClick(int firstIndex, unsigned long numSamples, double firstAdcTime) {
+    if (!latencySelfTest) return;
+
+    if (samplesUntilClick >= numSamples) {
+        samplesUntilClick -= numSamples;
+        return;
+    }
+
+    /* the click lands inside this block */
+    unsigned long offset = samplesUntilClick;
+    audioBuffer[mod(firstIndex + offset, bufferSizeSamples)] = SELF_TEST_CLICK_AMPLITUDE;
+    clickAdcTime.store(firstAdcTime + offset * samplingPeriod, std::memory_order_relaxed);
+    samplesUntilClick = (unsigned long) (SELF_TEST_CLICK_INTERVAL_SECONDS * samplingRate) - (numSamples - offset);
+}
+
 const unsigned int AudioInput::getVERBOSITY() {
     return VERBOSITY;
 }
@@ -184,12 +411,33 @@ void AudioInput::setSpectrogramSlice(float *spectrogramSlice) {
     AudioInput::spectrogramSlice = spectrogramSlice;
 }
 
-float *AudioInput::getWindowingFunction() const {
-    return windowingFunction;
+const float *AudioInput::getWindowingFunction() const {
+    return window.load()->coefficients.data();
+}
+
+const WindowLibrary::Table* AudioInput::getWindow() const {
+    return window.load();
 }
 
-void AudioInput::setWindowingFunction(float *windowingFunction) {
-    AudioInput::windowingFunction = windowingFunction;
+bool AudioInput::setWindow(WindowLibrary::Type type, float parameter) {
+    const WindowLibrary::Table* table = WindowLibrary::getInstance()->get(type, fftLength, parameter);
+    const WindowLibrary::Table* reducedTable = WindowLibrary::getInstance()->get(type, fftLength / 2, parameter);
+    if (!table || !reducedTable) return false;
+
+    /* the tables live as long as the library, so a frame being computed keeps using the one it loaded */
+    window.store(table);
+    reducedWindow.store(reducedTable);
+    if (!multitaper && !polyphase && !multiResolution) windowType = type;
+    return true;
+}
+
+double AudioInput::getDensityScale() const {
+    /* noise of variance s^2 has E|X|^2 = s^2 sum(w^2) and a one-sided density of 2 s^2 / fs */
+    double n = fftLength;
+    /* the middle band has the FFT length; the others differ by their length ratio, which is not corrected */
+    double bandwidth = multitaper ? multitaper->getNoiseBandwidth()
+                     : polyphase ? polyphase->getNoiseBandwidth() : window.load()->noiseBandwidth;
+    return 2.0 * n / (calibrationSum * calibrationSum * samplingRate * bandwidth);
 }
 
 unsigned int AudioInput::getSpectrogramSize() const {
@@ -208,6 +456,66 @@ void AudioInput::setFftLength(unsigned int fftLength) {
     AudioInput::fftLength = fftLength;
 }
 
+unsigned int AudioInput::getWindowType() const {
+    return windowType;
+}
+
+void AudioInput::setMultitaper(bool enabled) {
+    delete multitaper;
+    delete reducedMultitaper;
+    multitaper = enabled ? new MultitaperEstimator(fftLength) : nullptr;
+    reducedMultitaper = enabled ? new MultitaperEstimator(fftLength / 2) : nullptr;
+    windowType = enabled ? MULTITAPER_WINDOW : polyphase ? POLYPHASE_WINDOW
+                         : multiResolution ? MULTIRESOLUTION_WINDOW : (unsigned int) window.load()->type;
+}
+
+bool AudioInput::setPolyphase(bool enabled) {
+    delete polyphase;
+    delete reducedPolyphase;
+    fftwf_free(polyphaseFrame);
+    polyphase = nullptr;
+    reducedPolyphase = nullptr;
+    polyphaseFrame = nullptr;
+    windowType = multitaper ? MULTITAPER_WINDOW : multiResolution ? MULTIRESOLUTION_WINDOW
+                            : (unsigned int) window.load()->type;
+    if (!enabled) return true;
+    if ((unsigned int) bufferSizeSamples < PolyphaseFilterbank::TAPS * fftLength) {
+        Log::getInstance()->logger() << "Audio ring of " << bufferSizeSamples << " samples too short for a "
+                                     << PolyphaseFilterbank::TAPS << " tap polyphase filterbank" << std::endl;
+        return false;
+    }
+    polyphase = new PolyphaseFilterbank(fftLength);
+    reducedPolyphase = new PolyphaseFilterbank(fftLength / 2);
+    polyphaseFrame = fftwf_alloc_real(polyphase->getSpan());
+    windowType = POLYPHASE_WINDOW;
+    return true;
+}
+
+bool AudioInput::setMultiResolution(bool enabled) {
+    delete multiResolution;
+    delete reducedMultiResolution;
+    multiResolution = nullptr;
+    reducedMultiResolution = nullptr;
+    windowType = multitaper ? MULTITAPER_WINDOW : polyphase ? POLYPHASE_WINDOW : (unsigned int) window.load()->type;
+    if (!enabled) return true;
+    multiResolution = newMultiResolution(fftLength);
+    if ((unsigned int) bufferSizeSamples < multiResolution->getSpan()) {
+        Log::getInstance()->logger() << "Audio ring of " << bufferSizeSamples << " samples too short for a "
+                                     << multiResolution->getSpan() << " sample multi-resolution band" << std::endl;
+        delete multiResolution;
+        multiResolution = nullptr;
+        return false;
+    }
+    reducedMultiResolution = newMultiResolution(fftLength / 2);
+    windowType = MULTIRESOLUTION_WINDOW;
+    return true;
+}
+
+MultiResolutionStft* AudioInput::newMultiResolution(unsigned int length) const {
+    const WindowLibrary::Table* table = window.load();
+    return new MultiResolutionStft(length, samplingRate, N_FREQUENCIES, table->type, table->parameter, calibrationSum);
+}
+
 float AudioInput::getBufferMemorySeconds() const {
     return bufferMemorySeconds;
 }
@@ -272,6 +580,54 @@ void AudioInput::setWindowedAudioFrame(float *windowedAudioFrame) {
     AudioInput::windowedAudioFrame = windowedAudioFrame;
 }
 
+double AudioInput::getSpectrogramSliceTime() const {
+    return spectrogramSliceTime.load(std::memory_order_relaxed);
+}
+
+bool AudioInput::isLatencySelfTest() const {
+    return latencySelfTest;
+}
+
+void AudioInput::setLatencySelfTest(bool latencySelfTest) {
+    AudioInput::latencySelfTest = latencySelfTest;
+}
+
+double AudioInput::getClickAdcTime() const {
+    return clickAdcTime.load(std::memory_order_relaxed);
+}
+
+unsigned int AudioInput::getHopSize() const {
+    return hopSize;
+}
+
+void AudioInput::setHopSize(unsigned int hopSize) {
+    AudioInput::hopSize = hopSize;
+}
+
+unsigned long AudioInput::getInputOverflows() const {
+    return inputOverflows;
+}
+
+unsigned long AudioInput::getInputUnderflows() const {
+    return inputUnderflows;
+}
+
+unsigned long AudioInput::getDroppedHops() const {
+    return droppedHops;
+}
+
+unsigned long AudioInput::getColumnsProduced() const {
+    return columnsProduced;
+}
+
+uint64_t AudioInput::getCapturedSamples() const {
+    return capturedSamples;
+}
+
+DegradationGovernor& AudioInput::getGovernor() {
+    return governor;
+}
+
 unsigned long AudioInput::getBufferSizeFrames() const {
     return bufferSizeFrames;
 }
@@ -11,12 +11,25 @@
 #define OPENGL_SPECTROGRAM_AUDIOINPUT_H
 
 #include <thread>
+#include <algorithm>
+#include <atomic>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <math.h>
 #include <fftw3.h>
 #include "Log.hpp"
+#include "Trace.hpp"
+#include "DegradationGovernor.hpp"
+#include "AudioListener.hpp"
+#include "BoundedQueue.hpp"
+#include "DspThreadPool.hpp"
+#include "FftPlanCache.hpp"
+#include "MultiResolutionStft.hpp"
+#include "MultitaperEstimator.hpp"
+#include "PolyphaseFilterbank.hpp"
+#include "VectorOps.hpp"
+#include "WindowLibrary.hpp"
 #include "shared.hpp"
 
 class AudioInput {
@@ -36,6 +49,73 @@ public:
    */
   static const unsigned int N_TIME_WINDOWS;
 
+  /**
+   * Seconds between synthetic clicks in the latency self-test mode.
+   */
+  static const float SELF_TEST_CLICK_INTERVAL_SECONDS;
+
+  /**
+   * Amplitude of the synthetic click in the latency self-test mode.
+   */
+  static const float SELF_TEST_CLICK_AMPLITUDE;
+
+  /**
+   * Number of samples in each FFT frame.
+   */
+  static const unsigned int FFT_LENGTH;
+
+  /**
+   * Default number of samples between the ends of consecutive spectrogram frames.
+   */
+  static const unsigned int DEFAULT_HOP_SIZE;
+
+  /**
+   * Window type recorded for multitaper estimates, which use MultitaperEstimator instead of a window.
+   */
+  static const unsigned int MULTITAPER_WINDOW;
+
+  /**
+   * Window type recorded for polyphase filterbank spectra, which use PolyphaseFilterbank instead of a window.
+   */
+  static const unsigned int POLYPHASE_WINDOW;
+
+  /**
+   * Window type recorded for multi-resolution spectra, stitched by MultiResolutionStft from several windowed FFTs.
+   */
+  static const unsigned int MULTIRESOLUTION_WINDOW;
+
+  /**
+   * Fraction of each audio block's duration that may be spent computing spectrogram slices. Older hops that do not
+   * fit are dropped.
+   */
+  static const float DSP_BUDGET_FRACTION;
+
+  /**
+   * Maximum number of AudioListener observers.
+   */
+  static const unsigned int MAX_LISTENERS;
+
+  /**
+   * Number of captured blocks that can wait for the DSP thread pool before blocks are dropped.
+   */
+  static const unsigned int CAPTURED_BLOCK_QUEUE;
+
+  /**
+   * A captured block as queued for the DSP thread pool, with the capture position it ended at.
+   */
+  struct CapturedBlock {
+    unsigned long numSamples;
+    /**
+     * ADC time of the newest sample of the block.
+     */
+    double lastAdcTime;
+    /**
+     * Index into audioBuffer, and total number of captured samples, one past the newest sample of the block.
+     */
+    int endIndex;
+    uint64_t endSampleIndex;
+  };
+
   /**
    * Overloaded constructor to initialize various member parameters.
    */
@@ -50,24 +130,62 @@ public:
   virtual ~AudioInput() = 0;
 
   /**
-   * Sets up the windowing function to avoid the harmful spectral effects of a rectangular window.
-   * Note: windowSize is intentionally auto-casted to a signed integer to avoid inf result on exponential calculation.
+   * Obtains a windowed spectrogram of the audio stream.
+   * The FFT length is reduced by the fftDivisor of the current degradation level, in which case each computed bin
+   * fills fftDivisor consecutive bins of spectrogramSlice.
    * TODO this does not belong in this class.
-   * @param window array to hold the window coefficients.
-   * @param windowSize length of the window.
-   * @param windowType window type.
-   *    0: rectangular window.
-   *    1: Hann window.
-   *    2: truncated Gaussian window.
+   * @param audioInput  AudioInput handle which contains the audio data to window.
+   * @param frameEnd index into audioBuffer one past the newest sample of the frame.
+   * @return length of the FFT left in fftFrame in half-complex order, or 0 if the slice did not come from a single
+   * FFT (multitaper or multi-resolution spectra).
    */
-  void initializeWindow(float* window, int windowSize, unsigned int windowType);
+  static unsigned int computeSpectrogramSlice(AudioInput* audioInput, int frameEnd);
 
   /**
-   * Obtains a windowed spectrogram of the audio stream.
-   * TODO this does not belong in this class.
-   * @param audioInput  AudioInput handle which contains the audio data to window.
+   * Computes a spectrogram slice for every hop completed by a captured block of samples, as far as the DSP budget
+   * allows, and reports the DSP load to the governor. Runs on the DSP thread pool, one block of a source at a time.
+   * @param block the captured block.
+   */
+  void processHops(const CapturedBlock& block);
+
+  /**
+   * Queues a newly captured block for processHops() on the shared DSP thread pool. Realtime safe. Must be called
+   * after the block was written to audioBuffer, bufferIndex was advanced and notifySamplesCaptured() was called.
+   * @param numSamples number of samples in the block.
+   * @param lastAdcTime ADC time of the newest sample of the block.
+   */
+  void submitHops(unsigned long numSamples, double lastAdcTime);
+
+  /**
+   * Waits until no block of this source is being processed by the DSP thread pool, e.g. after quitNow() and before
+   * the listeners are destroyed.
+   */
+  void waitForDsp();
+
+  /**
+   * Adds a new AudioListener instance to the list of observers. May be called while capturing, from a single
+   * non-realtime thread.
+   * Follows the observer design pattern.
+   * @param listener new instance of AudioListener to act as an observer.
+   * @return false if MAX_LISTENERS are already registered.
+   */
+  bool addListener(AudioListener* listener);
+
+  /**
+   * Counts a newly captured block of samples and passes it on to all listeners. Must be called before processHops()
+   * for the same block.
+   * @param samples the captured samples, or nullptr for silence.
+   * @param numSamples number of samples in the block.
+   * @param firstAdcTime ADC time of the first sample of the block.
    */
-  static void computeSpectrogramSlice(AudioInput* audioInput);
+  void notifySamplesCaptured(const float* samples, unsigned long numSamples, double firstAdcTime);
+
+  /**
+   * Accounts for the status flags of a captured block, as reported by the audio driver.
+   * @param inputOverflow whether input samples were discarded before this block.
+   * @param inputUnderflow whether the block contains inserted silence.
+   */
+  void reportStatus(bool inputOverflow, bool inputUnderflow);
 
   /**
    * Defines how the instance stops capturing the audio stream.
@@ -79,6 +197,28 @@ public:
      */
     virtual int startCapture() = 0;
 
+  /**
+   * Current time of the clock used for the ADC timestamps of the stream, e.g. for comparison with
+   * getSpectrogramSliceTime().
+   * @return stream time in seconds.
+   */
+  virtual double getStreamTime() = 0;
+
+  /**
+   * In latency self-test mode, overwrites one sample of the most recently captured block with a synthetic click every
+   * SELF_TEST_CLICK_INTERVAL_SECONDS, and remembers its ADC time.
+   * @param firstIndex index into audioBuffer of the first sample of the block.
+   * @param numSamples number of samples in the block.
+   * @param firstAdcTime ADC time of the first sample of the block.
+   */
+  void injectSelfTestClick(int firstIndex, unsigned long numSamples, double firstAdcTime);
+
+  /**
+   * Creates a multi-resolution transform with the current window, rescaled to the calibration window.
+   * @param length length of its middle band.
+   */
+  MultiResolutionStft* newMultiResolution(unsigned int length) const;
+
 protected:
   /**
    * Size of the audio buffer that ALSA reports during device intiialization, in number of frames.
@@ -106,9 +246,25 @@ protected:
   float* spectrogramSlice;
 
   /**
-   * Window coefficients to be applied to each audio buffer frame.
+   * Window applied to each audio buffer frame, shared through the WindowLibrary and swapped by setWindow() while
+   * frames are being computed.
+   */
+  std::atomic<const WindowLibrary::Table*> window;
+
+  /**
+   * Window of the same type for the reduced FFT length used under degradation.
    */
-  float* windowingFunction;
+  std::atomic<const WindowLibrary::Table*> reducedWindow;
+
+  /**
+   * Coefficient sum of the full length Gaussian window, which all windows are calibrated to.
+   */
+  double calibrationSum;
+
+  /**
+   * Type of the window, or MULTITAPER_WINDOW, as recorded in spectrogram files.
+   */
+  unsigned int windowType;
 
     /**
      * TODO
@@ -116,10 +272,32 @@ protected:
     float* fftFrame;
 
   /**
-   * Resulting frame of audio data after applying the window coefficients in windowingFunction.
+   * Resulting frame of audio data after applying the window coefficients in window.
    */
   float* windowedAudioFrame;
 
+  /**
+   * Stream-clock ADC time of the newest sample that went into spectrogramSlice, in seconds.
+   * Written on the DSP thread and read on the display thread.
+   */
+  std::atomic<double> spectrogramSliceTime;
+
+  /**
+   * Whether synthetic clicks are injected into the captured audio to measure click-to-detection latency.
+   */
+  bool latencySelfTest;
+
+  /**
+   * Stream-clock ADC time of the most recently injected synthetic click, in seconds.
+   * Written on the DSP thread and read on the display thread.
+   */
+  std::atomic<double> clickAdcTime;
+
+  /**
+   * Number of samples to capture before the next synthetic click is injected.
+   */
+  unsigned long samplesUntilClick;
+
   /**
    * Number of samples in each spectrogram frame.
    */
@@ -163,15 +341,113 @@ protected:
   bool pause;
 
   /**
-   * Plan of FFT execution.
+   * Plan of FFT execution, shared with all sources through the FftPlanCache.
    */
   fftwf_plan fftPlan;
 
+  /**
+   * Plan of FFT execution for half the FFT length, prepared up front since planning is not realtime safe.
+   */
+  fftwf_plan reducedFftPlan;
+
+  /**
+   * Multitaper estimators for the full and the reduced FFT length, or nullptr if windowed FFTs are used.
+   */
+  MultitaperEstimator* multitaper;
+  MultitaperEstimator* reducedMultitaper;
+
+  /**
+   * Polyphase filterbanks for the full and the reduced FFT length, or nullptr if windowed FFTs are used, and room for
+   * the samples they fold.
+   */
+  PolyphaseFilterbank* polyphase;
+  PolyphaseFilterbank* reducedPolyphase;
+  float* polyphaseFrame;
+
+  /**
+   * Multi-resolution transforms for the full and the reduced FFT length, or nullptr if one FFT length is used.
+   */
+  MultiResolutionStft* multiResolution;
+  MultiResolutionStft* reducedMultiResolution;
+
+  /**
+   * Nominal number of samples between the ends of consecutive spectrogram frames, before degradation.
+   */
+  unsigned int hopSize;
+
+  /**
+   * Number of samples captured since the end of the most recent hop.
+   */
+  unsigned long samplesSinceHop;
+
+  /**
+   * Smoothed time needed to compute one spectrogram slice, in seconds.
+   */
+  float dspSecondsPerHop;
+
+  /**
+   * Number of input overflows reported by the audio driver.
+   */
+  std::atomic<unsigned long> inputOverflows;
+
+  /**
+   * Number of input underflows reported by the audio driver.
+   */
+  std::atomic<unsigned long> inputUnderflows;
+
+  /**
+   * Number of hops whose spectrogram slice was skipped to stay within the DSP budget.
+   */
+  std::atomic<unsigned long> droppedHops;
+
+  /**
+   * Number of spectrogram slices computed.
+   */
+  std::atomic<unsigned long> columnsProduced;
+
+  /**
+   * Adapts hop size, FFT length and rendering to the load.
+   */
+  DegradationGovernor governor;
+
+  /**
+   * Total number of samples captured.
+   */
+  uint64_t capturedSamples;
+
+  /**
+   * AudioListener instances notified of captured samples and computed slices, implementing the Observer design
+   * pattern. Only the first nListeners entries are valid.
+   */
+  AudioListener* listeners[16];  // MAX_LISTENERS
+
+  /**
+   * Number of valid entries in listeners, published after the entry is written.
+   */
+  std::atomic<unsigned int> nListeners;
+
+  /**
+   * Captured blocks waiting for the DSP thread pool.
+   */
+  BoundedQueue<CapturedBlock> capturedBlocks;
+
+  /**
+   * Whether a task draining capturedBlocks is queued or running on the DSP thread pool. At most one is, so that the
+   * blocks of a source are processed in order and its FFT buffers are never shared between workers.
+   */
+  std::atomic<bool> dspScheduled;
+
   /**
    * Thread used to asynchronously capture audio data into audioBuffer.
    */
   //std::unique_ptr<std::thread> captureThread;
 
+  /**
+   * DSP thread pool task draining capturedBlocks.
+   * @param audioInput the AudioInput instance.
+   */
+  static void runHops(void* audioInput);
+
 /* accessors (TODO are these necessary?) */
 public:
   static const unsigned int getVERBOSITY();
@@ -196,9 +472,30 @@ public:
 
   void setSpectrogramSlice(float* spectrogramSlice);
 
-  float* getWindowingFunction() const;
+  const float* getWindowingFunction() const;
+
+  /**
+   * @return the current window with its gains.
+   */
+  const WindowLibrary::Table* getWindow() const;
+
+  /**
+   * Switches the window, also while capturing. Coefficients are cached per type, length and parameter, so switching
+   * back and forth computes nothing after the first time. Powers are rescaled by the coherent gain of the window, so
+   * tone levels do not change with it.
+   * @param type window type.
+   * @param parameter Kaiser beta or Tukey taper fraction, 0 for the default.
+   * @return false for an unknown type.
+   */
+  bool setWindow(WindowLibrary::Type type, float parameter = 0.0f);
 
-  void setWindowingFunction(float* windowingFunction);
+  /**
+   * Factor converting slice powers of noise into a one-sided power spectral density in full scale^2 / Hz, undoing
+   * the coherent gain rescaling with the noise bandwidth of the window (or the unit energy of the tapers). Exact at
+   * the full FFT length; while the governor halves it, densities read 3 dB high.
+   * @return the factor for the current window.
+   */
+  double getDensityScale() const;
 
   unsigned int getSpectrogramSize() const;
 
@@ -206,6 +503,30 @@ public:
 
   unsigned int getFftLength() const;
 
+  unsigned int getWindowType() const;
+
+  /**
+   * Switches between multitaper estimates and the windowed FFT. Must be called before capture starts.
+   * @param enabled whether to use multitaper estimates.
+   */
+  void setMultitaper(bool enabled);
+
+  /**
+   * Switches between the polyphase filterbank and the windowed FFT. Must be called before capture starts, and not
+   * combined with multitaper estimates.
+   * @param enabled whether to use the polyphase filterbank.
+   * @return false if the audio ring is too short for the span of the filterbank.
+   */
+  bool setPolyphase(bool enabled);
+
+  /**
+   * Switches between multi-resolution spectra and the windowed FFT. The bands use the current window. Must be called
+   * before capture starts, and not combined with multitaper estimates or the polyphase filterbank.
+   * @param enabled whether to compute multi-resolution spectra.
+   * @return false if the audio ring is too short for the longest band.
+   */
+  bool setMultiResolution(bool enabled);
+
   void setFftLength(unsigned int fftLength);
 
   float getBufferMemorySeconds() const;
@@ -238,6 +559,30 @@ public:
 
   float* getWindowedAudioFrame() const;
 
+  double getSpectrogramSliceTime() const;
+
+  bool isLatencySelfTest() const;
+
+  void setLatencySelfTest(bool latencySelfTest);
+
+  double getClickAdcTime() const;
+
+  unsigned int getHopSize() const;
+
+  void setHopSize(unsigned int hopSize);
+
+  unsigned long getInputOverflows() const;
+
+  unsigned long getInputUnderflows() const;
+
+  unsigned long getDroppedHops() const;
+
+  unsigned long getColumnsProduced() const;
+
+  uint64_t getCapturedSamples() const;
+
+  DegradationGovernor& getGovernor();
+
   void setWindowedAudioFrame(float* windowedAudioFrame);
 };
 
@@ -0,0 +1,50 @@
+/*
+ * Abstract representation of a class which consumes the captured audio and the spectrogram slices computed from it.
+ * The AudioInput class maintains a list of AudioListener as observers which are notified of samples from the capture
+ * thread, and of the same samples again and of slices from a DSP pool worker, so implementations must be realtime
+ * safe: no locks, no allocation, no I/O. Notifications from the capture thread and from the worker may run
+ * concurrently; those from the worker come in order, one at a time.
+ * */
+
+#ifndef OPENGL_SPECTROGRAM_AUDIOLISTENER_H
+#define OPENGL_SPECTROGRAM_AUDIOLISTENER_H
+
+#include <stdint.h>
+
+class AudioListener {
+public:
+  virtual ~AudioListener() {}
+
+  /* block of captured samples; samples is nullptr if the driver delivered silence */
+  virtual void samplesCaptured(const float* samples, unsigned long numSamples, uint64_t firstSampleIndex,
+                               double firstAdcTime) = 0;
+
+  /* the samples of a captured block again, from the DSP pool worker right before it computes the slices that end in
+   * the block, for per-sample work too heavy for the capture thread. A block wrapping around the capture ring comes
+   * in two calls; silence comes as zeros. Ignored unless overridden */
+  virtual void samplesProcessed(const float* samples, unsigned long numSamples, uint64_t firstSampleIndex,
+                                double firstAdcTime)
+  {
+    (void) samples;
+    (void) numSamples;
+    (void) firstSampleIndex;
+    (void) firstAdcTime;
+  }
+
+  /* complex spectrum of that frame in FFTW half-complex order, right before its slice; only for slices computed by a
+   * single FFT, not for multitaper or multi-resolution spectra. Ignored unless overridden */
+  virtual void spectrumComputed(const float* halfComplex, unsigned int fftLength, uint64_t endSampleIndex,
+                                double adcTime)
+  {
+    (void) halfComplex;
+    (void) fftLength;
+    (void) endSampleIndex;
+    (void) adcTime;
+  }
+
+  /* spectrogram slice of the frame whose newest sample is the one just before endSampleIndex */
+  virtual void sliceComputed(const float* slice, unsigned int nFrequencies, uint64_t endSampleIndex,
+                             double adcTime) = 0;
+};
+
+#endif //OPENGL_SPECTROGRAM_AUDIOLISTENER_H
@@ -0,0 +1,89 @@
+#include "BandMeter.hpp"
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+#include <time.h>
+#include "Log.hpp"
+#include "Trace.hpp"
+
+/* static member declarations and initializations */
+const unsigned int BandMetrics::MAX_BANDS;
+
+BandMeter::BandMeter(const std::vector<BandSummaryIndex::Band>& bands, unsigned int samplingRate,
+                     unsigned int nFrequencies, double intervalSeconds)
+  : bands(bands), intervalSeconds(intervalSeconds), prefixSum(nFrequencies + 1, 0.0), interval(-1)
+{
+    if (bands.size() > BandMetrics::MAX_BANDS) {
+        Log::getInstance()->logger() << "At most " << BandMetrics::MAX_BANDS << " bands can be metered" << std::endl;
+        throw 99;
+    }
+
+    /* slice entry i is centred on i * nyquist / nFrequencies, as in BandSummaryWriter */
+    float hzPerBin = samplingRate / 2.0f / nFrequencies;
+    for (const BandSummaryIndex::Band& band : bands) {
+        firstBin.push_back(std::min(nFrequencies, (unsigned int) ceilf(band.lowHz / hzPerBin)));
+        endBin.push_back(std::min(nFrequencies, (unsigned int) ceilf(band.highHz / hzPerBin)));
+    }
+    memset(&metrics, 0, sizeof(metrics));
+    metrics.nBands = (unsigned int) bands.size();
+    Log::getInstance()->logger() << "Metering " << bands.size() << " bands every " << intervalSeconds << " s"
+                                 << std::endl;
+}
+
+const std::vector<BandSummaryIndex::Band>& BandMeter::getBands() const
+{
+    return bands;
+}
+
+void BandMeter::samplesCaptured(const float* samples, unsigned long numSamples, uint64_t firstSampleIndex,
+                                double firstAdcTime)
+{
+    (void) samples;
+    (void) numSamples;
+    (void) firstSampleIndex;
+    (void) firstAdcTime;
+}
+
+void BandMeter::sliceComputed(const float* slice, unsigned int nFrequencies, uint64_t endSampleIndex, double adcTime)
+{
+    (void) endSampleIndex;
+    TraceScope traceScope("band meter");
+    timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    double unixTime = now.tv_sec + now.tv_nsec * 1e-9;
+    int64_t current = (int64_t) floor(unixTime / intervalSeconds);
+    if (current > interval && metrics.columns) {
+        for (unsigned int b = 0; b < metrics.nBands; ++b) metrics.energy[b].mean /= metrics.columns;
+        emit(metrics);
+        metrics.columns = 0;
+    }
+    if (current > interval) {
+        interval = current;
+        metrics.startTime = unixTime;
+    }
+    /* if the wall clock stepped back, the column still counts towards the current interval */
+
+    unsigned int n = std::min(nFrequencies, (unsigned int) prefixSum.size() - 1);
+    double sum = 0.0;
+    for (unsigned int i = 0; i < n; ++i) {
+        prefixSum[i] = sum;
+        sum += slice[i];
+    }
+    prefixSum[n] = sum;
+
+    for (unsigned int b = 0; b < metrics.nBands; ++b) {
+        float energy = (float) (prefixSum[std::min(endBin[b], n)] - prefixSum[std::min(firstBin[b], n)]);
+        BandSummaryIndex::BandStatistics& s = metrics.energy[b];
+        if (metrics.columns) {
+            s.min = std::min(s.min, energy);
+            s.max = std::max(s.max, energy);
+            s.mean += energy;
+        } else {
+            s = {energy, energy, energy};
+        }
+    }
+    ++metrics.columns;
+    ++metrics.totalColumns;
+    metrics.endTime = unixTime;
+    metrics.adcTime = adcTime;
+}
@@ -0,0 +1,96 @@
+/**
+ * Energy of a few frequency bands per column, aggregated over fixed wall clock intervals for export as metrics. The
+ * meter listens to an input and runs on its DSP thread: one pass turns each slice into prefix sums over the bins, after
+ * which the energy of every band is the difference of two sums, however wide the band. At the end of every interval it
+ * emits the minimum, mean and maximum energy of every band into the DSP graph.
+ */
+
+#ifndef OPENGL_SPECTROGRAM_BANDMETER_HPP
+#define OPENGL_SPECTROGRAM_BANDMETER_HPP
+
+#include <atomic>
+#include <vector>
+#include <stdint.h>
+#include "AudioListener.hpp"
+#include "BandSummaryIndex.hpp"
+#include "DspGraph.hpp"
+
+/**
+ * Band energies over one interval.
+ */
+struct BandMetrics {
+  static const unsigned int MAX_BANDS = 32;
+
+  /**
+   * Wall clock times of the first and the newest column of the interval, the ADC time of the newest, and the number of
+   * columns.
+   */
+  double startTime;
+  double endTime;
+  double adcTime;
+  unsigned long columns;
+
+  /**
+   * Columns metered since the meter was created.
+   */
+  unsigned long totalColumns;
+
+  /**
+   * Energy of every band, the power of its bins summed per column.
+   */
+  unsigned int nBands;
+  BandSummaryIndex::BandStatistics energy[MAX_BANDS];
+};
+
+class BandMeter : public AudioListener, public DspProducer<BandMetrics> {
+public:
+  /**
+   * Throws 99 if there are more than BandMetrics::MAX_BANDS bands.
+   * @param bands frequency bands to meter.
+   * @param samplingRate sampling rate of the input.
+   * @param nFrequencies number of frequencies per slice.
+   * @param intervalSeconds length of an interval, aligned to multiples of it since the Unix epoch.
+   */
+  BandMeter(const std::vector<BandSummaryIndex::Band>& bands, unsigned int samplingRate, unsigned int nFrequencies,
+            double intervalSeconds);
+
+  BandMeter(const BandMeter&) = delete;
+  BandMeter& operator=(const BandMeter&) = delete;
+
+  const std::vector<BandSummaryIndex::Band>& getBands() const;
+
+  /**
+   * Ignores samples.
+   */
+  virtual void samplesCaptured(const float* samples, unsigned long numSamples, uint64_t firstSampleIndex,
+                               double firstAdcTime);
+
+  /**
+   * Adds the band energies of the slice to the interval, emitting the interval first if the slice is past its end.
+   * Realtime safe as long as no connected edge blocks.
+   */
+  virtual void sliceComputed(const float* slice, unsigned int nFrequencies, uint64_t endSampleIndex, double adcTime);
+
+private:
+  std::vector<BandSummaryIndex::Band> bands;
+  double intervalSeconds;
+
+  /**
+   * First and one past the last bin of every band.
+   */
+  std::vector<unsigned int> firstBin;
+  std::vector<unsigned int> endBin;
+
+  /**
+   * Sum of the powers of the bins below each index, in double so that narrow bands high up keep their precision.
+   */
+  std::vector<double> prefixSum;
+
+  /**
+   * Interval being accumulated, whose means are still sums; interval number -1 before the first column.
+   */
+  int64_t interval;
+  BandMetrics metrics;
+};
+
+#endif /* OPENGL_SPECTROGRAM_BANDMETER_HPP */
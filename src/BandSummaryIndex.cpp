@@ -0,0 +1,131 @@
+#include "BandSummaryIndex.hpp"
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "Log.hpp"
+
+/* static member declarations and initializations */
+const char BandSummaryIndex::MAGIC[8] = "AVBAND1";
+const std::vector<BandSummaryIndex::Band> BandSummaryIndex::DEFAULT_BANDS = {
+    {0, 125}, {125, 250}, {250, 500}, {500, 1000}, {1000, 2000}, {2000, 4000}, {4000, 8000}, {8000, 16000}
+};
+
+bool BandSummaryIndex::parseBands(const char* text, std::vector<Band>& bands)
+{
+    bands.clear();
+    while (*text) {
+        Band band;
+        int consumed;
+        if (sscanf(text, "%f-%f%n", &band.lowHz, &band.highHz, &consumed) != 2 || band.highHz <= band.lowHz) {
+            return false;
+        }
+        bands.push_back(band);
+        text += consumed;
+        if (*text == ',') ++text;
+        else if (*text) return false;
+    }
+    return !bands.empty();
+}
+
+size_t BandSummaryIndex::recordBytes(unsigned int nBands)
+{
+    return sizeof(RecordHeader) + nBands * sizeof(BandStatistics);
+}
+
+BandSummaryIndex::BandSummaryIndex(const std::string& path)
+  : data(nullptr), size(0), nRecords(0)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(Header)) {
+        Log::getInstance()->logger() << "Could not open band summary " << path << std::endl;
+        if (fd >= 0) close(fd);
+        throw 99;
+    }
+    size = (size_t) st.st_size;
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        Log::getInstance()->logger() << "Could not map band summary " << path << std::endl;
+        throw 99;
+    }
+    data = (const uint8_t*) mapping;
+
+    memcpy(&header, data, sizeof(header));
+    size_t bandsEnd = sizeof(Header) + header.nBands * sizeof(Band);
+    if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) || size < bandsEnd) {
+        Log::getInstance()->logger() << path << " is not a band summary." << std::endl;
+        munmap((void*) data, size);
+        throw 99;
+    }
+    bands.resize(header.nBands);
+    memcpy(bands.data(), data + sizeof(Header), header.nBands * sizeof(Band));
+
+    /* a record still being written is ignored */
+    nRecords = (size - bandsEnd) / recordBytes(header.nBands);
+}
+
+BandSummaryIndex::~BandSummaryIndex()
+{
+    munmap((void*) data, size);
+}
+
+bool BandSummaryIndex::query(unsigned int band, double fromUnixTime, double toUnixTime, Summary& summary) const
+{
+    summary.energy = {INFINITY, 0.0f, -INFINITY};
+    summary.seconds = 0;
+    summary.columns = 0;
+    if (band >= header.nBands) return false;
+
+    int64_t first = std::max<int64_t>((int64_t) floor(fromUnixTime) - header.firstSecond, 0);
+    int64_t end = std::min<int64_t>((int64_t) ceil(toUnixTime) - header.firstSecond, (int64_t) nRecords);
+    const size_t stride = recordBytes(header.nBands);
+    const uint8_t* records = data + sizeof(Header) + header.nBands * sizeof(Band);
+
+    double weightedMean = 0.0;
+    for (int64_t r = first; r < end; ++r) {
+        const uint8_t* record = records + r * stride;
+        RecordHeader recordHeader;
+        memcpy(&recordHeader, record, sizeof(recordHeader));
+        if (!recordHeader.nColumns) continue;
+        BandStatistics statistics;
+        memcpy(&statistics, record + sizeof(RecordHeader) + band * sizeof(BandStatistics), sizeof(statistics));
+        summary.energy.min = std::min(summary.energy.min, statistics.min);
+        summary.energy.max = std::max(summary.energy.max, statistics.max);
+        weightedMean += (double) statistics.mean * recordHeader.nColumns;
+        ++summary.seconds;
+        summary.columns += recordHeader.nColumns;
+    }
+    if (!summary.columns) return false;
+    summary.energy.mean = (float) (weightedMean / summary.columns);
+    return true;
+}
+
+int BandSummaryIndex::findBand(float lowHz, float highHz) const
+{
+    for (unsigned int b = 0; b < bands.size(); ++b) {
+        if (fabsf(bands[b].lowHz - lowHz) <= 1.0f && fabsf(bands[b].highHz - highHz) <= 1.0f) return (int) b;
+    }
+    return -1;
+}
+
+const std::vector<BandSummaryIndex::Band>& BandSummaryIndex::getBands() const
+{
+    return bands;
+}
+
+int64_t BandSummaryIndex::getFirstSecond() const
+{
+    return header.firstSecond;
+}
+
+int64_t BandSummaryIndex::getEndSecond() const
+{
+    return header.firstSecond + (int64_t) nRecords;
+}
@@ -0,0 +1,125 @@
+/**
+ * Per-second energy summary of a spectrogram recording in a few frequency bands, for answering questions like
+ * "energy in 2-4 kHz between 03:00 and 04:00" over weeks of recordings without decoding any column.
+ *
+ * The index holds one fixed-size record per wall clock second, so the records of any time range are found by
+ * arithmetic alone. Seconds without columns have records with nColumns 0.
+ *
+ * File layout (native endianness):
+ *    Header, Band[nBands]
+ *    records: uint32 nColumns, uint32 reserved, BandStatistics[nBands]
+ */
+
+#ifndef OPENGL_SPECTROGRAM_BANDSUMMARYINDEX_HPP
+#define OPENGL_SPECTROGRAM_BANDSUMMARYINDEX_HPP
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+class BandSummaryIndex {
+public:
+  struct Band {
+    float lowHz;
+    float highHz;
+  };
+
+  struct Header {
+    char magic[8];
+    uint32_t nBands;
+    uint32_t samplingRate;
+    /**
+     * Unix time of the first record.
+     */
+    int64_t firstSecond;
+  };
+
+  /**
+   * Energy of one band over the columns of one second, or of a query range.
+   */
+  struct BandStatistics {
+    float min;
+    float mean;
+    float max;
+  };
+
+  struct RecordHeader {
+    uint32_t nColumns;
+    uint32_t reserved;
+  };
+
+  /**
+   * Result of a query.
+   */
+  struct Summary {
+    BandStatistics energy;
+    /**
+     * Number of seconds in the range which had columns, and the number of columns.
+     */
+    unsigned long seconds;
+    unsigned long columns;
+  };
+
+  static const char MAGIC[8];
+
+  /**
+   * Bands used when none are configured: octaves from 125 Hz to 16 kHz, below which everything is one band.
+   */
+  static const std::vector<Band> DEFAULT_BANDS;
+
+  /**
+   * Parses a comma separated list of bands such as "0-250,250-500,2000-4000", in Hz.
+   * @param text list to parse.
+   * @param bands receives the bands.
+   * @return false on a syntax error.
+   */
+  static bool parseBands(const char* text, std::vector<Band>& bands);
+
+  /**
+   * @return size in bytes of one record of an index with nBands bands.
+   */
+  static size_t recordBytes(unsigned int nBands);
+
+  /**
+   * Maps an index for querying. Throws 99 if it cannot be read.
+   * @param path path of the index.
+   */
+  BandSummaryIndex(const std::string& path);
+
+  BandSummaryIndex(const BandSummaryIndex&) = delete;
+  BandSummaryIndex& operator=(const BandSummaryIndex&) = delete;
+
+  ~BandSummaryIndex();
+
+  /**
+   * Summarizes the energy of one band over a time range.
+   * @param band index into getBands().
+   * @param fromUnixTime start of the range.
+   * @param toUnixTime end of the range, exclusive.
+   * @param summary receives the summary.
+   * @return false if the range contains no columns.
+   */
+  bool query(unsigned int band, double fromUnixTime, double toUnixTime, Summary& summary) const;
+
+  /**
+   * @return index of the configured band closest to [lowHz, highHz], or -1 if none is within 1 Hz at both edges.
+   */
+  int findBand(float lowHz, float highHz) const;
+
+  const std::vector<Band>& getBands() const;
+
+  /**
+   * @return Unix time of the first second, and one past the last second, covered by the index.
+   */
+  int64_t getFirstSecond() const;
+  int64_t getEndSecond() const;
+
+private:
+  const uint8_t* data;
+  size_t size;
+  Header header;
+  std::vector<Band> bands;
+  size_t nRecords;
+};
+
+#endif /* OPENGL_SPECTROGRAM_BANDSUMMARYINDEX_HPP */
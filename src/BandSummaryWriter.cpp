@@ -0,0 +1,85 @@
+#include "BandSummaryWriter.hpp"
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+#include "Log.hpp"
+
+BandSummaryWriter::BandSummaryWriter(const std::string& path, const std::vector<BandSummaryIndex::Band>& bands,
+                                     const SpectrogramFile::Header& header)
+  : bands(bands), samplingRate(header.samplingRate), nFrequencies(header.nFrequencies), currentSecond(INT64_MIN),
+    nColumns(0), statistics(bands.size()), record(BandSummaryIndex::recordBytes(bands.size()))
+{
+    file = fopen(path.c_str(), "wb");
+    if (!file) {
+        Log::getInstance()->logger() << "Could not create " << path << std::endl;
+        throw 99;
+    }
+
+    /* slice entry i is centred on i * nyquist / nFrequencies */
+    float hzPerBin = header.samplingRate / 2.0f / nFrequencies;
+    for (const BandSummaryIndex::Band& band : bands) {
+        firstBin.push_back(std::min(nFrequencies, (unsigned int) ceilf(band.lowHz / hzPerBin)));
+        endBin.push_back(std::min(nFrequencies, (unsigned int) ceilf(band.highHz / hzPerBin)));
+    }
+    for (int q = 0; q < 256; ++q) {
+        powers[q] = q ? SpectrogramFile::dequantize((uint8_t) q, header.dbFloor, header.dbStep) : 0.0f;
+    }
+}
+
+BandSummaryWriter::~BandSummaryWriter()
+{
+    if (nColumns) writeRecord(currentSecond + 1);
+    fclose(file);
+}
+
+void BandSummaryWriter::add(const uint8_t* bins, double unixTime)
+{
+    int64_t second = (int64_t) floor(unixTime);
+    if (currentSecond == INT64_MIN) {
+        BandSummaryIndex::Header header;
+        memcpy(header.magic, BandSummaryIndex::MAGIC, sizeof(header.magic));
+        header.nBands = (uint32_t) bands.size();
+        header.samplingRate = samplingRate;
+        header.firstSecond = second;
+        fwrite(&header, sizeof(header), 1, file);
+        fwrite(bands.data(), sizeof(BandSummaryIndex::Band), bands.size(), file);
+        currentSecond = second;
+    } else if (second > currentSecond) {
+        writeRecord(second);
+    }
+    /* if the wall clock stepped back, the column still counts towards the current second */
+
+    for (size_t b = 0; b < bands.size(); ++b) {
+        float energy = 0.0f;
+        for (unsigned int i = firstBin[b]; i < endBin[b]; ++i) energy += powers[bins[i]];
+        BandSummaryIndex::BandStatistics& s = statistics[b];
+        if (nColumns) {
+            s.min = std::min(s.min, energy);
+            s.max = std::max(s.max, energy);
+            s.mean += energy;
+        } else {
+            s = {energy, energy, energy};
+        }
+    }
+    ++nColumns;
+}
+
+void BandSummaryWriter::writeRecord(int64_t nextSecond)
+{
+    BandSummaryIndex::RecordHeader recordHeader = {nColumns, 0};
+    memcpy(record.data(), &recordHeader, sizeof(recordHeader));
+    for (size_t b = 0; b < bands.size(); ++b) {
+        BandSummaryIndex::BandStatistics s = statistics[b];
+        s.mean /= std::max(1u, nColumns);
+        memcpy(record.data() + sizeof(recordHeader) + b * sizeof(s), &s, sizeof(s));
+    }
+    fwrite(record.data(), 1, record.size(), file);
+
+    /* keep one record per second, also across gaps */
+    memset(record.data(), 0, record.size());
+    for (int64_t s = currentSecond + 1; s < nextSecond; ++s) fwrite(record.data(), 1, record.size(), file);
+    fflush(file);
+
+    currentSecond = nextSecond;
+    nColumns = 0;
+}
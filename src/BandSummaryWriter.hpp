@@ -0,0 +1,74 @@
+/**
+ * Builds a BandSummaryIndex incrementally from quantized spectrogram columns, one record per wall clock second.
+ * Every completed record is flushed, so the index can be queried while it grows.
+ */
+
+#ifndef OPENGL_SPECTROGRAM_BANDSUMMARYWRITER_HPP
+#define OPENGL_SPECTROGRAM_BANDSUMMARYWRITER_HPP
+
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdint.h>
+#include "BandSummaryIndex.hpp"
+#include "SpectrogramFile.hpp"
+
+class BandSummaryWriter {
+public:
+  /**
+   * Creates the index. Throws 99 if the file cannot be created.
+   * @param path path of the index.
+   * @param bands frequency bands to summarize.
+   * @param header header of the recording the columns belong to, for their frequency and dB scales.
+   */
+  BandSummaryWriter(const std::string& path, const std::vector<BandSummaryIndex::Band>& bands,
+                    const SpectrogramFile::Header& header);
+
+  BandSummaryWriter(const BandSummaryWriter&) = delete;
+  BandSummaryWriter& operator=(const BandSummaryWriter&) = delete;
+
+  /**
+   * Writes the last, partial second and closes the index.
+   */
+  ~BandSummaryWriter();
+
+  /**
+   * Accounts for one column.
+   * @param bins quantized column, nFrequencies bytes.
+   * @param unixTime wall clock time of the column.
+   */
+  void add(const uint8_t* bins, double unixTime);
+
+private:
+  /**
+   * Appends the record of the current second, and empty records for any seconds without columns after it.
+   * @param nextSecond second of the next column.
+   */
+  void writeRecord(int64_t nextSecond);
+
+  FILE* file;
+  std::vector<BandSummaryIndex::Band> bands;
+  unsigned int samplingRate;
+  unsigned int nFrequencies;
+
+  /**
+   * First and one past the last bin of every band.
+   */
+  std::vector<unsigned int> firstBin;
+  std::vector<unsigned int> endBin;
+
+  /**
+   * Power of every quantization level.
+   */
+  float powers[256];
+
+  /**
+   * Second being accumulated, or INT64_MIN before the first column.
+   */
+  int64_t currentSecond;
+  uint32_t nColumns;
+  std::vector<BandSummaryIndex::BandStatistics> statistics;
+  std::vector<uint8_t> record;
+};
+
+#endif /* OPENGL_SPECTROGRAM_BANDSUMMARYWRITER_HPP */
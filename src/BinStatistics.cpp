@@ -0,0 +1,121 @@
+#include "BinStatistics.hpp"
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "Log.hpp"
+#include "Trace.hpp"
+#include "VectorOps.hpp"
+
+/* static member declarations and initializations */
+const char BinStatistics::MAGIC[8] = {'S', 'P', 'E', 'C', 'B', 'A', 'S', 'E'};
+const uint64_t BinStatistics::MAX_COUNT = 100000;
+const float BinStatistics::DEVIATION_FLOOR_DB = 0.5f;
+
+/* power floor, about -200 dB, so that silence has a logarithm */
+static const float POWER_FLOOR = 1e-20f;
+
+/* dB per unit of log2 power */
+static const float DB_PER_OCTAVE = 3.0103f;
+
+BinStatistics::BinStatistics(unsigned int nFrequencies, unsigned int samplingRate, unsigned int fftLength)
+  : DspSink<SpectrumFrame>("bin statistics"), nFrequencies(std::min(nFrequencies, SpectrumFrame::MAX_FREQUENCIES)),
+    samplingRate(samplingRate), fftLength(fftLength), learning(true), logPower(this->nFrequencies),
+    mean(this->nFrequencies, 0.0f), variance(this->nFrequencies, 0.0f), count(0)
+{
+}
+
+uint64_t BinStatistics::read(std::vector<float>& mean, std::vector<float>& inverseDeviation) const
+{
+    const float floor = DEVIATION_FLOOR_DB / DB_PER_OCTAVE;
+    std::lock_guard<std::mutex> lock(mutex);
+    mean = this->mean;
+    inverseDeviation.resize(nFrequencies);
+    for (unsigned int i = 0; i < nFrequencies; ++i) {
+        inverseDeviation[i] = 1.0f / sqrtf(std::max(variance[i], floor * floor));
+    }
+    return count;
+}
+
+void BinStatistics::setLearning(bool learning)
+{
+    this->learning.store(learning, std::memory_order_relaxed);
+    Log::getInstance()->logger() << (learning ? "Learning" : "Holding") << " the baseline of " << nFrequencies
+                                 << " frequencies" << std::endl;
+}
+
+bool BinStatistics::isLearning() const
+{
+    return learning.load(std::memory_order_relaxed);
+}
+
+bool BinStatistics::save(const std::string& path) const
+{
+    Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.nFrequencies = nFrequencies;
+    header.samplingRate = samplingRate;
+    header.fftLength = fftLength;
+
+    FILE* out = fopen(path.c_str(), "wb");
+    if (!out) {
+        Log::getInstance()->logger() << "Could not create " << path << std::endl;
+        return false;
+    }
+    bool written;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        header.count = count;
+        written = fwrite(&header, sizeof(header), 1, out) == 1
+                  && fwrite(mean.data(), sizeof(float), nFrequencies, out) == nFrequencies
+                  && fwrite(variance.data(), sizeof(float), nFrequencies, out) == nFrequencies;
+    }
+    written = fclose(out) == 0 && written;
+    if (!written) {
+        Log::getInstance()->logger() << "Could not write " << path << std::endl;
+        return false;
+    }
+    Log::getInstance()->logger() << "Saved a baseline of " << header.count << " columns to " << path << std::endl;
+    return true;
+}
+
+bool BinStatistics::load(const std::string& path)
+{
+    FILE* in = fopen(path.c_str(), "rb");
+    if (!in) {
+        Log::getInstance()->logger() << "Could not open " << path << std::endl;
+        return false;
+    }
+    Header header;
+    std::vector<float> newMean(nFrequencies), newVariance(nFrequencies);
+    bool valid = fread(&header, sizeof(header), 1, in) == 1 && !memcmp(header.magic, MAGIC, sizeof(MAGIC))
+                 && header.nFrequencies == nFrequencies && header.samplingRate == samplingRate
+                 && header.fftLength == fftLength
+                 && fread(newMean.data(), sizeof(float), nFrequencies, in) == nFrequencies
+                 && fread(newVariance.data(), sizeof(float), nFrequencies, in) == nFrequencies;
+    fclose(in);
+    if (!valid) {
+        Log::getInstance()->logger() << path << " is not a baseline of " << nFrequencies << " frequencies at "
+                                     << samplingRate << " Hz and FFT length " << fftLength << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    mean.swap(newMean);
+    variance.swap(newVariance);
+    count = header.count;
+    Log::getInstance()->logger() << "Loaded a baseline of " << count << " columns from " << path << std::endl;
+    return true;
+}
+
+void BinStatistics::consume(const SpectrumFrame& frame)
+{
+    if (frame.nFrequencies < nFrequencies || !learning.load(std::memory_order_relaxed)) return;
+    TraceScope traceScope("bin statistics");
+    VectorOps::log2Approx(frame.power, logPower.data(), nFrequencies, POWER_FLOOR);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (count < MAX_COUNT) ++count;
+    VectorOps::welford(logPower.data(), mean.data(), variance.data(), nFrequencies, 1.0f / count);
+}
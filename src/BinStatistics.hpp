@@ -0,0 +1,111 @@
+/**
+ * DSP graph sink learning a baseline of every frequency: the running mean and variance of its log power, updated
+ * with Welford's method across all frequencies at once. Until MAX_COUNT columns have been seen, the statistics are
+ * those of all columns; from then on, each column has a weight of 1 / MAX_COUNT, so the baseline follows slow
+ * changes of the plant. Learning can be paused to keep a baseline fixed, and baselines can be saved and loaded.
+ *
+ * A column is then judged by the z-score of every frequency, its deviation from the mean in standard deviations.
+ *
+ * Baseline file layout (native endianness):
+ *    Header
+ *    float mean[nFrequencies]
+ *    float variance[nFrequencies]
+ */
+
+#ifndef OPENGL_SPECTROGRAM_BINSTATISTICS_HPP
+#define OPENGL_SPECTROGRAM_BINSTATISTICS_HPP
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "DspGraph.hpp"
+#include "SpectrumTap.hpp"
+
+class BinStatistics : public DspSink<SpectrumFrame> {
+public:
+  struct Header {
+    char magic[8];
+    uint32_t nFrequencies;
+    uint32_t samplingRate;
+    uint32_t fftLength;
+    uint32_t reserved;
+    /**
+     * Number of columns learned.
+     */
+    uint64_t count;
+  };
+
+  static const char MAGIC[8];
+
+  /**
+   * Number of columns after which the weight of new columns stops decreasing.
+   */
+  static const uint64_t MAX_COUNT;
+
+  /**
+   * Smallest standard deviation in dB used for z-scores, so that a bin which never changed, e.g. in digital silence,
+   * does not flag every rounding error.
+   */
+  static const float DEVIATION_FLOOR_DB;
+
+  /**
+   * @param nFrequencies number of frequencies per frame; smaller frames are ignored.
+   * @param samplingRate sampling rate of the audio, recorded in saved baselines.
+   * @param fftLength FFT length, recorded in saved baselines.
+   */
+  BinStatistics(unsigned int nFrequencies, unsigned int samplingRate, unsigned int fftLength);
+
+  /**
+   * Reads the baseline for z-scores, z = (log2(power) - mean) * inverseDeviation. Safe to call from any thread.
+   * @param mean receives nFrequencies mean log2 powers.
+   * @param inverseDeviation receives nFrequencies reciprocal standard deviations of the log2 powers.
+   * @return number of columns learned.
+   */
+  uint64_t read(std::vector<float>& mean, std::vector<float>& inverseDeviation) const;
+
+  /**
+   * Pauses or resumes learning.
+   */
+  void setLearning(bool learning);
+
+  bool isLearning() const;
+
+  /**
+   * Writes the baseline to a file.
+   * @return false if the file could not be written.
+   */
+  bool save(const std::string& path) const;
+
+  /**
+   * Replaces the baseline by one read from a file, which must have the same number of frequencies, sampling rate and
+   * FFT length.
+   * @return false if the file could not be read or does not match.
+   */
+  bool load(const std::string& path);
+
+protected:
+  virtual void consume(const SpectrumFrame& frame);
+
+private:
+  unsigned int nFrequencies;
+  unsigned int samplingRate;
+  unsigned int fftLength;
+  std::atomic<bool> learning;
+
+  /**
+   * log2 powers of the frame being learned.
+   */
+  std::vector<float> logPower;
+
+  /**
+   * Running statistics of the log2 powers, guarded by mutex.
+   */
+  std::vector<float> mean;
+  std::vector<float> variance;
+  uint64_t count;
+  mutable std::mutex mutex;
+};
+
+#endif /* OPENGL_SPECTROGRAM_BINSTATISTICS_HPP */
@@ -0,0 +1,127 @@
+/**
+ * Fixed-capacity lock-free multi-producer multi-consumer queue (D. Vyukov's bounded MPMC queue). Every slot carries a
+ * sequence number which tells producers and consumers whether it is theirs to fill or drain, so neither side ever
+ * blocks or allocates after construction, which makes it usable from the audio callback.
+ */
+
+#ifndef OPENGL_SPECTROGRAM_BOUNDEDQUEUE_HPP
+#define OPENGL_SPECTROGRAM_BOUNDEDQUEUE_HPP
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+template<typename T>
+class BoundedQueue {
+public:
+  /**
+   * Allocates all slots up front.
+   * @param capacity maximum number of queued items, rounded up to a power of two.
+   */
+  explicit BoundedQueue(size_t capacity)
+  {
+    size_t n = 2;
+    while (n < capacity) n <<= 1;
+    mask = n - 1;
+    slots = new Slot[n];
+    for (size_t i = 0; i < n; ++i) slots[i].sequence.store(i, std::memory_order_relaxed);
+    enqueuePos.store(0, std::memory_order_relaxed);
+    dequeuePos.store(0, std::memory_order_relaxed);
+  }
+
+  BoundedQueue(const BoundedQueue&) = delete;
+  BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+  ~BoundedQueue()
+  {
+    delete[] slots;
+  }
+
+  /**
+   * Appends an item. Realtime safe.
+   * @param item item to append.
+   * @return false if the queue is full.
+   */
+  bool push(const T& item)
+  {
+    size_t pos = enqueuePos.load(std::memory_order_relaxed);
+    Slot* slot;
+    while (true) {
+      slot = &slots[pos & mask];
+      size_t sequence = slot->sequence.load(std::memory_order_acquire);
+      intptr_t diff = (intptr_t) sequence - (intptr_t) pos;
+      if (diff == 0) {
+        if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = enqueuePos.load(std::memory_order_relaxed);
+      }
+    }
+    slot->item = item;
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Removes the oldest item. Realtime safe.
+   * @param item receives the removed item.
+   * @return false if the queue is empty.
+   */
+  bool pop(T& item)
+  {
+    size_t pos = dequeuePos.load(std::memory_order_relaxed);
+    Slot* slot;
+    while (true) {
+      slot = &slots[pos & mask];
+      size_t sequence = slot->sequence.load(std::memory_order_acquire);
+      intptr_t diff = (intptr_t) sequence - (intptr_t) (pos + 1);
+      if (diff == 0) {
+        if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = dequeuePos.load(std::memory_order_relaxed);
+      }
+    }
+    item = slot->item;
+    slot->sequence.store(pos + mask + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @return approximate number of queued items.
+   */
+  size_t size() const
+  {
+    size_t enqueued = enqueuePos.load(std::memory_order_relaxed);
+    size_t dequeued = dequeuePos.load(std::memory_order_relaxed);
+    return enqueued > dequeued ? enqueued - dequeued : 0;
+  }
+
+  /**
+   * @return maximum number of queued items.
+   */
+  size_t capacity() const
+  {
+    return mask + 1;
+  }
+
+private:
+  struct Slot {
+    std::atomic<size_t> sequence;
+    T item;
+  };
+
+  Slot* slots;
+  size_t mask;
+
+  /* producers and consumers each get their own cache line (padded rather than aligned, for plain new in C++14) */
+  char producerPadding[64];
+  std::atomic<size_t> enqueuePos;
+  char consumerPadding[64];
+  std::atomic<size_t> dequeuePos;
+  char endPadding[64];
+};
+
+#endif /* OPENGL_SPECTROGRAM_BOUNDEDQUEUE_HPP */
@@ -0,0 +1,46 @@
+#include "ChannelSpectrumTap.hpp"
+#include <string.h>
+
+/* static member declarations and initializations */
+const unsigned int ChannelSpectrum::MAX_LENGTH;
+
+ChannelSpectrumTap::ChannelSpectrumTap(unsigned int channel, unsigned int samplingRate)
+{
+    memset(&spectrum, 0, sizeof(spectrum));
+    spectrum.channel = channel;
+    spectrum.samplingRate = samplingRate;
+}
+
+unsigned int ChannelSpectrumTap::getSamplingRate() const
+{
+    return spectrum.samplingRate;
+}
+
+void ChannelSpectrumTap::samplesCaptured(const float* samples, unsigned long numSamples, uint64_t firstSampleIndex,
+                                         double firstAdcTime)
+{
+    (void) samples;
+    (void) numSamples;
+    (void) firstSampleIndex;
+    (void) firstAdcTime;
+}
+
+void ChannelSpectrumTap::spectrumComputed(const float* halfComplex, unsigned int fftLength, uint64_t endSampleIndex,
+                                          double adcTime)
+{
+    if (fftLength > ChannelSpectrum::MAX_LENGTH) return;
+    spectrum.endSampleIndex = endSampleIndex;
+    spectrum.adcTime = adcTime;
+    spectrum.length = fftLength;
+    memcpy(spectrum.halfComplex, halfComplex, fftLength * sizeof(float));
+    emit(spectrum);
+}
+
+void ChannelSpectrumTap::sliceComputed(const float* slice, unsigned int nFrequencies, uint64_t endSampleIndex,
+                                       double adcTime)
+{
+    (void) slice;
+    (void) nFrequencies;
+    (void) endSampleIndex;
+    (void) adcTime;
+}
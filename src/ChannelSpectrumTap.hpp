@@ -0,0 +1,70 @@
+/**
+ * Entry point of the cross-channel analyses: an AudioListener that copies the complex spectrum of every frame of one
+ * input into a ChannelSpectrum and emits it into the connected edges, tagged with the index of the input. Several taps
+ * may feed the same edge, so that a stage sees the spectra of all its channels on one input.
+ */
+
+#ifndef OPENGL_SPECTROGRAM_CHANNELSPECTRUMTAP_HPP
+#define OPENGL_SPECTROGRAM_CHANNELSPECTRUMTAP_HPP
+
+#include <stdint.h>
+#include "AudioListener.hpp"
+#include "DspGraph.hpp"
+#include "SpectrumTap.hpp"
+
+/**
+ * Complex spectrum of one frame of one channel as it travels through the DSP graph.
+ */
+struct ChannelSpectrum {
+  /**
+   * Maximum FFT length.
+   */
+  static const unsigned int MAX_LENGTH = 2 * SpectrumFrame::MAX_FREQUENCIES;
+
+  unsigned int channel;
+  unsigned int samplingRate;
+  uint64_t endSampleIndex;
+  double adcTime;
+
+  /**
+   * FFT length, and the spectrum in FFTW half-complex order.
+   */
+  unsigned int length;
+  float halfComplex[MAX_LENGTH];
+};
+
+class ChannelSpectrumTap : public AudioListener, public DspProducer<ChannelSpectrum> {
+public:
+  /**
+   * @param channel index of the input tapped.
+   * @param samplingRate sampling rate of the input.
+   */
+  ChannelSpectrumTap(unsigned int channel, unsigned int samplingRate);
+
+  /**
+   * @return sampling rate of the input.
+   */
+  unsigned int getSamplingRate() const;
+
+  /**
+   * Ignores samples.
+   */
+  virtual void samplesCaptured(const float* samples, unsigned long numSamples, uint64_t firstSampleIndex,
+                               double firstAdcTime);
+
+  /**
+   * Emits the spectrum, unless longer than MAX_LENGTH. Realtime safe as long as no connected edge blocks.
+   */
+  virtual void spectrumComputed(const float* halfComplex, unsigned int fftLength, uint64_t endSampleIndex,
+                                double adcTime);
+
+  /**
+   * Ignores slices.
+   */
+  virtual void sliceComputed(const float* slice, unsigned int nFrequencies, uint64_t endSampleIndex, double adcTime);
+
+private:
+  ChannelSpectrum spectrum;
+};
+
+#endif /* OPENGL_SPECTROGRAM_CHANNELSPECTRUMTAP_HPP */
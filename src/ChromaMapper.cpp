@@ -0,0 +1,86 @@
+#include "ChromaMapper.hpp"
+#include <algorithm>
+#include <math.h>
+#include "Log.hpp"
+#include "Trace.hpp"
+#include "VectorOps.hpp"
+
+/* static member declarations and initializations */
+const unsigned int ChromaFrame::N_CLASSES;
+const float ChromaMapper::MIN_FREQUENCY = 55.0f;
+const float ChromaMapper::MAX_FREQUENCY = 5000.0f;
+
+ChromaMapper::ChromaMapper(unsigned int samplingRate, unsigned int nFrequencies, float cFrequency)
+  : DspStage<SpectrumFrame, ChromaFrame>("chroma"), nFrequencies(nFrequencies), latestSequence(0)
+{
+    for (std::atomic<float>& value : latest) value = 0.0f;
+
+    /* below the frequency where a semitone spans one bin, pitch classes cannot be told apart */
+    float hzPerBin = samplingRate / 2.0f / nFrequencies;
+    float lowest = std::max(MIN_FREQUENCY, hzPerBin / (powf(2.0f, 1.0f / 12) - 1.0f));
+    unsigned int firstBin = (unsigned int) ceilf(lowest / hzPerBin);
+    unsigned int endBin = std::min(nFrequencies, (unsigned int) (MAX_FREQUENCY / hzPerBin) + 1);
+
+    /* dense weights per class, then compressed into runs */
+    std::vector<std::vector<float>> dense(ChromaFrame::N_CLASSES, std::vector<float>(nFrequencies, 0.0f));
+    for (unsigned int k = firstBin; k < endBin; ++k) {
+        float semitones = 12.0f * log2f(k * hzPerBin / cFrequency);
+        float below = floorf(semitones);
+        int pitchClass = ((int) below % 12 + 12) % 12;
+        dense[pitchClass][k] += 1.0f - (semitones - below);
+        dense[(pitchClass + 1) % 12][k] += semitones - below;
+    }
+    for (unsigned int c = 0; c < ChromaFrame::N_CLASSES; ++c) {
+        for (unsigned int k = firstBin; k < endBin; ++k) {
+            if (dense[c][k] <= 0.0f) continue;
+            if (runs.empty() || runs.back().pitchClass != c || runs.back().firstBin + runs.back().length != k) {
+                runs.push_back({c, k, 0, (unsigned int) weights.size()});
+            }
+            runs.back().length++;
+            weights.push_back(dense[c][k]);
+        }
+    }
+    Log::getInstance()->logger() << "Chroma of " << lowest << "-" << std::min(MAX_FREQUENCY, samplingRate / 2.0f)
+                                 << " Hz: " << weights.size() << " weights in " << runs.size() << " runs" << std::endl;
+}
+
+void ChromaMapper::apply(const float* power, float* chroma) const
+{
+    std::fill(chroma, chroma + ChromaFrame::N_CLASSES, 0.0f);
+    for (const Run& run : runs) {
+        chroma[run.pitchClass] += VectorOps::dot(&weights[run.firstWeight], power + run.firstBin, run.length);
+    }
+}
+
+void ChromaMapper::getLatest(float* chroma) const
+{
+    unsigned int sequence;
+    do {
+        while ((sequence = latestSequence.load(std::memory_order_acquire)) & 1) {}
+        for (unsigned int c = 0; c < ChromaFrame::N_CLASSES; ++c) chroma[c] = latest[c].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while (latestSequence.load(std::memory_order_relaxed) != sequence);
+}
+
+size_t ChromaMapper::getWeights() const
+{
+    return weights.size();
+}
+
+bool ChromaMapper::process(const SpectrumFrame& frame, ChromaFrame& out)
+{
+    TraceScope traceScope("chroma");
+    out.endSampleIndex = frame.endSampleIndex;
+    out.adcTime = frame.adcTime;
+    out.unixTime = frame.unixTime;
+    if (frame.nFrequencies < nFrequencies) return false;
+    apply(frame.power, out.chroma);
+
+    /* only this stage writes, so a plain increment makes the sequence odd */
+    unsigned int sequence = latestSequence.load(std::memory_order_relaxed);
+    latestSequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (unsigned int c = 0; c < ChromaFrame::N_CLASSES; ++c) latest[c].store(out.chroma[c], std::memory_order_relaxed);
+    latestSequence.store(sequence + 2, std::memory_order_release);
+    return true;
+}
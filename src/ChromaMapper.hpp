@@ -0,0 +1,94 @@
+/**
+ * DSP graph stage folding every spectrum frame into 12 pitch classes (a chromagram column), class 0 being C.
+ *
+ * The mapping is a sparse matrix precomputed for the spectrum size and sampling rate: each frequency between
+ * MIN_FREQUENCY (raised until bins are narrower than a semitone) and MAX_FREQUENCY is split between the two nearest
+ * semitones in proportion to its distance from them. Since neighbouring frequencies mostly share their pitch classes,
+ * the matrix is stored as runs of consecutive frequencies per class, and applied as one dot product per run.
+ */
+
+#ifndef OPENGL_SPECTROGRAM_CHROMAMAPPER_HPP
+#define OPENGL_SPECTROGRAM_CHROMAMAPPER_HPP
+
+#include <atomic>
+#include <vector>
+#include <stdint.h>
+#include "DspGraph.hpp"
+#include "SpectrumTap.hpp"
+
+/**
+ * Chromagram column of one spectrum frame.
+ */
+struct ChromaFrame {
+  static const unsigned int N_CLASSES = 12;
+
+  uint64_t endSampleIndex;
+  double adcTime;
+  double unixTime;
+
+  /**
+   * Power per pitch class.
+   */
+  float chroma[N_CLASSES];
+};
+
+class ChromaMapper : public DspStage<SpectrumFrame, ChromaFrame> {
+public:
+  /**
+   * Range of frequencies folded into the chroma.
+   */
+  static const float MIN_FREQUENCY;
+  static const float MAX_FREQUENCY;
+
+  /**
+   * Builds the mapping.
+   * @param samplingRate sampling rate of the audio the frames were computed from.
+   * @param nFrequencies number of frequencies per frame.
+   * @param cFrequency frequency of a C, e.g. middle C, which defines the tuning.
+   */
+  ChromaMapper(unsigned int samplingRate, unsigned int nFrequencies, float cFrequency);
+
+  /**
+   * Folds a power spectrum into pitch classes.
+   * @param power nFrequencies powers.
+   * @param chroma receives N_CLASSES powers.
+   */
+  void apply(const float* power, float* chroma) const;
+
+  /**
+   * Latest chroma, for display. Safe to call from any thread.
+   * @param chroma receives N_CLASSES powers.
+   */
+  void getLatest(float* chroma) const;
+
+  /**
+   * @return number of nonzero weights in the mapping.
+   */
+  size_t getWeights() const;
+
+protected:
+  virtual bool process(const SpectrumFrame& frame, ChromaFrame& out);
+
+private:
+  /**
+   * Consecutive frequencies contributing to one pitch class.
+   */
+  struct Run {
+    unsigned int pitchClass;
+    unsigned int firstBin;
+    unsigned int length;
+    unsigned int firstWeight;
+  };
+
+  unsigned int nFrequencies;
+  std::vector<Run> runs;
+  std::vector<float> weights;
+
+  /**
+   * Latest chroma, behind a sequence counter that is odd while it is written.
+   */
+  std::atomic<unsigned int> latestSequence;
+  std::atomic<float> latest[ChromaFrame::N_CLASSES];
+};
+
+#endif /* OPENGL_SPECTROGRAM_CHROMAMAPPER_HPP */
@@ -0,0 +1,193 @@
+#include "ColumnEmitter.hpp"
+#include <algorithm>
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "Log.hpp"
+#include "SpectrogramFile.hpp"
+#include "Trace.hpp"
+
+/* static member declarations and initializations */
+const uint32_t ColumnEmitter::MAGIC = 0x46435641;
+const unsigned int ColumnEmitter::BATCH_COLUMNS = 8;
+const int ColumnEmitter::CLIENT_TIMEOUT_MS = 1000;
+
+/* poll interval while waiting for the reader, bounding how long stop() waits */
+static const int POLL_MS = 100;
+
+ColumnEmitter::ColumnEmitter(const std::string& target, Format format, unsigned int nBins)
+  : DspSink<SpectrumFrame>("column emitter"), format(format), nBins(nBins),
+    binBytes(nBins * (format == FLOAT_BINS ? sizeof(float) : sizeof(uint8_t))), fd(-1), listenFd(-1),
+    headers(BATCH_COLUMNS), bins(BATCH_COLUMNS * binBytes), vectors(2 * BATCH_COLUMNS),
+    batched(0), droppedReported(0), closed(false), emitted(0)
+{
+    if (target == "-") {
+        /* stays blocking, as the shell and the rest of the pipeline share it; writeAll() polls instead */
+        fd = STDOUT_FILENO;
+    } else if (!target.compare(0, 5, "unix:")) {
+        socketPath = target.substr(5);
+        sockaddr_un address;
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (socketPath.size() >= sizeof(address.sun_path)) {
+            Log::getInstance()->logger() << "Socket path too long: " << socketPath << std::endl;
+            throw 99;
+        }
+        strcpy(address.sun_path, socketPath.c_str());
+        unlink(socketPath.c_str());
+        listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listenFd < 0 || bind(listenFd, (sockaddr*) &address, sizeof(address)) != 0 || listen(listenFd, 4) != 0) {
+            Log::getInstance()->logger() << "Could not listen on " << socketPath << ": " << strerror(errno) << std::endl;
+            if (listenFd >= 0) close(listenFd);
+            throw 99;
+        }
+    } else {
+        Log::getInstance()->logger() << "Unknown emit target " << target << std::endl;
+        throw 99;
+    }
+    Log::getInstance()->logger() << "Emitting " << nBins << (format == FLOAT_BINS ? " float" : " byte")
+                                 << " bins per column to " << (fd >= 0 ? "stdout" : socketPath) << std::endl;
+}
+
+ColumnEmitter::~ColumnEmitter()
+{
+    if (listenFd >= 0) {
+        if (fd >= 0) close(fd);
+        close(listenFd);
+        unlink(socketPath.c_str());
+    }
+}
+
+bool ColumnEmitter::isClosed() const
+{
+    return closed;
+}
+
+unsigned long ColumnEmitter::getEmitted() const
+{
+    return emitted;
+}
+
+void ColumnEmitter::consume(const SpectrumFrame& frame)
+{
+    unsigned long dropped = getInput()->getDropped();
+    FrameHeader& header = headers[batched];
+    header.magic = MAGIC;
+    header.nBins = nBins;
+    header.format = format;
+    header.dropped = (uint32_t) (dropped - droppedReported);
+    header.endSampleIndex = frame.endSampleIndex;
+    header.adcTime = frame.adcTime;
+    header.unixTime = frame.unixTime;
+    droppedReported = dropped;
+
+    /* missing frequencies read as silence */
+    unsigned int n = std::min(nBins, frame.nFrequencies);
+    uint8_t* columnBins = bins.data() + batched * binBytes;
+    if (format == FLOAT_BINS) {
+        float* power = (float*) columnBins;
+        memcpy(power, frame.power, n * sizeof(float));
+        std::fill(power + n, power + nBins, 0.0f);
+    } else {
+        for (unsigned int j = 0; j < nBins; ++j) {
+            columnBins[j] = SpectrogramFile::quantize(j < n ? frame.power[j] : 0.0f, SpectrogramFile::DEFAULT_DB_FLOOR,
+                                                      SpectrogramFile::DEFAULT_DB_STEP);
+        }
+    }
+    vectors[2 * batched] = {&header, sizeof(FrameHeader)};
+    vectors[2 * batched + 1] = {columnBins, binBytes};
+    ++batched;
+
+    /* write when the batch is full, or when waiting for more columns would only add latency */
+    if (batched == BATCH_COLUMNS || !hasInput()) flush();
+}
+
+void ColumnEmitter::flush()
+{
+    TraceScope traceScope("emit columns");
+    unsigned int count = batched;
+    batched = 0;
+    if (closed) return;
+
+    if (listenFd >= 0 && fd < 0) {
+        fd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) return;
+        Log::getInstance()->logger() << "Emit client connected" << std::endl;
+    }
+
+    if (writeAll(vectors.data(), 2 * count)) {
+        emitted += count;
+    } else if (listenFd >= 0) {
+        Log::getInstance()->logger() << "Emit client disconnected" << std::endl;
+        close(fd);
+        fd = -1;
+    } else {
+        Log::getInstance()->logger() << "Stdout closed, no longer emitting" << std::endl;
+        closed = true;
+    }
+}
+
+bool ColumnEmitter::writeAll(iovec* vectors, int count)
+{
+    int waitedMs = 0;
+    while (count > 0) {
+        ssize_t written;
+        if (listenFd >= 0) {
+            msghdr message;
+            memset(&message, 0, sizeof(message));
+            message.msg_iov = vectors;
+            message.msg_iovlen = (size_t) count;
+            written = sendmsg(fd, &message, MSG_DONTWAIT | MSG_NOSIGNAL);
+        } else {
+            /* a blocking pipe that polls writable takes PIPE_BUF bytes without blocking, but not necessarily more */
+            pollfd writable = {fd, POLLOUT, 0};
+            int ready = poll(&writable, 1, POLL_MS);
+            if (ready == 0) {
+                written = -1;
+                errno = EAGAIN;
+            } else if (ready < 0) {
+                written = -1;
+            } else if (writable.revents & (POLLERR | POLLHUP | POLLNVAL)) {
+                return false;
+            } else {
+                int n = 0;
+                size_t bytes = 0;
+                while (n < count && bytes + vectors[n].iov_len <= PIPE_BUF) bytes += vectors[n++].iov_len;
+                iovec head = {vectors->iov_base, PIPE_BUF};
+                written = n ? writev(fd, vectors, n) : writev(fd, &head, 1);
+            }
+        }
+
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) return false;
+
+            /* the reader is slow; meanwhile the input edge drops the oldest columns */
+            if (isStopping() || (listenFd >= 0 && waitedMs >= CLIENT_TIMEOUT_MS)) return false;
+            if (listenFd >= 0) {
+                pollfd writable = {fd, POLLOUT, 0};
+                poll(&writable, 1, POLL_MS);
+            }
+            waitedMs += POLL_MS;
+            continue;
+        }
+        waitedMs = 0;
+
+        /* skip what was written, resuming within a partially written vector */
+        size_t remaining = (size_t) written;
+        while (count > 0 && remaining >= vectors->iov_len) {
+            remaining -= vectors->iov_len;
+            ++vectors;
+            --count;
+        }
+        if (count > 0) {
+            vectors->iov_base = (uint8_t*) vectors->iov_base + remaining;
+            vectors->iov_len -= remaining;
+        }
+    }
+    return true;
+}
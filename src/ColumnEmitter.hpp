@@ -0,0 +1,125 @@
+/**
+ * DSP graph sink writing the column stream as fixed-size binary frames to stdout or to the clients of a Unix domain
+ * socket, for piping live spectra into other tools (-emit).
+ *
+ * Frame layout (native endianness), the same size for every frame of a stream:
+ *    header:  uint32 magic = 0x46435641 ("AVCF"), uint32 nBins, uint32 format (0: float, 1: uint8 dB levels as in
+ *             SpectrogramFile), uint32 dropped (columns lost just before this one), uint64 endSampleIndex,
+ *             double adcTime, double unixTime
+ *    bins:    nBins floats or bytes
+ *
+ * Up to BATCH_COLUMNS frames are written per writev() call. A slow reader blocks only the pinned emitter thread: its
+ * input edge then drops the oldest columns, which the next frame reports. A socket client that accepts nothing for
+ * CLIENT_TIMEOUT_MS is disconnected, and the socket accepts one client at a time.
+ */
+
+#ifndef OPENGL_SPECTROGRAM_COLUMNEMITTER_HPP
+#define OPENGL_SPECTROGRAM_COLUMNEMITTER_HPP
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <sys/uio.h>
+#include "DspGraph.hpp"
+#include "SpectrumTap.hpp"
+
+class ColumnEmitter : public DspSink<SpectrumFrame> {
+public:
+  enum Format {
+    FLOAT_BINS,
+    BYTE_BINS
+  };
+
+  struct FrameHeader {
+    uint32_t magic;
+    uint32_t nBins;
+    uint32_t format;
+    uint32_t dropped;
+    uint64_t endSampleIndex;
+    double adcTime;
+    double unixTime;
+  };
+
+  static const uint32_t MAGIC;
+
+  /**
+   * Maximum number of frames per write.
+   */
+  static const unsigned int BATCH_COLUMNS;
+
+  /**
+   * Time after which a socket client that does not read is disconnected.
+   */
+  static const int CLIENT_TIMEOUT_MS;
+
+  /**
+   * Opens the output. Throws 99 on failure.
+   * @param target "-" for stdout, or "unix:<path>" for a socket listening at path.
+   * @param format type of the bins.
+   * @param nBins number of frequencies per frame.
+   */
+  ColumnEmitter(const std::string& target, Format format, unsigned int nBins);
+
+  ColumnEmitter(const ColumnEmitter&) = delete;
+  ColumnEmitter& operator=(const ColumnEmitter&) = delete;
+
+  /**
+   * Closes the socket, if any.
+   */
+  ~ColumnEmitter();
+
+  /**
+   * @return whether stdout was closed by its reader, after which nothing more is written.
+   */
+  bool isClosed() const;
+
+  /**
+   * @return number of frames written.
+   */
+  unsigned long getEmitted() const;
+
+protected:
+  /**
+   * Adds a frame to the batch, which is written once full or once the input edge is empty.
+   */
+  virtual void consume(const SpectrumFrame& frame);
+
+private:
+  /**
+   * Writes the batch to the output, or to the next socket client, or discards it if there is none.
+   */
+  void flush();
+
+  /**
+   * Writes all bytes of a batch, resuming partial writes.
+   * @return false on an error or a client timeout.
+   */
+  bool writeAll(iovec* vectors, int count);
+
+  Format format;
+  unsigned int nBins;
+  size_t binBytes;
+
+  /**
+   * Output file descriptor, -1 while a socket has no client.
+   */
+  int fd;
+  int listenFd;
+  std::string socketPath;
+
+  std::vector<FrameHeader> headers;
+  std::vector<uint8_t> bins;
+  std::vector<iovec> vectors;
+  unsigned int batched;
+
+  /**
+   * Edge drops already reported in a frame.
+   */
+  unsigned long droppedReported;
+
+  std::atomic<bool> closed;
+  std::atomic<unsigned long> emitted;
+};
+
+#endif /* OPENGL_SPECTROGRAM_COLUMNEMITTER_HPP */
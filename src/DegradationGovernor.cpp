@@ -0,0 +1,110 @@
+#include "DegradationGovernor.hpp"
+#include "Log.hpp"
+#include "Trace.hpp"
+
+/* static member declarations and initializations */
+const DegradationGovernor::Level DegradationGovernor::LEVELS[] = {
+    /* name                hop  fft  aux plots  frame interval */
+    {"full quality",       1,   1,   true,      1},
+    {"hop x2",             2,   1,   true,      1},
+    {"hop x2, fft/2",      2,   2,   true,      1},
+    {"hop x4, fft/2",      4,   2,   false,     1},
+    {"hop x4, fft/2, fps/2", 4, 2,   false,     2}
+};
+const unsigned int DegradationGovernor::N_LEVELS = sizeof(LEVELS) / sizeof(LEVELS[0]);
+const float DegradationGovernor::DSP_OVERLOAD_LOAD = 0.75f;
+const float DegradationGovernor::DSP_RECOVERY_LOAD = 0.3f;
+const float DegradationGovernor::RENDER_OVERLOAD_RATIO = 1.8f;
+const double DegradationGovernor::OVERLOAD_HOLD_SECONDS = 2.0;
+const double DegradationGovernor::RECOVERY_HOLD_SECONDS = 10.0;
+
+DegradationGovernor::DegradationGovernor()
+  : level(0), dspLoad(0.0f), overflows(0), seenOverflows(0), frameTimeRatio(1.0f),
+    overloadedSince(-1.0), idleSince(-1.0), lastTransitionTime(-OVERLOAD_HOLD_SECONDS)
+{
+}
+
+void DegradationGovernor::reportDspLoad(float load)
+{
+  /* exponential smoothing over roughly 20 callbacks */
+  float smoothed = dspLoad.load(std::memory_order_relaxed);
+  dspLoad.store(0.95f * smoothed + 0.05f * load, std::memory_order_relaxed);
+}
+
+void DegradationGovernor::reportOverflow()
+{
+  overflows.fetch_add(1, std::memory_order_relaxed);
+}
+
+void DegradationGovernor::reportFrameTime(float seconds, float nominalSeconds)
+{
+  frameTimeRatio = 0.9f * frameTimeRatio + 0.1f * (seconds / nominalSeconds);
+}
+
+void DegradationGovernor::update(double now)
+{
+  unsigned long nOverflows = overflows.load(std::memory_order_relaxed);
+  bool overflowed = nOverflows != seenOverflows;
+  seenOverflows = nOverflows;
+  float load = dspLoad.load(std::memory_order_relaxed);
+
+  const char* reason = nullptr;
+  if (overflowed) reason = "input overflow";
+  else if (load > DSP_OVERLOAD_LOAD) reason = "dsp load";
+  else if (frameTimeRatio > RENDER_OVERLOAD_RATIO) reason = "render load";
+
+  if (reason) {
+    idleSince = -1.0;
+    if (overloadedSince < 0) overloadedSince = now;
+    /* a single overflow already means lost audio, so it does not have to be sustained */
+    bool sustained = now - overloadedSince >= OVERLOAD_HOLD_SECONDS;
+    bool settled = now - lastTransitionTime >= OVERLOAD_HOLD_SECONDS;
+    if (((overflowed && settled) || sustained) && getLevel() + 1 < N_LEVELS) {
+      transition(now, getLevel() + 1, reason);
+      overloadedSince = now;
+    }
+  } else {
+    overloadedSince = -1.0;
+    bool idle = load < DSP_RECOVERY_LOAD && frameTimeRatio < 0.5f * (1.0f + RENDER_OVERLOAD_RATIO);
+    if (!idle) {
+      idleSince = -1.0;
+    } else {
+      if (idleSince < 0) idleSince = now;
+      if (now - idleSince >= RECOVERY_HOLD_SECONDS && getLevel() > 0) {
+        transition(now, getLevel() - 1, "recovered");
+        idleSince = now;
+      }
+    }
+  }
+}
+
+void DegradationGovernor::transition(double now, unsigned int to, const char* reason)
+{
+  unsigned int from = getLevel();
+  transitions.push_back({now, from, to, reason});
+  lastTransitionTime = now;
+  level.store(to, std::memory_order_relaxed);
+  Trace::getInstance()->instant(to > from ? "governor step down" : "governor step up");
+  Log::getInstance()->logger() << "Degradation level " << from << " -> " << to << " (" << LEVELS[to].name
+                               << "), reason: " << reason << std::endl;
+}
+
+const DegradationGovernor::Level& DegradationGovernor::current() const
+{
+  return LEVELS[level.load(std::memory_order_relaxed)];
+}
+
+unsigned int DegradationGovernor::getLevel() const
+{
+  return level.load(std::memory_order_relaxed);
+}
+
+float DegradationGovernor::getDspLoad() const
+{
+  return dspLoad.load(std::memory_order_relaxed);
+}
+
+const std::vector<DegradationGovernor::Transition>& DegradationGovernor::getTransitions() const
+{
+  return transitions;
+}
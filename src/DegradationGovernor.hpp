@@ -0,0 +1,180 @@
+/**
+ * Steps the capture, DSP and render pipeline down to cheaper settings under sustained overload, and back up once the
+ * load has dropped, so that resolution is lost instead of audio.
+ *
+ * The DSP pool reports the load of each captured block it processes, the audio callback reports input overflows, and
+ * the render thread reports its frame times and periodically calls update(), which decides on and records level
+ * transitions.
+ */
+
+#ifndef OPENGL_SPECTROGRAM_DEGRADATIONGOVERNOR_HPP
+#define OPENGL_SPECTROGRAM_DEGRADATIONGOVERNOR_HPP
+
+#include <atomic>
+#include <vector>
+
+class DegradationGovernor {
+public:
+  /**
+   * Settings of one degradation level.
+   */
+  struct Level {
+    /**
+     * Short description of the level for logs and the diagnosis overlay.
+     */
+    const char* name;
+    /**
+     * Multiplier on the nominal hop size between spectrogram slices. Every column keeps its exact sample index and
+     * ADC time, but spans counted in columns from the nominal hop (the Welch average, the flight recorder's column
+     * ring) stretch by this factor while it applies.
+     */
+    unsigned int hopMultiplier;
+    /**
+     * Divisor of the nominal FFT length.
+     */
+    unsigned int fftDivisor;
+    /**
+     * Whether the auxiliary plots (time domain, spectral magnitude) are rendered next to the spectrogram.
+     */
+    bool renderAuxiliaryPlots;
+    /**
+     * Number of vSyncs per redisplay.
+     */
+    unsigned int frameInterval;
+  };
+
+  /**
+   * A change of level, with the reason for it.
+   */
+  struct Transition {
+    double time;
+    unsigned int from;
+    unsigned int to;
+    const char* reason;
+  };
+
+  /**
+   * All levels, from full quality (0) to the cheapest.
+   */
+  static const Level LEVELS[];
+
+  /**
+   * Number of entries in LEVELS.
+   */
+  static const unsigned int N_LEVELS;
+
+  /**
+   * Fraction of the real-time budget above which the DSP counts as overloaded.
+   */
+  static const float DSP_OVERLOAD_LOAD;
+
+  /**
+   * Fraction of the real-time budget below which the DSP counts as idle enough to recover.
+   */
+  static const float DSP_RECOVERY_LOAD;
+
+  /**
+   * Ratio of measured to nominal frame time above which rendering counts as overloaded.
+   */
+  static const float RENDER_OVERLOAD_RATIO;
+
+  /**
+   * Seconds of continuous overload before stepping down one level.
+   */
+  static const double OVERLOAD_HOLD_SECONDS;
+
+  /**
+   * Seconds of continuous low load before stepping up one level.
+   */
+  static const double RECOVERY_HOLD_SECONDS;
+
+  DegradationGovernor();
+
+  /**
+   * Reports the DSP load of one captured block, from the DSP pool thread that processed it. Lock-free.
+   * @param load time spent on DSP divided by the duration of the block.
+   */
+  void reportDspLoad(float load);
+
+  /**
+   * Reports an input overflow flagged by the audio driver. Realtime safe.
+   */
+  void reportOverflow();
+
+  /**
+   * Reports the time between two rendered frames. Called from the render thread.
+   * @param seconds measured frame time.
+   * @param nominalSeconds frame time expected at the current level.
+   */
+  void reportFrameTime(float seconds, float nominalSeconds);
+
+  /**
+   * Re-evaluates the load and steps the level down or up when warranted. Called from the render thread.
+   * @param now current time in seconds, on any monotonic clock.
+   */
+  void update(double now);
+
+  /**
+   * @return settings of the current level. Realtime safe.
+   */
+  const Level& current() const;
+
+  unsigned int getLevel() const;
+
+  float getDspLoad() const;
+
+  const std::vector<Transition>& getTransitions() const;
+
+private:
+  /**
+   * Changes the level and records the transition.
+   */
+  void transition(double now, unsigned int to, const char* reason);
+
+  /**
+   * Current index into LEVELS.
+   */
+  std::atomic<unsigned int> level;
+
+  /**
+   * Smoothed DSP load, written by the DSP pool.
+   */
+  std::atomic<float> dspLoad;
+
+  /**
+   * Number of input overflows reported, written by the audio callback.
+   */
+  std::atomic<unsigned long> overflows;
+
+  /**
+   * Number of input overflows already accounted for by update().
+   */
+  unsigned long seenOverflows;
+
+  /**
+   * Smoothed ratio of measured to nominal frame time.
+   */
+  float frameTimeRatio;
+
+  /**
+   * Time since which the pipeline has been continuously overloaded, or negative if it is not.
+   */
+  double overloadedSince;
+
+  /**
+   * Time since which the pipeline has been continuously lightly loaded, or negative if it is not.
+   */
+  double idleSince;
+
+  /**
+   * Time of the most recent level change.
+   */
+  double lastTransitionTime;
+
+  /**
+   * All level changes so far.
+   */
+  std::vector<Transition> transitions;
+};
+
+#endif /* OPENGL_SPECTROGRAM_DEGRADATIONGOVERNOR_HPP */
@@ -0,0 +1,26 @@
+#include "DelayCsvWriter.hpp"
+#include "Log.hpp"
+
+DelayCsvWriter::DelayCsvWriter(const std::string& path)
+  : DspSink<DelayEstimate>("delay csv")
+{
+    file = fopen(path.c_str(), "w");
+    if (!file) {
+        Log::getInstance()->logger() << "Could not create " << path << std::endl;
+        throw 99;
+    }
+    fprintf(file, "unix_time,adc_time,end_sample,first,second,delay_ms,peak\n");
+    Log::getInstance()->logger() << "Writing time delays to " << path << std::endl;
+}
+
+DelayCsvWriter::~DelayCsvWriter()
+{
+    fclose(file);
+}
+
+void DelayCsvWriter::consume(const DelayEstimate& estimate)
+{
+    fprintf(file, "%.3f,%.6f,%llu,%u,%u,%.4f,%.3f\n", estimate.unixTime, estimate.adcTime,
+            (unsigned long long) estimate.endSampleIndex, estimate.first + 1, estimate.second + 1,
+            estimate.delay * 1e3, estimate.peak);
+}
@@ -0,0 +1,38 @@
+/**
+ * DSP graph sink exporting time delay estimates as CSV, one line per pair of frames of every pair of channels:
+ *    unix_time,adc_time,end_sample,first,second,delay_ms,peak
+ * where first and second number the inputs from 1 and end_sample counts samples of the first.
+ */
+
+#ifndef OPENGL_SPECTROGRAM_DELAYCSVWRITER_HPP
+#define OPENGL_SPECTROGRAM_DELAYCSVWRITER_HPP
+
+#include <stdio.h>
+#include <string>
+#include "DelayEstimator.hpp"
+#include "DspGraph.hpp"
+
+class DelayCsvWriter : public DspSink<DelayEstimate> {
+public:
+  /**
+   * Creates the file and writes the header line. Throws 99 on failure.
+   * @param path path of the CSV file.
+   */
+  DelayCsvWriter(const std::string& path);
+
+  DelayCsvWriter(const DelayCsvWriter&) = delete;
+  DelayCsvWriter& operator=(const DelayCsvWriter&) = delete;
+
+  /**
+   * Flushes and closes the file.
+   */
+  ~DelayCsvWriter();
+
+protected:
+  virtual void consume(const DelayEstimate& estimate);
+
+private:
+  FILE* file;
+};
+
+#endif /* OPENGL_SPECTROGRAM_DELAYCSVWRITER_HPP */
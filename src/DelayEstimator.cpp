@@ -0,0 +1,130 @@
+#include "DelayEstimator.hpp"
+#include <algorithm>
+#include <math.h>
+#include <time.h>
+#include "FftPlanCache.hpp"
+#include "Log.hpp"
+#include "Trace.hpp"
+
+/* static member declarations and initializations */
+const unsigned int DelayEstimate::CURVE_POINTS;
+
+/* added to the cross-spectrum magnitude before whitening, so that empty bins stay empty */
+static const float PHAT_EPSILON = 1e-12f;
+
+DelayEstimator::DelayEstimator(unsigned int first, unsigned int second, double maxDelay, unsigned int fftLength)
+  : DspStage<ChannelSpectrum, DelayEstimate>("delay estimator"), first(first), second(second), maxDelay(maxDelay),
+    hasShown(false)
+{
+    pending[0] = pending[1] = false;
+    crossSpectrum = fftwf_alloc_real(ChannelSpectrum::MAX_LENGTH);
+    correlation = fftwf_alloc_real(ChannelSpectrum::MAX_LENGTH);
+    FftPlanCache::getInstance()->hc2r(fftLength);
+    FftPlanCache::getInstance()->hc2r(fftLength / 2);
+    Log::getInstance()->logger() << "Estimating the delay of input " << first + 1 << " behind input " << second + 1
+                                 << " up to " << maxDelay * 1e3 << " ms" << std::endl;
+}
+
+DelayEstimator::~DelayEstimator()
+{
+    fftwf_free(crossSpectrum);
+    fftwf_free(correlation);
+}
+
+bool DelayEstimator::getLatest(DelayEstimate& estimate) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (hasShown) estimate = shown;
+    return hasShown;
+}
+
+unsigned int DelayEstimator::getFirst() const
+{
+    return first;
+}
+
+unsigned int DelayEstimator::getSecond() const
+{
+    return second;
+}
+
+double DelayEstimator::getMaxDelay() const
+{
+    return maxDelay;
+}
+
+bool DelayEstimator::process(const ChannelSpectrum& spectrum, DelayEstimate& estimate)
+{
+    if (spectrum.channel != first && spectrum.channel != second) return false;
+    unsigned int c = spectrum.channel == first ? 0 : 1;
+    latest[c] = spectrum;
+    pending[c] = true;
+
+    const ChannelSpectrum& a = latest[0];
+    const ChannelSpectrum& b = latest[1];
+    if (!pending[0] || !pending[1]) return false;
+    if (a.length != b.length || a.samplingRate != b.samplingRate) return false;
+    if (fabs(a.adcTime - b.adcTime) >= a.length / 4.0 / a.samplingRate) return false;
+    pending[0] = pending[1] = false;
+    correlate(estimate);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    shown = estimate;
+    hasShown = true;
+    return true;
+}
+
+void DelayEstimator::correlate(DelayEstimate& estimate)
+{
+    TraceScope traceScope("delay estimator");
+    const ChannelSpectrum& a = latest[0];
+    const ChannelSpectrum& b = latest[1];
+    int n = (int) a.length;
+    double fs = a.samplingRate;
+
+    /* whitened cross-spectrum A conj(B) in half-complex order; DC and Nyquist are real */
+    crossSpectrum[0] = a.halfComplex[0] * b.halfComplex[0] >= 0.0f ? 1.0f : -1.0f;
+    crossSpectrum[n / 2] = a.halfComplex[n / 2] * b.halfComplex[n / 2] >= 0.0f ? 1.0f : -1.0f;
+    for (int k = 1; k < n / 2; ++k) {
+        float ar = a.halfComplex[k], ai = a.halfComplex[n - k];
+        float br = b.halfComplex[k], bi = b.halfComplex[n - k];
+        float re = ar * br + ai * bi;
+        float im = ai * br - ar * bi;
+        float weight = 1.0f / (sqrtf(re * re + im * im) + PHAT_EPSILON);
+        crossSpectrum[k] = re * weight;
+        crossSpectrum[n - k] = im * weight;
+    }
+    fftwf_execute_r2r(FftPlanCache::getInstance()->hc2r(n), crossSpectrum, correlation);
+
+    /* lag m of the correlation, circular, normalized so that a pure delay peaks at 1 */
+    auto at = [&](int m) {
+        return correlation[((m % n) + n) % n] / n;
+    };
+
+    /* the frames end (ta - tb) apart, so a delay d shows at lag (d - (ta - tb)) fs */
+    double offset = a.adcTime - b.adcTime;
+    int lowest = std::max(-(n / 2 - 1), (int) floor((-maxDelay - offset) * fs));
+    int highest = std::min(n / 2 - 1, (int) ceil((maxDelay - offset) * fs));
+    int best = lowest;
+    for (int m = lowest + 1; m <= highest; ++m) {
+        if (at(m) > at(best)) best = m;
+    }
+    float left = at(best - 1), peak = at(best), right = at(best + 1);
+    float curvature = left - 2.0f * peak + right;
+    double refined = best + (curvature < 0.0f ? 0.5 * (left - right) / curvature : 0.0);
+
+    timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    estimate.endSampleIndex = a.endSampleIndex;
+    estimate.adcTime = a.adcTime;
+    estimate.unixTime = now.tv_sec + now.tv_nsec * 1e-9;
+    estimate.first = first;
+    estimate.second = second;
+    estimate.delay = refined / fs + offset;
+    estimate.peak = peak;
+    for (unsigned int i = 0; i < DelayEstimate::CURVE_POINTS; ++i) {
+        double delay = maxDelay * (2.0 * i / (DelayEstimate::CURVE_POINTS - 1) - 1.0);
+        int m = (int) lround((delay - offset) * fs);
+        estimate.correlation[i] = std::abs(m) < n / 2 ? at(m) : 0.0f;
+    }
+}
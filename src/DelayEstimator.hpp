@@ -0,0 +1,109 @@
+/**
+ * Time delay between two channels by the generalized cross-correlation with phase transform (GCC-PHAT). It reuses the
+ * FFT of every frame of both channels: the cross-spectrum A conj(B) is whitened to unit magnitude, so that every
+ * frequency votes equally and the correlation peaks sharply even for coloured or reverberant sound, and one inverse
+ * FFT turns it into the correlation of the frames. The peak within the searched range, refined by a parabola through
+ * its neighbours, gives the delay.
+ *
+ * The channels are separate inputs with their own sample clocks, so frames are paired by their ADC times: a frame is
+ * matched with the latest frame of the other channel if they end less than a quarter frame apart, and the difference
+ * of their end times is added to the measured lag. A positive delay means the sound reaches the first channel later.
+ *
+ * Every pair of channels is a stage of its own, so the pairs are spread over the DSP thread pool.
+ */
+
+#ifndef OPENGL_SPECTROGRAM_DELAYESTIMATOR_HPP
+#define OPENGL_SPECTROGRAM_DELAYESTIMATOR_HPP
+
+#include <mutex>
+#include <stdint.h>
+#include <fftw3.h>
+#include "ChannelSpectrumTap.hpp"
+#include "DspGraph.hpp"
+
+/**
+ * Delay between two channels at one pair of frames.
+ */
+struct DelayEstimate {
+  /**
+   * Lags at which correlation[] samples the correlation, evenly spanning the searched range.
+   */
+  static const unsigned int CURVE_POINTS = 65;
+
+  /**
+   * End sample and ADC time of the frame of the first channel.
+   */
+  uint64_t endSampleIndex;
+  double adcTime;
+  double unixTime;
+  unsigned int first;
+  unsigned int second;
+
+  /**
+   * Delay of the first channel behind the second in seconds, and the height of the correlation peak, 1 for
+   * channels that differ only by the delay.
+   */
+  double delay;
+  float peak;
+
+  /**
+   * Correlation from -maxDelay to +maxDelay.
+   */
+  float correlation[CURVE_POINTS];
+};
+
+class DelayEstimator : public DspStage<ChannelSpectrum, DelayEstimate> {
+public:
+  /**
+   * @param first index of the first channel.
+   * @param second index of the second channel.
+   * @param maxDelay largest delay searched, in seconds.
+   * @param fftLength FFT length of the channels. The inverse is planned up front for it and for the halved length
+   * used while the DSP is degraded, so that no planning happens on a pool thread.
+   */
+  DelayEstimator(unsigned int first, unsigned int second, double maxDelay, unsigned int fftLength);
+
+  DelayEstimator(const DelayEstimator&) = delete;
+  DelayEstimator& operator=(const DelayEstimator&) = delete;
+
+  ~DelayEstimator();
+
+  /**
+   * Latest estimate, for display. Safe to call from any thread.
+   * @param estimate receives the estimate.
+   * @return false if there has been none yet.
+   */
+  bool getLatest(DelayEstimate& estimate) const;
+
+  unsigned int getFirst() const;
+  unsigned int getSecond() const;
+  double getMaxDelay() const;
+
+protected:
+  virtual bool process(const ChannelSpectrum& spectrum, DelayEstimate& estimate);
+
+private:
+  /**
+   * Correlates the latest frames of both channels into an estimate.
+   */
+  void correlate(DelayEstimate& estimate);
+
+  unsigned int first;
+  unsigned int second;
+  double maxDelay;
+
+  /**
+   * Latest unmatched frame of each channel, if pending.
+   */
+  ChannelSpectrum latest[2];
+  bool pending[2];
+
+  float* crossSpectrum;
+  float* correlation;
+
+  mutable std::mutex mutex;
+  DelayEstimate shown;
+  bool hasShown;
+};
+
+#endif /* OPENGL_SPECTROGRAM_DELAYESTIMATOR_HPP */
@@ -3,10 +3,15 @@
 //
 
 #include "Display.hpp"
+#include <math.h>
+#include <unistd.h>
 
 /* static member initializations */
 const char* const Display::TITLE = "OpenGL Spectrum Visualization";
 std::vector<GraphicsItem*> Display::graphicsItems;
+uint64_t Display::lastRedisplayNs = 0;
+int Display::windowSize[2] = {1280, 768};
+int Display::mouseItem = -1;
 
 Display::Display(int argc, char** argv, int screenMode)
 {
@@ -30,6 +35,7 @@ Display::Display(int argc, char** argv, int screenMode)
   glutMouseFunc(Display::mouse);
   glutMotionFunc(Display::motion);
   glutIdleFunc(Display::idle);
+  Trace::getInstance()->setThreadName("render");
 
   this->screenMode = screenMode;
 }
@@ -68,50 +74,129 @@ void Display::smallText(float x, float y, char* string)
 void Display::display()
 {
   glClear(GL_COLOR_BUFFER_BIT); // no depth buffer
-  glMatrixMode(GL_PROJECTION);
-  glLoadIdentity();
-  glOrtho(0, 1, 0, 1, -1, 1);  // l r b t n f
-  glMatrixMode(GL_MODELVIEW);
-  glLoadIdentity();
-  std::for_each(graphicsItems.begin(), graphicsItems.end(), [&](auto item) { item->display(); });
-  glFinish();   // wait for all gl commands to complete
-  glutSwapBuffers(); // for this to WAIT for vSync, need enable in NVIDIA OpenGL
+  glEnable(GL_SCISSOR_TEST);  // keep every observer, and its glDrawPixels, inside its tile
+  for (unsigned int i = 0; i < graphicsItems.size(); ++i) {
+    TraceScope traceScope("observer display");
+    int viewport[4];
+    tile(i, viewport);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    glScissor(viewport[0], viewport[1], viewport[2], viewport[3]);
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    glOrtho(0, 1, 0, 1, -1, 1);  // l r b t n f
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+    graphicsItems[i]->display();
+  }
+  glDisable(GL_SCISSOR_TEST);
+  glViewport(0, 0, windowSize[0], windowSize[1]);
+  {
+    TraceScope traceScope("swap");
+    glFinish();   // wait for all gl commands to complete
+    glutSwapBuffers(); // for this to WAIT for vSync, need enable in NVIDIA OpenGL
+  }
+  std::for_each(graphicsItems.begin(), graphicsItems.end(), [&](auto item) { item->swapped(); });
 }
 
 void Display::idle(void)
 {
+  Trace::getInstance()->flushIfRequested();
   std::for_each(graphicsItems.begin(), graphicsItems.end(), [&](auto item) { item->idle(); });
+
+  /* skip vSyncs if any observer asks for a lower frame rate */
+  unsigned int interval = 1;
+  std::for_each(graphicsItems.begin(), graphicsItems.end(), [&](auto item) {
+    interval = std::max(interval, item->frameInterval());
+  });
+  uint64_t now = Trace::now();
+  if (interval > 1 && now - lastRedisplayNs < (uint64_t) ((interval - 0.5f) / FPS * 1e9f)) {
+    usleep(1000);
+    return;
+  }
+  lastRedisplayNs = now;
   glutPostRedisplay();  /* trigger GLUT display function */
 }
 
 void Display::keyboard(unsigned char key, int xPos, int yPos)
 {
-  std::for_each(graphicsItems.begin(), graphicsItems.end(), [&](auto item) { item->keyboard(key, xPos, yPos); });
+  int item = itemAt(xPos, yPos);
+  if (item >= 0) graphicsItems[item]->keyboard(key, xPos, yPos);
 }
 
 void Display::special(int key, int xPos, int yPos)
 {
-  std::for_each(graphicsItems.begin(), graphicsItems.end(), [&](auto item) { item->special(key, xPos, yPos); });
+  int item = itemAt(xPos, yPos);
+  if (item >= 0) graphicsItems[item]->special(key, xPos, yPos);
 }
 
 void Display::reshape(int w, int h)
 {
   Log::getInstance()->logger() << "Setting w=" << w << ", h=" << h << std::endl;
-  std::for_each(graphicsItems.begin(), graphicsItems.end(), [&](auto item) { item->reshape(w, h); });
+  windowSize[0] = w;
+  windowSize[1] = h;
+  for (unsigned int i = 0; i < graphicsItems.size(); ++i) {
+    int viewport[4];
+    tile(i, viewport);
+    graphicsItems[i]->reshape(viewport[2], viewport[3]);
+  }
   glViewport(0, 0, w, h);
 }
 
 void Display::mouse(int button, int state, int x, int y)
 {
-  std::for_each(graphicsItems.begin(), graphicsItems.end(), [&](auto item) { item->mouse(button, state, x, y); });
+  /* a drag belongs to the tile it started in */
+  if (state == GLUT_DOWN) {
+    int tileX = x, tileY = y;
+    mouseItem = itemAt(tileX, tileY);
+  }
+  if (mouseItem < 0) return;
+  int viewport[4];
+  tile(mouseItem, viewport);
+  graphicsItems[mouseItem]->mouse(button, state, x - viewport[0], y - (windowSize[1] - viewport[1] - viewport[3]));
 }
 
 void Display::motion(int x, int y)
 {
-  std::for_each(graphicsItems.begin(), graphicsItems.end(), [&](auto item) { item->motion(x, y); });
+  if (mouseItem < 0) return;
+  int viewport[4];
+  tile(mouseItem, viewport);
+  graphicsItems[mouseItem]->motion(x - viewport[0], y - (windowSize[1] - viewport[1] - viewport[3]));
 }
 
 void Display::addGraphicsItem(GraphicsItem* const newItem)
 {
   graphicsItems.push_back(newItem);
 }
+
+void Display::quit()
+{
+  std::for_each(graphicsItems.begin(), graphicsItems.end(), [&](auto item) { item->quit(); });
+  exit(0);
+}
+
+void Display::tile(unsigned int item, int* viewport)
+{
+  unsigned int n = std::max<size_t>(1, graphicsItems.size());
+  unsigned int columns = (unsigned int) ceil(sqrt((double) n));
+  unsigned int rows = (n + columns - 1) / columns;
+  int width = windowSize[0] / (int) columns, height = windowSize[1] / (int) rows;
+  viewport[0] = (int) (item % columns) * width;
+  viewport[1] = windowSize[1] - (int) (item / columns + 1) * height;
+  viewport[2] = width;
+  viewport[3] = height;
+}
+
+int Display::itemAt(int& x, int& y)
+{
+  if (graphicsItems.empty()) return -1;
+  unsigned int n = graphicsItems.size();
+  unsigned int columns = (unsigned int) ceil(sqrt((double) n));
+  unsigned int rows = (n + columns - 1) / columns;
+  int width = std::max(1, windowSize[0] / (int) columns), height = std::max(1, windowSize[1] / (int) rows);
+  int column = std::max(0, std::min((int) columns - 1, x / width));
+  int row = std::max(0, std::min((int) rows - 1, y / height));
+  int item = std::min((int) n - 1, row * (int) columns + column);
+  x -= column * width;
+  y -= row * height;
+  return item;
+}
@@ -1,5 +1,7 @@
 /**
  * Handles interaction with OpenGL and displaying additional content on the GUI canvas.
+ * Several GraphicsItem observers are tiled in a grid, each drawing into its own viewport as if it had the whole
+ * window; mouse and keyboard input goes to the tile under the pointer.
  * @author Anthony Agnone, Aug 2016
  */
 
@@ -11,6 +13,7 @@
 #include "common.h"
 #include "AudioInput.hpp"
 #include "GraphicsItem.hpp"
+#include "Trace.hpp"
 
 /* forward declarations */
 class SpectrogramVisualizer;
@@ -49,13 +52,15 @@ public:
   static void smallText(float x, float y, char* string);
 
   /**
-   * Loops through all observers and instructs them to display their content.
+   * Loops through all observers and instructs them to display their content in their tiles, then notifies them once
+   * the frame has been swapped to the screen.
    * Follows the observer design pattern.
    */
   static void display();
 
   /**
    * Called by OpenGL during an idling period, and calls idle() on all of its observers.
+   * Redisplay is triggered at most as often as the largest frameInterval() of the observers allows.
    * Follows the observer design pattern.
    */
   static void idle(void);
@@ -77,7 +82,7 @@ public:
   static void special(int key, int xPos, int yPos);
 
   /**
-   * Responds to a reshaping of the main window, reshaping all of its constituent plots and text.
+   * Responds to a reshaping of the main window, reshaping all observers to their tile size.
    * @param w new width of the main window.
    * @param h new height of the main window.
    */
@@ -100,18 +105,54 @@ public:
   static void motion(int x, int y);
 
   /**
-   * Adds a new GraphicsItem instance to the list of observers.
+   * Adds a new GraphicsItem instance to the list of observers, in the next tile of the grid.
    * Follows the observer design pattern.
    * @param newItem new instance of GraphicsItem to act as an observer.
    */
   void addGraphicsItem(GraphicsItem* const newItem);
 
+  /**
+   * Quits all observers, then exits the process.
+   */
+  static void quit();
+
 private:
+  /**
+   * Computes the viewport of an observer's tile. The grid has ceil(sqrt(n)) columns and as many rows as needed,
+   * filled left to right and top to bottom.
+   * @param item index of the observer.
+   * @param viewport receives x, y, width and height of the tile in window pixels, y counted from the bottom.
+   */
+  static void tile(unsigned int item, int* viewport);
+
+  /**
+   * Finds the observer whose tile contains a point, and converts the point to tile coordinates.
+   * @param x coordinate x in window pixels, counted from the left, updated to tile pixels.
+   * @param y coordinate y in window pixels, counted from the top, updated to tile pixels.
+   * @return index of the observer, or -1 if there are none.
+   */
+  static int itemAt(int& x, int& y);
+
+  /**
+   * Width and height of the main window.
+   */
+  static int windowSize[2];
+
+  /**
+   * Index of the observer which received the last mouse button press, which also receives the following motion.
+   */
+  static int mouseItem;
+
   /**
    * A list of GraphicsItem instances to notify on each OpenGL callback, implementing the Observer design pattern.
    */
   static std::vector<GraphicsItem*> graphicsItems;
 
+  /**
+   * Time of the most recently triggered redisplay, from Trace::now().
+   */
+  static uint64_t lastRedisplayNs;
+
   /**
    * Title string for the GUI window.
    */
@@ -0,0 +1,187 @@
+#include "DspGraph.hpp"
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include "DspThreadPool.hpp"
+#include "Log.hpp"
+#include "Trace.hpp"
+
+DspEdgeBase::DspEdgeBase(const char* name, Policy policy, DspStageBase* consumer)
+  : name(name), policy(policy), consumer(consumer), pushed(0), popped(0), dropped(0), coalesced(0), blocked(0),
+    highWater(0), stopping(false)
+{
+}
+
+const char* DspEdgeBase::getName() const
+{
+    return name;
+}
+
+DspEdgeBase::Policy DspEdgeBase::getPolicy() const
+{
+    return policy;
+}
+
+unsigned long DspEdgeBase::getPushed() const
+{
+    return pushed;
+}
+
+unsigned long DspEdgeBase::getPopped() const
+{
+    return popped;
+}
+
+unsigned long DspEdgeBase::getDropped() const
+{
+    return dropped;
+}
+
+unsigned long DspEdgeBase::getCoalesced() const
+{
+    return coalesced;
+}
+
+unsigned long DspEdgeBase::getBlocked() const
+{
+    return blocked;
+}
+
+size_t DspEdgeBase::getHighWater() const
+{
+    return highWater;
+}
+
+void DspEdgeBase::stop()
+{
+    stopping = true;
+}
+
+void DspEdgeBase::notifyConsumer()
+{
+    consumer->notify();
+}
+
+void DspEdgeBase::recordOccupancy()
+{
+    size_t occupancy = size();
+    size_t high = highWater.load(std::memory_order_relaxed);
+    while (occupancy > high && !highWater.compare_exchange_weak(high, occupancy, std::memory_order_relaxed)) {}
+}
+
+DspStageBase::DspStageBase(const char* name)
+  : name(name), scheduling(POOLED), started(false), stopping(false), scheduled(false)
+{
+    sem_init(&wake, 0, 0);
+}
+
+DspStageBase::~DspStageBase()
+{
+    stop();
+    sem_destroy(&wake);
+}
+
+void DspStageBase::start(Scheduling scheduling, int cpu)
+{
+    this->scheduling = scheduling;
+    stopping = false;
+    if (scheduling == PINNED) {
+        thread = std::thread(&DspStageBase::pinnedLoop, this, cpu);
+    }
+    started = true;
+
+    /* items may have arrived before the stage was started */
+    if (hasInput()) notify();
+}
+
+void DspStageBase::stop()
+{
+    if (!started.exchange(false)) return;
+    stopping = true;
+    if (scheduling == PINNED) {
+        sem_post(&wake);
+        if (thread.joinable()) thread.join();
+    } else {
+        while (scheduled) usleep(1000);
+    }
+}
+
+void DspStageBase::notify()
+{
+    if (!started.load(std::memory_order_acquire)) return;
+    if (scheduling == PINNED) {
+        sem_post(&wake);
+    } else if (!scheduled.exchange(true)) {
+        /* if the pool is full, the items wait for the next push */
+        if (stopping || !DspThreadPool::getInstance()->submit({&DspStageBase::runPooled, this})) scheduled = false;
+    }
+}
+
+const char* DspStageBase::getName() const
+{
+    return name;
+}
+
+void DspStageBase::pinnedLoop(int cpu)
+{
+    Trace::getInstance()->setThreadName(name);
+    if (cpu >= 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(cpu, &cpus);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) != 0) {
+            Log::getInstance()->logger() << "Could not pin " << name << " to CPU " << cpu << std::endl;
+        }
+    }
+    while (!stopping) {
+        while (sem_wait(&wake) != 0 && errno == EINTR) {}
+        while (!stopping && step()) {}
+    }
+}
+
+void DspStageBase::runPooled(void* argument)
+{
+    DspStageBase* stage = (DspStageBase*) argument;
+    TraceScope traceScope(stage->name);
+    do {
+        while (!stage->stopping && stage->step()) {}
+        stage->scheduled = false;
+        /* an item pushed after the last step saw the task still scheduled, so pick it up here */
+    } while (!stage->stopping && stage->hasInput() && !stage->scheduled.exchange(true));
+}
+
+DspGraph::DspGraph()
+  : running(false)
+{
+}
+
+DspGraph::~DspGraph()
+{
+    stop();
+}
+
+void DspGraph::start()
+{
+    for (size_t i = 0; i < stages.size(); ++i) stages[i]->start(schedulings[i], cpus[i]);
+    running = true;
+}
+
+void DspGraph::stop()
+{
+    if (!running) return;
+    for (std::unique_ptr<DspEdgeBase>& edge : edges) edge->stop();
+    for (std::unique_ptr<DspStageBase>& stage : stages) stage->stop();
+    running = false;
+}
+
+void DspGraph::describe(std::string& text) const
+{
+    text.clear();
+    char edgeText[160];
+    for (const std::unique_ptr<DspEdgeBase>& edge : edges) {
+        snprintf(edgeText, sizeof(edgeText), "%s%s %zu/%zu max %zu drop %lu coal %lu",
+                 text.empty() ? "" : "  ", edge->getName(), edge->size(), edge->capacity(), edge->getHighWater(),
+                 edge->getDropped(), edge->getCoalesced());
+        text += edgeText;
+    }
+}
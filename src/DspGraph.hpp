@@ -0,0 +1,481 @@
+/**
+ * Small dataflow framework for analyses downstream of the spectrogram: typed stages connected by bounded lock-free
+ * edges, so that a new analysis is added by connecting a stage in main rather than by editing the audio callback.
+ *
+ * Every stage is either pinned, running on its own thread (optionally bound to one CPU), or pooled, running as a task
+ * on the shared DspThreadPool whenever its input edge has items. Every edge has a fixed capacity and a policy for a
+ * full queue:
+ *    BLOCK        the producer waits for room; never use it on an edge fed from an audio or DSP thread.
+ *    DROP_OLDEST  the oldest queued item is discarded to make room.
+ *    COALESCE     the item is merged into a producer-side pending item, which a later push queues once there is
+ *                 room, so no peak is lost and only the time resolution drops. Edges with this policy must have one
+ *                 producer.
+ * Edges count what passes through them, so that a slow stage shows up as an occupied edge with drops.
+ */
+
+#ifndef OPENGL_SPECTROGRAM_DSPGRAPH_HPP
+#define OPENGL_SPECTROGRAM_DSPGRAPH_HPP
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <semaphore.h>
+#include <unistd.h>
+#include "BoundedQueue.hpp"
+
+class DspStageBase;
+
+/**
+ * Untyped part of an edge: policy and occupancy metrics.
+ */
+class DspEdgeBase {
+public:
+  enum Policy {
+    BLOCK,
+    DROP_OLDEST,
+    COALESCE
+  };
+
+  DspEdgeBase(const char* name, Policy policy, DspStageBase* consumer);
+  virtual ~DspEdgeBase() {}
+
+  /**
+   * @return number of queued items.
+   */
+  virtual size_t size() const = 0;
+
+  /**
+   * @return maximum number of queued items.
+   */
+  virtual size_t capacity() const = 0;
+
+  const char* getName() const;
+  Policy getPolicy() const;
+
+  /**
+   * Counters: items queued, items taken by the consumer, items discarded (DROP_OLDEST), items merged into a pending
+   * item (COALESCE), pushes that had to wait (BLOCK), and the largest occupancy seen.
+   */
+  unsigned long getPushed() const;
+  unsigned long getPopped() const;
+  unsigned long getDropped() const;
+  unsigned long getCoalesced() const;
+  unsigned long getBlocked() const;
+  size_t getHighWater() const;
+
+  /**
+   * Makes blocked producers give up, when the graph stops.
+   */
+  void stop();
+
+protected:
+  /**
+   * Wakes the consuming stage after a push.
+   */
+  void notifyConsumer();
+
+  /**
+   * Updates the high water mark after a push.
+   */
+  void recordOccupancy();
+
+  const char* name;
+  Policy policy;
+  DspStageBase* consumer;
+
+  std::atomic<unsigned long> pushed;
+  std::atomic<unsigned long> popped;
+  std::atomic<unsigned long> dropped;
+  std::atomic<unsigned long> coalesced;
+  std::atomic<unsigned long> blocked;
+  std::atomic<size_t> highWater;
+  std::atomic<bool> stopping;
+};
+
+/**
+ * Bounded queue of items of type T between two stages. Pushing never allocates, so with DROP_OLDEST or COALESCE an
+ * edge can be fed from realtime threads.
+ */
+template<typename T>
+class DspEdge : public DspEdgeBase {
+public:
+  /**
+   * Merges a newer item into an older one, e.g. by taking the maximum of two spectra.
+   */
+  typedef void (*Coalesce)(T& into, const T& from);
+
+  /**
+   * @param name static string naming the edge in metrics.
+   * @param capacity maximum number of queued items, rounded up to a power of two.
+   * @param policy what push() does when the queue is full.
+   * @param consumer stage woken after every push.
+   * @param coalesce merge function, required for COALESCE.
+   */
+  DspEdge(const char* name, size_t capacity, Policy policy, DspStageBase* consumer, Coalesce coalesce)
+    : DspEdgeBase(name, policy, consumer), queue(capacity), coalesce(coalesce), hasPending(false)
+  {
+  }
+
+  /**
+   * Queues an item according to the policy.
+   * @param item item to queue.
+   * @return false if the item was not queued by itself: dropped, merged, or given up on while blocking because the
+   * graph stopped.
+   */
+  bool push(const T& item)
+  {
+    if (policy == COALESCE) {
+      /* the pending item goes first, to keep the order */
+      if (hasPending) {
+        if (!queue.push(pending)) {
+          coalesce(pending, item);
+          ++coalesced;
+          return false;
+        }
+        hasPending = false;
+        ++pushed;
+      }
+      if (!queue.push(item)) {
+        pending = item;
+        hasPending = true;
+        notifyConsumer();
+        return false;
+      }
+    } else if (policy == DROP_OLDEST) {
+      T oldest;
+      while (!queue.push(item)) {
+        if (queue.pop(oldest)) ++dropped;
+      }
+    } else {
+      bool waited = false;
+      while (!queue.push(item)) {
+        waited = true;
+        notifyConsumer();
+        if (stopping) return false;
+        usleep(100);
+      }
+      if (waited) ++blocked;
+    }
+    ++pushed;
+    recordOccupancy();
+    notifyConsumer();
+    return true;
+  }
+
+  /**
+   * Takes the oldest item.
+   * @param item receives the item.
+   * @return false if the edge is empty.
+   */
+  bool pop(T& item)
+  {
+    if (!queue.pop(item)) return false;
+    ++popped;
+    return true;
+  }
+
+  virtual size_t size() const
+  {
+    return queue.size();
+  }
+
+  virtual size_t capacity() const
+  {
+    return queue.capacity();
+  }
+
+private:
+  BoundedQueue<T> queue;
+  Coalesce coalesce;
+
+  /**
+   * Item that did not fit in COALESCE mode, owned by the single producer.
+   */
+  T pending;
+  bool hasPending;
+};
+
+/**
+ * Anything that emits items of type T into edges, whether a stage or an outside source such as a SpectrumTap.
+ */
+template<typename T>
+class DspProducer {
+public:
+  virtual ~DspProducer() {}
+
+  /**
+   * Adds an edge that receives every emitted item. Must not be called while producing.
+   */
+  void addOutput(DspEdge<T>* edge)
+  {
+    outputs.push_back(edge);
+  }
+
+protected:
+  /**
+   * Pushes an item into all output edges.
+   */
+  void emit(const T& item)
+  {
+    for (DspEdge<T>* edge : outputs) edge->push(item);
+  }
+
+  std::vector<DspEdge<T>*> outputs;
+};
+
+/**
+ * Untyped part of a stage: how and where it runs.
+ */
+class DspStageBase {
+public:
+  enum Scheduling {
+    PINNED,
+    POOLED
+  };
+
+  /**
+   * @param name static string naming the stage in traces.
+   */
+  DspStageBase(const char* name);
+
+  DspStageBase(const DspStageBase&) = delete;
+  DspStageBase& operator=(const DspStageBase&) = delete;
+
+  virtual ~DspStageBase();
+
+  /**
+   * Processes at most one queued input item.
+   * @return false if there was nothing to process.
+   */
+  virtual bool step() = 0;
+
+  /**
+   * @return whether input items are queued.
+   */
+  virtual bool hasInput() const = 0;
+
+  /**
+   * Starts running the stage. Pinned stages get a thread, bound to a CPU if cpu >= 0.
+   */
+  void start(Scheduling scheduling, int cpu);
+
+  /**
+   * Stops the thread of a pinned stage, or waits until a pooled stage is idle.
+   */
+  void stop();
+
+  /**
+   * Called by the input edge after every push: wakes the thread of a pinned stage, or queues a task for a pooled
+   * stage unless one is queued already. Realtime safe.
+   */
+  void notify();
+
+  const char* getName() const;
+
+protected:
+  /**
+   * @return whether stop() was called, for stages that wait on something else than their input.
+   */
+  bool isStopping() const
+  {
+    return stopping;
+  }
+
+private:
+  /**
+   * Body of the thread of a pinned stage.
+   */
+  void pinnedLoop(int cpu);
+
+  /**
+   * DSP thread pool task running a pooled stage until its input is empty.
+   * @param stage the DspStageBase instance.
+   */
+  static void runPooled(void* stage);
+
+  const char* name;
+  Scheduling scheduling;
+  std::atomic<bool> started;
+  std::atomic<bool> stopping;
+
+  /**
+   * Pinned: counts pushes to wake the thread. Pooled: whether a task is queued or running.
+   */
+  sem_t wake;
+  std::thread thread;
+  std::atomic<bool> scheduled;
+};
+
+/**
+ * Stage that transforms items of type In from its input edge into items of type Out for its output edges.
+ */
+template<typename In, typename Out>
+class DspStage : public DspStageBase, public DspProducer<Out> {
+public:
+  DspStage(const char* name)
+    : DspStageBase(name), input(nullptr)
+  {
+  }
+
+  void setInput(DspEdge<In>* edge)
+  {
+    input = edge;
+  }
+
+  virtual bool step()
+  {
+    if (!input || !input->pop(in)) return false;
+    if (process(in, out)) this->emit(out);
+    return true;
+  }
+
+  virtual bool hasInput() const
+  {
+    return input && input->size() > 0;
+  }
+
+protected:
+  /**
+   * Transforms one item.
+   * @param in input item.
+   * @param out output item, reused between calls.
+   * @return whether out should be emitted.
+   */
+  virtual bool process(const In& in, Out& out) = 0;
+
+private:
+  DspEdge<In>* input;
+
+  /**
+   * Items of the stage, kept as members since spectra are too large for the stacks of some threads.
+   */
+  In in;
+  Out out;
+};
+
+/**
+ * Stage that consumes items of type In, e.g. to store or export them.
+ */
+template<typename In>
+class DspSink : public DspStageBase {
+public:
+  DspSink(const char* name)
+    : DspStageBase(name), input(nullptr)
+  {
+  }
+
+  void setInput(DspEdge<In>* edge)
+  {
+    input = edge;
+  }
+
+  virtual bool step()
+  {
+    if (!input || !input->pop(in)) return false;
+    consume(in);
+    return true;
+  }
+
+  virtual bool hasInput() const
+  {
+    return input && input->size() > 0;
+  }
+
+protected:
+  /**
+   * Consumes one item.
+   */
+  virtual void consume(const In& in) = 0;
+
+  /**
+   * @return the input edge, e.g. to report its drops downstream.
+   */
+  const DspEdge<In>* getInput() const
+  {
+    return input;
+  }
+
+private:
+  DspEdge<In>* input;
+  In in;
+};
+
+/**
+ * Owns the stages and edges of a dataflow graph, and starts and stops them together.
+ */
+class DspGraph {
+public:
+  DspGraph();
+
+  DspGraph(const DspGraph&) = delete;
+  DspGraph& operator=(const DspGraph&) = delete;
+
+  /**
+   * Stops all stages.
+   */
+  ~DspGraph();
+
+  /**
+   * Adds a stage to the graph, which takes ownership of it. It runs once the graph is started.
+   * @param stage the stage.
+   * @param scheduling whether the stage gets its own thread or runs on the DSP thread pool.
+   * @param cpu CPU to bind a pinned stage to, or -1 for any.
+   * @return the stage.
+   */
+  template<typename Stage>
+  Stage* add(Stage* stage, DspStageBase::Scheduling scheduling, int cpu = -1)
+  {
+    stages.emplace_back(stage);
+    schedulings.push_back(scheduling);
+    cpus.push_back(cpu);
+    return stage;
+  }
+
+  /**
+   * Connects a producer to a stage or sink with a new edge, owned by the graph. Must be called before start().
+   * @param from producer of the items.
+   * @param to consuming stage or sink, which must not have another input.
+   * @param name static string naming the edge in metrics.
+   * @param capacity maximum number of queued items.
+   * @param policy what happens when the edge is full.
+   * @param coalesce merge function, required for COALESCE.
+   * @return the edge.
+   */
+  template<typename T, typename Consumer>
+  DspEdge<T>* connect(DspProducer<T>* from, Consumer* to, const char* name, size_t capacity,
+                      DspEdgeBase::Policy policy, typename DspEdge<T>::Coalesce coalesce = nullptr)
+  {
+    DspEdge<T>* edge = new DspEdge<T>(name, capacity, policy, to, coalesce);
+    edges.emplace_back(edge);
+    to->setInput(edge);
+    from->addOutput(edge);
+    return edge;
+  }
+
+  /**
+   * Starts all stages.
+   */
+  void start();
+
+  /**
+   * Stops all stages; items still queued are not processed.
+   */
+  void stop();
+
+  /**
+   * Formats the occupancy of every edge on one line, e.g. "history 3/64 max 64 drop 0 coal 12".
+   * @param text receives the description.
+   */
+  void describe(std::string& text) const;
+
+private:
+  std::vector<std::unique_ptr<DspStageBase>> stages;
+  std::vector<DspStageBase::Scheduling> schedulings;
+  std::vector<int> cpus;
+  std::vector<std::unique_ptr<DspEdgeBase>> edges;
+  bool running;
+};
+
+#endif /* OPENGL_SPECTROGRAM_DSPGRAPH_HPP */
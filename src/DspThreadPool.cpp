@@ -0,0 +1,85 @@
+#include "DspThreadPool.hpp"
+#include <algorithm>
+#include <errno.h>
+#include "Log.hpp"
+#include "Trace.hpp"
+
+/* static member declarations and initializations */
+const unsigned int DspThreadPool::TASKS_PER_WORKER = 256;
+DspThreadPool* DspThreadPool::instance;
+
+DspThreadPool* DspThreadPool::getInstance()
+{
+    if (!instance) {
+        DspThreadPool::instance = new DspThreadPool();
+    }
+    return DspThreadPool::instance;
+}
+
+DspThreadPool::DspThreadPool()
+  : nextQueue(0), stolenTasks(0), stopping(false)
+{
+    unsigned int nWorkers = std::max(1u, std::thread::hardware_concurrency());
+    sem_init(&pending, 0, 0);
+    for (unsigned int i = 0; i < nWorkers; ++i) {
+        queues.emplace_back(new BoundedQueue<Task>(TASKS_PER_WORKER));
+    }
+    for (unsigned int i = 0; i < nWorkers; ++i) {
+        workers.emplace_back(&DspThreadPool::workerLoop, this, i);
+    }
+    Log::getInstance()->logger() << "Started " << nWorkers << " DSP workers." << std::endl;
+}
+
+bool DspThreadPool::submit(const Task& task)
+{
+    if (stopping.load(std::memory_order_relaxed)) return false;
+    unsigned int n = (unsigned int) queues.size();
+    unsigned int first = nextQueue.fetch_add(1, std::memory_order_relaxed) % n;
+    for (unsigned int i = 0; i < n; ++i) {
+        if (queues[(first + i) % n]->push(task)) {
+            sem_post(&pending);
+            return true;
+        }
+    }
+    return false;
+}
+
+void DspThreadPool::stop()
+{
+    if (stopping.exchange(true)) return;
+    for (size_t i = 0; i < workers.size(); ++i) sem_post(&pending);
+    for (std::thread& worker : workers) worker.join();
+}
+
+void DspThreadPool::workerLoop(unsigned int worker)
+{
+    Trace::getInstance()->setThreadName("dsp worker");
+    unsigned int n = (unsigned int) queues.size();
+    Task task;
+    while (true) {
+        while (sem_wait(&pending) != 0 && errno == EINTR) {}
+        if (stopping) break;
+
+        /* every post follows a completed push, so some queue holds a task for this wakeup: own queue first, then
+         * steal from the others */
+        for (unsigned int attempt = 0;; ++attempt) {
+            unsigned int q = (worker + attempt) % n;
+            if (queues[q]->pop(task)) {
+                if (q != worker) ++stolenTasks;
+                break;
+            }
+            if (q == (worker + n - 1) % n) std::this_thread::yield();
+        }
+        task.function(task.argument);
+    }
+}
+
+unsigned int DspThreadPool::getNWorkers() const
+{
+    return (unsigned int) workers.size();
+}
+
+unsigned long DspThreadPool::getStolenTasks() const
+{
+    return stolenTasks;
+}
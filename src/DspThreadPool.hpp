@@ -0,0 +1,92 @@
+/**
+ * Process-wide pool of DSP worker threads shared by all audio sources, sized to the number of cores.
+ *
+ * Every worker owns a lock-free task queue. Submitted tasks are spread over the queues round-robin, and a worker whose
+ * own queue is empty steals from the others, so a burst of blocks from a few busy streams still keeps every core
+ * busy. Submitting never locks or allocates, so tasks can be submitted from audio callbacks.
+ */
+
+#ifndef OPENGL_SPECTROGRAM_DSPTHREADPOOL_HPP
+#define OPENGL_SPECTROGRAM_DSPTHREADPOOL_HPP
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <semaphore.h>
+#include "BoundedQueue.hpp"
+
+class DspThreadPool {
+public:
+  /**
+   * Unit of work: a function and its argument, so that submitting a task does not allocate.
+   */
+  struct Task {
+    void (*function)(void*);
+    void* argument;
+  };
+
+  /**
+   * Capacity of the task queue of every worker.
+   */
+  static const unsigned int TASKS_PER_WORKER;
+
+  /**
+   * Accessor method for the singleton instance of the class, following Log::getInstance(). The workers are started
+   * on the first call.
+   * @return the process-wide DspThreadPool instance.
+   */
+  static DspThreadPool* getInstance();
+
+  DspThreadPool(const DspThreadPool&) = delete;
+  DspThreadPool& operator=(const DspThreadPool&) = delete;
+
+  /**
+   * Queues a task for any worker. Realtime safe.
+   * @param task task to run.
+   * @return false if all queues are full or the pool is stopped, in which case the task is not run.
+   */
+  bool submit(const Task& task);
+
+  /**
+   * Stops and joins the workers after their current task. Tasks still queued are not run.
+   */
+  void stop();
+
+  /**
+   * @return number of worker threads.
+   */
+  unsigned int getNWorkers() const;
+
+  /**
+   * @return number of tasks run by a worker other than the one they were queued to.
+   */
+  unsigned long getStolenTasks() const;
+
+private:
+  /**
+   * Starts one worker per core.
+   */
+  DspThreadPool();
+
+  /**
+   * Body of worker thread number worker.
+   */
+  void workerLoop(unsigned int worker);
+
+  static DspThreadPool* instance;
+
+  std::vector<std::unique_ptr<BoundedQueue<Task>>> queues;
+  std::vector<std::thread> workers;
+
+  /**
+   * Counts queued tasks, so that idle workers sleep instead of spinning.
+   */
+  sem_t pending;
+
+  std::atomic<unsigned int> nextQueue;
+  std::atomic<unsigned long> stolenTasks;
+  std::atomic<bool> stopping;
+};
+
+#endif /* OPENGL_SPECTROGRAM_DSPTHREADPOOL_HPP */
@@ -0,0 +1,76 @@
+#include "FftPlanCache.hpp"
+#include "Log.hpp"
+
+/* static member declarations and initializations */
+FftPlanCache* FftPlanCache::instance;
+
+FftPlanCache* FftPlanCache::getInstance()
+{
+    if (!instance) {
+        FftPlanCache::instance = new FftPlanCache();
+    }
+    return FftPlanCache::instance;
+}
+
+FftPlanCache::FftPlanCache()
+{
+}
+
+fftwf_plan FftPlanCache::r2hc(unsigned int length)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = r2hcPlans.find(length);
+    if (found != r2hcPlans.end()) return found->second;
+
+    /* FFTW_MEASURE overwrites the arrays, so plan on scratch arrays of the alignment used by the callers */
+    float* in = fftwf_alloc_real(length);
+    float* out = fftwf_alloc_real(length);
+    fftwf_plan plan = fftwf_plan_r2r_1d(length, in, out, FFTW_R2HC, FFTW_MEASURE);
+    fftwf_free(in);
+    fftwf_free(out);
+    r2hcPlans[length] = plan;
+    Log::getInstance()->logger() << "Planned a " << length << " point FFT." << std::endl;
+    return plan;
+}
+
+fftwf_plan FftPlanCache::hc2r(unsigned int length)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = hc2rPlans.find(length);
+    if (found != hc2rPlans.end()) return found->second;
+
+    float* in = fftwf_alloc_real(length);
+    float* out = fftwf_alloc_real(length);
+    fftwf_plan plan = fftwf_plan_r2r_1d(length, in, out, FFTW_HC2R, FFTW_MEASURE);
+    fftwf_free(in);
+    fftwf_free(out);
+    hc2rPlans[length] = plan;
+    Log::getInstance()->logger() << "Planned a " << length << " point inverse FFT." << std::endl;
+    return plan;
+}
+
+fftwf_plan FftPlanCache::r2cBatch(unsigned int length, unsigned int count)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::pair<unsigned int, unsigned int> key(length, count);
+    auto found = r2cBatchPlans.find(key);
+    if (found != r2cBatchPlans.end()) return found->second;
+
+    int n = (int) length;
+    int outLength = (int) (length / 2 + 1);
+    float* in = fftwf_alloc_real(count * length);
+    fftwf_complex* out = fftwf_alloc_complex(count * outLength);
+    fftwf_plan plan = fftwf_plan_many_dft_r2c(1, &n, (int) count, in, nullptr, 1, n, out, nullptr, 1, outLength,
+                                              FFTW_MEASURE);
+    fftwf_free(in);
+    fftwf_free(out);
+    r2cBatchPlans[key] = plan;
+    Log::getInstance()->logger() << "Planned a batch of " << count << " " << length << " point FFTs." << std::endl;
+    return plan;
+}
+
+size_t FftPlanCache::size()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return r2hcPlans.size() + hc2rPlans.size() + r2cBatchPlans.size();
+}
@@ -0,0 +1,68 @@
+/**
+ * Process-wide cache of FFTW plans, so that any number of audio sources share one plan per transform instead of each
+ * measuring its own.
+ *
+ * Planning is not thread-safe in FFTW and is serialized here; executing a cached plan is thread-safe, through the
+ * new-array execute functions (e.g. fftwf_execute_r2r()) on arrays allocated with fftwf_alloc_real(), which have the
+ * alignment the plans were made for.
+ */
+
+#ifndef OPENGL_SPECTROGRAM_FFTPLANCACHE_HPP
+#define OPENGL_SPECTROGRAM_FFTPLANCACHE_HPP
+
+#include <map>
+#include <mutex>
+#include <fftw3.h>
+
+class FftPlanCache {
+public:
+  /**
+   * Accessor method for the singleton instance of the class, following Log::getInstance().
+   * @return the process-wide FftPlanCache instance.
+   */
+  static FftPlanCache* getInstance();
+
+  FftPlanCache(const FftPlanCache&) = delete;
+  FftPlanCache& operator=(const FftPlanCache&) = delete;
+
+  /**
+   * Returns the out-of-place real-to-halfcomplex plan of a length, planning it on first use. Not realtime safe.
+   * @param length transform length.
+   * @return the plan, owned by the cache.
+   */
+  fftwf_plan r2hc(unsigned int length);
+
+  /**
+   * Returns the out-of-place halfcomplex-to-real plan of a length, the unnormalized inverse of r2hc(), planning it on
+   * first use. Executing it destroys its input. Not realtime safe.
+   * @param length transform length.
+   * @return the plan, owned by the cache.
+   */
+  fftwf_plan hc2r(unsigned int length);
+
+  /**
+   * Returns the out-of-place real-to-complex plan of a batch of transforms of a length, planning it on first use.
+   * The inputs follow each other in one array, as do the length / 2 + 1 outputs. Not realtime safe.
+   * @param length transform length.
+   * @param count number of transforms per execution.
+   * @return the plan, owned by the cache.
+   */
+  fftwf_plan r2cBatch(unsigned int length, unsigned int count);
+
+  /**
+   * @return number of distinct plans made so far.
+   */
+  size_t size();
+
+private:
+  FftPlanCache();
+
+  static FftPlanCache* instance;
+
+  std::mutex mutex;
+  std::map<unsigned int, fftwf_plan> r2hcPlans;
+  std::map<unsigned int, fftwf_plan> hc2rPlans;
+  std::map<std::pair<unsigned int, unsigned int>, fftwf_plan> r2cBatchPlans;
+};
+
+#endif /* OPENGL_SPECTROGRAM_FFTPLANCACHE_HPP */
@@ -0,0 +1,276 @@
+#include "FlightRecorder.hpp"
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+#include "Log.hpp"
+#include "Trace.hpp"
+
+/* static member declarations and initializations */
+const float FlightRecorder::POST_TRIGGER_SECONDS = 10.0f;
+const float FlightRecorder::DUMPABLE_FRACTION = 0.9f;
+volatile sig_atomic_t FlightRecorder::triggerRequested = 0;
+
+FlightRecorder::FlightRecorder(float minutes, unsigned int samplingRate, unsigned int nFrequencies,
+                               float columnsPerSecond, const std::string& directory)
+  : samplingRate(samplingRate), nFrequencies(nFrequencies), directory(directory),
+    pcmWritten(0), largestBlock(0), columnsWritten(0), triggerSample(0), dumping(false), stop(false)
+{
+    pcmCapacity = (uint64_t) (minutes * 60 * samplingRate);
+    columnCapacity = (uint64_t) (minutes * 60 * columnsPerSecond) + 1;
+    pcmBytes = pcmCapacity * sizeof(float);
+    columnBytes = columnCapacity * nFrequencies * sizeof(float);
+    columnInfoBytes = columnCapacity * sizeof(ColumnInfo);
+
+    bool infoHugePages;
+    pcm = (float*) allocate(pcmBytes, pcmHugePages);
+    columns = (float*) allocate(columnBytes, columnHugePages);
+    columnInfo = (ColumnInfo*) allocate(columnInfoBytes, infoHugePages);
+    if (!pcm || !columns || !columnInfo) {
+        Log::getInstance()->logger() << "Could not allocate the flight recorder rings." << std::endl;
+        throw 99;
+    }
+
+    Log::getInstance()->logger() << "Flight recorder: " << minutes << " min, "
+                                 << (pcmBytes + columnBytes + columnInfoBytes) / (1 << 20) << " MiB"
+                                 << (pcmHugePages && columnHugePages ? " in huge pages" : "") << std::endl;
+
+    writer = std::thread(&FlightRecorder::writerLoop, this);
+}
+
+FlightRecorder::~FlightRecorder()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    wakeUp.notify_all();
+    writer.join();
+
+    munmap(pcm, pcmBytes);
+    munmap(columns, columnBytes);
+    munmap(columnInfo, columnInfoBytes);
+}
+
+void* FlightRecorder::allocate(size_t& bytes, bool& hugePages)
+{
+    /* round up to a whole number of 2 MiB huge pages, which munmap requires for huge page mappings */
+    const size_t hugePageSize = 2 << 20;
+    bytes = (bytes + hugePageSize - 1) / hugePageSize * hugePageSize;
+
+    void* p = MAP_FAILED;
+    hugePages = false;
+#ifdef MAP_HUGETLB
+    p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    hugePages = p != MAP_FAILED;
+#endif
+    if (p == MAP_FAILED) {
+        /* no huge pages reserved, fall back to (possibly transparent huge) regular pages */
+        p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) return nullptr;
+#ifdef MADV_HUGEPAGE
+        madvise(p, bytes, MADV_HUGEPAGE);
+#endif
+    }
+
+    /* pre-fault every page */
+    memset(p, 0, bytes);
+    return p;
+}
+
+void FlightRecorder::samplesCaptured(const float* samples, unsigned long numSamples, uint64_t firstSampleIndex,
+                                     double firstAdcTime)
+{
+    (void) firstAdcTime;
+    if (numSamples > largestBlock.load(std::memory_order_relaxed)) {
+        largestBlock.store(numSamples, std::memory_order_relaxed);
+    }
+    uint64_t start = firstSampleIndex % pcmCapacity;
+    unsigned long head = (unsigned long) std::min<uint64_t>(numSamples, pcmCapacity - start);
+    if (samples) {
+        memcpy(pcm + start, samples, head * sizeof(float));
+        memcpy(pcm, samples + head, (numSamples - head) * sizeof(float));
+    } else {
+        memset(pcm + start, 0, head * sizeof(float));
+        memset(pcm, 0, (numSamples - head) * sizeof(float));
+    }
+    pcmWritten.store(firstSampleIndex + numSamples, std::memory_order_release);
+}
+
+void FlightRecorder::sliceComputed(const float* slice, unsigned int nFrequencies, uint64_t endSampleIndex,
+                                   double adcTime)
+{
+    uint64_t n = columnsWritten.load(std::memory_order_relaxed);
+    uint64_t slot = n % columnCapacity;
+    memcpy(columns + slot * this->nFrequencies, slice, std::min(nFrequencies, this->nFrequencies) * sizeof(float));
+    columnInfo[slot] = {adcTime, endSampleIndex};
+    columnsWritten.store(n + 1, std::memory_order_release);
+}
+
+bool FlightRecorder::trigger(const char* reason)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (dumping) {
+            Log::getInstance()->logger() << "Flight recorder busy, ignoring trigger: " << reason << std::endl;
+            return false;
+        }
+        triggerSample = pcmWritten.load(std::memory_order_acquire);
+        dumping = true;
+    }
+    Trace::getInstance()->instant("flight recorder trigger");
+    Log::getInstance()->logger() << "Flight recorder triggered: " << reason << std::endl;
+    wakeUp.notify_all();
+    return true;
+}
+
+void FlightRecorder::requestTrigger(int signum)
+{
+    (void) signum;
+    triggerRequested = 1;
+}
+
+void FlightRecorder::triggerIfRequested()
+{
+    if (triggerRequested) {
+        triggerRequested = 0;
+        trigger("signal");
+    }
+}
+
+bool FlightRecorder::isDumping() const
+{
+    return dumping.load();
+}
+
+void FlightRecorder::writerLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wakeUp.wait(lock, [&] { return stop || dumping.load(); });
+        if (stop) break;
+
+        /* let the post-trigger part of the window arrive, unless capture stops */
+        uint64_t end = triggerSample + (uint64_t) (POST_TRIGGER_SECONDS * samplingRate);
+        wakeUp.wait_for(lock, std::chrono::duration<float>(POST_TRIGGER_SECONDS + 1.0f), [&] {
+            return stop || pcmWritten.load(std::memory_order_acquire) >= end;
+        });
+        end = std::min(end, pcmWritten.load(std::memory_order_acquire));
+        uint64_t dumpable = (uint64_t) (DUMPABLE_FRACTION * pcmCapacity);
+        uint64_t first = end > dumpable ? end - dumpable : 0;
+        lock.unlock();
+
+        char stamp[32];
+        time_t now = time(nullptr);
+        strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", localtime(&now));
+        std::string base = directory + "/flight_" + stamp;
+        uint64_t silenced = 0;
+        uint64_t nSamples = writeWav(base + ".wav", first, end, silenced);
+        uint64_t nColumns = writeColumns(base + ".cols", first, end);
+        std::string lapped = silenced ? " (the first " + std::to_string(silenced)
+                                        + " silenced, capture overwrote them during the copy)" : "";
+        Log::getInstance()->logger() << "Flight recorder wrote " << nSamples << " samples" << lapped << " and "
+                                     << nColumns << " columns to " << base << ".{wav,cols}" << std::endl;
+
+        lock.lock();
+        dumping = false;
+    }
+}
+
+uint64_t FlightRecorder::writeWav(const std::string& path, uint64_t first, uint64_t end, uint64_t& silenced)
+{
+    TraceScope traceScope("flight recorder wav");
+    FILE* out = fopen(path.c_str(), "wb");
+    if (!out) {
+        Log::getInstance()->logger() << "Could not open " << path << std::endl;
+        return 0;
+    }
+
+    /* RIFF header for mono 32-bit float PCM (WAVE_FORMAT_IEEE_FLOAT) */
+    uint32_t dataBytes = (uint32_t) ((end - first) * sizeof(float));
+    uint32_t riffBytes = 36 + dataBytes, fmtBytes = 16, byteRate = samplingRate * sizeof(float);
+    uint16_t format = 3, nChannels = 1, blockAlign = sizeof(float), bitsPerSample = 32;
+    fwrite("RIFF", 1, 4, out);
+    fwrite(&riffBytes, 4, 1, out);
+    fwrite("WAVEfmt ", 1, 8, out);
+    fwrite(&fmtBytes, 4, 1, out);
+    fwrite(&format, 2, 1, out);
+    fwrite(&nChannels, 2, 1, out);
+    fwrite(&samplingRate, 4, 1, out);
+    fwrite(&byteRate, 4, 1, out);
+    fwrite(&blockAlign, 2, 1, out);
+    fwrite(&bitsPerSample, 2, 1, out);
+    fwrite("data", 1, 4, out);
+    fwrite(&dataBytes, 4, 1, out);
+
+    /* copy out in chunks, oldest first, then silence the part of the chunk that capture lapped (or is lapping,
+     * up to one block ahead of pcmWritten) during the copy, as writeColumns() drops lapped columns */
+    const uint64_t chunk = 1 << 16;
+    std::vector<float> buffer(chunk);
+    silenced = 0;
+    for (uint64_t i = first; i < end; i += chunk) {
+        uint64_t n = std::min(chunk, end - i);
+        for (uint64_t j = 0; j < n; ++j) buffer[j] = pcm[(i + j) % pcmCapacity];
+        uint64_t reach = pcmWritten.load(std::memory_order_acquire) + largestBlock.load(std::memory_order_relaxed);
+        if (reach > pcmCapacity && reach - pcmCapacity > i) {
+            uint64_t lapped = std::min(n, reach - pcmCapacity - i);
+            std::fill(buffer.begin(), buffer.begin() + lapped, 0.0f);
+            silenced += lapped;
+        }
+        fwrite(buffer.data(), sizeof(float), n, out);
+    }
+    fclose(out);
+    return end - first;
+}
+
+uint64_t FlightRecorder::writeColumns(const std::string& path, uint64_t first, uint64_t end)
+{
+    TraceScope traceScope("flight recorder columns");
+    FILE* out = fopen(path.c_str(), "wb");
+    if (!out) {
+        Log::getInstance()->logger() << "Could not open " << path << std::endl;
+        return 0;
+    }
+
+    char magic[8] = "AVCOLS1";
+    uint64_t nColumns = 0;
+    fwrite(magic, 1, sizeof(magic), out);
+    fwrite(&nFrequencies, 4, 1, out);
+    fwrite(&samplingRate, 4, 1, out);
+    long countOffset = ftell(out);
+    fwrite(&nColumns, 8, 1, out);
+
+    /* copy out one column at a time, dropping any column that capture reused (or is reusing) during the copy */
+    std::vector<float> bins(nFrequencies);
+    uint64_t written = columnsWritten.load(std::memory_order_acquire);
+    uint64_t oldest = written > columnCapacity ? written - columnCapacity : 0;
+    uint64_t overwritten = 0;
+    for (uint64_t c = oldest; c < written; ++c) {
+        uint64_t slot = c % columnCapacity;
+        ColumnInfo info = columnInfo[slot];
+        if (info.endSampleIndex < first || info.endSampleIndex > end) continue;
+        memcpy(bins.data(), columns + slot * nFrequencies, nFrequencies * sizeof(float));
+        uint64_t after = columnsWritten.load(std::memory_order_acquire);
+        if (after + 1 > columnCapacity && after + 1 - columnCapacity > c) {
+            ++overwritten;
+            continue;
+        }
+        fwrite(&info.adcTime, sizeof(double), 1, out);
+        fwrite(&info.endSampleIndex, sizeof(uint64_t), 1, out);
+        fwrite(bins.data(), sizeof(float), nFrequencies, out);
+        ++nColumns;
+    }
+
+    fseek(out, countOffset, SEEK_SET);
+    fwrite(&nColumns, 8, 1, out);
+    fclose(out);
+
+    if (overwritten) {
+        Log::getInstance()->logger() << "Flight recorder: " << overwritten
+                                     << " columns were overwritten by capture before they were written." << std::endl;
+    }
+    return nColumns;
+}
@@ -0,0 +1,191 @@
+/**
+ * Keeps the last minutes of raw audio and spectrogram slices in large preallocated rings, and on a trigger (key press,
+ * signal or detector event) writes the window around the trigger to a WAV file plus a column file, from a background
+ * thread, without pausing capture.
+ *
+ * Column file layout (native endianness):
+ *    header:  char magic[8] = "AVCOLS1", uint32 nFrequencies, uint32 samplingRate, uint64 nColumns
+ *    columns: double adcTime, uint64 endSampleIndex, float power[nFrequencies]
+ */
+
+#ifndef OPENGL_SPECTROGRAM_FLIGHTRECORDER_HPP
+#define OPENGL_SPECTROGRAM_FLIGHTRECORDER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <signal.h>
+#include <stdint.h>
+#include "AudioListener.hpp"
+
+class FlightRecorder : public AudioListener {
+public:
+  /**
+   * Seconds of audio after the trigger included in a dump.
+   */
+  static const float POST_TRIGGER_SECONDS;
+
+  /**
+   * Fraction of the ring that may be dumped. The rest is a margin which capture may overwrite while the oldest part
+   * of the window is still being written.
+   */
+  static const float DUMPABLE_FRACTION;
+
+  /**
+   * Allocates and pre-faults the rings.
+   * @param minutes length of the retained history.
+   * @param samplingRate sampling rate of the captured audio.
+   * @param nFrequencies number of frequencies per spectrogram slice.
+   * @param columnsPerSecond upper bound on the number of slices computed per second.
+   * @param directory directory the dumps are written to.
+   */
+  FlightRecorder(float minutes, unsigned int samplingRate, unsigned int nFrequencies, float columnsPerSecond,
+                 const std::string& directory);
+
+  FlightRecorder(const FlightRecorder&) = delete;
+  FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+  /**
+   * Stops the writer thread, waiting for a dump in progress, and releases the rings.
+   */
+  ~FlightRecorder();
+
+  /**
+   * Copies a block of captured samples into the PCM ring. Realtime safe.
+   */
+  virtual void samplesCaptured(const float* samples, unsigned long numSamples, uint64_t firstSampleIndex,
+                               double firstAdcTime);
+
+  /**
+   * Copies a spectrogram slice into the column ring. Realtime safe.
+   */
+  virtual void sliceComputed(const float* slice, unsigned int nFrequencies, uint64_t endSampleIndex,
+                             double adcTime);
+
+  /**
+   * Requests a dump of the window around the current time. Ignored while a dump is pending or in progress.
+   * Not realtime safe, but cheap.
+   * @param reason short description of the trigger for the log.
+   * @return whether a dump was scheduled.
+   */
+  bool trigger(const char* reason);
+
+  /**
+   * Signal handler which requests a dump at the next call of triggerIfRequested().
+   * @param signum signal number (unused).
+   */
+  static void requestTrigger(int signum);
+
+  /**
+   * Triggers a dump if one was requested by requestTrigger(). Meant to be polled from a non-realtime thread.
+   */
+  void triggerIfRequested();
+
+  /**
+   * @return whether a dump is pending or being written.
+   */
+  bool isDumping() const;
+
+private:
+  /**
+   * Metadata stored alongside each slice in the column ring.
+   */
+  struct ColumnInfo {
+    double adcTime;
+    uint64_t endSampleIndex;
+  };
+
+  /**
+   * Maps anonymous memory, backed by huge pages if any are reserved, and touches every page so that the capture
+   * thread never faults.
+   * @param bytes requested size, rounded up to the mapped size on return.
+   * @param hugePages set to whether the mapping uses reserved huge pages.
+   * @return the mapping, or nullptr on failure.
+   */
+  static void* allocate(size_t& bytes, bool& hugePages);
+
+  /**
+   * Body of the writer thread.
+   */
+  void writerLoop();
+
+  /**
+   * Writes the PCM window [first, end) to a float WAV file. Samples that capture overwrote before they were copied
+   * are written as silence, so the file keeps its length and timing.
+   * @param silenced receives the number of samples written as silence.
+   * @return number of samples written.
+   */
+  uint64_t writeWav(const std::string& path, uint64_t first, uint64_t end, uint64_t& silenced);
+
+  /**
+   * Writes all retained columns whose frames end within [first, end] to a column file, leaving out columns
+   * that capture overwrote while they were being copied.
+   * @return number of columns written.
+   */
+  uint64_t writeColumns(const std::string& path, uint64_t first, uint64_t end);
+
+  /**
+   * Set asynchronously by requestTrigger().
+   */
+  static volatile sig_atomic_t triggerRequested;
+
+  unsigned int samplingRate;
+  unsigned int nFrequencies;
+  std::string directory;
+
+  /**
+   * Ring of raw samples, and its capacity in samples.
+   */
+  float* pcm;
+  uint64_t pcmCapacity;
+  size_t pcmBytes;
+  bool pcmHugePages;
+
+  /**
+   * Ring of spectrogram slices and their metadata, and its capacity in columns.
+   */
+  float* columns;
+  ColumnInfo* columnInfo;
+  uint64_t columnCapacity;
+  size_t columnBytes;
+  size_t columnInfoBytes;
+  bool columnHugePages;
+
+  /**
+   * Sample index one past the newest sample in the PCM ring.
+   */
+  std::atomic<uint64_t> pcmWritten;
+
+  /**
+   * Largest block of samples captured so far; a block is copied into the ring before pcmWritten covers it.
+   */
+  std::atomic<unsigned long> largestBlock;
+
+  /**
+   * Number of columns ever written to the column ring.
+   */
+  std::atomic<uint64_t> columnsWritten;
+
+  /**
+   * Sample index at which the pending dump was triggered.
+   */
+  uint64_t triggerSample;
+
+  /**
+   * Whether a dump is pending or in progress.
+   */
+  std::atomic<bool> dumping;
+
+  /**
+   * Whether the writer thread should exit.
+   */
+  bool stop;
+
+  std::mutex mutex;
+  std::condition_variable wakeUp;
+  std::thread writer;
+};
+
+#endif /* OPENGL_SPECTROGRAM_FLIGHTRECORDER_HPP */
@@ -28,6 +28,15 @@ public:
   virtual void mouse(int, int, int, int) = 0;
 
   virtual void motion(int, int) = 0;
+
+  /* called once the frame drawn by display() has been swapped to the screen */
+  virtual void swapped() = 0;
+
+  /* number of vSyncs the item wants between redisplays */
+  virtual unsigned int frameInterval() = 0;
+
+  /* stops whatever feeds the item, before the process exits */
+  virtual void quit() = 0;
 protected:
   bool isPaused;
 };
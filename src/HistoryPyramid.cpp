@@ -0,0 +1,189 @@
+#include "HistoryPyramid.hpp"
+#include <algorithm>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "Log.hpp"
+#include "SpectrogramFile.hpp"
+#include "Trace.hpp"
+
+/* static member declarations and initializations */
+const unsigned int HistoryPyramid::N_LEVELS = 16;  // coarsest column: 32768 frames, about 6 min at 86 columns/s
+const unsigned int HistoryPyramid::N_BINS = 512;
+const unsigned int HistoryPyramid::TILE_COLUMNS = 256;
+const unsigned int HistoryPyramid::MAX_MAPPED_TILES = 64;
+const uint64_t HistoryPyramid::DEFAULT_MAX_LEVEL_BYTES = (uint64_t) 1 << 30;  // level 0: about 6.8 h at 86 columns/s
+
+/* level files grow by this many tiles at a time */
+static const uint64_t GROWTH_TILES = 64;
+
+HistoryPyramid::HistoryPyramid(const std::string& directory, Pooling pooling, uint64_t maxLevelBytes)
+  : directory(directory), pooling(pooling),
+    maxTiles(std::max<uint64_t>(1, maxLevelBytes / (GROWTH_TILES * TILE_COLUMNS * N_BINS)) * GROWTH_TILES), files(N_LEVELS, -1), fileTiles(N_LEVELS, 0), columns(N_LEVELS, 0),
+    pending(N_LEVELS, std::vector<uint16_t>(N_BINS, 0)), nPending(N_LEVELS, 0), lastTime(0.0), useCounter(0),
+    column(N_BINS)
+{
+    mkdir(directory.c_str(), 0755);
+    for (unsigned int level = 0; level < N_LEVELS; ++level) {
+        std::string path = directory + "/level" + std::to_string(level) + ".tiles";
+        files[level] = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (files[level] < 0) {
+            Log::getInstance()->logger() << "Could not create " << path << std::endl;
+            throw 99;
+        }
+    }
+    Log::getInstance()->logger() << "History pyramid in " << directory << ", "
+                                 << (pooling == MAX_POOLING ? "max" : "mean") << " pooling, at most "
+                                 << (maxTiles * TILE_COLUMNS * N_BINS >> 20) << " MB per level" << std::endl;
+}
+
+HistoryPyramid::~HistoryPyramid()
+{
+    for (auto& entry : mapped) munmap(entry.second.data, TILE_COLUMNS * N_BINS);
+    for (int file : files) if (file >= 0) close(file);
+}
+
+void HistoryPyramid::append(const float* slice, unsigned int nFrequencies, double unixTime)
+{
+    TraceScope traceScope("history append");
+    std::lock_guard<std::mutex> lock(mutex);
+    if (columns[0] % TILE_COLUMNS == 0) tileTimes.push_back(unixTime);
+    lastTime = unixTime;
+
+    /* reduce to N_BINS by taking the loudest of each group of frequencies */
+    unsigned int group = std::max(1u, nFrequencies / N_BINS);
+    for (unsigned int j = 0; j < N_BINS; ++j) {
+        float power = 0.0f;
+        for (unsigned int k = j * group; k < std::min(nFrequencies, (j + 1) * group); ++k) {
+            power = std::max(power, slice[k]);
+        }
+        column[j] = SpectrogramFile::quantize(power, SpectrogramFile::DEFAULT_DB_FLOOR,
+                                              SpectrogramFile::DEFAULT_DB_STEP);
+    }
+    appendToLevel(0, column.data());
+}
+
+void HistoryPyramid::appendToLevel(unsigned int level, const uint8_t* levelColumn)
+{
+    uint8_t* data = tile(level, columns[level] / TILE_COLUMNS, true);
+    if (data) memcpy(data + (columns[level] % TILE_COLUMNS) * N_BINS, levelColumn, N_BINS);
+    ++columns[level];
+
+    if (level + 1 == N_LEVELS) return;
+    std::vector<uint16_t>& accumulator = pending[level + 1];
+    for (unsigned int j = 0; j < N_BINS; ++j) {
+        if (pooling == MAX_POOLING) {
+            accumulator[j] = nPending[level + 1] ? std::max<uint16_t>(accumulator[j], levelColumn[j]) : levelColumn[j];
+        } else {
+            accumulator[j] = nPending[level + 1] ? accumulator[j] + levelColumn[j] : levelColumn[j];
+        }
+    }
+    if (++nPending[level + 1] < 2) return;
+
+    /* a pair is complete, pool it into the next level */
+    uint8_t pooled[N_BINS];
+    for (unsigned int j = 0; j < N_BINS; ++j) {
+        pooled[j] = (uint8_t) (pooling == MAX_POOLING ? accumulator[j] : (accumulator[j] + 1) / 2);
+    }
+    nPending[level + 1] = 0;
+    appendToLevel(level + 1, pooled);
+}
+
+uint8_t* HistoryPyramid::tile(unsigned int level, uint64_t index, bool forWriting)
+{
+    const size_t tileBytes = TILE_COLUMNS * N_BINS;
+    if (index < oldestTile(level)) return nullptr;
+
+    /* keyed by file slot, so that a reused slot is mapped only once */
+    uint64_t slot = index % maxTiles;
+    uint64_t key = ((uint64_t) level << 56) | slot;
+    auto it = mapped.find(key);
+    if (it != mapped.end()) {
+        it->second.lastUse = ++useCounter;
+        return it->second.data;
+    }
+
+    if (slot >= fileTiles[level]) {
+        if (!forWriting) return nullptr;
+        uint64_t grown = (slot / GROWTH_TILES + 1) * GROWTH_TILES;
+        if (ftruncate(files[level], (off_t) (grown * tileBytes)) != 0) return nullptr;
+        fileTiles[level] = grown;
+    }
+
+    /* page in lazily, evicting the least recently used tile */
+    if (mapped.size() >= MAX_MAPPED_TILES) {
+        auto oldest = std::min_element(mapped.begin(), mapped.end(), [](const std::pair<const uint64_t, MappedTile>& a,
+                                                                         const std::pair<const uint64_t, MappedTile>& b) {
+            return a.second.lastUse < b.second.lastUse;
+        });
+        munmap(oldest->second.data, tileBytes);
+        mapped.erase(oldest);
+    }
+    void* data = mmap(nullptr, tileBytes, PROT_READ | PROT_WRITE, MAP_SHARED, files[level], (off_t) (slot * tileBytes));
+    if (data == MAP_FAILED) {
+        Log::getInstance()->logger() << "Could not map history tile " << index << " of level " << level << std::endl;
+        return nullptr;
+    }
+    mapped[key] = {(uint8_t*) data, ++useCounter};
+    return (uint8_t*) data;
+}
+
+void HistoryPyramid::read(unsigned int level, int64_t first, unsigned int count, uint8_t* out)
+{
+    TraceScope traceScope("history read");
+    std::lock_guard<std::mutex> lock(mutex);
+    memset(out, 0, (size_t) count * N_BINS);
+    int64_t i = std::max<int64_t>(0, (int64_t) (oldestTile(level) * TILE_COLUMNS) - first);
+    while (i < count && first + i < (int64_t) columns[level]) {
+        /* copy the run of columns within one tile */
+        uint64_t c = (uint64_t) (first + i);
+        uint64_t end = std::min<uint64_t>({(c / TILE_COLUMNS + 1) * TILE_COLUMNS, columns[level], (uint64_t) (first + count)});
+        const uint8_t* data = tile(level, c / TILE_COLUMNS, false);
+        for (; c < end; ++c, ++i) {
+            if (!data) continue;
+            const uint8_t* source = data + (c % TILE_COLUMNS) * N_BINS;
+            for (unsigned int j = 0; j < N_BINS; ++j) out[j * count + i] = source[j];
+        }
+    }
+}
+
+uint64_t HistoryPyramid::getColumns(unsigned int level) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return columns[level];
+}
+
+uint64_t HistoryPyramid::getOldestColumn(unsigned int level) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return oldestTile(level) * TILE_COLUMNS;
+}
+
+uint64_t HistoryPyramid::oldestTile(unsigned int level) const
+{
+    /* the tile being written has taken over the slot of the tile maxTiles before it */
+    uint64_t newest = columns[level] ? (columns[level] - 1) / TILE_COLUMNS : 0;
+    return newest + 1 > maxTiles ? newest + 1 - maxTiles : 0;
+}
+
+double HistoryPyramid::columnTime(unsigned int level, int64_t column) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (column < 0) return 0.0;
+    uint64_t column0 = (uint64_t) column << level;
+    if (column0 >= columns[0]) return 0.0;
+
+    /* interpolate within the level 0 tile */
+    uint64_t t = column0 / TILE_COLUMNS;
+    bool complete = t + 1 < tileTimes.size();
+    double end = complete ? tileTimes[t + 1] : lastTime;
+    uint64_t span = complete ? TILE_COLUMNS : columns[0] - 1 - t * TILE_COLUMNS;
+    return tileTimes[t] + (span ? (end - tileTimes[t]) * (column0 % TILE_COLUMNS) / span : 0.0);
+}
+
+float HistoryPyramid::dequantize(uint8_t level)
+{
+    return SpectrogramFile::dequantize(level, SpectrogramFile::DEFAULT_DB_FLOOR, SpectrogramFile::DEFAULT_DB_STEP);
+}
@@ -0,0 +1,179 @@
+/**
+ * Disk-backed level-of-detail store of computed spectrogram columns, for scrolling back over hours of history at a
+ * constant render cost.
+ *
+ * Level 0 holds every column, reduced to N_BINS one-byte dB bins. Each further level halves the time resolution by
+ * max- or mean-pooling pairs of columns of the level below, so that any time span fits the screen at some level.
+ * Every level lives in its own file under the store directory, split into tiles of TILE_COLUMNS columns which are
+ * memory-mapped on first use and unmapped again, least recently used first, beyond MAX_MAPPED_TILES.
+ *
+ * Each level file is capped in size: once it holds its maximum number of tiles it is used as a ring, the newest tile
+ * replacing the oldest. Coarser levels fill more slowly, so zooming out reaches further back than level 0 retains.
+ *
+ * Columns are appended by a DSP graph sink and read by the render thread; a mutex serializes the two.
+ */
+
+#ifndef OPENGL_SPECTROGRAM_HISTORYPYRAMID_HPP
+#define OPENGL_SPECTROGRAM_HISTORYPYRAMID_HPP
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <stdint.h>
+
+class HistoryPyramid {
+public:
+  enum Pooling {
+    MAX_POOLING,
+    MEAN_POOLING
+  };
+
+  /**
+   * Number of levels, the coarsest pooling 2^(N_LEVELS - 1) columns.
+   */
+  static const unsigned int N_LEVELS;
+
+  /**
+   * Number of frequency bins per stored column.
+   */
+  static const unsigned int N_BINS;
+
+  /**
+   * Number of columns per tile.
+   */
+  static const unsigned int TILE_COLUMNS;
+
+  /**
+   * Maximum number of tiles mapped at the same time.
+   */
+  static const unsigned int MAX_MAPPED_TILES;
+
+  /**
+   * Default maximum size of one level file in bytes.
+   */
+  static const uint64_t DEFAULT_MAX_LEVEL_BYTES;
+
+  /**
+   * Creates an empty store, replacing any previous one in the directory. Throws 99 on failure.
+   * @param directory directory of the level files, created if missing.
+   * @param pooling how columns are combined into the next level.
+   * @param maxLevelBytes maximum size of each level file, rounded down to whole growth steps of the file but at least
+   * one step; older columns are overwritten beyond it.
+   */
+  HistoryPyramid(const std::string& directory, Pooling pooling, uint64_t maxLevelBytes = DEFAULT_MAX_LEVEL_BYTES);
+
+  HistoryPyramid(const HistoryPyramid&) = delete;
+  HistoryPyramid& operator=(const HistoryPyramid&) = delete;
+
+  /**
+   * Unmaps all tiles and closes the level files.
+   */
+  ~HistoryPyramid();
+
+  /**
+   * Appends a column to level 0 and to every level that completes a pooled column with it.
+   * @param slice power spectrum of the column.
+   * @param nFrequencies number of frequencies in slice.
+   * @param unixTime wall clock time of the column.
+   */
+  void append(const float* slice, unsigned int nFrequencies, double unixTime);
+
+  /**
+   * Copies a range of columns of one level, frequency-major (bin j of column i at out[j * count + i]). Columns that
+   * do not exist yet, or no longer, read as 0.
+   * @param level level to read.
+   * @param first first column to copy, may be negative.
+   * @param count number of columns to copy.
+   * @param out receives count * N_BINS quantized levels.
+   */
+  void read(unsigned int level, int64_t first, unsigned int count, uint8_t* out);
+
+  /**
+   * @return number of columns stored at a level.
+   */
+  uint64_t getColumns(unsigned int level) const;
+
+  /**
+   * @return index of the oldest column still retained at a level.
+   */
+  uint64_t getOldestColumn(unsigned int level) const;
+
+  /**
+   * @return approximate wall clock time of a column of a level, or 0 if it does not exist.
+   */
+  double columnTime(unsigned int level, int64_t column) const;
+
+  /**
+   * @return the power represented by a stored quantized level.
+   */
+  static float dequantize(uint8_t level);
+
+private:
+  struct MappedTile {
+    uint8_t* data;
+    uint64_t lastUse;
+  };
+
+  /**
+   * Stores a column at a level and pools it into the next one.
+   */
+  void appendToLevel(unsigned int level, const uint8_t* column);
+
+  /**
+   * Maps a tile, growing the level file first when writing.
+   * @return the tile, or nullptr if it is not written yet, has been overwritten, or cannot be mapped.
+   */
+  uint8_t* tile(unsigned int level, uint64_t index, bool forWriting);
+
+  /**
+   * Index of the oldest retained tile of a level. Expects the mutex to be held.
+   */
+  uint64_t oldestTile(unsigned int level) const;
+
+  std::string directory;
+  Pooling pooling;
+
+  /**
+   * Number of tiles a level file holds at most; tile i lives in slot i % maxTiles.
+   */
+  uint64_t maxTiles;
+
+  /**
+   * Per level: file descriptor, number of tiles the file has room for, and number of columns stored.
+   */
+  std::vector<int> files;
+  std::vector<uint64_t> fileTiles;
+  std::vector<uint64_t> columns;
+
+  /**
+   * Per level from 1: pooling accumulator, and number of columns accumulated (0 or 1).
+   */
+  std::vector<std::vector<uint16_t>> pending;
+  std::vector<unsigned int> nPending;
+
+  /**
+   * Wall clock time of the first column of every level 0 tile.
+   */
+  std::vector<double> tileTimes;
+
+  /**
+   * Wall clock time of the newest column.
+   */
+  double lastTime;
+
+  /**
+   * Mapped tiles, keyed by level and tile index.
+   */
+  std::unordered_map<uint64_t, MappedTile> mapped;
+  uint64_t useCounter;
+
+  std::vector<uint8_t> column;
+
+  /**
+   * Guards all of the above between the appending and the reading thread.
+   */
+  mutable std::mutex mutex;
+};
+
+#endif /* OPENGL_SPECTROGRAM_HISTORYPYRAMID_HPP */
@@ -0,0 +1,11 @@
+#include "HistorySink.hpp"
+
+HistorySink::HistorySink(HistoryPyramid* history)
+  : DspSink<SpectrumFrame>("history sink"), history(history)
+{
+}
+
+void HistorySink::consume(const SpectrumFrame& frame)
+{
+    history->append(frame.power, frame.nFrequencies, frame.unixTime);
+}
@@ -0,0 +1,27 @@
+/**
+ * DSP graph sink appending every spectrum frame to a history pyramid, so that quantizing and pooling columns and
+ * writing tiles happen on a pool worker rather than on the render or audio thread.
+ */
+
+#ifndef OPENGL_SPECTROGRAM_HISTORYSINK_HPP
+#define OPENGL_SPECTROGRAM_HISTORYSINK_HPP
+
+#include "DspGraph.hpp"
+#include "HistoryPyramid.hpp"
+#include "SpectrumTap.hpp"
+
+class HistorySink : public DspSink<SpectrumFrame> {
+public:
+  /**
+   * @param history pyramid to append to, which must outlive the sink.
+   */
+  HistorySink(HistoryPyramid* history);
+
+protected:
+  virtual void consume(const SpectrumFrame& frame);
+
+private:
+  HistoryPyramid* history;
+};
+
+#endif /* OPENGL_SPECTROGRAM_HISTORYSINK_HPP */
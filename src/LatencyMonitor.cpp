@@ -0,0 +1,67 @@
+#include "LatencyMonitor.hpp"
+
+/* static member declarations and initializations */
+const float LatencyMonitor::BIN_WIDTH_SECONDS = 0.0005f;
+const unsigned int LatencyMonitor::N_BINS = 2000;  // 0.5 ms resolution up to 1 s
+
+LatencyMonitor::LatencyMonitor()
+  : histogram(N_BINS, 0)
+{
+  reset();
+}
+
+void LatencyMonitor::record(double seconds)
+{
+  if (seconds < 0) return;
+  auto bin = (unsigned int) (seconds / BIN_WIDTH_SECONDS);
+  if (bin >= N_BINS) bin = N_BINS - 1;
+  ++histogram[bin];
+  ++count;
+  sum += seconds;
+  last = (float) seconds;
+  if (last > max) max = last;
+}
+
+float LatencyMonitor::percentile(float percent) const
+{
+  if (count == 0) return 0.0f;
+  auto target = (unsigned long) (percent / 100.0f * (count - 1));
+  unsigned long seen = 0;
+  for (unsigned int i = 0; i < N_BINS; ++i) {
+    seen += histogram[i];
+    if (seen > target) {
+      /* report the bin center */
+      return (i + 0.5f) * BIN_WIDTH_SECONDS;
+    }
+  }
+  return max;
+}
+
+void LatencyMonitor::reset()
+{
+  for (unsigned int i = 0; i < N_BINS; ++i) histogram[i] = 0;
+  count = 0;
+  sum = 0.0;
+  max = 0.0f;
+  last = 0.0f;
+}
+
+unsigned long LatencyMonitor::getCount() const
+{
+  return count;
+}
+
+float LatencyMonitor::getMean() const
+{
+  return count ? (float) (sum / count) : 0.0f;
+}
+
+float LatencyMonitor::getMax() const
+{
+  return max;
+}
+
+float LatencyMonitor::getLast() const
+{
+  return last;
+}
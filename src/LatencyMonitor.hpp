@@ -0,0 +1,78 @@
+/**
+ * Fixed-resolution histogram of latency measurements, e.g. from the ADC timestamp of an audio sample to the buffer
+ * swap that first shows it on screen.
+ */
+
+#ifndef OPENGL_SPECTROGRAM_LATENCYMONITOR_HPP
+#define OPENGL_SPECTROGRAM_LATENCYMONITOR_HPP
+
+#include <vector>
+
+class LatencyMonitor {
+public:
+  /**
+   * Width of each histogram bin, in seconds.
+   */
+  static const float BIN_WIDTH_SECONDS;
+
+  /**
+   * Number of histogram bins. Measurements beyond the last bin are counted in the last bin.
+   */
+  static const unsigned int N_BINS;
+
+  LatencyMonitor();
+
+  /**
+   * Adds a measurement to the distribution. Negative measurements (clock glitches) are ignored.
+   * @param seconds measured latency, in seconds.
+   */
+  void record(double seconds);
+
+  /**
+   * Estimates a percentile of the distribution, to the resolution of BIN_WIDTH_SECONDS.
+   * @param percent requested percentile in [0, 100].
+   * @return latency at the requested percentile in seconds, or 0 if there are no measurements.
+   */
+  float percentile(float percent) const;
+
+  /**
+   * Clears all measurements.
+   */
+  void reset();
+
+  unsigned long getCount() const;
+
+  float getMean() const;
+
+  float getMax() const;
+
+  float getLast() const;
+
+private:
+  /**
+   * Number of measurements per bin.
+   */
+  std::vector<unsigned long> histogram;
+
+  /**
+   * Total number of measurements.
+   */
+  unsigned long count;
+
+  /**
+   * Sum of all measurements, in seconds.
+   */
+  double sum;
+
+  /**
+   * Largest measurement, in seconds.
+   */
+  float max;
+
+  /**
+   * Most recent measurement, in seconds.
+   */
+  float last;
+};
+
+#endif /* OPENGL_SPECTROGRAM_LATENCYMONITOR_HPP */
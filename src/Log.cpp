@@ -30,6 +30,9 @@ void Log::log(std::string& message)
     }
     file << message << std::endl;
     break;
+  case 3:
+    std::cerr << message << std::endl;
+    break;
   default:
     break;
   }
@@ -54,6 +57,9 @@ void Log::log(const char* const message)
     }
     file << message << std::endl;
     break;
+  case 3:
+    std::cerr << message << std::endl;
+    break;
   default:
     break;
   }
@@ -68,6 +74,8 @@ std::ostream& Log::logger() {
       throw "Log file not initialized!";
     }
     return file;
+  case 3:
+    return std::cerr;
   default:
     return std::cout;
   }
@@ -1,5 +1,5 @@
 /**
- * Singleton class to handle logging to standard output or a file.
+ * Singleton class to handle logging to standard output, standard error or a file.
  */
 
 #ifndef OPENGL_SPECTROGRAM_LOG_H
@@ -17,6 +17,7 @@ public:
    *    0 -> std::cout
    *    1 -> file with low verbosity
    *    2 -> file with high verbosity
+   *    3 -> std::cerr, when std::cout carries data
    */
   static unsigned int OUTPUT_DIRECTION;
 
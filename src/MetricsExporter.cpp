@@ -0,0 +1,137 @@
+#include "MetricsExporter.hpp"
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "Log.hpp"
+#include "Trace.hpp"
+
+/* static member declarations and initializations */
+const int MetricsExporter::CLIENT_TIMEOUT_MS = 1000;
+
+/* poll interval of the server thread, bounding how long destruction waits */
+static const int POLL_MS = 100;
+
+/* end of every exposition, and an exposition without samples until the first interval ends */
+static const char* const EMPTY_EXPOSITION = "# EOF\n";
+
+MetricsExporter::MetricsExporter(const std::string& target, const std::vector<BandSummaryIndex::Band>& bands)
+  : DspSink<BandMetrics>("metrics exporter"), listenFd(-1), text(EMPTY_EXPOSITION), quit(false)
+{
+    char label[64];
+    for (const BandSummaryIndex::Band& band : bands) {
+        snprintf(label, sizeof(label), "%g-%g", band.lowHz, band.highHz);
+        labels.push_back(label);
+    }
+
+    if (!target.compare(0, 5, "unix:")) {
+        path = target.substr(5);
+        sockaddr_un address;
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path)) {
+            Log::getInstance()->logger() << "Socket path too long: " << path << std::endl;
+            throw 99;
+        }
+        strcpy(address.sun_path, path.c_str());
+        unlink(path.c_str());
+        listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listenFd < 0 || bind(listenFd, (sockaddr*) &address, sizeof(address)) != 0 || listen(listenFd, 4) != 0) {
+            Log::getInstance()->logger() << "Could not listen on " << path << ": " << strerror(errno) << std::endl;
+            if (listenFd >= 0) close(listenFd);
+            throw 99;
+        }
+        server = std::thread(&MetricsExporter::serveLoop, this);
+    } else {
+        path = target;
+        if (!writeFile()) throw 99;
+    }
+    Log::getInstance()->logger() << "Exporting band metrics to " << path << std::endl;
+}
+
+MetricsExporter::~MetricsExporter()
+{
+    if (listenFd >= 0) {
+        quit = true;
+        server.join();
+        close(listenFd);
+        unlink(path.c_str());
+    }
+}
+
+void MetricsExporter::consume(const BandMetrics& metrics)
+{
+    TraceScope traceScope("export metrics");
+    std::string exposition;
+    char line[160];
+    exposition += "# TYPE spectrogram_band_energy gauge\n"
+                  "# HELP spectrogram_band_energy Power of the bins of a band summed per column, over the interval.\n";
+    static const char* const statistics[] = {"min", "mean", "max"};
+    for (unsigned int b = 0; b < metrics.nBands && b < labels.size(); ++b) {
+        const float values[] = {metrics.energy[b].min, metrics.energy[b].mean, metrics.energy[b].max};
+        for (int s = 0; s < 3; ++s) {
+            snprintf(line, sizeof(line), "spectrogram_band_energy{band=\"%s\",statistic=\"%s\"} %.6g\n",
+                     labels[b].c_str(), statistics[s], values[s]);
+            exposition += line;
+        }
+    }
+    exposition += "# TYPE spectrogram_interval_columns gauge\n"
+                  "# HELP spectrogram_interval_columns Columns metered in the interval.\n";
+    snprintf(line, sizeof(line), "spectrogram_interval_columns %lu\n", metrics.columns);
+    exposition += line;
+    exposition += "# TYPE spectrogram_columns counter\n"
+                  "# HELP spectrogram_columns Columns metered since start.\n";
+    snprintf(line, sizeof(line), "spectrogram_columns_total %lu\n", metrics.totalColumns);
+    exposition += line;
+    exposition += "# TYPE spectrogram_interval_end_time_seconds gauge\n"
+                  "# UNIT spectrogram_interval_end_time_seconds seconds\n"
+                  "# HELP spectrogram_interval_end_time_seconds Unix time of the newest column of the interval.\n";
+    snprintf(line, sizeof(line), "spectrogram_interval_end_time_seconds %.3f\n", metrics.endTime);
+    exposition += line;
+    exposition += EMPTY_EXPOSITION;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    text.swap(exposition);
+    if (listenFd < 0) writeFile();
+}
+
+bool MetricsExporter::writeFile()
+{
+    /* a scraper never reads a partial file */
+    std::string temporary = path + ".tmp";
+    FILE* file = fopen(temporary.c_str(), "w");
+    bool written = file && fwrite(text.data(), 1, text.size(), file) == text.size();
+    if (file && fclose(file) != 0) written = false;
+    if (!written || rename(temporary.c_str(), path.c_str()) != 0) {
+        Log::getInstance()->logger() << "Could not write " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void MetricsExporter::serveLoop()
+{
+    pollfd listening = {listenFd, POLLIN, 0};
+    while (!quit) {
+        if (poll(&listening, 1, POLL_MS) <= 0) continue;
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) continue;
+        std::string exposition;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            exposition = text;
+        }
+        timeval timeout = {CLIENT_TIMEOUT_MS / 1000, (CLIENT_TIMEOUT_MS % 1000) * 1000};
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        size_t sent = 0;
+        while (sent < exposition.size()) {
+            ssize_t n = send(fd, exposition.data() + sent, exposition.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) break;
+            sent += n;
+        }
+        close(fd);
+    }
+}
@@ -0,0 +1,80 @@
+/**
+ * DSP graph sink publishing the band energies of a BandMeter as OpenMetrics text, for a local scraper:
+ *    # TYPE spectrogram_band_energy gauge
+ *    spectrogram_band_energy{band="250-500",statistic="mean"} 1.5e-05
+ *    ...
+ *    # EOF
+ * with the minimum, mean and maximum energy of every band over the latest interval, the columns in it, the columns
+ * metered in total, and the Unix time of its newest column.
+ *
+ * The target is either a file, replaced atomically after every interval as for a textfile collector, or "unix:<path>"
+ * for a Unix domain socket that sends every client the latest exposition and closes the connection. The socket is
+ * served by a thread of its own, so that a scrape is answered at once and never waits for the next interval.
+ */
+
+#ifndef OPENGL_SPECTROGRAM_METRICSEXPORTER_HPP
+#define OPENGL_SPECTROGRAM_METRICSEXPORTER_HPP
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "BandMeter.hpp"
+#include "DspGraph.hpp"
+
+class MetricsExporter : public DspSink<BandMetrics> {
+public:
+  /**
+   * Time after which a socket client that does not read is disconnected.
+   */
+  static const int CLIENT_TIMEOUT_MS;
+
+  /**
+   * Opens the output. Throws 99 on failure.
+   * @param target path of the file, or "unix:<path>" for a socket listening at path.
+   * @param bands bands of the metrics, for their labels.
+   */
+  MetricsExporter(const std::string& target, const std::vector<BandSummaryIndex::Band>& bands);
+
+  MetricsExporter(const MetricsExporter&) = delete;
+  MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+  /**
+   * Stops serving and removes the socket, if any.
+   */
+  ~MetricsExporter();
+
+protected:
+  /**
+   * Formats the metrics and writes them to the file, or keeps them for the socket clients.
+   */
+  virtual void consume(const BandMetrics& metrics);
+
+private:
+  /**
+   * Body of the thread answering socket clients.
+   */
+  void serveLoop();
+
+  /**
+   * Replaces the file with the latest exposition.
+   * @return false on an error, which is logged.
+   */
+  bool writeFile();
+
+  std::string path;
+  std::vector<std::string> labels;
+  int listenFd;
+
+  /**
+   * Latest exposition, guarded by the mutex when served.
+   */
+  std::string text;
+  std::mutex mutex;
+
+  std::thread server;
+  std::atomic<bool> quit;
+};
+
+#endif /* OPENGL_SPECTROGRAM_METRICSEXPORTER_HPP */
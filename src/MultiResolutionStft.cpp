@@ -0,0 +1,131 @@
+#include "MultiResolutionStft.hpp"
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+#include <thread>
+#include "DspThreadPool.hpp"
+#include "FftPlanCache.hpp"
+#include "Log.hpp"
+#include "Trace.hpp"
+#include "VectorOps.hpp"
+
+/* static member declarations and initializations */
+const float MultiResolutionStft::LOW_CROSSOVER_HZ = 500.0f;
+const float MultiResolutionStft::HIGH_CROSSOVER_HZ = 4000.0f;
+
+MultiResolutionStft::MultiResolutionStft(unsigned int fftLength, unsigned int samplingRate, unsigned int nFrequencies,
+                                         WindowLibrary::Type type, float parameter, double calibrationSum)
+  : nFrequencies(nFrequencies), ring(nullptr), ringSize(0), frameEnd(0), slice(nullptr), done(0), pending(0)
+{
+    const unsigned int lengths[N_BANDS] = {4 * fftLength, fftLength, fftLength / 8};
+    float hzPerBin = samplingRate / (2.0f * nFrequencies);
+    unsigned int low = std::min(nFrequencies, (unsigned int) lroundf(LOW_CROSSOVER_HZ / hzPerBin));
+    unsigned int high = std::min(nFrequencies, std::max(low, (unsigned int) lroundf(HIGH_CROSSOVER_HZ / hzPerBin)));
+    const unsigned int edges[N_BANDS + 1] = {0, low, high, nFrequencies};
+
+    for (unsigned int b = 0; b < N_BANDS; ++b) {
+        Band& band = bands[b];
+        band.owner = this;
+        band.length = lengths[b];
+        band.first = edges[b];
+        band.last = edges[b + 1];
+        band.plan = FftPlanCache::getInstance()->r2hc(band.length);
+        band.window = WindowLibrary::getInstance()->get(type, band.length, parameter);
+        double coherentSum = band.window->coherentGain * band.length;
+        band.gain = (float) (calibrationSum * calibrationSum / (coherentSum * coherentSum));
+        band.frame = fftwf_alloc_real(band.length);
+        band.spectrum = fftwf_alloc_real(band.length);
+        band.claimed = true;
+        Log::getInstance()->logger() << "Multi-resolution band of " << band.length << " samples for "
+                                     << band.first * hzPerBin << " to " << band.last * hzPerBin << " Hz" << std::endl;
+    }
+}
+
+MultiResolutionStft::~MultiResolutionStft()
+{
+    while (pending.load(std::memory_order_acquire) > 0) std::this_thread::yield();
+    for (Band& band : bands) {
+        fftwf_free(band.frame);
+        fftwf_free(band.spectrum);
+    }
+}
+
+unsigned int MultiResolutionStft::getSpan() const
+{
+    return bands[0].length;
+}
+
+unsigned int MultiResolutionStft::getLength(unsigned int band) const
+{
+    return bands[band].length;
+}
+
+void MultiResolutionStft::compute(const float* ring, int ringSize, int frameEnd, float* slice)
+{
+    TraceScope traceScope("multi-resolution column");
+    this->ring = ring;
+    this->ringSize = ringSize;
+    this->frameEnd = frameEnd;
+    this->slice = slice;
+    done.store(0, std::memory_order_relaxed);
+    for (Band& band : bands) band.claimed.store(false, std::memory_order_release);
+
+    /* a task that finds its band claimed does nothing, also when it runs during a later column */
+    for (unsigned int b = 1; b < N_BANDS; ++b) {
+        pending.fetch_add(1, std::memory_order_relaxed);
+        if (!DspThreadPool::getInstance()->submit({&runBand, &bands[b]})) pending.fetch_sub(1, std::memory_order_relaxed);
+    }
+    for (Band& band : bands) {
+        if (!band.claimed.exchange(true, std::memory_order_acq_rel)) {
+            computeBand(band);
+            done.fetch_add(1, std::memory_order_release);
+        }
+    }
+
+    /* only bands a worker is computing remain */
+    while (done.load(std::memory_order_acquire) < N_BANDS) std::this_thread::yield();
+}
+
+void MultiResolutionStft::runBand(void* argument)
+{
+    Band* band = (Band*) argument;
+    MultiResolutionStft* owner = band->owner;
+    if (!band->claimed.exchange(true, std::memory_order_acq_rel)) {
+        owner->computeBand(*band);
+        owner->done.fetch_add(1, std::memory_order_release);
+    }
+    owner->pending.fetch_sub(1, std::memory_order_release);
+}
+
+void MultiResolutionStft::computeBand(Band& band)
+{
+    TraceScope traceScope("multi-resolution band");
+    int n = (int) band.length;
+    int start = ((frameEnd - n) % ringSize + ringSize) % ringSize;
+    int head = std::min(n, ringSize - start);
+    memcpy(band.frame, ring + start, head * sizeof(float));
+    memcpy(band.frame + head, ring, (n - head) * sizeof(float));
+    VectorOps::multiply(band.frame, band.window->coefficients.data(), band.frame, n);
+    fftwf_execute_r2r(band.plan, band.frame, band.spectrum);
+
+    auto power = [&](int k) {
+        float im = k > 0 && k < n / 2 ? band.spectrum[n - k] : 0.0f;
+        return band.gain * (band.spectrum[k] * band.spectrum[k] + im * im);
+    };
+    int displayLength = 2 * (int) nFrequencies;
+    if (n >= displayLength) {
+        /* the finest bins around every display bin, by their maximum */
+        int ratio = n / displayLength;
+        for (unsigned int d = band.first; d < band.last; ++d) {
+            int lowest = std::max(0, (int) d * ratio - ratio / 2);
+            int highest = std::min(n / 2, (int) d * ratio + (ratio - 1) / 2);
+            float loudest = 0.0f;
+            for (int k = lowest; k <= highest; ++k) loudest = std::max(loudest, power(k));
+            slice[d] = loudest;
+        }
+    } else {
+        /* every coarse bin fills displayLength / n display bins, as for a reduced FFT length */
+        int ratio = displayLength / n;
+        for (unsigned int d = band.first; d < band.last; ++d) slice[d] = power((int) d / ratio);
+    }
+}
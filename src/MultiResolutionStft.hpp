@@ -0,0 +1,117 @@
+/**
+ * Multi-resolution spectrum: N_BANDS short-time Fourier transforms of different lengths, each covering one region of
+ * the display axis, stitched into one column. The longest transform resolves the lows, the FFT length covers the
+ * middle, and the shortest follows transients in the highs, which a single length would have to trade off.
+ *
+ * All transforms end at the same sample, so a longer one reaches further into the past. Finer bins are pooled into the
+ * display bins by their maximum and coarser bins are repeated, and every band is rescaled by the coherent gain of its
+ * window, so tone levels stay continuous across the crossovers.
+ *
+ * The bands are computed concurrently: compute() queues all but the first on the DSP thread pool, computes the first
+ * itself, and then claims any band no worker has started yet, so it never waits on a queued task.
+ */
+
+#ifndef OPENGL_SPECTROGRAM_MULTIRESOLUTIONSTFT_HPP
+#define OPENGL_SPECTROGRAM_MULTIRESOLUTIONSTFT_HPP
+
+#include <atomic>
+#include <fftw3.h>
+#include "WindowLibrary.hpp"
+
+class MultiResolutionStft {
+public:
+  static const unsigned int N_BANDS = 3;
+
+  /**
+   * Crossover frequencies between the long and the middle band, and between the middle and the short band.
+   */
+  static const float LOW_CROSSOVER_HZ;
+  static const float HIGH_CROSSOVER_HZ;
+
+  /**
+   * Obtains the plans and windows of the bands. Not realtime safe.
+   * @param fftLength length of the middle band; the long band is 4 times, the short band 1/8 of it.
+   * @param samplingRate sampling rate of the audio.
+   * @param nFrequencies number of display bins, spaced samplingRate / (2 nFrequencies) apart.
+   * @param type window type of every band.
+   * @param parameter window parameter, see WindowLibrary::get().
+   * @param calibrationSum coefficient sum of the window whose tone levels the bands are rescaled to.
+   */
+  MultiResolutionStft(unsigned int fftLength, unsigned int samplingRate, unsigned int nFrequencies,
+                      WindowLibrary::Type type, float parameter, double calibrationSum);
+
+  MultiResolutionStft(const MultiResolutionStft&) = delete;
+  MultiResolutionStft& operator=(const MultiResolutionStft&) = delete;
+
+  /**
+   * Waits for the tasks still queued on the pool.
+   */
+  ~MultiResolutionStft();
+
+  /**
+   * Computes one column. Must not be called concurrently on the same instance.
+   * @param ring audio ring buffer.
+   * @param ringSize number of samples in the ring, at least getSpan().
+   * @param frameEnd ring index one past the newest sample of the frames.
+   * @param slice receives nFrequencies powers.
+   */
+  void compute(const float* ring, int ringSize, int frameEnd, float* slice);
+
+  /**
+   * @return number of samples of the longest band.
+   */
+  unsigned int getSpan() const;
+
+  /**
+   * @return length of a band, 0 being the longest.
+   */
+  unsigned int getLength(unsigned int band) const;
+
+private:
+  struct Band {
+    MultiResolutionStft* owner;
+    unsigned int length;
+
+    /**
+     * Display bins [first, last) written by the band.
+     */
+    unsigned int first;
+    unsigned int last;
+    fftwf_plan plan;
+    const WindowLibrary::Table* window;
+    float gain;
+    float* frame;
+    float* spectrum;
+
+    /**
+     * Set by whichever thread computes the band of the current column.
+     */
+    std::atomic<bool> claimed;
+  };
+
+  /**
+   * Pool task computing a band unless already claimed.
+   */
+  static void runBand(void* argument);
+
+  void computeBand(Band& band);
+
+  unsigned int nFrequencies;
+  Band bands[N_BANDS];
+
+  /**
+   * The column being computed, written before the bands are released.
+   */
+  const float* ring;
+  int ringSize;
+  int frameEnd;
+  float* slice;
+  std::atomic<unsigned int> done;
+
+  /**
+   * Tasks queued on the pool and not yet finished, waited for on destruction.
+   */
+  std::atomic<unsigned int> pending;
+};
+
+#endif /* OPENGL_SPECTROGRAM_MULTIRESOLUTIONSTFT_HPP */
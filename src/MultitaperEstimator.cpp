@@ -0,0 +1,174 @@
+#include "MultitaperEstimator.hpp"
+#include <algorithm>
+#include <map>
+#include <math.h>
+#include <memory>
+#include <mutex>
+#include "FftPlanCache.hpp"
+#include "Log.hpp"
+#include "Trace.hpp"
+#include "VectorOps.hpp"
+
+/* static member declarations and initializations */
+const float MultitaperEstimator::TIME_BANDWIDTH = 3.0f;
+const unsigned int MultitaperEstimator::N_TAPERS = 5;
+
+/* inverse iterations per taper; each gains many digits since the eigenvalues are well separated */
+static const unsigned int INVERSE_ITERATIONS = 3;
+
+/**
+ * Returns the scaled tapers of a length, computing them on first use.
+ */
+static const float* sharedTapers(unsigned int length)
+{
+    static std::mutex mutex;
+    static std::map<unsigned int, std::unique_ptr<float[]>> tapers;
+    std::lock_guard<std::mutex> lock(mutex);
+    std::unique_ptr<float[]>& found = tapers[length];
+    if (!found) {
+        std::vector<double> unit;
+        MultitaperEstimator::dpss(length, MultitaperEstimator::TIME_BANDWIDTH, MultitaperEstimator::N_TAPERS, unit);
+        found.reset(new float[unit.size()]);
+        double scale = sqrt((double) length);
+        for (size_t i = 0; i < unit.size(); ++i) found[i] = (float) (scale * unit[i]);
+        Log::getInstance()->logger() << "Computed " << MultitaperEstimator::N_TAPERS << " DPSS tapers of length "
+                                     << length << std::endl;
+    }
+    return found.get();
+}
+
+MultitaperEstimator::MultitaperEstimator(unsigned int length)
+  : length(length), power(length / 2 + 1)
+{
+    tapers = sharedTapers(length);
+    plan = FftPlanCache::getInstance()->r2cBatch(length, N_TAPERS);
+    tapered = fftwf_alloc_real(N_TAPERS * length);
+    spectra = fftwf_alloc_complex(N_TAPERS * (length / 2 + 1));
+
+    /* a bin-centred tone has power (sum of the taper)^2 in each tapered spectrum; each taper has energy length */
+    double squaredSums = 0.0;
+    for (unsigned int k = 0; k < N_TAPERS; ++k) {
+        double sum = 0.0;
+        for (unsigned int i = 0; i < length; ++i) sum += tapers[k * length + i];
+        squaredSums += sum * sum;
+    }
+    coherentSum = sqrt(squaredSums / N_TAPERS);
+    noiseBandwidth = (double) length * length / (coherentSum * coherentSum);
+}
+
+MultitaperEstimator::~MultitaperEstimator()
+{
+    fftwf_free(tapered);
+    fftwf_free(spectra);
+}
+
+const float* MultitaperEstimator::estimate(const float* frame)
+{
+    TraceScope traceScope("multitaper");
+    for (unsigned int k = 0; k < N_TAPERS; ++k) {
+        VectorOps::multiply(frame, tapers + k * length, tapered + k * length, length);
+    }
+    fftwf_execute_dft_r2c(plan, tapered, spectra);
+
+    unsigned int nBins = length / 2 + 1;
+    for (unsigned int j = 0; j < nBins; ++j) {
+        float sum = 0.0f;
+        for (unsigned int k = 0; k < N_TAPERS; ++k) {
+            const fftwf_complex& value = spectra[k * nBins + j];
+            sum += value[0] * value[0] + value[1] * value[1];
+        }
+        power[j] = sum / N_TAPERS;
+    }
+    return power.data();
+}
+
+double MultitaperEstimator::getCoherentSum() const
+{
+    return coherentSum;
+}
+
+double MultitaperEstimator::getNoiseBandwidth() const
+{
+    return noiseBandwidth;
+}
+
+void MultitaperEstimator::dpss(unsigned int length, double timeBandwidth, unsigned int nTapers,
+                               std::vector<double>& tapers)
+{
+    /* the tridiagonal matrix of Slepian (1978): diagonal ((N - 1 - 2i) / 2)^2 cos(2 pi W), off-diagonal i (N - i) / 2 */
+    unsigned int n = length;
+    double cosine = cos(2.0 * M_PI * timeBandwidth / n);
+    std::vector<double> diagonal(n), offDiagonal(n, 0.0);
+    for (unsigned int i = 0; i < n; ++i) {
+        double d = (n - 1.0 - 2.0 * i) / 2.0;
+        diagonal[i] = d * d * cosine;
+        if (i > 0) offDiagonal[i] = i * (double) (n - i) / 2.0;
+    }
+
+    /* Gershgorin bounds of the spectrum */
+    double lowest = diagonal[0], highest = diagonal[0];
+    for (unsigned int i = 0; i < n; ++i) {
+        double radius = offDiagonal[i] + (i + 1 < n ? offDiagonal[i + 1] : 0.0);
+        lowest = std::min(lowest, diagonal[i] - radius);
+        highest = std::max(highest, diagonal[i] + radius);
+    }
+
+    /* Sturm sequence count of the eigenvalues below x */
+    auto countBelow = [&](double x) {
+        unsigned int count = 0;
+        double q = 1.0;
+        for (unsigned int i = 0; i < n; ++i) {
+            q = diagonal[i] - x - (i > 0 ? offDiagonal[i] * offDiagonal[i] / q : 0.0);
+            if (q == 0.0) q = -1e-300;
+            if (q < 0.0) ++count;
+        }
+        return count;
+    };
+
+    tapers.assign((size_t) nTapers * n, 0.0);
+    std::vector<double> x(n), pivot(n), upper(n);
+    for (unsigned int k = 0; k < nTapers; ++k) {
+        /* the k-th largest eigenvalue by bisection */
+        unsigned int index = n - 1 - k;
+        double below = lowest, above = highest;
+        for (int iteration = 0; iteration < 200 && above - below > 1e-12 * std::max(1.0, fabs(above)); ++iteration) {
+            double middle = 0.5 * (below + above);
+            if (countBelow(middle) > index) above = middle;
+            else below = middle;
+        }
+        double shift = 0.5 * (below + above) + 1e-10 * (highest - lowest);
+
+        /* factor T - shift I once, then inverse iteration from an asymmetric start */
+        for (unsigned int i = 0; i < n; ++i) {
+            double d = diagonal[i] - shift - (i > 0 ? offDiagonal[i] * upper[i - 1] : 0.0);
+            if (fabs(d) < 1e-300) d = 1e-300;
+            pivot[i] = d;
+            upper[i] = i + 1 < n ? offDiagonal[i + 1] / d : 0.0;
+        }
+        for (unsigned int i = 0; i < n; ++i) x[i] = 1.0 + (double) i / n;
+        for (unsigned int iteration = 0; iteration < INVERSE_ITERATIONS; ++iteration) {
+            for (unsigned int i = 0; i < n; ++i) {
+                x[i] = (x[i] - (i > 0 ? offDiagonal[i] * x[i - 1] : 0.0)) / pivot[i];
+            }
+            for (unsigned int i = n - 1; i-- > 0;) x[i] -= upper[i] * x[i + 1];
+
+            /* keep orthogonal to the previous tapers, then normalize */
+            for (unsigned int j = 0; j < k; ++j) {
+                const double* previous = &tapers[(size_t) j * n];
+                double projection = 0.0;
+                for (unsigned int i = 0; i < n; ++i) projection += x[i] * previous[i];
+                for (unsigned int i = 0; i < n; ++i) x[i] -= projection * previous[i];
+            }
+            double norm = 0.0;
+            for (unsigned int i = 0; i < n; ++i) norm += x[i] * x[i];
+            norm = sqrt(norm);
+            for (unsigned int i = 0; i < n; ++i) x[i] /= norm;
+        }
+
+        /* sign convention: symmetric tapers have a positive mean, antisymmetric ones start positive */
+        double orientation = 0.0;
+        for (unsigned int i = 0; i < n; ++i) orientation += (k % 2 ? n - 1.0 - 2.0 * i : 1.0) * x[i];
+        double sign = orientation < 0.0 ? -1.0 : 1.0;
+        for (unsigned int i = 0; i < n; ++i) tapers[(size_t) k * n + i] = sign * x[i];
+    }
+}
@@ -0,0 +1,86 @@
+/**
+ * Multitaper power spectrum estimate: the mean of the power spectra of one frame tapered by each of N_TAPERS discrete
+ * prolate spheroidal sequences (DPSS, Slepian tapers) of time-bandwidth product TIME_BANDWIDTH. The tapers are
+ * orthogonal and maximally concentrated within +-TIME_BANDWIDTH bins, so their spectra are nearly independent
+ * estimates and the mean has about 1/N_TAPERS of the variance of a single windowed spectrum, at the cost of a main lobe
+ * 2 TIME_BANDWIDTH bins wide.
+ *
+ * The tapers are computed once per length and shared by all estimators. The N_TAPERS transforms of a frame run as one
+ * batched FFTW execution of a plan made for the batch, rather than N_TAPERS separate executions.
+ */
+
+#ifndef OPENGL_SPECTROGRAM_MULTITAPERESTIMATOR_HPP
+#define OPENGL_SPECTROGRAM_MULTITAPERESTIMATOR_HPP
+
+#include <vector>
+#include <fftw3.h>
+
+class MultitaperEstimator {
+public:
+  /**
+   * Time-bandwidth product NW of the tapers.
+   */
+  static const float TIME_BANDWIDTH;
+
+  /**
+   * Number of tapers, the usual 2 NW - 1; the last still has 95 % of its energy within the band.
+   */
+  static const unsigned int N_TAPERS;
+
+  /**
+   * Allocates the buffers and obtains the tapers and the batched plan of a length. Not realtime safe.
+   * @param length frame length.
+   */
+  MultitaperEstimator(unsigned int length);
+
+  MultitaperEstimator(const MultitaperEstimator&) = delete;
+  MultitaperEstimator& operator=(const MultitaperEstimator&) = delete;
+
+  ~MultitaperEstimator();
+
+  /**
+   * Estimates the power spectrum of a frame. Each taper has the energy of a rectangular window of the same length,
+   * so that noise levels match those of the rectangular window.
+   * @param frame length samples.
+   * @return length / 2 + 1 powers, valid until the next call.
+   */
+  const float* estimate(const float* frame);
+
+  /**
+   * @return root mean square over the tapers of their coefficient sums, the amplitude of a bin-centred tone of unit
+   * amplitude in the estimate.
+   */
+  double getCoherentSum() const;
+
+  /**
+   * @return equivalent noise bandwidth of a bin in bins.
+   */
+  double getNoiseBandwidth() const;
+
+  /**
+   * Computes DPSS tapers as the eigenvectors of the largest eigenvalues of the symmetric tridiagonal matrix that
+   * commutes with the concentration problem, by bisection and inverse iteration. Each taper has unit energy.
+   * @param length taper length.
+   * @param timeBandwidth time-bandwidth product NW.
+   * @param nTapers number of tapers.
+   * @param tapers receives nTapers tapers of length samples, one after the other.
+   */
+  static void dpss(unsigned int length, double timeBandwidth, unsigned int nTapers, std::vector<double>& tapers);
+
+private:
+  unsigned int length;
+
+  /**
+   * Shared tapers, N_TAPERS times length coefficients.
+   */
+  const float* tapers;
+  double coherentSum;
+  double noiseBandwidth;
+
+  fftwf_plan plan;
+  float* tapered;
+  fftwf_complex* spectra;
+  std::vector<float> power;
+};
+
+#endif /* OPENGL_SPECTROGRAM_MULTITAPERESTIMATOR_HPP */
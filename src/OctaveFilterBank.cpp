@@ -0,0 +1,253 @@
+#include "OctaveFilterBank.hpp"
+#include <algorithm>
+#include <complex>
+#include <math.h>
+#include <stdio.h>
+#include "Log.hpp"
+#include "Trace.hpp"
+#include "VectorOps.hpp"
+
+/* static member declarations and initializations */
+const unsigned int OctaveFilterBank::MAX_BANDS;
+const unsigned int OctaveFilterBank::MAX_STAGES;
+const unsigned int OctaveFilterBank::N_SECTIONS;
+const unsigned int OctaveFilterBank::N_DECIMATION_SECTIONS;
+const double OctaveFilterBank::DECIMATION_CUTOFF = 1.0 / 3.0;
+const float OctaveFilterBank::LOWEST_FREQUENCY = 19.0f;
+const float OctaveFilterBank::HIGHEST_EDGE = 0.9f;
+const double OctaveFilterBank::TIME_CONSTANT = 0.125;
+
+/* octave frequency ratio of the base-10 system */
+static const double OCTAVE_RATIO = pow(10.0, 0.3);
+
+/* nominal midband frequencies of a decade of one-third octave bands, from 1 */
+static const double NOMINAL_MANTISSAS[10] = {1.0, 1.25, 1.6, 2.0, 2.5, 3.15, 4.0, 5.0, 6.3, 8.0};
+
+/* added to every sample, so that the filter states of a silent input settle on a constant instead of decaying into
+ * denormals */
+static const float ANTI_DENORMAL = 1e-18f;
+
+/* level of silence, -200 dB */
+static const double MEAN_SQUARE_FLOOR = 1e-20;
+
+typedef std::complex<double> Complex;
+
+/* digital pole of an analog one by the bilinear transform at a rate */
+static Complex bilinear(Complex s, double rate)
+{
+    return (1.0 + s / (2.0 * rate)) / (1.0 - s / (2.0 * rate));
+}
+
+/* poles of the analog Butterworth lowpass prototype of an order, with cutoff 1 rad/s */
+static std::vector<Complex> butterworthPoles(unsigned int order)
+{
+    std::vector<Complex> poles;
+    for (unsigned int k = 0; k < order; ++k) poles.push_back(std::polar(1.0, M_PI * (2 * k + order + 1) / (2 * order)));
+    return poles;
+}
+
+void OctaveFilterBank::Biquads::resize(unsigned int n)
+{
+    for (std::vector<float>* v : {&b0, &b1, &b2, &a1, &a2, &z1, &z2}) v->assign(n, 0.0f);
+}
+
+void OctaveFilterBank::Biquads::set(unsigned int i, double poleRe, double poleIm, const double* numerator,
+                                    double gain)
+{
+    b0[i] = (float) (gain * numerator[0]);
+    b1[i] = (float) (gain * numerator[1]);
+    b2[i] = (float) (gain * numerator[2]);
+    a1[i] = (float) (-2.0 * poleRe);
+    a2[i] = (float) (poleRe * poleRe + poleIm * poleIm);
+}
+
+OctaveFilterBank::OctaveFilterBank(unsigned int samplingRate, unsigned int bandsPerOctave)
+  : bandsPerOctave(bandsPerOctave), nBands(0), nStages(0)
+{
+    if (bandsPerOctave != 1 && bandsPerOctave != 3) {
+        Log::getInstance()->logger() << "Bands must be octaves or one-third octaves" << std::endl;
+        throw 99;
+    }
+
+    /* every band on the one-third octave scale from the lowest up, while its upper edge fits below Nyquist */
+    double halfBand = pow(OCTAVE_RATIO, 0.5 / bandsPerOctave);
+    int step = 3 / bandsPerOctave;
+    int x = (int) ceil(3.0 * log(LOWEST_FREQUENCY / 1000.0) / log(OCTAVE_RATIO));
+    x = step * (int) ceil((double) x / step);
+    unsigned int stageOf[MAX_BANDS];
+    for (; nBands < MAX_BANDS; x += step) {
+        double frequency = 1000.0 * pow(OCTAVE_RATIO, x / 3.0);
+        if (frequency * halfBand > HIGHEST_EDGE * samplingRate / 2.0) break;
+
+        /* the lowest stage whose rate is at least four times the upper edge */
+        unsigned int k = 0;
+        while (k + 1 < MAX_STAGES && frequency * halfBand <= samplingRate / pow(2.0, k + 3)) ++k;
+        thirdIndex[nBands] = x;
+        frequencies[nBands] = (float) frequency;
+        stageOf[nBands] = k;
+        nStages = std::max(nStages, k + 1);
+        levels[nBands].store(-INFINITY, std::memory_order_relaxed);
+        ++nBands;
+    }
+
+    /* bands are ordered from the lowest up, so the highest stage comes first */
+    for (unsigned int k = 0; k < nStages; ++k) {
+        Stage& stage = stages[k];
+        double rate = samplingRate / pow(2.0, k);
+        stage.firstBand = nBands;
+        stage.nBands = 0;
+        for (unsigned int b = 0; b < nBands; ++b) {
+            if (stageOf[b] != k) continue;
+            stage.firstBand = std::min(stage.firstBand, b);
+            ++stage.nBands;
+        }
+        stage.bands.resize(N_SECTIONS * stage.nBands);
+        for (unsigned int lane = 0; lane < stage.nBands; ++lane) {
+            double frequency = frequencies[stage.firstBand + lane];
+            designBand(stage, lane, frequency / halfBand, frequency * halfBand, rate);
+        }
+        stage.decimation.resize(N_DECIMATION_SECTIONS);
+        designDecimation(stage, rate);
+        stage.weight = (float) (1.0 - exp(-1.0 / (TIME_CONSTANT * rate)));
+        stage.input.assign(stage.nBands, 0.0f);
+        stage.output.assign(stage.nBands, 0.0f);
+        stage.meanSquare.assign(stage.nBands, 0.0f);
+        stage.skip = false;
+    }
+    Log::getInstance()->logger() << "Filtering " << nBands << (bandsPerOctave == 1 ? " octave" : " one-third octave")
+                                 << " bands at " << nStages << " rates" << std::endl;
+}
+
+void OctaveFilterBank::designBand(Stage& stage, unsigned int lane, double f1, double f2, double rate)
+{
+    /* prewarped edges; the lowpass prototype pole p becomes the roots of s^2 - p B s + w0^2 */
+    double w1 = 2.0 * rate * tan(M_PI * f1 / rate);
+    double w2 = 2.0 * rate * tan(M_PI * f2 / rate);
+    double w0 = sqrt(w1 * w2), bandwidth = w2 - w1;
+    std::vector<Complex> poles;
+    for (Complex p : butterworthPoles(N_SECTIONS)) {
+        Complex root = sqrt(p * p * bandwidth * bandwidth - 4.0 * w0 * w0);
+        for (Complex s : {(p * bandwidth + root) / 2.0, (p * bandwidth - root) / 2.0}) {
+            Complex z = bilinear(s, rate);
+            if (z.imag() > 0.0) poles.push_back(z);
+        }
+    }
+
+    /* zeros at z = 1 and z = -1; every section has unit gain at the centre */
+    static const double numerator[3] = {1.0, 0.0, -1.0};
+    Complex centre = std::polar(1.0, 2.0 * atan(w0 / (2.0 * rate)));
+    for (unsigned int s = 0; s < N_SECTIONS && s < poles.size(); ++s) {
+        Complex z = poles[s];
+        Complex response = (1.0 - 1.0 / (centre * centre)) / ((1.0 - z / centre) * (1.0 - std::conj(z) / centre));
+        stage.bands.set(s * stage.nBands + lane, z.real(), z.imag(), numerator, 1.0 / std::abs(response));
+    }
+}
+
+void OctaveFilterBank::designDecimation(Stage& stage, double rate)
+{
+    /* Butterworth lowpass with double zeros at z = -1 and unit gain at DC */
+    double cutoff = 2.0 * rate * tan(M_PI * DECIMATION_CUTOFF / 2.0);
+    static const double numerator[3] = {1.0, 2.0, 1.0};
+    unsigned int s = 0;
+    for (Complex p : butterworthPoles(2 * N_DECIMATION_SECTIONS)) {
+        Complex z = bilinear(p * cutoff, rate);
+        if (z.imag() <= 0.0 || s == N_DECIMATION_SECTIONS) continue;
+        double gain = (1.0 - 2.0 * z.real() + std::norm(z)) / 4.0;
+        stage.decimation.set(s++, z.real(), z.imag(), numerator, gain);
+    }
+}
+
+unsigned int OctaveFilterBank::getNBands() const
+{
+    return nBands;
+}
+
+unsigned int OctaveFilterBank::getBandsPerOctave() const
+{
+    return bandsPerOctave;
+}
+
+float OctaveFilterBank::getFrequency(unsigned int band) const
+{
+    return frequencies[band];
+}
+
+void OctaveFilterBank::nominalLabel(unsigned int band, char* buffer) const
+{
+    int x = thirdIndex[band];
+    int decade = (int) floor(x / 10.0);
+    double nominal = NOMINAL_MANTISSAS[x - 10 * decade] * pow(10.0, 3 + decade);
+    if (nominal >= 1000.0) sprintf(buffer, "%gk", nominal / 1000.0);
+    else sprintf(buffer, "%g", nominal);
+}
+
+float OctaveFilterBank::getLevel(unsigned int band) const
+{
+    return levels[band].load(std::memory_order_relaxed);
+}
+
+void OctaveFilterBank::samplesCaptured(const float* samples, unsigned long numSamples, uint64_t firstSampleIndex,
+                                       double firstAdcTime)
+{
+    (void) samples;
+    (void) numSamples;
+    (void) firstSampleIndex;
+    (void) firstAdcTime;
+}
+
+void OctaveFilterBank::samplesProcessed(const float* samples, unsigned long numSamples, uint64_t firstSampleIndex,
+                                        double firstAdcTime)
+{
+    (void) firstSampleIndex;
+    (void) firstAdcTime;
+    TraceScope traceScope("octave bands");
+    for (unsigned long i = 0; i < numSamples; ++i) {
+        float x = samples[i] + ANTI_DENORMAL;
+        for (unsigned int k = 0; k < nStages; ++k) {
+            Stage& stage = stages[k];
+            unsigned int n = stage.nBands;
+            if (n) {
+                std::fill(stage.input.begin(), stage.input.end(), x);
+                const float* in = stage.input.data();
+                for (unsigned int s = 0; s < N_SECTIONS; ++s) {
+                    Biquads& b = stage.bands;
+                    unsigned int o = s * n;
+                    VectorOps::biquads(in, stage.output.data(), &b.b0[o], &b.b1[o], &b.b2[o], &b.a1[o], &b.a2[o],
+                                       &b.z1[o], &b.z2[o], n);
+                    in = stage.output.data();
+                }
+                for (unsigned int lane = 0; lane < n; ++lane) {
+                    float y = stage.output[lane];
+                    stage.meanSquare[lane] += stage.weight * (y * y - stage.meanSquare[lane]);
+                }
+            }
+            if (k + 1 == nStages) break;
+
+            /* the lowpass runs at this stage's rate, and every other output goes on to the stage below */
+            Biquads& d = stage.decimation;
+            for (unsigned int s = 0; s < N_DECIMATION_SECTIONS; ++s) {
+                VectorOps::biquads(&x, &x, &d.b0[s], &d.b1[s], &d.b2[s], &d.a1[s], &d.a2[s], &d.z1[s], &d.z2[s], 1);
+            }
+            stage.skip = !stage.skip;
+            if (stage.skip) break;
+        }
+    }
+
+    /* a full scale sine has a mean square of 1/2 */
+    for (unsigned int k = 0; k < nStages; ++k) {
+        const Stage& stage = stages[k];
+        for (unsigned int lane = 0; lane < stage.nBands; ++lane) {
+            double meanSquare = std::max((double) stage.meanSquare[lane], MEAN_SQUARE_FLOOR);
+            levels[stage.firstBand + lane].store((float) (10.0 * log10(2.0 * meanSquare)), std::memory_order_relaxed);
+        }
+    }
+}
+
+void OctaveFilterBank::sliceComputed(const float* slice, unsigned int nFrequencies, uint64_t endSampleIndex,
+                                     double adcTime)
+{
+    (void) slice;
+    (void) nFrequencies;
+    (void) endSampleIndex;
+    (void) adcTime;
+}
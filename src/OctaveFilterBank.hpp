@@ -0,0 +1,161 @@
+/**
+ * Octave or one-third octave band levels as a sound level meter shows them (IEC 61260-1 bands, IEC 61672-1 Fast time
+ * weighting), filtered in the time domain instead of binned from the FFT, whose bins have the wrong band shapes.
+ *
+ * Bands have the base-10 midband frequencies 1000 G^(x / b) Hz, G = 10^(3 / 10), b = 1 or 3, and edges a factor
+ * G^(1 / 2b) either side. Each is a Butterworth bandpass of order 2 N_SECTIONS with its -3 dB points at the edges.
+ *
+ * The bands run on octave-decimated copies of the signal: every stage halves the rate of the one above through the
+ * same lowpass, and each band runs at the lowest rate that still holds it comfortably, so every octave of bands costs
+ * half the one above and the total cost stays flat with the number of bands. Within a stage, the bands are the lanes
+ * of VectorOps::biquads(), one call per section.
+ */
+
+#ifndef OPENGL_SPECTROGRAM_OCTAVEFILTERBANK_HPP
+#define OPENGL_SPECTROGRAM_OCTAVEFILTERBANK_HPP
+
+#include <atomic>
+#include <vector>
+#include <stdint.h>
+#include "AudioListener.hpp"
+
+class OctaveFilterBank : public AudioListener {
+public:
+  static const unsigned int MAX_BANDS = 48;
+  static const unsigned int MAX_STAGES = 12;
+
+  /**
+   * Biquads per band filter.
+   */
+  static const unsigned int N_SECTIONS = 3;
+
+  /**
+   * Biquads of the decimation lowpass, and its cutoff as a fraction of the Nyquist frequency of the stage it filters.
+   */
+  static const unsigned int N_DECIMATION_SECTIONS = 4;
+  static const double DECIMATION_CUTOFF;
+
+  /**
+   * Lowest midband frequency, and highest upper band edge as a fraction of the Nyquist frequency.
+   */
+  static const float LOWEST_FREQUENCY;
+  static const float HIGHEST_EDGE;
+
+  /**
+   * Time constant of the exponential mean square, 125 ms for Fast.
+   */
+  static const double TIME_CONSTANT;
+
+  /**
+   * Designs the filters. Throws 99 unless bandsPerOctave is 1 or 3. Not realtime safe.
+   * @param samplingRate sampling rate of the audio.
+   * @param bandsPerOctave 1 for octave bands, 3 for one-third octave bands.
+   */
+  OctaveFilterBank(unsigned int samplingRate, unsigned int bandsPerOctave);
+
+  OctaveFilterBank(const OctaveFilterBank&) = delete;
+  OctaveFilterBank& operator=(const OctaveFilterBank&) = delete;
+
+  unsigned int getNBands() const;
+  unsigned int getBandsPerOctave() const;
+
+  /**
+   * @return exact midband frequency of a band in Hz, from the lowest band up.
+   */
+  float getFrequency(unsigned int band) const;
+
+  /**
+   * Formats the nominal midband frequency of a band, e.g. "31.5" or "1k".
+   * @param buffer receives the label, at least 8 bytes.
+   */
+  void nominalLabel(unsigned int band, char* buffer) const;
+
+  /**
+   * @return Fast weighted level of a band in dB re a full scale sine. Safe to call from any thread.
+   */
+  float getLevel(unsigned int band) const;
+
+  /**
+   * Ignores samples on the capture thread; the bands are filtered on the DSP thread instead.
+   */
+  virtual void samplesCaptured(const float* samples, unsigned long numSamples, uint64_t firstSampleIndex,
+                               double firstAdcTime);
+
+  /**
+   * Filters the samples and publishes the levels, on the DSP thread.
+   */
+  virtual void samplesProcessed(const float* samples, unsigned long numSamples, uint64_t firstSampleIndex,
+                                double firstAdcTime);
+
+  /**
+   * Ignores slices.
+   */
+  virtual void sliceComputed(const float* slice, unsigned int nFrequencies, uint64_t endSampleIndex, double adcTime);
+
+private:
+  /**
+   * Biquad coefficients and states, N_SECTIONS (or N_DECIMATION_SECTIONS) sections of lanes biquads each.
+   */
+  struct Biquads {
+    std::vector<float> b0, b1, b2, a1, a2, z1, z2;
+
+    void resize(unsigned int n);
+
+    /**
+     * Sets a biquad from its pole, in the upper half plane, and its numerator up to the gain.
+     * @param i index of the biquad.
+     * @param poleRe, poleIm digital pole; the other one is its conjugate.
+     * @param numerator b0, b1, b2 before scaling.
+     * @param gain scale of the numerator.
+     */
+    void set(unsigned int i, double poleRe, double poleIm, const double* numerator, double gain);
+  };
+
+  /**
+   * Bands sharing one rate, which is that of the stage above halved.
+   */
+  struct Stage {
+    unsigned int firstBand;
+    unsigned int nBands;
+    Biquads bands;
+    Biquads decimation;
+
+    /**
+     * Weight of a new squared sample in the mean square, at the rate of the stage.
+     */
+    float weight;
+
+    /**
+     * Input of every lane, the output of every lane, the mean squares, and whether the next sample is dropped by the
+     * decimation to the stage below.
+     */
+    std::vector<float> input;
+    std::vector<float> output;
+    std::vector<float> meanSquare;
+    bool skip;
+  };
+
+  /**
+   * Designs the sections of a band filter with edges f1 and f2 in Hz at a rate, into lanes of the stage.
+   */
+  void designBand(Stage& stage, unsigned int lane, double f1, double f2, double rate);
+
+  /**
+   * Designs the decimation lowpass of a stage at a rate.
+   */
+  void designDecimation(Stage& stage, double rate);
+
+  unsigned int bandsPerOctave;
+  unsigned int nBands;
+  unsigned int nStages;
+
+  /**
+   * Index of every band on the one-third octave scale, 0 at 1 kHz.
+   */
+  int thirdIndex[MAX_BANDS];
+  float frequencies[MAX_BANDS];
+  Stage stages[MAX_STAGES];
+  std::atomic<float> levels[MAX_BANDS];
+};
+
+#endif /* OPENGL_SPECTROGRAM_OCTAVEFILTERBANK_HPP */
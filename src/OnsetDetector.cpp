@@ -0,0 +1,161 @@
+#include "OnsetDetector.hpp"
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+#include "Trace.hpp"
+#include "VectorOps.hpp"
+
+/* static member declarations and initializations */
+const unsigned int OnsetDetector::MEDIAN_FRAMES = 32;
+const float OnsetDetector::THRESHOLD_FACTOR = 1.5f;
+const float OnsetDetector::THRESHOLD_DB = 1.0f;
+const float OnsetDetector::MIN_INTERVAL_SECONDS = 0.05f;
+
+/* power floor per frequency, about -200 dB, so that silence has a flux */
+static const float POWER_FLOOR = 1e-20f;
+
+/* samples per energy value when locating an onset */
+static const unsigned int LOCATE_BLOCK = 32;
+
+OnsetDetector::OnsetDetector(unsigned int samplingRate, unsigned int fftLength)
+  : DspStage<SpectrumFrame, OnsetEvent>("onset detector"), samplingRate(samplingRate), fftLength(fftLength),
+    previousPower(SpectrumFrame::MAX_FREQUENCIES), hasPrevious(false),
+    fluxHistory(MEDIAN_FRAMES), sortedFlux(MEDIAN_FRAMES), frames(0), lastOnsetSample(0), hasOnset(false),
+    pcmWritten(0), window(fftLength), detected(0)
+{
+    /* room for the window of a frame processed late, plus a margin for the block being written */
+    size_t capacity = 1;
+    while (capacity < 8 * (size_t) fftLength) capacity *= 2;
+    pcm.assign(capacity, 0.0f);
+}
+
+void OnsetDetector::samplesCaptured(const float* samples, unsigned long numSamples, uint64_t firstSampleIndex,
+                                    double firstAdcTime)
+{
+    (void) firstAdcTime;
+    uint64_t capacity = pcm.size();
+    if (numSamples > capacity) {
+        if (samples) samples += numSamples - capacity;
+        firstSampleIndex += numSamples - capacity;
+        numSamples = (unsigned long) capacity;
+    }
+    uint64_t start = firstSampleIndex % capacity;
+    unsigned long head = (unsigned long) std::min<uint64_t>(numSamples, capacity - start);
+    if (samples) {
+        memcpy(&pcm[start], samples, head * sizeof(float));
+        memcpy(&pcm[0], samples + head, (numSamples - head) * sizeof(float));
+    } else {
+        memset(&pcm[start], 0, head * sizeof(float));
+        memset(&pcm[0], 0, (numSamples - head) * sizeof(float));
+    }
+    pcmWritten.store(firstSampleIndex + numSamples, std::memory_order_release);
+}
+
+void OnsetDetector::sliceComputed(const float* slice, unsigned int nFrequencies, uint64_t endSampleIndex,
+                                  double adcTime)
+{
+    (void) slice;
+    (void) nFrequencies;
+    (void) endSampleIndex;
+    (void) adcTime;
+}
+
+unsigned long OnsetDetector::getDetected() const
+{
+    return detected.load(std::memory_order_relaxed);
+}
+
+bool OnsetDetector::process(const SpectrumFrame& frame, OnsetEvent& event)
+{
+    TraceScope traceScope("onset detector");
+    unsigned int n = frame.nFrequencies;
+    bool first = !hasPrevious;
+    float increase = VectorOps::rectifiedDifferenceSum(frame.power, previousPower.data(), n);
+    float previous = VectorOps::sum(previousPower.data(), n) + n * POWER_FLOOR;
+    float flux = 10.0f * log10f(1.0f + increase / previous);
+    memcpy(previousPower.data(), frame.power, n * sizeof(float));
+    hasPrevious = true;
+    if (first) return false;
+
+    /* compare with the median of the preceding frames only, so that the decision needs no later frame */
+    bool onset = false;
+    float threshold = 0.0f;
+    if (frames >= MEDIAN_FRAMES) {
+        sortedFlux = fluxHistory;
+        std::nth_element(sortedFlux.begin(), sortedFlux.begin() + MEDIAN_FRAMES / 2, sortedFlux.end());
+        threshold = THRESHOLD_FACTOR * sortedFlux[MEDIAN_FRAMES / 2] + THRESHOLD_DB;
+        onset = flux > threshold;
+    }
+    fluxHistory[frames % MEDIAN_FRAMES] = flux;
+    ++frames;
+    if (!onset) return false;
+
+    /* without the samples, the centre of the window is the best guess */
+    uint64_t sampleIndex;
+    if (!locate(frame.endSampleIndex, sampleIndex)) {
+        sampleIndex = frame.endSampleIndex > fftLength / 2 ? frame.endSampleIndex - fftLength / 2 : 0;
+    }
+    if (hasOnset && sampleIndex < lastOnsetSample + (uint64_t) (MIN_INTERVAL_SECONDS * samplingRate)) return false;
+    lastOnsetSample = sampleIndex;
+    hasOnset = true;
+
+    double before = (double) (frame.endSampleIndex - sampleIndex) / samplingRate;
+    event.sampleIndex = sampleIndex;
+    event.adcTime = frame.adcTime - before;
+    event.unixTime = frame.unixTime - before;
+    event.endSampleIndex = frame.endSampleIndex;
+    event.flux = flux;
+    event.threshold = threshold;
+    detected.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool OnsetDetector::locate(uint64_t endSampleIndex, uint64_t& sampleIndex)
+{
+    uint64_t capacity = pcm.size();
+    uint64_t margin = capacity / 4;
+    if (endSampleIndex < fftLength) return false;
+    uint64_t first = endSampleIndex - fftLength;
+    uint64_t written = pcmWritten.load(std::memory_order_acquire);
+    if (endSampleIndex > written || first + capacity < written + margin) return false;
+
+    uint64_t start = first % capacity;
+    unsigned long head = (unsigned long) std::min<uint64_t>(fftLength, capacity - start);
+    memcpy(window.data(), &pcm[start], head * sizeof(float));
+    memcpy(window.data() + head, &pcm[0], (fftLength - head) * sizeof(float));
+
+    /* capture may have lapped the copied window meanwhile */
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (first + capacity < pcmWritten.load(std::memory_order_relaxed) + margin) return false;
+
+    /* the loudest block, and the quietest as the level before the onset */
+    unsigned int nBlocks = fftLength / LOCATE_BLOCK;
+    if (nBlocks == 0) return false;
+    float quietest = 0.0f, loudest = 0.0f;
+    unsigned int loudestBlock = 0;
+    for (unsigned int b = 0; b < nBlocks; ++b) {
+        const float* block = &window[b * LOCATE_BLOCK];
+        float energy = VectorOps::dot(block, block, LOCATE_BLOCK) / LOCATE_BLOCK;
+        if (b == 0 || energy < quietest) quietest = energy;
+        if (energy > loudest) {
+            loudest = energy;
+            loudestBlock = b;
+        }
+    }
+    if (loudest <= 0.0f) return false;
+
+    /* walk back from the loudest block while above the level halfway between both in dB */
+    float level = sqrtf(std::max(quietest, 1e-6f * loudest) * loudest);
+    unsigned int b = loudestBlock;
+    while (b > 0) {
+        const float* block = &window[(b - 1) * LOCATE_BLOCK];
+        if (VectorOps::dot(block, block, LOCATE_BLOCK) / LOCATE_BLOCK < level) break;
+        --b;
+    }
+
+    /* the mean energy of block b reaches the level, so one of its samples does */
+    unsigned int i = b * LOCATE_BLOCK;
+    while (i + 1 < (b + 1) * LOCATE_BLOCK && window[i] * window[i] < level) ++i;
+    sampleIndex = first + i;
+    return true;
+}
@@ -0,0 +1,133 @@
+/**
+ * DSP graph stage detecting onsets (transients) in the spectrum frames by their spectral flux: the half-wave rectified
+ * increase of the power of every frequency over the previous frame, summed and relative to the total power of the
+ * previous frame, as 10 log10(1 + increase / previous) dB. Relative flux does not depend on the input level, and
+ * noise in frequencies far below the loudest ones hardly contributes to it. A frame is an onset if its flux exceeds
+ * THRESHOLD_FACTOR times the median flux of the preceding MEDIAN_FRAMES frames plus THRESHOLD_DB, and no onset was
+ * detected in the preceding MIN_INTERVAL_SECONDS.
+ *
+ * The decision uses past frames only, so an onset is reported while processing the frame that reveals it, without
+ * waiting for the next hop. Since a frame spans a whole FFT window, the detector also listens to the captured samples
+ * and locates the onset within that window at sample precision: the first sample of the energy rise leading to the
+ * loudest part of the window.
+ */
+
+#ifndef OPENGL_SPECTROGRAM_ONSETDETECTOR_HPP
+#define OPENGL_SPECTROGRAM_ONSETDETECTOR_HPP
+
+#include <atomic>
+#include <vector>
+#include <stdint.h>
+#include "AudioListener.hpp"
+#include "DspGraph.hpp"
+#include "SpectrumTap.hpp"
+
+/**
+ * One detected onset.
+ */
+struct OnsetEvent {
+  /**
+   * Index of the first sample of the onset.
+   */
+  uint64_t sampleIndex;
+
+  /**
+   * Capture and wall clock time of that sample.
+   */
+  double adcTime;
+  double unixTime;
+
+  /**
+   * End sample index of the frame that revealed the onset.
+   */
+  uint64_t endSampleIndex;
+
+  /**
+   * Spectral flux of that frame and the threshold it exceeded, in dB.
+   */
+  float flux;
+  float threshold;
+};
+
+class OnsetDetector : public AudioListener, public DspStage<SpectrumFrame, OnsetEvent> {
+public:
+  /**
+   * Number of preceding frames whose median flux sets the threshold.
+   */
+  static const unsigned int MEDIAN_FRAMES;
+
+  /**
+   * Threshold relative to the median flux, and above it.
+   */
+  static const float THRESHOLD_FACTOR;
+  static const float THRESHOLD_DB;
+
+  /**
+   * Shortest time between two onsets.
+   */
+  static const float MIN_INTERVAL_SECONDS;
+
+  /**
+   * @param samplingRate sampling rate of the audio.
+   * @param fftLength length of the window each frame was computed from, in samples.
+   */
+  OnsetDetector(unsigned int samplingRate, unsigned int fftLength);
+
+  /**
+   * Copies samples into the ring the onsets are located in. Realtime safe.
+   */
+  virtual void samplesCaptured(const float* samples, unsigned long numSamples, uint64_t firstSampleIndex,
+                               double firstAdcTime);
+
+  /**
+   * Ignores slices, which arrive through the DSP graph instead.
+   */
+  virtual void sliceComputed(const float* slice, unsigned int nFrequencies, uint64_t endSampleIndex, double adcTime);
+
+  /**
+   * @return number of onsets detected so far. Safe to call from any thread.
+   */
+  unsigned long getDetected() const;
+
+protected:
+  virtual bool process(const SpectrumFrame& frame, OnsetEvent& event);
+
+private:
+  /**
+   * Finds the first sample of the onset within the window of a frame.
+   * @param endSampleIndex end sample index of the frame.
+   * @param sampleIndex receives the first sample of the onset.
+   * @return false if the window is no longer in the ring.
+   */
+  bool locate(uint64_t endSampleIndex, uint64_t& sampleIndex);
+
+  unsigned int samplingRate;
+  unsigned int fftLength;
+
+  /**
+   * Power of the previous frame.
+   */
+  std::vector<float> previousPower;
+  bool hasPrevious;
+
+  /**
+   * Flux of the preceding MEDIAN_FRAMES frames, as a ring, and a scratch copy for the median.
+   */
+  std::vector<float> fluxHistory;
+  std::vector<float> sortedFlux;
+  unsigned long frames;
+
+  uint64_t lastOnsetSample;
+  bool hasOnset;
+
+  /**
+   * Ring of the latest captured samples, sample i at i % size, and the window copied out of it.
+   */
+  std::vector<float> pcm;
+  std::atomic<uint64_t> pcmWritten;
+  std::vector<float> window;
+
+  std::atomic<unsigned long> detected;
+};
+
+#endif /* OPENGL_SPECTROGRAM_ONSETDETECTOR_HPP */
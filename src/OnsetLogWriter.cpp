@@ -0,0 +1,33 @@
+#include "OnsetLogWriter.hpp"
+#include "Log.hpp"
+
+OnsetLogWriter::OnsetLogWriter(const char* path, FlightRecorder* flightRecorder)
+  : DspSink<OnsetEvent>("onset log"), file(nullptr), flightRecorder(flightRecorder)
+{
+    if (path) {
+        file = fopen(path, "w");
+        if (!file) {
+            Log::getInstance()->logger() << "Could not create " << path << std::endl;
+            throw 99;
+        }
+        fprintf(file, "unix_time,adc_time,sample,frame_end_sample,flux_db,threshold_db\n");
+        fflush(file);
+        Log::getInstance()->logger() << "Writing onsets to " << path << std::endl;
+    }
+}
+
+OnsetLogWriter::~OnsetLogWriter()
+{
+    if (file) fclose(file);
+}
+
+void OnsetLogWriter::consume(const OnsetEvent& event)
+{
+    if (file) {
+        fprintf(file, "%.6f,%.6f,%llu,%llu,%.2f,%.2f\n", event.unixTime, event.adcTime,
+                (unsigned long long) event.sampleIndex, (unsigned long long) event.endSampleIndex, event.flux,
+                event.threshold);
+        fflush(file);
+    }
+    if (flightRecorder) flightRecorder->trigger("onset");
+}
@@ -0,0 +1,40 @@
+/**
+ * DSP graph sink handling detected onsets: appends them to a CSV event log, one line per onset:
+ *    unix_time,adc_time,sample,frame_end_sample,flux_db,threshold_db
+ * flushed after every line so that other tools can follow it, and/or triggers a flight recorder dump around each.
+ */
+
+#ifndef OPENGL_SPECTROGRAM_ONSETLOGWRITER_HPP
+#define OPENGL_SPECTROGRAM_ONSETLOGWRITER_HPP
+
+#include <stdio.h>
+#include "DspGraph.hpp"
+#include "FlightRecorder.hpp"
+#include "OnsetDetector.hpp"
+
+class OnsetLogWriter : public DspSink<OnsetEvent> {
+public:
+  /**
+   * Creates the log and writes its header line. Throws 99 on failure.
+   * @param path path of the CSV file, or nullptr for no log.
+   * @param flightRecorder flight recorder to trigger on every onset, or nullptr.
+   */
+  OnsetLogWriter(const char* path, FlightRecorder* flightRecorder);
+
+  OnsetLogWriter(const OnsetLogWriter&) = delete;
+  OnsetLogWriter& operator=(const OnsetLogWriter&) = delete;
+
+  /**
+   * Closes the log.
+   */
+  ~OnsetLogWriter();
+
+protected:
+  virtual void consume(const OnsetEvent& event);
+
+private:
+  FILE* file;
+  FlightRecorder* flightRecorder;
+};
+
+#endif /* OPENGL_SPECTROGRAM_ONSETLOGWRITER_HPP */
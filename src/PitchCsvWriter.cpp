@@ -0,0 +1,28 @@
+#include "PitchCsvWriter.hpp"
+#include <math.h>
+#include "Log.hpp"
+
+PitchCsvWriter::PitchCsvWriter(const std::string& path)
+  : DspSink<PitchEstimate>("pitch csv")
+{
+    file = fopen(path.c_str(), "w");
+    if (!file) {
+        Log::getInstance()->logger() << "Could not create " << path << std::endl;
+        throw 99;
+    }
+    fprintf(file, "unix_time,adc_time,end_sample,frequency_hz,salience_db,midi_note\n");
+    Log::getInstance()->logger() << "Writing pitch track to " << path << std::endl;
+}
+
+PitchCsvWriter::~PitchCsvWriter()
+{
+    fclose(file);
+}
+
+void PitchCsvWriter::consume(const PitchEstimate& estimate)
+{
+    fprintf(file, "%.3f,%.6f,%llu,%.2f,%.1f,", estimate.unixTime, estimate.adcTime,
+            (unsigned long long) estimate.endSampleIndex, estimate.frequency, estimate.salience);
+    if (estimate.frequency > 0.0f) fprintf(file, "%.0f", roundf(PitchTracker::midiNote(estimate.frequency)));
+    fputc('\n', file);
+}
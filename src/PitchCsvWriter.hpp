@@ -0,0 +1,38 @@
+/**
+ * DSP graph sink exporting pitch estimates as CSV, one line per spectrum frame:
+ *    unix_time,adc_time,end_sample,frequency_hz,salience_db,midi_note
+ * where frequency_hz is 0 and midi_note is empty for unvoiced frames.
+ */
+
+#ifndef OPENGL_SPECTROGRAM_PITCHCSVWRITER_HPP
+#define OPENGL_SPECTROGRAM_PITCHCSVWRITER_HPP
+
+#include <stdio.h>
+#include <string>
+#include "DspGraph.hpp"
+#include "PitchTracker.hpp"
+
+class PitchCsvWriter : public DspSink<PitchEstimate> {
+public:
+  /**
+   * Creates the file and writes the header line. Throws 99 on failure.
+   * @param path path of the CSV file.
+   */
+  PitchCsvWriter(const std::string& path);
+
+  PitchCsvWriter(const PitchCsvWriter&) = delete;
+  PitchCsvWriter& operator=(const PitchCsvWriter&) = delete;
+
+  /**
+   * Flushes and closes the file.
+   */
+  ~PitchCsvWriter();
+
+protected:
+  virtual void consume(const PitchEstimate& estimate);
+
+private:
+  FILE* file;
+};
+
+#endif /* OPENGL_SPECTROGRAM_PITCHCSVWRITER_HPP */
@@ -0,0 +1,92 @@
+#include "PitchTracker.hpp"
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+#include "Trace.hpp"
+#include "VectorOps.hpp"
+
+/* static member declarations and initializations */
+const float PitchTracker::MIN_FREQUENCY = 60.0f;
+const float PitchTracker::MAX_FREQUENCY = 1500.0f;
+const unsigned int PitchTracker::N_HARMONICS = 5;
+const float PitchTracker::VOICING_DB = 8.0f;
+
+/* 10 log10(x) = DB_PER_LOG2 log2(x) */
+static const float DB_PER_LOG2 = 3.01029996f;
+
+/* power floor before taking logs, about -200 dB */
+static const float POWER_FLOOR = 1e-20f;
+
+PitchTracker::PitchTracker(unsigned int samplingRate)
+  : DspStage<SpectrumFrame, PitchEstimate>("pitch tracker"), samplingRate(samplingRate),
+    logPower(SpectrumFrame::MAX_FREQUENCIES), product(SpectrumFrame::MAX_FREQUENCIES), latest(0)
+{
+}
+
+void PitchTracker::getLatest(float& frequency, float& salience) const
+{
+    uint64_t packed = latest.load(std::memory_order_relaxed);
+    uint32_t bits[2] = {(uint32_t) packed, (uint32_t) (packed >> 32)};
+    memcpy(&frequency, &bits[0], sizeof(float));
+    memcpy(&salience, &bits[1], sizeof(float));
+}
+
+float PitchTracker::midiNote(float frequency)
+{
+    return 69.0f + 12.0f * log2f(frequency / 440.0f);
+}
+
+bool PitchTracker::process(const SpectrumFrame& frame, PitchEstimate& estimate)
+{
+    TraceScope traceScope("pitch tracker");
+    unsigned int n = frame.nFrequencies;
+    float hzPerBin = samplingRate / 2.0f / n;
+    estimate.endSampleIndex = frame.endSampleIndex;
+    estimate.adcTime = frame.adcTime;
+    estimate.unixTime = frame.unixTime;
+    estimate.frequency = 0.0f;
+    estimate.salience = 0.0f;
+
+    /* candidates need all harmonics (and the bin above the last) inside the spectrum */
+    unsigned int first = std::max(2u, (unsigned int) ceilf(MIN_FREQUENCY / hzPerBin));
+    unsigned int last = std::min((unsigned int) (MAX_FREQUENCY / hzPerBin), (n - 2) / N_HARMONICS);
+    if (first + 2 <= last) {
+        VectorOps::log2Approx(frame.power, logPower.data(), n, POWER_FLOOR);
+        unsigned int searched = N_HARMONICS * last + 3 - first;
+        float meanLog = VectorOps::sum(&logPower[first - 1], searched) / searched;
+
+        for (unsigned int k = first; k <= last; ++k) {
+            float sum = 0.0f;
+            for (unsigned int h = 1; h <= N_HARMONICS; ++h) {
+                const float* around = &logPower[h * k - 1];
+                sum += std::max(around[0], std::max(around[1], around[2]));
+            }
+            product[k - first] = sum;
+        }
+        unsigned int best = VectorOps::argmax(product.data(), last - first + 1);
+        float salience = DB_PER_LOG2 * (product[best] / N_HARMONICS - meanLog);
+
+        /* refine between bins by fitting f0 to the interpolated peaks of the audible harmonics, the higher ones
+         * being the more precise */
+        unsigned int k = first + best;
+        float weightedPeaks = 0.0f, weights = 0.0f;
+        for (unsigned int h = 1; h <= N_HARMONICS; ++h) {
+            unsigned int peak = h * k - 1;
+            for (unsigned int j = h * k; j <= h * k + 1; ++j) if (logPower[j] > logPower[peak]) peak = j;
+            if (logPower[peak] <= meanLog || peak == 0 || peak + 1 >= n) continue;
+            float below = logPower[peak - 1], at = logPower[peak], above = logPower[peak + 1];
+            float curvature = below - 2.0f * at + above;
+            float offset = curvature < 0.0f ? 0.5f * (below - above) / curvature : 0.0f;
+            weightedPeaks += h * (peak + offset);
+            weights += h * h;
+        }
+        estimate.salience = salience;
+        if (salience >= VOICING_DB) estimate.frequency = (weights > 0.0f ? weightedPeaks / weights : k) * hzPerBin;
+    }
+
+    uint32_t bits[2];
+    memcpy(&bits[0], &estimate.frequency, sizeof(float));
+    memcpy(&bits[1], &estimate.salience, sizeof(float));
+    latest.store(bits[0] | (uint64_t) bits[1] << 32, std::memory_order_relaxed);
+    return true;
+}
@@ -0,0 +1,88 @@
+/**
+ * DSP graph stage estimating the fundamental frequency of every spectrum frame with a harmonic product spectrum,
+ * reusing the power spectrum that the spectrogram already computed.
+ *
+ * The product of the spectrum decimated by 1..N_HARMONICS is taken as a sum of log powers, the harmonic of each
+ * candidate being the loudest of the three bins around it. The best candidate is refined by a least squares fit to the
+ * parabolically interpolated peaks of its harmonics, and reported as voiced if its harmonics stand out from the mean
+ * log power of the searched range by VOICING_DB.
+ */
+
+#ifndef OPENGL_SPECTROGRAM_PITCHTRACKER_HPP
+#define OPENGL_SPECTROGRAM_PITCHTRACKER_HPP
+
+#include <atomic>
+#include <vector>
+#include <stdint.h>
+#include "DspGraph.hpp"
+#include "SpectrumTap.hpp"
+
+/**
+ * Pitch of one spectrum frame.
+ */
+struct PitchEstimate {
+  uint64_t endSampleIndex;
+  double adcTime;
+  double unixTime;
+
+  /**
+   * Fundamental frequency in Hz, or 0 if the frame is unvoiced.
+   */
+  float frequency;
+
+  /**
+   * Mean level of the harmonics above the mean level of the searched range, in dB.
+   */
+  float salience;
+};
+
+class PitchTracker : public DspStage<SpectrumFrame, PitchEstimate> {
+public:
+  /**
+   * Searched range of fundamental frequencies.
+   */
+  static const float MIN_FREQUENCY;
+  static const float MAX_FREQUENCY;
+
+  /**
+   * Number of harmonics, including the fundamental, in the product.
+   */
+  static const unsigned int N_HARMONICS;
+
+  /**
+   * Salience above which a frame is voiced.
+   */
+  static const float VOICING_DB;
+
+  /**
+   * @param samplingRate sampling rate of the audio the frames were computed from.
+   */
+  PitchTracker(unsigned int samplingRate);
+
+  /**
+   * Latest estimate, for display. Safe to call from any thread.
+   * @param frequency receives the fundamental frequency, 0 if unvoiced.
+   * @param salience receives the salience in dB.
+   */
+  void getLatest(float& frequency, float& salience) const;
+
+  /**
+   * @return MIDI note number of a frequency, A4 (440 Hz) being 69.
+   */
+  static float midiNote(float frequency);
+
+protected:
+  virtual bool process(const SpectrumFrame& frame, PitchEstimate& estimate);
+
+private:
+  unsigned int samplingRate;
+  std::vector<float> logPower;
+  std::vector<float> product;
+
+  /**
+   * Frequency and salience of the latest estimate, packed so that they are read together.
+   */
+  std::atomic<uint64_t> latest;
+};
+
+#endif /* OPENGL_SPECTROGRAM_PITCHTRACKER_HPP */
@@ -0,0 +1,76 @@
+#include "PolyphaseFilterbank.hpp"
+#include <map>
+#include <math.h>
+#include <memory>
+#include <mutex>
+#include "Log.hpp"
+#include "Trace.hpp"
+#include "VectorOps.hpp"
+#include "WindowLibrary.hpp"
+
+/* static member declarations and initializations */
+const unsigned int PolyphaseFilterbank::TAPS = 8;
+const float PolyphaseFilterbank::PASSBAND_BINS = 1.5f;
+
+/**
+ * Returns the prototype of a length, computing it on first use.
+ */
+static const float* sharedPrototype(unsigned int length)
+{
+    static std::mutex mutex;
+    static std::map<unsigned int, std::unique_ptr<float[]>> prototypes;
+    std::lock_guard<std::mutex> lock(mutex);
+    std::unique_ptr<float[]>& found = prototypes[length];
+    if (!found) {
+        unsigned int span = PolyphaseFilterbank::TAPS * length;
+        const std::vector<float>& window =
+            WindowLibrary::getInstance()->get(WindowLibrary::BLACKMAN_HARRIS, span)->coefficients;
+        found.reset(new float[span]);
+        for (unsigned int i = 0; i < span; ++i) {
+            /* the sinc and the window are both centred on span / 2 */
+            double x = PolyphaseFilterbank::PASSBAND_BINS * ((double) i - span / 2.0) / length;
+            double sinc = x == 0.0 ? 1.0 : sin(M_PI * x) / (M_PI * x);
+            found[i] = (float) (sinc * window[i]);
+        }
+        Log::getInstance()->logger() << "Computed a " << PolyphaseFilterbank::TAPS << " tap polyphase prototype for "
+                                     << length << " bins" << std::endl;
+    }
+    return found.get();
+}
+
+PolyphaseFilterbank::PolyphaseFilterbank(unsigned int length)
+  : length(length)
+{
+    prototype = sharedPrototype(length);
+    double sum = 0.0, squares = 0.0;
+    for (unsigned int i = 0; i < getSpan(); ++i) {
+        sum += prototype[i];
+        squares += (double) prototype[i] * prototype[i];
+    }
+    coherentSum = sum;
+    noiseBandwidth = length * squares / (sum * sum);
+}
+
+void PolyphaseFilterbank::fold(const float* samples, float* folded) const
+{
+    TraceScope traceScope("polyphase fold");
+    VectorOps::multiply(samples, prototype, folded, length);
+    for (unsigned int t = 1; t < TAPS; ++t) {
+        VectorOps::multiplyAdd(samples + t * length, prototype + t * length, folded, length);
+    }
+}
+
+unsigned int PolyphaseFilterbank::getSpan() const
+{
+    return TAPS * length;
+}
+
+double PolyphaseFilterbank::getCoherentSum() const
+{
+    return coherentSum;
+}
+
+double PolyphaseFilterbank::getNoiseBandwidth() const
+{
+    return noiseBandwidth;
+}
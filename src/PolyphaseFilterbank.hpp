@@ -0,0 +1,66 @@
+/**
+ * Polyphase filterbank (PFB) front end: the TAPS * length most recent samples are weighted by a prototype lowpass
+ * filter and folded into length samples by summing the TAPS segments, so that the FFT of the folded frame is a bank of
+ * length bandpass filters, each the prototype shifted to the centre of a bin.
+ *
+ * The prototype is a sinc with a passband of PASSBAND_BINS bins, windowed by a Blackman-Harris window of the full
+ * TAPS * length samples. Compared with the Gaussian window on its own, a tone between two bins loses 0.3 dB instead of
+ * 1.6 dB, and leakage beyond 1.5 bins falls from -16 dB to below -110 dB, for TAPS multiply-adds per sample on top of
+ * the unchanged FFT. With hops shorter than length, the bank is oversampled in time.
+ */
+
+#ifndef OPENGL_SPECTROGRAM_POLYPHASEFILTERBANK_HPP
+#define OPENGL_SPECTROGRAM_POLYPHASEFILTERBANK_HPP
+
+class PolyphaseFilterbank {
+public:
+  /**
+   * Number of segments folded into a frame.
+   */
+  static const unsigned int TAPS;
+
+  /**
+   * Width of the passband of the prototype in bins, a little over 1 so that the bins overlap with a flat top.
+   */
+  static const float PASSBAND_BINS;
+
+  /**
+   * Obtains the prototype of a length. Not realtime safe.
+   * @param length number of bins, the length of the folded frame.
+   */
+  PolyphaseFilterbank(unsigned int length);
+
+  /**
+   * Weights and folds samples.
+   * @param samples TAPS * length consecutive samples, oldest first.
+   * @param folded receives length samples.
+   */
+  void fold(const float* samples, float* folded) const;
+
+  /**
+   * @return number of samples taken per frame, TAPS * length.
+   */
+  unsigned int getSpan() const;
+
+  /**
+   * @return sum of the prototype coefficients, the amplitude of a bin-centred tone of unit amplitude in its bin.
+   */
+  double getCoherentSum() const;
+
+  /**
+   * @return equivalent noise bandwidth of a bin in bins.
+   */
+  double getNoiseBandwidth() const;
+
+private:
+  unsigned int length;
+
+  /**
+   * Shared prototype of TAPS * length coefficients, and its sums.
+   */
+  const float* prototype;
+  double coherentSum;
+  double noiseBandwidth;
+};
+
+#endif /* OPENGL_SPECTROGRAM_POLYPHASEFILTERBANK_HPP */
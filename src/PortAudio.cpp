@@ -47,14 +47,21 @@ int PortAudio::audioIn(const void* inputBuffer, void* outputBuffer, unsigned lon
                        void* customData)
 {
     //Log::getInstance()->logger() << "audioIn()" << std::endl;
+    TraceScope traceScope("audio callback");
     PortAudio *instance = (PortAudio*)customData;
     const SAMPLE *in = (SAMPLE*)inputBuffer;
     int index;
     
     /* prevent unused variable warnings */
     (void) outputBuffer;
-    (void) timeInfo;
-    (void) statusFlags;
+
+    instance->reportStatus((statusFlags & paInputOverflow) != 0, (statusFlags & paInputUnderflow) != 0);
+
+    /* some host APIs leave the ADC time at zero, in which case estimate it from the callback time */
+    double firstAdcTime = timeInfo->inputBufferAdcTime;
+    if (firstAdcTime == 0.0) {
+        firstAdcTime = timeInfo->currentTime - numSamples * instance->samplingPeriod;
+    }
     
     if (inputBuffer == NULL)
     {
@@ -77,8 +84,10 @@ int PortAudio::audioIn(const void* inputBuffer, void* outputBuffer, unsigned lon
             //if (NUM_CHANNELS == 2) audioBuffer[i] = *in++; /* right channel */
         }
     }
+    instance->injectSelfTestClick(instance->bufferIndex, numSamples, firstAdcTime);
     instance->bufferIndex = mod(instance->bufferIndex + numSamples, instance->bufferSizeSamples);
-    computeSpectrogramSlice(instance);
+    instance->notifySamplesCaptured(in, numSamples, firstAdcTime);
+    instance->submitHops(numSamples, firstAdcTime + (numSamples - 1) * instance->samplingPeriod);
     
     //Log::getInstance()->logger() << "Buffer Index: " << instance->bufferIndex << std::endl;
     //Log::getInstance()->logger() << "# Samples: " << numSamples << ", Size: " << instance->bufferSizeSamples << std::endl;
@@ -108,6 +117,11 @@ void PortAudio::quitNow()
     }
 }
 
+double PortAudio::getStreamTime()
+{
+    return Pa_GetStreamTime(stream);
+}
+
 int PortAudio::startCapture()
 {
     PaError err;
@@ -167,6 +181,9 @@ int PortAudio::startCapture()
 
     }
     
+    /* the callback thread must not allocate its trace buffer itself */
+    Trace::getInstance()->reserveThread("audio callback");
+
     /* start the audio stream */
     err = Pa_StartStream(stream);
     if (err != paNoError) {
@@ -10,6 +10,7 @@
 #include <portaudio.h>
 #include "AudioInput.hpp"
 #include "Log.hpp"
+#include "Trace.hpp"
 
 typedef float SAMPLE;
 #define SAMPLE_SILENCE (0.0f)
@@ -55,6 +56,11 @@ public:
    */
   virtual void quitNow();
 
+  /**
+   * @return current time of the PortAudio stream clock, on which the callback ADC timestamps are given.
+   */
+  virtual double getStreamTime();
+
 private:
     /**
      * Audio stream pointer.
@@ -0,0 +1,249 @@
+#include "SharedColumnRing.hpp"
+#include <algorithm>
+#include <climits>
+#include <errno.h>
+#include <new>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include "Log.hpp"
+
+/* static member declarations and initializations */
+const uint32_t SharedColumnRing::VERSION = 1;
+
+static const char MAGIC[8] = "AVSHM1";
+static const size_t ALIGNMENT = 64;
+
+static size_t alignUp(size_t bytes)
+{
+    return (bytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+SharedColumnPublisher::SharedColumnPublisher(const std::string& name, unsigned int nFrequencies,
+                                             unsigned int samplingRate, unsigned int columnSlots, uint64_t pcmSamples)
+  : name(name), bytes(0), base(nullptr), header(nullptr), pcm(nullptr)
+{
+    size_t headerBytes = alignUp(sizeof(SharedColumnRing::Header));
+    size_t slotBytes = alignUp(sizeof(SharedColumnRing::Slot) + nFrequencies * sizeof(float));
+    size_t pcmOffset = headerBytes + columnSlots * slotBytes;
+    bytes = pcmOffset + pcmSamples * sizeof(float);
+
+    /* a segment left behind by a crashed process is replaced, readers still attached to it keep the old one */
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        Log::getInstance()->logger() << "Could not create shared memory " << name << ": " << strerror(errno) << std::endl;
+        throw 99;
+    }
+    void* p = MAP_FAILED;
+    if (ftruncate(fd, (off_t) bytes) == 0) {
+        p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (p == MAP_FAILED) {
+        Log::getInstance()->logger() << "Could not map shared memory " << name << std::endl;
+        shm_unlink(name.c_str());
+        throw 99;
+    }
+    base = (uint8_t*) p;
+
+    /* pre-fault every page, so publishing never page faults */
+    memset(base, 0, bytes);
+    header = new (base) SharedColumnRing::Header();
+    header->version = SharedColumnRing::VERSION;
+    header->headerBytes = (uint32_t) headerBytes;
+    header->nFrequencies = nFrequencies;
+    header->samplingRate = samplingRate;
+    header->columnSlots = columnSlots;
+    header->slotBytes = (uint32_t) slotBytes;
+    header->pcmSamples = pcmSamples;
+    header->pcmOffset = pcmOffset;
+    header->columnsWritten = 0;
+    header->samplesWritten = 0;
+    header->sequence = 0;
+    header->publisherPid = (uint32_t) getpid();
+    for (unsigned int s = 0; s < columnSlots; ++s) {
+        new (base + headerBytes + s * slotBytes) SharedColumnRing::Slot();
+    }
+    pcm = pcmSamples ? (float*) (base + pcmOffset) : nullptr;
+
+    /* readers check the magic last */
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(header->magic, MAGIC, sizeof(MAGIC));
+
+    Log::getInstance()->logger() << "Publishing columns" << (pcm ? " and PCM" : "") << " in shared memory " << name
+                                 << " (" << bytes / 1024 << " KiB)" << std::endl;
+}
+
+SharedColumnPublisher::~SharedColumnPublisher()
+{
+    munmap(base, bytes);
+    shm_unlink(name.c_str());
+}
+
+void SharedColumnPublisher::samplesCaptured(const float* samples, unsigned long numSamples,
+                                            uint64_t firstSampleIndex, double firstAdcTime)
+{
+    (void) firstAdcTime;
+    if (!pcm) return;
+    uint64_t capacity = header->pcmSamples;
+
+    /* only the newest capacity samples of a huge block survive anyway */
+    if (numSamples > capacity) {
+        if (samples) samples += numSamples - capacity;
+        firstSampleIndex += numSamples - capacity;
+        numSamples = (unsigned long) capacity;
+    }
+    uint64_t start = firstSampleIndex % capacity;
+    unsigned long head = (unsigned long) std::min<uint64_t>(numSamples, capacity - start);
+    if (samples) {
+        memcpy(pcm + start, samples, head * sizeof(float));
+        memcpy(pcm, samples + head, (numSamples - head) * sizeof(float));
+    } else {
+        memset(pcm + start, 0, head * sizeof(float));
+        memset(pcm, 0, (numSamples - head) * sizeof(float));
+    }
+    header->samplesWritten.store(firstSampleIndex + numSamples, std::memory_order_release);
+}
+
+void SharedColumnPublisher::sliceComputed(const float* slice, unsigned int nFrequencies, uint64_t endSampleIndex,
+                                          double adcTime)
+{
+    uint64_t n = header->columnsWritten.load(std::memory_order_relaxed);
+    SharedColumnRing::Slot* slot = (SharedColumnRing::Slot*) (base + header->headerBytes
+                                                               + (n % header->columnSlots) * header->slotBytes);
+
+    /* seqlock: odd while writing */
+    slot->sequence.store(2 * n + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot->endSampleIndex = endSampleIndex;
+    slot->adcTime = adcTime;
+    unsigned int copied = std::min(nFrequencies, header->nFrequencies);
+    float* power = (float*) (slot + 1);
+    memcpy(power, slice, copied * sizeof(float));
+    memset(power + copied, 0, (header->nFrequencies - copied) * sizeof(float));
+    slot->sequence.store(2 * n + 2, std::memory_order_release);
+
+    header->columnsWritten.store(n + 1, std::memory_order_release);
+    header->sequence.fetch_add(1, std::memory_order_release);
+    syscall(SYS_futex, &header->sequence, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+SharedColumnReader::SharedColumnReader(const std::string& name)
+  : bytes(0), base(nullptr), header(nullptr)
+{
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        Log::getInstance()->logger() << "Could not open shared memory " << name << ": " << strerror(errno) << std::endl;
+        throw 99;
+    }
+    struct stat status;
+    void* p = MAP_FAILED;
+    if (fstat(fd, &status) == 0 && (size_t) status.st_size >= sizeof(SharedColumnRing::Header)) {
+        bytes = (size_t) status.st_size;
+        p = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (p == MAP_FAILED) {
+        Log::getInstance()->logger() << "Could not map shared memory " << name << std::endl;
+        throw 99;
+    }
+    base = (const uint8_t*) p;
+    header = (const SharedColumnRing::Header*) base;
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 || header->version != SharedColumnRing::VERSION
+        || header->pcmOffset + header->pcmSamples * sizeof(float) > bytes) {
+        Log::getInstance()->logger() << "Shared memory " << name << " has an unknown layout" << std::endl;
+        munmap((void*) base, bytes);
+        throw 99;
+    }
+}
+
+SharedColumnReader::~SharedColumnReader()
+{
+    munmap((void*) base, bytes);
+}
+
+const SharedColumnRing::Header& SharedColumnReader::getHeader() const
+{
+    return *header;
+}
+
+uint64_t SharedColumnReader::getColumnsWritten() const
+{
+    return header->columnsWritten.load(std::memory_order_acquire);
+}
+
+uint64_t SharedColumnReader::getSamplesWritten() const
+{
+    return header->samplesWritten.load(std::memory_order_acquire);
+}
+
+bool SharedColumnReader::wait(uint32_t& sequence, int timeoutMs)
+{
+    uint32_t current = header->sequence.load(std::memory_order_acquire);
+    if (current == sequence) {
+        timespec timeout = {timeoutMs / 1000, (timeoutMs % 1000) * 1000000L};
+        syscall(SYS_futex, &header->sequence, FUTEX_WAIT, sequence, &timeout, nullptr, 0);
+        current = header->sequence.load(std::memory_order_acquire);
+    }
+    bool published = current != sequence;
+    sequence = current;
+    return published;
+}
+
+const SharedColumnRing::Slot* SharedColumnReader::peek(uint64_t column, uint64_t& token) const
+{
+    const SharedColumnRing::Slot* slot = (const SharedColumnRing::Slot*) (base + header->headerBytes
+                                                                          + (column % header->columnSlots)
+                                                                            * header->slotBytes);
+    token = slot->sequence.load(std::memory_order_acquire);
+    return token == 2 * column + 2 ? slot : nullptr;
+}
+
+const float* SharedColumnReader::power(const SharedColumnRing::Slot* slot) const
+{
+    return (const float*) (slot + 1);
+}
+
+bool SharedColumnReader::validate(const SharedColumnRing::Slot* slot, uint64_t token) const
+{
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot->sequence.load(std::memory_order_relaxed) == token;
+}
+
+bool SharedColumnReader::readColumn(uint64_t column, float* out, uint64_t& endSampleIndex, double& adcTime) const
+{
+    uint64_t token;
+    const SharedColumnRing::Slot* slot = peek(column, token);
+    if (!slot) return false;
+    endSampleIndex = slot->endSampleIndex;
+    adcTime = slot->adcTime;
+    memcpy(out, power(slot), header->nFrequencies * sizeof(float));
+    return validate(slot, token);
+}
+
+bool SharedColumnReader::readSamples(uint64_t first, unsigned long count, float* out) const
+{
+    uint64_t capacity = header->pcmSamples;
+    if (count > capacity) return false;
+    uint64_t margin = capacity / 8;
+    uint64_t written = getSamplesWritten();
+    if (first + count > written || first + capacity < written + margin) return false;
+
+    const float* pcm = (const float*) (base + header->pcmOffset);
+    uint64_t start = first % capacity;
+    unsigned long head = (unsigned long) std::min<uint64_t>(count, capacity - start);
+    memcpy(out, pcm + start, head * sizeof(float));
+    memcpy(out + head, pcm, (count - head) * sizeof(float));
+
+    /* the publisher may have lapped the copied range meanwhile, or be writing a block over its oldest part */
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return first + capacity >= header->samplesWritten.load(std::memory_order_relaxed) + margin;
+}
@@ -0,0 +1,187 @@
+/**
+ * Publication of the spectrogram columns, and optionally the raw PCM, to other local processes through a POSIX
+ * shared memory ring, so that detectors, loggers or a second viewer reuse the capture and FFT work of this process.
+ *
+ * Segment layout (native endianness, every part aligned to 64 bytes):
+ *    header:  SharedColumnRing::Header
+ *    columns: columnSlots slots of slotBytes: uint64 sequence, uint64 endSampleIndex, double adcTime,
+ *             float power[nFrequencies]
+ *    pcm:     float samples[pcmSamples], if pcmSamples > 0
+ *
+ * Column n lives in slot n % columnSlots. Its slot sequence is 2n + 1 while the publisher writes it and 2n + 2 once it
+ * is complete (a seqlock), so readers can use a column in place and then check that it was not overwritten meanwhile.
+ * The PCM ring holds sample i at i % pcmSamples. Since the publisher writes a block before advancing samplesWritten,
+ * readers only trust samples newer than samplesWritten - 7/8 pcmSamples.
+ *
+ * After every column the publisher increments the header sequence and wakes futex waiters on it, so readers sleep
+ * instead of polling. Readers map the segment read-only and never write to it.
+ */
+
+#ifndef OPENGL_SPECTROGRAM_SHAREDCOLUMNRING_HPP
+#define OPENGL_SPECTROGRAM_SHAREDCOLUMNRING_HPP
+
+#include <atomic>
+#include <string>
+#include <stdint.h>
+#include "AudioListener.hpp"
+
+namespace SharedColumnRing {
+
+/**
+ * Layout version, incremented on any incompatible change.
+ */
+extern const uint32_t VERSION;
+
+/**
+ * Segment header. The atomics are lock-free, hence address-free, so they work across processes.
+ */
+struct Header {
+  char magic[8];           /* "AVSHM1" */
+  uint32_t version;
+  uint32_t headerBytes;
+  uint32_t nFrequencies;
+  uint32_t samplingRate;
+  uint32_t columnSlots;
+  uint32_t slotBytes;
+  uint64_t pcmSamples;
+  uint64_t pcmOffset;      /* byte offset of the PCM ring */
+  std::atomic<uint64_t> columnsWritten;
+  std::atomic<uint64_t> samplesWritten;
+  std::atomic<uint32_t> sequence;  /* futex word, incremented after every column */
+  uint32_t publisherPid;
+};
+
+/**
+ * Column slot header, followed by the power spectrum.
+ */
+struct Slot {
+  std::atomic<uint64_t> sequence;
+  uint64_t endSampleIndex;
+  double adcTime;
+};
+
+}
+
+/**
+ * Creates a segment and publishes into it the slices and samples of the AudioInput it listens to.
+ */
+class SharedColumnPublisher : public AudioListener {
+public:
+  /**
+   * Creates the segment, replacing any stale one of the same name. Throws 99 on failure.
+   * @param name shared memory object name, e.g. "/spectrogram".
+   * @param nFrequencies number of frequencies per column.
+   * @param samplingRate sampling rate of the audio.
+   * @param columnSlots number of columns kept.
+   * @param pcmSamples number of samples kept, or 0 not to publish PCM.
+   */
+  SharedColumnPublisher(const std::string& name, unsigned int nFrequencies, unsigned int samplingRate,
+                        unsigned int columnSlots, uint64_t pcmSamples);
+
+  SharedColumnPublisher(const SharedColumnPublisher&) = delete;
+  SharedColumnPublisher& operator=(const SharedColumnPublisher&) = delete;
+
+  /**
+   * Unmaps and removes the segment; readers attached to it keep their mapping.
+   */
+  ~SharedColumnPublisher();
+
+  /**
+   * Copies samples into the PCM ring, if any. Realtime safe.
+   */
+  virtual void samplesCaptured(const float* samples, unsigned long numSamples, uint64_t firstSampleIndex,
+                               double firstAdcTime);
+
+  /**
+   * Writes a column into its slot and wakes readers. Realtime safe: the wakeup is a non-blocking system call.
+   */
+  virtual void sliceComputed(const float* slice, unsigned int nFrequencies, uint64_t endSampleIndex, double adcTime);
+
+private:
+  std::string name;
+  size_t bytes;
+  uint8_t* base;
+  SharedColumnRing::Header* header;
+  float* pcm;
+};
+
+/**
+ * Read-only attachment to a segment created by a SharedColumnPublisher, possibly in another process.
+ */
+class SharedColumnReader {
+public:
+  /**
+   * Maps an existing segment read-only. Throws 99 if it does not exist or has an unknown layout.
+   * @param name shared memory object name.
+   */
+  SharedColumnReader(const std::string& name);
+
+  SharedColumnReader(const SharedColumnReader&) = delete;
+  SharedColumnReader& operator=(const SharedColumnReader&) = delete;
+
+  ~SharedColumnReader();
+
+  const SharedColumnRing::Header& getHeader() const;
+
+  /**
+   * @return number of columns published so far; the newest is column getColumnsWritten() - 1.
+   */
+  uint64_t getColumnsWritten() const;
+
+  /**
+   * @return number of samples published so far.
+   */
+  uint64_t getSamplesWritten() const;
+
+  /**
+   * Sleeps until a column is published after the one seen in sequence, or until the timeout.
+   * @param sequence header sequence seen last, updated to the current one.
+   * @param timeoutMs maximum wait in milliseconds.
+   * @return whether a column was published.
+   */
+  bool wait(uint32_t& sequence, int timeoutMs);
+
+  /**
+   * Zero-copy access to a column, which stays usable until validate() says that it was overwritten.
+   * @param column column number.
+   * @param token receives the slot sequence to pass to validate().
+   * @return the slot of the column, followed by its power spectrum, or nullptr if it is not (or no longer) available.
+   */
+  const SharedColumnRing::Slot* peek(uint64_t column, uint64_t& token) const;
+
+  /**
+   * @return the power spectrum of a slot returned by peek().
+   */
+  const float* power(const SharedColumnRing::Slot* slot) const;
+
+  /**
+   * @return whether the column read through peek() was left untouched by the publisher until now.
+   */
+  bool validate(const SharedColumnRing::Slot* slot, uint64_t token) const;
+
+  /**
+   * Copies a column.
+   * @param column column number.
+   * @param out receives nFrequencies powers.
+   * @param endSampleIndex receives the end sample index of the column.
+   * @param adcTime receives the capture time of the column.
+   * @return false if the column is not (or no longer) available.
+   */
+  bool readColumn(uint64_t column, float* out, uint64_t& endSampleIndex, double& adcTime) const;
+
+  /**
+   * Copies samples from the PCM ring.
+   * @param first index of the first sample.
+   * @param count number of samples.
+   * @param out receives the samples.
+   * @return false if the samples are not published yet, are too old, or were overwritten while copying.
+   */
+  bool readSamples(uint64_t first, unsigned long count, float* out) const;
+
+private:
+  size_t bytes;
+  const uint8_t* base;
+  const SharedColumnRing::Header* header;
+};
+
+#endif /* OPENGL_SPECTROGRAM_SHAREDCOLUMNRING_HPP */
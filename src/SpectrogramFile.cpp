@@ -0,0 +1,135 @@
+#include "SpectrogramFile.hpp"
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+#include <zlib.h>
+#include "Log.hpp"
+
+/* static member declarations and initializations */
+const char SpectrogramFile::HEADER_MAGIC[8] = "AVSPEC1";
+const char SpectrogramFile::TRAILER_MAGIC[8] = "AVSPIDX";
+const float SpectrogramFile::DEFAULT_DB_FLOOR = -60.0f;
+const float SpectrogramFile::DEFAULT_DB_STEP = 0.5f;
+const unsigned int SpectrogramFile::DEFAULT_COLUMNS_PER_CHUNK = 256;
+
+SpectrogramFile::SpectrogramFile(const std::string& path)
+{
+    file = fopen(path.c_str(), "rb");
+    if (!file) {
+        Log::getInstance()->logger() << "Could not open " << path << std::endl;
+        throw 99;
+    }
+    if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, HEADER_MAGIC, sizeof(HEADER_MAGIC))) {
+        Log::getInstance()->logger() << path << " is not a spectrogram recording." << std::endl;
+        fclose(file);
+        throw 99;
+    }
+
+    /* load the index from the trailer, if the recording was closed properly */
+    Trailer trailer;
+    bool indexed = fseeko(file, -(off_t) sizeof(trailer), SEEK_END) == 0 &&
+                   fread(&trailer, sizeof(trailer), 1, file) == 1 &&
+                   !memcmp(trailer.magic, TRAILER_MAGIC, sizeof(TRAILER_MAGIC));
+    if (indexed) {
+        index.resize(trailer.nChunks);
+        indexed = fseeko(file, (off_t) trailer.indexOffset, SEEK_SET) == 0 &&
+                  fread(index.data(), sizeof(IndexEntry), index.size(), file) == index.size();
+    }
+    if (!indexed) {
+        Log::getInstance()->logger() << path << " has no seek index, rebuilding it." << std::endl;
+        rebuildIndex();
+    }
+
+    Log::getInstance()->logger() << "Opened " << path << ": " << index.size() << " chunks, "
+                                 << (getLastSampleIndex() - getFirstSampleIndex()) / (double) header.samplingRate
+                                 << " s" << std::endl;
+}
+
+SpectrogramFile::~SpectrogramFile()
+{
+    fclose(file);
+}
+
+void SpectrogramFile::rebuildIndex()
+{
+    index.clear();
+    off_t offset = sizeof(Header);
+    ChunkHeader chunkHeader;
+    std::vector<uint64_t> endSampleIndices;
+    std::vector<uint8_t> bins;
+    while (fseeko(file, offset, SEEK_SET) == 0 && fread(&chunkHeader, sizeof(chunkHeader), 1, file) == 1) {
+        /* a chunk cut short by the crash is dropped */
+        IndexEntry entry = {chunkHeader.firstEndSampleIndex, chunkHeader.firstEndSampleIndex, (uint64_t) offset,
+                            chunkHeader.nColumns, 0};
+        index.push_back(entry);
+        if (readChunk(index.size() - 1, endSampleIndices, bins) != (int) chunkHeader.nColumns) {
+            index.pop_back();
+            break;
+        }
+        index.back().lastEndSampleIndex = endSampleIndices.back();
+        offset += sizeof(chunkHeader) + chunkHeader.compressedBytes;
+    }
+}
+
+uint8_t SpectrogramFile::quantize(float power, float dbFloor, float dbStep)
+{
+    if (power <= 0.0f) return 0;
+    float level = (10.0f * log10f(power) - dbFloor) / dbStep;
+    return (uint8_t) std::max(0.0f, std::min(255.0f, roundf(level)));
+}
+
+float SpectrogramFile::dequantize(uint8_t level, float dbFloor, float dbStep)
+{
+    return powf(10.0f, (dbFloor + level * dbStep) / 10.0f);
+}
+
+int SpectrogramFile::readChunk(size_t chunk, std::vector<uint64_t>& endSampleIndices, std::vector<uint8_t>& bins)
+{
+    ChunkHeader chunkHeader;
+    if (fseeko(file, (off_t) index[chunk].offset, SEEK_SET) != 0 ||
+        fread(&chunkHeader, sizeof(chunkHeader), 1, file) != 1) {
+        return -1;
+    }
+    compressed.resize(chunkHeader.compressedBytes);
+    if (fread(compressed.data(), 1, compressed.size(), file) != compressed.size()) return -1;
+
+    /* the column times and the bins are decompressed into one buffer and split afterwards */
+    size_t nColumns = chunkHeader.nColumns;
+    std::vector<uint8_t> raw(nColumns * (sizeof(uint64_t) + header.nFrequencies));
+    uLongf rawBytes = raw.size();
+    if (uncompress(raw.data(), &rawBytes, compressed.data(), compressed.size()) != Z_OK || rawBytes != raw.size()) {
+        return -1;
+    }
+    endSampleIndices.resize(nColumns);
+    memcpy(endSampleIndices.data(), raw.data(), nColumns * sizeof(uint64_t));
+    bins.assign(raw.begin() + nColumns * sizeof(uint64_t), raw.end());
+    return (int) nColumns;
+}
+
+size_t SpectrogramFile::findChunk(uint64_t sampleIndex) const
+{
+    auto it = std::upper_bound(index.begin(), index.end(), sampleIndex, [](uint64_t s, const IndexEntry& entry) {
+        return s < entry.firstEndSampleIndex;
+    });
+    return it == index.begin() ? 0 : it - index.begin() - 1;
+}
+
+const SpectrogramFile::Header& SpectrogramFile::getHeader() const
+{
+    return header;
+}
+
+const std::vector<SpectrogramFile::IndexEntry>& SpectrogramFile::getIndex() const
+{
+    return index;
+}
+
+uint64_t SpectrogramFile::getFirstSampleIndex() const
+{
+    return index.empty() ? 0 : index.front().firstEndSampleIndex;
+}
+
+uint64_t SpectrogramFile::getLastSampleIndex() const
+{
+    return index.empty() ? 0 : index.back().lastEndSampleIndex;
+}
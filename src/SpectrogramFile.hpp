@@ -0,0 +1,151 @@
+/**
+ * Compact on-disk format for recorded spectrogram columns, and a reader for it.
+ *
+ * Columns are quantized to one byte per frequency on a dB scale and grouped into chunks, each compressed on its own
+ * with zlib so that any chunk can be decoded without its predecessors. A seek index of all chunks is appended when the
+ * recording is closed; if it is missing, e.g. after a crash, the reader rebuilds it by walking the chunk headers.
+ *
+ * File layout (native endianness):
+ *    Header
+ *    chunks:  ChunkHeader, zlib(uint64 endSampleIndex[nColumns], uint8 bins[nColumns][nFrequencies])
+ *    index:   IndexEntry[nChunks]
+ *    Trailer
+ */
+
+#ifndef OPENGL_SPECTROGRAM_SPECTROGRAMFILE_HPP
+#define OPENGL_SPECTROGRAM_SPECTROGRAMFILE_HPP
+
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdint.h>
+
+class SpectrogramFile {
+public:
+  struct Header {
+    char magic[8];
+    uint32_t samplingRate;
+    uint32_t fftLength;
+    /**
+     * Nominal hop size; the actual spacing of columns is given by their end sample indices.
+     */
+    uint32_t hopSize;
+    uint32_t nFrequencies;
+    /**
+     * Window type as numbered by WindowLibrary::Type, AudioInput::MULTITAPER_WINDOW, AudioInput::POLYPHASE_WINDOW or
+     * AudioInput::MULTIRESOLUTION_WINDOW.
+     */
+    uint32_t windowType;
+    uint32_t columnsPerChunk;
+    /**
+     * Power in dB represented by quantization level 0.
+     */
+    float dbFloor;
+    /**
+     * dB per quantization level.
+     */
+    float dbStep;
+    /**
+     * Unix time of sample index 0.
+     */
+    double originUnixTime;
+  };
+
+  struct ChunkHeader {
+    uint32_t compressedBytes;
+    uint32_t nColumns;
+    uint64_t firstEndSampleIndex;
+  };
+
+  struct IndexEntry {
+    uint64_t firstEndSampleIndex;
+    uint64_t lastEndSampleIndex;
+    uint64_t offset;
+    uint32_t nColumns;
+    uint32_t reserved;
+  };
+
+  struct Trailer {
+    uint64_t indexOffset;
+    uint64_t nChunks;
+    char magic[8];
+  };
+
+  static const char HEADER_MAGIC[8];
+  static const char TRAILER_MAGIC[8];
+
+  /**
+   * Default quantization: 0.5 dB steps from -60 dB, covering -60 dB to +67.5 dB.
+   */
+  static const float DEFAULT_DB_FLOOR;
+  static const float DEFAULT_DB_STEP;
+
+  /**
+   * Default number of columns per compressed chunk, a few seconds at the default hop size.
+   */
+  static const unsigned int DEFAULT_COLUMNS_PER_CHUNK;
+
+  /**
+   * Opens a recording and loads or rebuilds its seek index.
+   * Throws 99 if the file cannot be opened or is not a spectrogram recording.
+   * @param path path of the recording.
+   */
+  SpectrogramFile(const std::string& path);
+
+  SpectrogramFile(const SpectrogramFile&) = delete;
+  SpectrogramFile& operator=(const SpectrogramFile&) = delete;
+
+  ~SpectrogramFile();
+
+  /**
+   * Quantizes a power value to one byte on the dB scale of a header.
+   */
+  static uint8_t quantize(float power, float dbFloor, float dbStep);
+
+  /**
+   * Inverse of quantize(), up to the quantization error.
+   */
+  static float dequantize(uint8_t level, float dbFloor, float dbStep);
+
+  /**
+   * Decodes one chunk.
+   * @param chunk index into getIndex().
+   * @param endSampleIndices receives the end sample index of each column.
+   * @param bins receives the quantized columns, nFrequencies bytes each.
+   * @return number of columns decoded, or -1 on a read or decompression error.
+   */
+  int readChunk(size_t chunk, std::vector<uint64_t>& endSampleIndices, std::vector<uint8_t>& bins);
+
+  /**
+   * @param sampleIndex sample index to look up.
+   * @return index of the last chunk whose first column ends at or before sampleIndex, or 0.
+   */
+  size_t findChunk(uint64_t sampleIndex) const;
+
+  const Header& getHeader() const;
+
+  const std::vector<IndexEntry>& getIndex() const;
+
+  /**
+   * @return end sample index of the first recorded column, or 0 for an empty recording.
+   */
+  uint64_t getFirstSampleIndex() const;
+
+  /**
+   * @return end sample index of the last recorded column, or 0 for an empty recording.
+   */
+  uint64_t getLastSampleIndex() const;
+
+private:
+  /**
+   * Rebuilds the index by walking the chunk headers, for recordings that were not closed properly.
+   */
+  void rebuildIndex();
+
+  FILE* file;
+  Header header;
+  std::vector<IndexEntry> index;
+  std::vector<uint8_t> compressed;
+};
+
+#endif /* OPENGL_SPECTROGRAM_SPECTROGRAMFILE_HPP */
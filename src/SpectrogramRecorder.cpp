@@ -0,0 +1,169 @@
+#include "SpectrogramRecorder.hpp"
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <zlib.h>
+#include "Log.hpp"
+#include "Trace.hpp"
+
+/* static member declarations and initializations */
+const unsigned int SpectrogramRecorder::QUEUE_COLUMNS = 512;
+const unsigned int SpectrogramRecorder::WRITER_POLL_MICROSECONDS = 10000;
+
+SpectrogramRecorder::SpectrogramRecorder(const std::string& path, const AudioInput& audioInput,
+                                         const std::vector<BandSummaryIndex::Band>& bands)
+  : path(path), headerWritten(false), freeSlots(QUEUE_COLUMNS), filledSlots(QUEUE_COLUMNS), originSet(false),
+    droppedColumns(0), columnsWritten(0), stop(false)
+{
+    file = fopen(path.c_str(), "wb");
+    if (!file) {
+        Log::getInstance()->logger() << "Could not create " << path << std::endl;
+        throw 99;
+    }
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SpectrogramFile::HEADER_MAGIC, sizeof(header.magic));
+    header.samplingRate = audioInput.getSamplingRate();
+    header.fftLength = audioInput.getFftLength();
+    header.hopSize = audioInput.getHopSize();
+    header.nFrequencies = AudioInput::N_FREQUENCIES;
+    header.windowType = audioInput.getWindowType();
+    header.columnsPerChunk = SpectrogramFile::DEFAULT_COLUMNS_PER_CHUNK;
+    header.dbFloor = SpectrogramFile::DEFAULT_DB_FLOOR;
+    header.dbStep = SpectrogramFile::DEFAULT_DB_STEP;
+
+    slotBins.resize(QUEUE_COLUMNS * header.nFrequencies);
+    slotSampleIndices.resize(QUEUE_COLUMNS);
+    for (uint32_t slot = 0; slot < QUEUE_COLUMNS; ++slot) freeSlots.push(slot);
+    chunkSampleIndices.reserve(header.columnsPerChunk);
+    chunkBins.reserve(header.columnsPerChunk * header.nFrequencies);
+    if (!bands.empty()) {
+        bandSummary.reset(new BandSummaryWriter(path + ".bands", bands, header));
+    }
+
+    Log::getInstance()->logger() << "Recording spectrogram to " << path << std::endl;
+    writer = std::thread(&SpectrogramRecorder::writerLoop, this);
+}
+
+SpectrogramRecorder::~SpectrogramRecorder()
+{
+    stop = true;
+    writer.join();
+
+    /* flush the partial chunk, then append the index and the trailer */
+    writeChunk();
+    SpectrogramFile::Trailer trailer;
+    trailer.indexOffset = (uint64_t) ftello(file);
+    trailer.nChunks = index.size();
+    memcpy(trailer.magic, SpectrogramFile::TRAILER_MAGIC, sizeof(trailer.magic));
+    fwrite(index.data(), sizeof(SpectrogramFile::IndexEntry), index.size(), file);
+    fwrite(&trailer, sizeof(trailer), 1, file);
+    fclose(file);
+
+    Log::getInstance()->logger() << "Closed " << path << ": " << columnsWritten << " columns, " << droppedColumns
+                                 << " dropped" << std::endl;
+}
+
+void SpectrogramRecorder::samplesCaptured(const float* samples, unsigned long numSamples, uint64_t firstSampleIndex,
+                                          double firstAdcTime)
+{
+    (void) samples;
+    (void) numSamples;
+    (void) firstSampleIndex;
+    (void) firstAdcTime;
+}
+
+void SpectrogramRecorder::sliceComputed(const float* slice, unsigned int nFrequencies, uint64_t endSampleIndex,
+                                        double adcTime)
+{
+    (void) adcTime;
+    if (!originSet) {
+        /* anchor sample index 0 to the wall clock; published to the writer thread by the queue */
+        timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        header.originUnixTime = now.tv_sec + now.tv_nsec * 1e-9 - (double) endSampleIndex / header.samplingRate;
+        originSet = true;
+    }
+
+    uint32_t slot;
+    if (!freeSlots.pop(slot)) {
+        ++droppedColumns;
+        return;
+    }
+    uint8_t* bins = &slotBins[slot * header.nFrequencies];
+    unsigned int n = std::min(nFrequencies, header.nFrequencies);
+    for (unsigned int i = 0; i < n; ++i) {
+        bins[i] = SpectrogramFile::quantize(slice[i], header.dbFloor, header.dbStep);
+    }
+    memset(bins + n, 0, header.nFrequencies - n);
+    slotSampleIndices[slot] = endSampleIndex;
+    filledSlots.push(slot);
+}
+
+void SpectrogramRecorder::writerLoop()
+{
+    Trace::getInstance()->setThreadName("spectrogram recorder");
+    uint32_t slot;
+    while (true) {
+        if (!filledSlots.pop(slot)) {
+            /* drain everything queued before stopping */
+            if (stop) break;
+            usleep(WRITER_POLL_MICROSECONDS);
+            continue;
+        }
+        chunkSampleIndices.push_back(slotSampleIndices[slot]);
+        const uint8_t* bins = &slotBins[slot * header.nFrequencies];
+        chunkBins.insert(chunkBins.end(), bins, bins + header.nFrequencies);
+        if (bandSummary) {
+            bandSummary->add(bins, header.originUnixTime + (double) slotSampleIndices[slot] / header.samplingRate);
+        }
+        freeSlots.push(slot);
+
+        if (chunkSampleIndices.size() == header.columnsPerChunk) writeChunk();
+    }
+}
+
+void SpectrogramRecorder::writeChunk()
+{
+    if (!headerWritten) {
+        fwrite(&header, sizeof(header), 1, file);
+        headerWritten = true;
+    }
+    if (chunkSampleIndices.empty()) return;
+    TraceScope traceScope("recorder chunk");
+
+    /* column times first, then all bins, so that similar bytes are adjacent for the compressor */
+    size_t nColumns = chunkSampleIndices.size();
+    std::vector<uint8_t> raw(nColumns * sizeof(uint64_t) + chunkBins.size());
+    memcpy(raw.data(), chunkSampleIndices.data(), nColumns * sizeof(uint64_t));
+    memcpy(raw.data() + nColumns * sizeof(uint64_t), chunkBins.data(), chunkBins.size());
+    uLongf compressedBytes = compressBound(raw.size());
+    compressed.resize(compressedBytes);
+    if (compress2(compressed.data(), &compressedBytes, raw.data(), raw.size(), Z_BEST_SPEED) != Z_OK) {
+        Log::getInstance()->logger() << "Could not compress a spectrogram chunk, " << nColumns << " columns lost."
+                                     << std::endl;
+        droppedColumns += nColumns;
+    } else {
+        SpectrogramFile::ChunkHeader chunkHeader = {(uint32_t) compressedBytes, (uint32_t) nColumns,
+                                                    chunkSampleIndices.front()};
+        SpectrogramFile::IndexEntry entry = {chunkSampleIndices.front(), chunkSampleIndices.back(),
+                                             (uint64_t) ftello(file), (uint32_t) nColumns, 0};
+        fwrite(&chunkHeader, sizeof(chunkHeader), 1, file);
+        fwrite(compressed.data(), 1, compressedBytes, file);
+        fflush(file);
+        index.push_back(entry);
+        columnsWritten += nColumns;
+    }
+    chunkSampleIndices.clear();
+    chunkBins.clear();
+}
+
+unsigned long SpectrogramRecorder::getDroppedColumns() const
+{
+    return droppedColumns;
+}
+
+unsigned long SpectrogramRecorder::getColumnsWritten() const
+{
+    return columnsWritten;
+}
@@ -0,0 +1,129 @@
+/**
+ * Records every computed spectrogram slice to a SpectrogramFile.
+ *
+ * The DSP pool thread that computed a slice only quantizes it into a preallocated slot and queues it; a writer thread
+ * groups the queued columns into chunks, compresses and appends them, and writes the seek index when the recorder is
+ * destroyed.
+ * The writer thread also maintains a BandSummaryIndex of the recording next to it, at the path plus ".bands".
+ */
+
+#ifndef OPENGL_SPECTROGRAM_SPECTROGRAMRECORDER_HPP
+#define OPENGL_SPECTROGRAM_SPECTROGRAMRECORDER_HPP
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+#include <stdint.h>
+#include "AudioInput.hpp"
+#include "AudioListener.hpp"
+#include "BandSummaryWriter.hpp"
+#include "BoundedQueue.hpp"
+#include "SpectrogramFile.hpp"
+
+class SpectrogramRecorder : public AudioListener {
+public:
+  /**
+   * Number of columns that can be queued for the writer thread before columns are dropped.
+   */
+  static const unsigned int QUEUE_COLUMNS;
+
+  /**
+   * Time the writer thread sleeps when there is nothing to write.
+   */
+  static const unsigned int WRITER_POLL_MICROSECONDS;
+
+  /**
+   * Creates the recording and starts the writer thread. Throws 99 if the file cannot be created.
+   * @param path path of the recording.
+   * @param audioInput source whose parameters are written to the header.
+   * @param bands frequency bands of the band summary index, or none for no index.
+   */
+  SpectrogramRecorder(const std::string& path, const AudioInput& audioInput,
+                      const std::vector<BandSummaryIndex::Band>& bands);
+
+  SpectrogramRecorder(const SpectrogramRecorder&) = delete;
+  SpectrogramRecorder& operator=(const SpectrogramRecorder&) = delete;
+
+  /**
+   * Writes the remaining columns and the seek index, and closes the recording.
+   */
+  ~SpectrogramRecorder();
+
+  /**
+   * Ignored; only spectrogram slices are recorded.
+   */
+  virtual void samplesCaptured(const float* samples, unsigned long numSamples, uint64_t firstSampleIndex,
+                               double firstAdcTime);
+
+  /**
+   * Quantizes a slice and queues it for the writer thread. Called on the DSP pool thread; never blocks.
+   */
+  virtual void sliceComputed(const float* slice, unsigned int nFrequencies, uint64_t endSampleIndex,
+                             double adcTime);
+
+  /**
+   * @return number of columns dropped because the writer thread fell behind.
+   */
+  unsigned long getDroppedColumns() const;
+
+  /**
+   * @return number of columns written to disk.
+   */
+  unsigned long getColumnsWritten() const;
+
+private:
+  /**
+   * Body of the writer thread.
+   */
+  void writerLoop();
+
+  /**
+   * Compresses and appends the columns gathered so far as one chunk.
+   */
+  void writeChunk();
+
+  std::string path;
+  FILE* file;
+  SpectrogramFile::Header header;
+  bool headerWritten;
+
+  /**
+   * Preallocated column slots, QUEUE_COLUMNS columns of header.nFrequencies bytes, and their end sample indices.
+   */
+  std::vector<uint8_t> slotBins;
+  std::vector<uint64_t> slotSampleIndices;
+
+  /**
+   * Indices of slots available to the DSP thread, and of slots waiting for the writer thread.
+   */
+  BoundedQueue<uint32_t> freeSlots;
+  BoundedQueue<uint32_t> filledSlots;
+
+  /**
+   * Whether originUnixTime has been set from the first slice.
+   */
+  bool originSet;
+
+  /**
+   * Columns of the chunk being gathered by the writer thread.
+   */
+  std::vector<uint64_t> chunkSampleIndices;
+  std::vector<uint8_t> chunkBins;
+  std::vector<uint8_t> compressed;
+  std::vector<SpectrogramFile::IndexEntry> index;
+
+  /**
+   * Per-second band energies of the recording, if any bands were given.
+   */
+  std::unique_ptr<BandSummaryWriter> bandSummary;
+
+  std::atomic<unsigned long> droppedColumns;
+  std::atomic<unsigned long> columnsWritten;
+  std::atomic<bool> stop;
+  std::thread writer;
+};
+
+#endif /* OPENGL_SPECTROGRAM_SPECTROGRAMRECORDER_HPP */
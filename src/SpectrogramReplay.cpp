@@ -0,0 +1,198 @@
+#include "SpectrogramReplay.hpp"
+#include <unistd.h>
+#include "Log.hpp"
+#include "Trace.hpp"
+
+/* static member declarations and initializations */
+const float SpectrogramReplay::MIN_SPEED = 1.0f / 16;
+const float SpectrogramReplay::MAX_SPEED = 256.0f;
+
+SpectrogramReplay::SpectrogramReplay(const std::string& path)
+  : AudioInput(), file(path), speed(1.0f), anchorPaused(false), seekPending(false), currentChunk(0), nextColumn(0)
+{
+    const SpectrogramFile::Header& header = file.getHeader();
+    samplingRate = header.samplingRate;
+    samplingPeriod = 1.0f / samplingRate;
+    hopSize = header.hopSize;
+    windowType = header.windowType;
+    nChannels = 1;
+
+    /* there is no audio to show, but the time domain plot still reads the buffer */
+    bufferMemorySeconds = 5;
+    bufferSizeSamples = bufferMemorySeconds * samplingRate;
+    audioBuffer = new float[bufferSizeSamples];
+    for (int i = 0; i < bufferSizeSamples; ++i) audioBuffer[i] = 0.0f;
+    bufferIndex = 0;
+
+    anchorSamples = (double) file.getFirstSampleIndex();
+    anchorWallTime = Trace::now() * 1e-9;
+}
+
+SpectrogramReplay::~SpectrogramReplay()
+{
+    quit = true;
+    if (playback.joinable()) playback.join();
+}
+
+int SpectrogramReplay::startCapture()
+{
+    if (file.getIndex().empty()) {
+        Log::getInstance()->logger() << "Nothing to replay." << std::endl;
+        return 1;
+    }
+    if (!loadChunk(0)) return 1;
+    {
+        std::lock_guard<std::mutex> lock(clockMutex);
+        anchorWallTime = Trace::now() * 1e-9;
+    }
+    playback = std::thread(&SpectrogramReplay::playbackLoop, this);
+    return 0;
+}
+
+void SpectrogramReplay::quitNow()
+{
+    Log::getInstance()->logger() << "Stopping replay." << std::endl;
+    quit = true;
+    if (playback.joinable()) playback.join();
+}
+
+double SpectrogramReplay::getStreamTime()
+{
+    std::lock_guard<std::mutex> lock(clockMutex);
+    return positionSamples() / samplingRate;
+}
+
+double SpectrogramReplay::positionSamples()
+{
+    double now = Trace::now() * 1e-9;
+    double position = anchorPaused ? anchorSamples : anchorSamples + (now - anchorWallTime) * speed * samplingRate;
+    position = std::min(position, (double) file.getLastSampleIndex());
+    if (pause != anchorPaused) {
+        anchorSamples = position;
+        anchorWallTime = now;
+        anchorPaused = pause;
+    }
+    return position;
+}
+
+void SpectrogramReplay::setSpeed(float speed)
+{
+    std::lock_guard<std::mutex> lock(clockMutex);
+    anchorSamples = positionSamples();
+    anchorWallTime = Trace::now() * 1e-9;
+    this->speed = std::max(MIN_SPEED, std::min(MAX_SPEED, speed));
+    Log::getInstance()->logger() << "Replay speed x" << this->speed << std::endl;
+}
+
+float SpectrogramReplay::getSpeed()
+{
+    std::lock_guard<std::mutex> lock(clockMutex);
+    return speed;
+}
+
+void SpectrogramReplay::seek(double seconds)
+{
+    std::lock_guard<std::mutex> lock(clockMutex);
+    double target = seconds * samplingRate;
+    target = std::max((double) file.getFirstSampleIndex(), std::min((double) file.getLastSampleIndex(), target));
+    anchorSamples = target;
+    anchorWallTime = Trace::now() * 1e-9;
+    seekPending = true;
+}
+
+void SpectrogramReplay::seekUnixTime(double unixTime)
+{
+    seek(unixTime - file.getHeader().originUnixTime);
+}
+
+double SpectrogramReplay::getPositionUnixTime()
+{
+    return file.getHeader().originUnixTime + getStreamTime();
+}
+
+const SpectrogramFile& SpectrogramReplay::getFile() const
+{
+    return file;
+}
+
+bool SpectrogramReplay::loadChunk(size_t chunk)
+{
+    TraceScope traceScope("replay chunk");
+    if (file.readChunk(chunk, chunkSampleIndices, chunkBins) < 0) {
+        Log::getInstance()->logger() << "Could not read replay chunk " << chunk << std::endl;
+        return false;
+    }
+    currentChunk = chunk;
+    nextColumn = 0;
+    return true;
+}
+
+void SpectrogramReplay::publishColumn(size_t column)
+{
+    const SpectrogramFile::Header& header = file.getHeader();
+    const uint8_t* bins = &chunkBins[column * header.nFrequencies];
+    unsigned int n = std::min(header.nFrequencies, N_FREQUENCIES);
+    for (unsigned int i = 0; i < n; ++i) {
+        spectrogramSlice[i] = SpectrogramFile::dequantize(bins[i], header.dbFloor, header.dbStep);
+    }
+    for (unsigned int i = n; i < N_FREQUENCIES; ++i) spectrogramSlice[i] = 0.0f;
+
+    uint64_t endSampleIndex = chunkSampleIndices[column];
+    double sliceTime = (double) endSampleIndex / samplingRate;
+    spectrogramSliceTime.store(sliceTime, std::memory_order_relaxed);
+    ++columnsProduced;
+    for (unsigned int i = 0; i < nListeners.load(std::memory_order_acquire); ++i) {
+        listeners[i]->sliceComputed(spectrogramSlice, N_FREQUENCIES, endSampleIndex, sliceTime);
+    }
+}
+
+void SpectrogramReplay::playbackLoop()
+{
+    Trace::getInstance()->setThreadName("replay");
+    size_t nChunks = file.getIndex().size();
+    bool finished = false;
+    while (!quit) {
+        double position;
+        bool seeked;
+        float currentSpeed;
+        {
+            std::lock_guard<std::mutex> lock(clockMutex);
+            position = positionSamples();
+            seeked = seekPending;
+            seekPending = false;
+            currentSpeed = anchorPaused ? 0.0f : speed;
+        }
+
+        if (seeked) {
+            /* jump straight to the column at the new position, publishing the one just before it */
+            if (!loadChunk(file.findChunk((uint64_t) position))) break;
+            finished = false;
+            while (nextColumn + 1 < chunkSampleIndices.size() && chunkSampleIndices[nextColumn + 1] <= position) {
+                ++nextColumn;
+            }
+        }
+
+        /* publish every column that is due */
+        while (!finished && chunkSampleIndices[nextColumn] <= position) {
+            publishColumn(nextColumn++);
+            if (nextColumn < chunkSampleIndices.size()) continue;
+            if (currentChunk + 1 == nChunks) {
+                /* end of the recording, wait for a seek */
+                nextColumn = chunkSampleIndices.size() - 1;
+                finished = true;
+                break;
+            }
+            if (!loadChunk(currentChunk + 1)) {
+                quit = true;
+                break;
+            }
+        }
+
+        /* sleep until the next column is due, but keep reacting to seeks and speed changes */
+        double wait = 0.01;
+        if (!finished && currentSpeed > 0.0f) {
+            wait = std::min(wait, (chunkSampleIndices[nextColumn] - position) / (currentSpeed * samplingRate));
+        }
+        usleep((useconds_t) (std::max(wait, 0.0) * 1e6));
+    }
+}
@@ -0,0 +1,141 @@
+/**
+ * Plays back a SpectrogramFile as an audio source, without recomputing any FFT. A playback thread publishes the
+ * recorded columns at their recorded pace times a speed factor, and can jump to any time of the recording through
+ * the seek index.
+ */
+
+#ifndef OPENGL_SPECTROGRAM_SPECTROGRAMREPLAY_HPP
+#define OPENGL_SPECTROGRAM_SPECTROGRAMREPLAY_HPP
+
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "AudioInput.hpp"
+#include "SpectrogramFile.hpp"
+
+class SpectrogramReplay : public AudioInput {
+public:
+  /**
+   * Slowest and fastest supported playback speed.
+   */
+  static const float MIN_SPEED;
+  static const float MAX_SPEED;
+
+  /**
+   * Opens a recording. Throws 99 if it cannot be read.
+   * @param path path of the recording.
+   */
+  SpectrogramReplay(const std::string& path);
+
+  SpectrogramReplay(const SpectrogramReplay&) = delete;
+  SpectrogramReplay& operator=(const SpectrogramReplay&) = delete;
+
+  /**
+   * Stops the playback thread.
+   */
+  ~SpectrogramReplay();
+
+  /**
+   * Starts the playback thread.
+   * @return 0 on success.
+   */
+  virtual int startCapture();
+
+  /**
+   * Stops the playback thread.
+   */
+  virtual void quitNow();
+
+  /**
+   * @return current playback position, in seconds of recorded time since sample index 0.
+   */
+  virtual double getStreamTime();
+
+  /**
+   * Sets the playback speed, clamped to [MIN_SPEED, MAX_SPEED].
+   * @param speed recorded seconds played per wall clock second.
+   */
+  void setSpeed(float speed);
+
+  float getSpeed();
+
+  /**
+   * Jumps to a time of the recording. Takes effect on the playback thread.
+   * @param seconds recorded time since sample index 0, clamped to the recording.
+   */
+  void seek(double seconds);
+
+  /**
+   * Jumps to a wall clock time of the recording.
+   * @param unixTime Unix time, clamped to the recording.
+   */
+  void seekUnixTime(double unixTime);
+
+  /**
+   * @return Unix time of the current playback position.
+   */
+  double getPositionUnixTime();
+
+  /**
+   * @return the recording being played back.
+   */
+  const SpectrogramFile& getFile() const;
+
+private:
+  /**
+   * Body of the playback thread.
+   */
+  void playbackLoop();
+
+  /**
+   * Decodes a chunk into the chunk buffers.
+   * @param chunk index into the seek index.
+   * @return false on a read error.
+   */
+  bool loadChunk(size_t chunk);
+
+  /**
+   * Publishes one decoded column of the current chunk like a freshly computed slice.
+   */
+  void publishColumn(size_t column);
+
+  /**
+   * @return playback position as a sample index, derived from the wall clock. Picks up changes of the pause flag.
+   * Must be called with clockMutex held.
+   */
+  double positionSamples();
+
+  SpectrogramFile file;
+
+  /**
+   * Guards the playback clock, which is read and changed from both the render and the playback thread.
+   */
+  std::mutex clockMutex;
+
+  float speed;
+
+  /**
+   * Playback position at the last change of speed, pause state or position, and the wall clock time of it.
+   */
+  double anchorSamples;
+  double anchorWallTime;
+  bool anchorPaused;
+
+  /**
+   * Whether seek() moved the playback position since the playback thread last looked.
+   */
+  bool seekPending;
+
+  /**
+   * Decoded columns of the current chunk, its index and the next column to publish.
+   */
+  std::vector<uint64_t> chunkSampleIndices;
+  std::vector<uint8_t> chunkBins;
+  size_t currentChunk;
+  size_t nextColumn;
+
+  std::thread playback;
+};
+
+#endif /* OPENGL_SPECTROGRAM_SPECTROGRAMREPLAY_HPP */
@@ -13,16 +13,63 @@ const struct SpectrogramVisualizer::shortcuts SpectrogramVisualizer::KEYBOARD_SH
         ' ',  /* PAUSE */
         ']',  /* SAMPLE_RATE_UP */
         '[',  /* SAMPLE_RATE_DOWN */
-        'i'   /* CHANGE_COLOR_SCHEME */
+        'i',  /* CHANGE_COLOR_SCHEME */
+        't',  /* FLUSH_TRACE */
+        'r',  /* DUMP_FLIGHT_RECORDER */
+        ',',  /* REPLAY_SEEK_BACK */
+        '.',  /* REPLAY_SEEK_FORWARD */
+        '-',  /* REPLAY_SLOWER */
+        '=',  /* REPLAY_FASTER */
+        'h',  /* HISTORY_VIEW */
+        'z',  /* HISTORY_ZOOM_OUT */
+        'x',  /* HISTORY_ZOOM_IN */
+        'a',  /* HISTORY_BACK */
+        's',  /* HISTORY_FORWARD */
+        'p',  /* PITCH_VIEW */
+        'c',  /* CHROMA_VIEW */
+        'o',  /* ONSET_VIEW */
+        'w',  /* NEXT_WINDOW */
+        'l',  /* WELCH_VIEW */
+        'e',  /* WELCH_EXPORT */
+        'b',  /* BASELINE_LEARN */
+        'v',  /* BASELINE_SAVE */
+        'g',  /* AUTO_LEVEL */
+        'k',  /* TRACK_TONE */
+        'j',  /* CLEAR_TONES */
+        'u',  /* CORRELATION_VIEW */
+        'n'   /* OCTAVE_VIEW */
 };
 const float SpectrogramVisualizer::MIDDLE_C_FREQUENCY = 261.626f;
 const unsigned int SpectrogramVisualizer::N_SEMITONES_PER_OCTAVE = 12;
+const float SpectrogramVisualizer::CLICK_DETECTION_RATIO = 20.0f;  // 13 dB
+const double SpectrogramVisualizer::REPLAY_SEEK_SECONDS = 10.0;
+const float SpectrogramVisualizer::Z_SCORE_THRESHOLD = 3.0f;
+const float SpectrogramVisualizer::Z_SCORE_SATURATION = 12.0f;
+const double SpectrogramVisualizer::AUTO_LEVEL_LOW_QUANTILE = 0.05;
+const double SpectrogramVisualizer::AUTO_LEVEL_HIGH_QUANTILE = 0.995;
+const unsigned int SpectrogramVisualizer::AUTO_LEVEL_COLUMNS = 64;
+const float SpectrogramVisualizer::AUTO_LEVEL_RATE = 0.02f;
+const float SpectrogramVisualizer::AUTO_LEVEL_MIN_RANGE_DB = 20.0f;
+const unsigned int SpectrogramVisualizer::TONE_TRACE_READINGS = 3000;  // readings, ToneTracker::READOUT_INTERVAL samples apart
+const float SpectrogramVisualizer::TONE_TRACE_RANGE_DB = 100.0f;
+const float SpectrogramVisualizer::OCTAVE_RANGE_DB = 100.0f;
+
+/* colours of the tone traces, by tone */
+static const float TONE_COLORS[ToneReading::MAX_TONES][3] = {
+    {0.2f, 0.9f, 1.0f}, {1.0f, 0.8f, 0.3f}, {0.5f, 1.0f, 0.4f}, {1.0f, 0.5f, 1.0f},
+    {1.0f, 1.0f, 1.0f}, {0.4f, 0.6f, 1.0f}, {1.0f, 0.6f, 0.4f}, {0.7f, 0.7f, 0.7f}
+};
 
-SpectrogramVisualizer::SpectrogramVisualizer(int scrollFactor, int requestedInputDeviceId) {
+SpectrogramVisualizer::SpectrogramVisualizer(int scrollFactor, AudioInput* audioInput) {
     isPaused = false;
     colorScale[0] = 100.0f;     // 8-bit intensity offset
     colorScale[1] = 255 / 120.0f;     // 8-bit intensity slope (per dB units)
-    audioInput = new PortAudio(requestedInputDeviceId);
+    autoLevel = false;
+    lowLevel = StreamingQuantile(AUTO_LEVEL_LOW_QUANTILE);
+    highLevel = StreamingQuantile(AUTO_LEVEL_HIGH_QUANTILE);
+    autoLevelSettled = false;
+    for (int i = 0; i < 2; i++) autoLevelTarget[i] = autoLevelCurrent[i] = 0.0f;
+    this->audioInput = audioInput;
     unsigned int spectrogramSize = audioInput->getSpectrogramSize();
 
     OUT("Spectrogram size: " << spectrogramSize);
@@ -37,6 +84,9 @@ SpectrogramVisualizer::SpectrogramVisualizer(int scrollFactor, int requestedInpu
     hzPerPixelY = (float) highestFrequency / viewportSize[1];
     hzPerPixelX = (float) highestFrequency / viewportSize[0];
     fpsTick = time(nullptr);
+    lastSwapNs = 0;
+    scrolledColumns = 0;
+    renderBacklog = 0;
     frameCount = 0;
     fps = 0;
     colorMode = 2;
@@ -47,17 +97,59 @@ SpectrogramVisualizer::SpectrogramVisualizer(int scrollFactor, int requestedInpu
     frequencyReadOff = 0;
     diagnose = false;
     strcpy(diagnosis, "no diagnosis ...");
+    latestColumnTime = 0.0;
+    latestColumnPower = 0.0f;
+    uploadedColumnTime = 0.0;
+    uploadedColumnPower = 0.0f;
+    measuredColumnTime = 0.0;
+    columnPowerBaseline = 0.0f;
+    detectedClickTime = 0.0;
+    flightRecorder = nullptr;
+    replay = nullptr;
+    history = nullptr;
+    dspGraph = nullptr;
+    pitchTracker = nullptr;
+    pitchView = false;
+    pitchTrack.assign(AudioInput::N_TIME_WINDOWS, 0.0f);
+    chromaMapper = nullptr;
+    chromaView = false;
+    chromaBytes.assign(ChromaFrame::N_CLASSES * AudioInput::N_TIME_WINDOWS, 0);
+    onsetDetector = nullptr;
+    onsetView = false;
+    onsetMarks.assign(AudioInput::N_TIME_WINDOWS, 0);
+    markedOnsets = 0;
+    welchAverager = nullptr;
+    welchView = false;
+    binStatistics = nullptr;
+    toneTracker = nullptr;
+    toneTrace.assign(ToneReading::MAX_TONES * TONE_TRACE_READINGS, -INFINITY);
+    toneTraceEnd = 0;
+    latestTone.nTones = 0;
+    toneGeneration = 0;
+    correlationView = false;
+    octaveFilterBank = nullptr;
+    octaveView = false;
+    historyView = false;
+    historyLevel = 0;
+    historyEnd = -1;
+    historyBytes = new uint8_t[AudioInput::N_TIME_WINDOWS * HistoryPyramid::N_BINS];
 
     OUT("Highest Frequency: " << highestFrequency);
 
     specId = 7;
 #ifdef DISPLAY_SPECTROGRAM
-    glGenTextures(14, &specId);
+    glGenTextures(1, &specId);
     glBindTexture(GL_TEXTURE_2D, specId);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    /* keep the pitch class rows crisp */
+    glGenTextures(1, &chromaId);
+    glBindTexture(GL_TEXTURE_2D, chromaId);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 #endif
 
     /* notify the AudioInput instance that it should start capturing audio */
@@ -75,6 +167,9 @@ SpectrogramVisualizer::SpectrogramVisualizer(const SpectrogramVisualizer& other)
     this->frameCount = other.frameCount;
     this->fps = other.fps;
     this->fpsTick = other.fpsTick;
+    this->lastSwapNs = other.lastSwapNs;
+    this->scrolledColumns = other.scrolledColumns;
+    this->renderBacklog = other.renderBacklog;
     this->startTime = other.startTime;
     this->frequencyReadOff = other.frequencyReadOff;
     this->scrollFactor = other.scrollFactor;
@@ -85,8 +180,58 @@ SpectrogramVisualizer::SpectrogramVisualizer(const SpectrogramVisualizer& other)
     this->hzPerPixelY = other.hzPerPixelY;
     this->highestFrequency = other.highestFrequency;
     this->specId = other.specId;
+    this->latestColumnTime = other.latestColumnTime;
+    this->latestColumnPower = other.latestColumnPower;
+    this->uploadedColumnTime = other.uploadedColumnTime;
+    this->uploadedColumnPower = other.uploadedColumnPower;
+    this->measuredColumnTime = other.measuredColumnTime;
+    this->columnPowerBaseline = other.columnPowerBaseline;
+    this->detectedClickTime = other.detectedClickTime;
+    this->glassLatency = other.glassLatency;
+    this->clickLatency = other.clickLatency;
+    this->flightRecorder = other.flightRecorder;
+    this->replay = other.replay;
+    this->history = other.history;
+    this->dspGraph = other.dspGraph;
+    this->pitchTracker = other.pitchTracker;
+    this->pitchView = other.pitchView;
+    this->pitchTrack = other.pitchTrack;
+    this->chromaMapper = other.chromaMapper;
+    this->chromaView = other.chromaView;
+    this->chromaBytes = other.chromaBytes;
+    this->chromaId = other.chromaId;
+    this->onsetDetector = other.onsetDetector;
+    this->onsetView = other.onsetView;
+    this->onsetMarks = other.onsetMarks;
+    this->markedOnsets = other.markedOnsets;
+    this->welchAverager = other.welchAverager;
+    this->welchView = other.welchView;
+    this->welchMean = other.welchMean;
+    this->welchVariance = other.welchVariance;
+    this->binStatistics = other.binStatistics;
+    this->baselineMean = other.baselineMean;
+    this->baselineInverseDeviation = other.baselineInverseDeviation;
+    this->toneTracker = other.toneTracker;
+    this->toneTrace = other.toneTrace;
+    this->toneTraceEnd = other.toneTraceEnd;
+    this->latestTone = other.latestTone;
+    this->toneGeneration = other.toneGeneration;
+    this->delayEstimators = other.delayEstimators;
+    this->correlationView = other.correlationView;
+    this->octaveFilterBank = other.octaveFilterBank;
+    this->octaveView = other.octaveView;
+    this->historyView = other.historyView;
+    this->historyLevel = other.historyLevel;
+    this->historyEnd = other.historyEnd;
+    this->label = other.label;
     for (int i = 0; i < 2; i++) this->viewportSize[i] = other.viewportSize[i];
     for (int i = 0; i < 2; i++) this->colorScale[i] = other.colorScale[i];
+    this->autoLevel = other.autoLevel;
+    this->lowLevel = other.lowLevel;
+    this->highLevel = other.highLevel;
+    for (int i = 0; i < 2; i++) this->autoLevelTarget[i] = other.autoLevelTarget[i];
+    for (int i = 0; i < 2; i++) this->autoLevelCurrent[i] = other.autoLevelCurrent[i];
+    this->autoLevelSettled = other.autoLevelSettled;
     for (int i = 0; i < 3; i++) this->mouseHandle[i] = other.mouseHandle[i];
 
     int spectrogramSize = this->audioInput->getSpectrogramSize();
@@ -102,6 +247,9 @@ SpectrogramVisualizer& SpectrogramVisualizer::operator=(const SpectrogramVisuali
     this->frameCount = other.frameCount;
     this->fps = other.fps;
     this->fpsTick = other.fpsTick;
+    this->lastSwapNs = other.lastSwapNs;
+    this->scrolledColumns = other.scrolledColumns;
+    this->renderBacklog = other.renderBacklog;
     this->startTime = other.startTime;
     this->frequencyReadOff = other.frequencyReadOff;
     this->scrollFactor = other.scrollFactor;
@@ -112,8 +260,58 @@ SpectrogramVisualizer& SpectrogramVisualizer::operator=(const SpectrogramVisuali
     this->hzPerPixelY = other.hzPerPixelY;
     this->highestFrequency = other.highestFrequency;
     this->specId = other.specId;
+    this->latestColumnTime = other.latestColumnTime;
+    this->latestColumnPower = other.latestColumnPower;
+    this->uploadedColumnTime = other.uploadedColumnTime;
+    this->uploadedColumnPower = other.uploadedColumnPower;
+    this->measuredColumnTime = other.measuredColumnTime;
+    this->columnPowerBaseline = other.columnPowerBaseline;
+    this->detectedClickTime = other.detectedClickTime;
+    this->glassLatency = other.glassLatency;
+    this->clickLatency = other.clickLatency;
+    this->flightRecorder = other.flightRecorder;
+    this->replay = other.replay;
+    this->history = other.history;
+    this->dspGraph = other.dspGraph;
+    this->pitchTracker = other.pitchTracker;
+    this->pitchView = other.pitchView;
+    this->pitchTrack = other.pitchTrack;
+    this->chromaMapper = other.chromaMapper;
+    this->chromaView = other.chromaView;
+    this->chromaBytes = other.chromaBytes;
+    this->chromaId = other.chromaId;
+    this->onsetDetector = other.onsetDetector;
+    this->onsetView = other.onsetView;
+    this->onsetMarks = other.onsetMarks;
+    this->markedOnsets = other.markedOnsets;
+    this->welchAverager = other.welchAverager;
+    this->welchView = other.welchView;
+    this->welchMean = other.welchMean;
+    this->welchVariance = other.welchVariance;
+    this->binStatistics = other.binStatistics;
+    this->baselineMean = other.baselineMean;
+    this->baselineInverseDeviation = other.baselineInverseDeviation;
+    this->toneTracker = other.toneTracker;
+    this->toneTrace = other.toneTrace;
+    this->toneTraceEnd = other.toneTraceEnd;
+    this->latestTone = other.latestTone;
+    this->toneGeneration = other.toneGeneration;
+    this->delayEstimators = other.delayEstimators;
+    this->correlationView = other.correlationView;
+    this->octaveFilterBank = other.octaveFilterBank;
+    this->octaveView = other.octaveView;
+    this->historyView = other.historyView;
+    this->historyLevel = other.historyLevel;
+    this->historyEnd = other.historyEnd;
+    this->label = other.label;
     for (int i = 0; i < 2; i++) this->viewportSize[i] = other.viewportSize[i];
     for (int i = 0; i < 2; i++) this->colorScale[i] = other.colorScale[i];
+    this->autoLevel = other.autoLevel;
+    this->lowLevel = other.lowLevel;
+    this->highLevel = other.highLevel;
+    for (int i = 0; i < 2; i++) this->autoLevelTarget[i] = other.autoLevelTarget[i];
+    for (int i = 0; i < 2; i++) this->autoLevelCurrent[i] = other.autoLevelCurrent[i];
+    this->autoLevelSettled = other.autoLevelSettled;
     for (int i = 0; i < 3; i++) this->mouseHandle[i] = other.mouseHandle[i];
 
     int spectrogramSize = this->audioInput->getSpectrogramSize();
@@ -129,6 +327,7 @@ SpectrogramVisualizer::~SpectrogramVisualizer() {
 
     delete[] spectrogramBytes;
     delete[] spectrogramFloat;
+    delete[] historyBytes;
 }
 
 void SpectrogramVisualizer::plotTimeDomain() {
@@ -212,6 +411,72 @@ void SpectrogramVisualizer::plotSpectralMagnitude() {
     glScalef(0.7f / highestFrequency, 0.0015, 1.0);
     drawAxes(EPSILON, highestFrequency, -50, 50, 1.0, 1.0, xLabel, yLabel);
     glPopMatrix();
+
+    if (welchView && welchAverager) plotWelch();
+}
+
+void SpectrogramVisualizer::plotOctaveBands() {
+    /* where the time domain plot would be, full scale at the top */
+    const float left = 0.78, right = 0.98, bottom = 0.025, top = 0.175;
+    unsigned int nBands = octaveFilterBank->getNBands();
+    if (nBands == 0) return;
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glTranslatef(left, bottom, 0);
+    glScalef((right - left) / nBands, (top - bottom) / OCTAVE_RANGE_DB, 1);
+    glDisable(GL_BLEND);
+    glColor4f(0.4, 1.0, 0.6, 1);
+    glBegin(GL_QUADS);
+        for (unsigned int b = 0; b < nBands; ++b) {
+            float height = std::min(std::max(octaveFilterBank->getLevel(b) + OCTAVE_RANGE_DB, 0.0f), OCTAVE_RANGE_DB);
+            glVertex2f(b + 0.1f, 0);
+            glVertex2f(b + 0.9f, 0);
+            glVertex2f(b + 0.9f, height);
+            glVertex2f(b + 0.1f, height);
+        }
+    glEnd();
+    glPopMatrix();
+
+    /* a label every other octave, under its bar */
+    char str[16];
+    for (unsigned int b = 0; b < nBands; b += 2 * octaveFilterBank->getBandsPerOctave()) {
+        octaveFilterBank->nominalLabel(b, str);
+        Display::smallText(left + (right - left) * b / nBands, 0.005, str);
+    }
+    snprintf(str, sizeof(str), "0 dB");
+    Display::smallText(left, top + 0.005f, str);
+}
+
+void SpectrogramVisualizer::plotWelch() {
+    unsigned long columns = welchAverager->read(welchMean, welchVariance);
+    if (columns == 0) return;
+
+    /* densities in dB re full scale^2 / Hz, the top of the scale rounded up to 10 dB above the peak */
+    double scale = audioInput->getDensityScale();
+    float peak = -300.0f;
+    for (float& value : welchMean) {
+        value = 10.0f * log10f((float) std::max(scale * value, 1e-30));
+        peak = std::max(peak, value);
+    }
+    float top = 10.0f * ceilf(peak / 10.0f);
+
+    glPushMatrix();
+    glTranslatef(0.05, 0.1, 0);
+    glScalef(0.7f / AudioInput::N_FREQUENCIES, 0.0015, 1.0);
+    glColor4f(0.2, 0.9, 1.0, 1);
+    glBegin(GL_LINE_STRIP);
+        for (unsigned int i = 0; i < welchMean.size(); i++) {
+            glVertex2f(i, std::max(welchMean[i], top - 100.0f) - top + 50.0f);
+        }
+    glEnd();
+    glPopMatrix();
+
+    char str[64];
+    float seconds = (float) columns * audioInput->getHopSize() / audioInput->getSamplingRate();
+    snprintf(str, sizeof(str), "mean %.0f s, %.0f dB/Hz", seconds, top);
+    Display::smallText(0.76, 0.175, str);
+    snprintf(str, sizeof(str), "%.0f dB/Hz", top - 100.0f);
+    Display::smallText(0.76, 0.025, str);
 }
 
 void SpectrogramVisualizer::plotSpectrogram() {
@@ -220,32 +485,43 @@ void SpectrogramVisualizer::plotSpectrogram() {
     float curFrequency, lineFrequency;
     float secondsPerPixel = scrollFactor / FPS; // (float)fps, or longer FPS mean?
     float endTime = secondsPerPixel * AudioInput::N_TIME_WINDOWS;
-    char buffer[50];  /* for frequencyReadOff */
-    int nHarmonics, i, j, noteNum, octave;   // for frequencyReadOff
+    char buffer[50], note[8];  /* for frequencyReadOff */
+    int nHarmonics, i;   // for frequencyReadOff
+
+    if (historyView && history) {
+        plotHistory();
+        return;
+    }
 
     /* plot the spectrogram values */
     glDisable(GL_DEPTH_TEST);
     glDisable(GL_BLEND);
-    if (colorMode < 2) {
-        /* plot B/W */
-        glDrawPixels(AudioInput::N_TIME_WINDOWS, AudioInput::N_FREQUENCIES, GL_LUMINANCE, GL_UNSIGNED_BYTE,
-                     spectrogramBytes);
-    } else {
-        glTranslatef(x0, y0, 0);
-        int width = AudioInput::N_TIME_WINDOWS, height = AudioInput::N_FREQUENCIES;
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_R3_G3_B2, width, height, 0,
-                     GL_RGB, GL_UNSIGNED_BYTE_3_3_2, spectrogramBytes);
-        glEnable(GL_TEXTURE_2D);
-            glTexEnvf(GL_POINT_SPRITE, GL_TEXTURE_ENV_MODE, GL_TEXTURE);
-            glBindTexture(GL_TEXTURE_2D, specId);
-            glBegin(GL_QUADS);
-                glTexCoord2f(0, 0); glVertex2f(0, 0);  // bottom left
-                glTexCoord2f(1, 0); glVertex2f(0.9, 0);  // bottom right
-                glTexCoord2f(1, 1); glVertex2f(0.9, 0.75);  // top right
-                glTexCoord2f(0, 1); glVertex2f(0, 0.75);  // top left
-            glEnd();
-            glFlush();
-        glDisable(GL_TEXTURE_2D);
+    {
+        TraceScope traceScope("texture upload");
+        uploadedColumnTime = latestColumnTime;
+        uploadedColumnPower = latestColumnPower;
+        if (colorMode < 2) {
+            /* plot B/W */
+            glDrawPixels(AudioInput::N_TIME_WINDOWS, AudioInput::N_FREQUENCIES, GL_LUMINANCE, GL_UNSIGNED_BYTE,
+                         spectrogramBytes);
+        } else {
+            glTranslatef(x0, y0, 0);
+            int width = AudioInput::N_TIME_WINDOWS, height = AudioInput::N_FREQUENCIES;
+            glBindTexture(GL_TEXTURE_2D, specId);  // upload into this visualizer's texture, not the last bound one
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_R3_G3_B2, width, height, 0,
+                         GL_RGB, GL_UNSIGNED_BYTE_3_3_2, spectrogramBytes);
+            glEnable(GL_TEXTURE_2D);
+                glTexEnvf(GL_POINT_SPRITE, GL_TEXTURE_ENV_MODE, GL_TEXTURE);
+                glBindTexture(GL_TEXTURE_2D, specId);
+                glBegin(GL_QUADS);
+                    glTexCoord2f(0, 0); glVertex2f(0, 0);  // bottom left
+                    glTexCoord2f(1, 0); glVertex2f(0.9, 0);  // bottom right
+                    glTexCoord2f(1, 1); glVertex2f(0.9, 0.75);  // top right
+                    glTexCoord2f(0, 1); glVertex2f(0, 0.75);  // top left
+                glEnd();
+                glFlush();
+            glDisable(GL_TEXTURE_2D);
+        }
     }
 
     /* align spectrogram with the time and frequency axes */
@@ -267,7 +543,7 @@ void SpectrogramVisualizer::plotSpectrogram() {
     /* plot frequency read-off line(s) */
     if (frequencyReadOff) {
         /* obtain the selected frequency from current y mouse position */
-        curFrequency = hzPerPixelY * (viewportSize[1] * (1 - y0) - mouseHandle[1]);
+        curFrequency = readOffFrequency();
         if (curFrequency > 0.0) {       // only show if meaningful freq
             nHarmonics = (frequencyReadOff > 1) ? 10 : 1;
             /* plot desired frequency line and potentially also its harmonics */
@@ -291,19 +567,264 @@ void SpectrogramVisualizer::plotSpectrogram() {
                 /* draw text label(s) */
                 glEnable(GL_BLEND);
                 glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
-                noteNum = (int) roundf(N_SEMITONES_PER_OCTAVE * logf(lineFrequency / MIDDLE_C_FREQUENCY) / logf(2.0));
-                octave = 4 + noteNum / N_SEMITONES_PER_OCTAVE;  /* note: int division intentional */
-                if (octave < 0) octave = (int) NAN;
-                sprintf(buffer, "  %.d   %s%d", (int) roundf(lineFrequency),
-                        noteNames[(noteNum + 1200) % N_SEMITONES_PER_OCTAVE],
-                        octave);
+                noteLabel(lineFrequency, note);
+                sprintf(buffer, "  %.d   %s", (int) roundf(lineFrequency), note);
                 Display::smallText(runTime - endTime, lineFrequency + 3.0f * hzPerPixelY, buffer);
             }
         }
     }
+    if (onsetView && onsetDetector) plotOnsets(runTime - endTime, secondsPerPixel);
+    if (pitchView && pitchTracker) plotPitchTrack(runTime - endTime, secondsPerPixel);
+    glPopMatrix();
+
+    if (chromaView && chromaMapper) plotChroma();
+    if (toneTracker) plotToneTraces();
+    if (correlationView) plotCorrelations();
+}
+
+void SpectrogramVisualizer::plotToneTraces() {
+    ToneReading reading;
+    while (toneTracker->readReading(reading)) {
+        if (reading.generation != toneGeneration) {
+            std::fill(toneTrace.begin(), toneTrace.end(), -INFINITY);
+            toneGeneration = reading.generation;
+        }
+        for (unsigned int t = 0; t < reading.nTones; ++t) {
+            toneTrace[t * TONE_TRACE_READINGS + toneTraceEnd] = reading.level[t];
+        }
+        toneTraceEnd = (toneTraceEnd + 1) % TONE_TRACE_READINGS;
+        latestTone = reading;
+    }
+    unsigned int nTones = latestTone.generation == toneGeneration ? latestTone.nTones : 0;
+    if (nTones == 0) return;
+
+    /* a strip over the bottom of the spectrogram, full scale at its top, oldest reading on the left */
+    const float left = 0.05, right = 0.95, bottom = 0.23, top = 0.38;
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glColor4f(0.0, 0.0, 0.0, 0.6);
+    glBegin(GL_QUADS);
+        glVertex2f(left, bottom);
+        glVertex2f(right, bottom);
+        glVertex2f(right, top);
+        glVertex2f(left, top);
+    glEnd();
+
+    glTranslatef(left, top, 0);
+    glScalef((right - left) / TONE_TRACE_READINGS, (top - bottom) / TONE_TRACE_RANGE_DB, 1);
+    glDisable(GL_LINE_SMOOTH);
+    glLineWidth(1);
+    char str[64];
+    for (unsigned int t = 0; t < nTones; ++t) {
+        const float* color = TONE_COLORS[t];
+        const float* trace = &toneTrace[t * TONE_TRACE_READINGS];
+        float threshold = toneTracker->getThreshold(t);
+        if (std::isfinite(threshold)) {
+            glColor4f(color[0], color[1], color[2], 0.5);
+            glBegin(GL_LINES);
+                glVertex2f(0, std::max(threshold, -TONE_TRACE_RANGE_DB));
+                glVertex2f(TONE_TRACE_READINGS, std::max(threshold, -TONE_TRACE_RANGE_DB));
+            glEnd();
+        }
+        glColor4f(color[0], color[1], color[2], 1);
+        glBegin(GL_LINE_STRIP);
+            for (unsigned int i = 0; i < TONE_TRACE_READINGS; ++i) {
+                float level = trace[(toneTraceEnd + i) % TONE_TRACE_READINGS];
+                if (level > -INFINITY) glVertex2f(i, std::max(level, -TONE_TRACE_RANGE_DB));
+            }
+        glEnd();
+
+        bool alarm = latestTone.level[t] > threshold;
+        snprintf(str, sizeof(str), "%.1f Hz  %.1f dB  %+.2f rad%s", toneTracker->getFrequency(t),
+                 latestTone.level[t], latestTone.phase[t], alarm ? "  ALARM" : "");
+        if (alarm) glColor4f(1.0, 0.3, 0.3, 1);
+        Display::smallText(TONE_TRACE_READINGS * 0.01f, -(t + 1) * TONE_TRACE_RANGE_DB / 9.0f, str);
+    }
+    glPopMatrix();
+}
+
+void SpectrogramVisualizer::plotCorrelations() {
+    /* a panel below the chroma strip, zero delay in the middle and a peak of 1 at its top */
+    const float left = 0.60, right = 0.95, bottom = 0.70, top = 0.86;
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glColor4f(0.0, 0.0, 0.0, 0.6);
+    glBegin(GL_QUADS);
+        glVertex2f(left, bottom);
+        glVertex2f(right, bottom);
+        glVertex2f(right, top);
+        glVertex2f(left, top);
+    glEnd();
+
+    glTranslatef(left, bottom, 0);
+    glScalef((right - left) / (DelayEstimate::CURVE_POINTS - 1), top - bottom, 1);
+    glDisable(GL_LINE_SMOOTH);
+    glLineWidth(1);
+    glColor4f(0.5, 0.5, 0.5, 1);
+    glBegin(GL_LINES);
+        glVertex2f((DelayEstimate::CURVE_POINTS - 1) / 2.0f, 0);
+        glVertex2f((DelayEstimate::CURVE_POINTS - 1) / 2.0f, 1);
+    glEnd();
+
+    char str[64];
+    DelayEstimate estimate;
+    for (size_t p = 0; p < delayEstimators.size(); ++p) {
+        if (!delayEstimators[p]->getLatest(estimate)) continue;
+        const float* color = TONE_COLORS[p % ToneReading::MAX_TONES];
+        glColor4f(color[0], color[1], color[2], 1);
+        glBegin(GL_LINE_STRIP);
+            for (unsigned int i = 0; i < DelayEstimate::CURVE_POINTS; ++i) {
+                glVertex2f(i, std::min(std::max(estimate.correlation[i], 0.0f), 1.0f));
+            }
+        glEnd();
+        snprintf(str, sizeof(str), "%u-%u: %+.3f ms (peak %.2f)", estimate.first + 1, estimate.second + 1,
+                 estimate.delay * 1e3, estimate.peak);
+        Display::smallText(DelayEstimate::CURVE_POINTS * 0.01f, 1.0f - (p + 1) / 8.0f, str);
+    }
+    if (!delayEstimators.empty()) {
+        glColor4f(0.7, 0.7, 0.7, 1);
+        snprintf(str, sizeof(str), "+/-%.1f ms", delayEstimators[0]->getMaxDelay() * 1e3);
+        Display::smallText(DelayEstimate::CURVE_POINTS * 0.01f, 0.03f, str);
+    }
+    glPopMatrix();
+}
+
+float SpectrogramVisualizer::readOffFrequency() const {
+    const float y0 = 0.22;
+    return hzPerPixelY * (viewportSize[1] * (1 - y0) - mouseHandle[1]);
+}
+
+void SpectrogramVisualizer::plotChroma() {
+    /* the strip covers the top of the spectrogram area, lowest pitch class at the bottom */
+    const float left = 0.05, right = 0.95, bottom = 0.87, top = 0.97;
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+    glBindTexture(GL_TEXTURE_2D, chromaId);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, AudioInput::N_TIME_WINDOWS, ChromaFrame::N_CLASSES, 0,
+                 GL_LUMINANCE, GL_UNSIGNED_BYTE, chromaBytes.data());
+    glEnable(GL_TEXTURE_2D);
+    glColor4f(1.0, 1.0, 1.0, 1);
+    glBegin(GL_QUADS);
+        glTexCoord2f(0, 0); glVertex2f(left, bottom);
+        glTexCoord2f(1, 0); glVertex2f(right, bottom);
+        glTexCoord2f(1, 1); glVertex2f(right, top);
+        glTexCoord2f(0, 1); glVertex2f(left, top);
+    glEnd();
+    glDisable(GL_TEXTURE_2D);
+
+    /* name every other row */
+    char name[4];
+    float rowHeight = (top - bottom) / ChromaFrame::N_CLASSES;
+    glColor4f(0.2, 0.9, 1.0, 1);
+    for (unsigned int c = 0; c < ChromaFrame::N_CLASSES; c += 2) {
+        snprintf(name, sizeof(name), "%s", noteNames[c]);
+        Display::smallText(left - 0.03f, bottom + c * rowHeight, name);
+    }
     glPopMatrix();
 }
 
+void SpectrogramVisualizer::plotPitchTrack(float startTime, float secondsPerPixel) {
+    /* one line strip per voiced run */
+    glDisable(GL_LINE_SMOOTH);
+    glLineWidth(2);
+    glColor4f(0.2, 0.9, 1.0, 1);
+    bool drawing = false;
+    for (unsigned int i = 0; i < pitchTrack.size(); ++i) {
+        if (pitchTrack[i] > 0.0f && !drawing) glBegin(GL_LINE_STRIP);
+        if (pitchTrack[i] <= 0.0f && drawing) glEnd();
+        drawing = pitchTrack[i] > 0.0f;
+        if (drawing) glVertex2f(startTime + (i + 0.5f) * secondsPerPixel, pitchTrack[i]);
+    }
+    if (drawing) glEnd();
+
+    /* name the latest pitch next to the newest column */
+    float frequency = pitchTrack.back();
+    if (frequency > 0.0f) {
+        char note[8], buffer[32];
+        noteLabel(frequency, note);
+        sprintf(buffer, " %s %.0f Hz", note, frequency);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        Display::smallText(startTime + pitchTrack.size() * secondsPerPixel, frequency, buffer);
+    }
+}
+
+void SpectrogramVisualizer::plotOnsets(float startTime, float secondsPerPixel) {
+    glDisable(GL_LINE_SMOOTH);
+    glLineWidth(1);
+    glColor4f(1.0, 0.3, 0.3, 1);
+    glBegin(GL_LINES);
+    for (unsigned int i = 0; i < onsetMarks.size(); ++i) {
+        if (!onsetMarks[i]) continue;
+        glVertex2f(startTime + (i + 0.5f) * secondsPerPixel, 0.0f);
+        glVertex2f(startTime + (i + 0.5f) * secondsPerPixel, highestFrequency);
+    }
+    glEnd();
+}
+
+void SpectrogramVisualizer::noteLabel(float frequency, char* buffer) {
+    int noteNum = (int) roundf(N_SEMITONES_PER_OCTAVE * log2f(frequency / MIDDLE_C_FREQUENCY));
+    int octave = 4 + (int) floorf((float) noteNum / N_SEMITONES_PER_OCTAVE);
+    sprintf(buffer, "%s%d", noteNames[(noteNum + 1200) % N_SEMITONES_PER_OCTAVE], octave);
+}
+
+void SpectrogramVisualizer::plotHistory() {
+    float x0 = 0.05, y0 = 0.22;
+    int width = AudioInput::N_TIME_WINDOWS, height = HistoryPyramid::N_BINS;
+
+    /* the view always spans N_TIME_WINDOWS columns of its level, so it costs the same at any zoom */
+    int64_t end0 = historyEnd < 0 ? (int64_t) history->getColumns(0) : historyEnd;
+    int64_t first = (end0 >> historyLevel) - width;
+    {
+        TraceScope traceScope("history upload");
+        history->read(historyLevel, first, width, historyBytes);
+
+        /* colour map through a lookup table of the 256 stored levels */
+        char lut[256];
+        for (int q = 0; q < 256; ++q) lut[q] = colorByteMap(HistoryPyramid::dequantize((uint8_t) q));
+        for (int i = 0; i < width * height; ++i) historyBytes[i] = (uint8_t) lut[historyBytes[i]];
+
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_BLEND);
+        glTranslatef(x0, y0, 0);
+        glBindTexture(GL_TEXTURE_2D, specId);
+        if (colorMode < 2) {
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, width, height, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE,
+                         historyBytes);
+        } else {
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_R3_G3_B2, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE_3_3_2,
+                         historyBytes);
+        }
+        glEnable(GL_TEXTURE_2D);
+            glBindTexture(GL_TEXTURE_2D, specId);
+            glBegin(GL_QUADS);
+                glTexCoord2f(0, 0); glVertex2f(0, 0);  // bottom left
+                glTexCoord2f(1, 0); glVertex2f(0.9, 0);  // bottom right
+                glTexCoord2f(1, 1); glVertex2f(0.9, 0.75);  // top right
+                glTexCoord2f(0, 1); glVertex2f(0, 0.75);  // top left
+            glEnd();
+        glDisable(GL_TEXTURE_2D);
+    }
+
+    /* label the shown time range */
+    char startStamp[32], endStamp[32], label[100];
+    int64_t oldest = (int64_t) history->getOldestColumn(historyLevel);
+    time_t startTime = (time_t) history->columnTime(historyLevel, std::max<int64_t>(first, oldest));
+    time_t endTime = (time_t) history->columnTime(historyLevel, (end0 >> historyLevel) - 1);
+    strftime(startStamp, sizeof(startStamp), "%H:%M:%S", localtime(&startTime));
+    strftime(endStamp, sizeof(endStamp), "%H:%M:%S", localtime(&endTime));
+    sprintf(label, "history %s - %s  level %u%s", startStamp, endStamp, historyLevel, historyEnd < 0 ? "  live" : "");
+    glColor4f(1, .4, .4, 1.0);
+    Display::smallText(0, 0.77, label);
+}
+
 void SpectrogramVisualizer::drawAxes(float xStart, float xEnd, float yStart, float yEnd,
                                      float xFudgeFactor, float yFudgeFactor,
                                      char *xLabel, char *yLabel) {
@@ -396,7 +917,7 @@ char SpectrogramVisualizer::colorByteMap(float x) {
     if (colorMode == 1) {
         // inverse b/w
         return (char) (255 - k);
-    } else if (colorMode == 2) {    // color (pack into 3_3_2 RGB format) .. SLOW?
+    } else if (colorMode >= 2) {    // color (pack into 3_3_2 RGB format) .. SLOW?
         float a = k / 255.0f;       // 0<a<1. now map from [0,1] to rgb in [0,1]
         float r = 5 * (a - 0.2);
         if (r < 0) r = 0.0; else if (r >= 1) r = .955; // clip
@@ -412,13 +933,64 @@ char SpectrogramVisualizer::colorByteMap(float x) {
     }
 }
 
+char SpectrogramVisualizer::zScoreByteMap(float x, unsigned int frequency) {
+    /* the absolute level in 4 grey steps for context */
+    double fac = 20.0 * colorScale[1];
+    auto k = (int) (colorScale[0] + fac * log10((double)x));
+    if (k > 255) k = 255; else if (k < 0) k = 0;
+    int grey = k >> 6;
+
+    float z = (log2f(std::max(x, 1e-20f)) - baselineMean[frequency]) * baselineInverseDeviation[frequency];
+    if (z < Z_SCORE_THRESHOLD) return (char) (32 * grey + 4 * grey + grey / 2);
+
+    /* red at the threshold turning yellow towards saturation */
+    float a = std::min(1.0f, (z - Z_SCORE_THRESHOLD) / (Z_SCORE_SATURATION - Z_SCORE_THRESHOLD));
+    return (char) (32 * 7 + 4 * (int) (a * 7.99f));
+}
+
+void SpectrogramVisualizer::refreshBaseline() {
+    binStatistics->read(baselineMean, baselineInverseDeviation);
+}
+
 void SpectrogramVisualizer::recomputeSpectrogramBytes() {
     int i, j, n = AudioInput::N_TIME_WINDOWS;
+    if (colorMode == 3) {
+        refreshBaseline();
+        for (i = 0; i < n; ++i)
+            for (unsigned int bin = 0; bin < AudioInput::N_FREQUENCIES; ++bin)
+                spectrogramBytes[bin * n + i] = zScoreByteMap(spectrogramFloat[bin * n + i], bin);
+        return;
+    }
     for (i = 0; i < n; ++i)
         for (j = 0; j < AudioInput::N_FREQUENCIES; ++j)
             spectrogramBytes[j * n + i] = colorByteMap(spectrogramFloat[j * n + i]);
 }
 
+void SpectrogramVisualizer::updateAutoLevel(const float* column) {
+    /* digital silence would pull the low quantile to the power floor */
+    for (unsigned int j = 0; j < AudioInput::N_FREQUENCIES; ++j) {
+        if (column[j] <= 0.0f) continue;
+        double level = 20.0 * log10((double) column[j]);
+        lowLevel.add(level);
+        highLevel.add(level);
+    }
+    if (lowLevel.getCount() >= AUTO_LEVEL_COLUMNS * AudioInput::N_FREQUENCIES) {
+        autoLevelTarget[0] = (float) lowLevel.get();
+        autoLevelTarget[1] = std::max((float) highLevel.get(), autoLevelTarget[0] + AUTO_LEVEL_MIN_RANGE_DB);
+        lowLevel.reset();
+        highLevel.reset();
+        if (!autoLevelSettled) {
+            for (int i = 0; i < 2; i++) autoLevelCurrent[i] = autoLevelTarget[i];
+            autoLevelSettled = true;
+        }
+    }
+    if (!autoLevelSettled) return;
+
+    for (int i = 0; i < 2; i++) autoLevelCurrent[i] += AUTO_LEVEL_RATE * (autoLevelTarget[i] - autoLevelCurrent[i]);
+    colorScale[1] = 255.0f / (autoLevelCurrent[1] - autoLevelCurrent[0]);
+    colorScale[0] = -colorScale[1] * autoLevelCurrent[0];
+}
+
 int SpectrogramVisualizer::chooseTics(float lowValue, float range, float fudgeFactor, float *tickMarks) {
     int i, nTics, startTick;
     float exponent, logr, spacing;
@@ -447,6 +1019,13 @@ void SpectrogramVisualizer::scrollSpectrogram() {
     int i, j;
     int n = AudioInput::N_TIME_WINDOWS;
     float *newSpectrogramData = audioInput->getSpectrogramSlice();
+    latestColumnTime = audioInput->getSpectrogramSliceTime();
+    unsigned long producedColumns = audioInput->getColumnsProduced();
+    if (producedColumns > scrolledColumns + 1) {
+        renderBacklog += producedColumns - scrolledColumns - 1;
+    }
+    scrolledColumns = producedColumns;
+    TraceScope traceScope("colour map");
 
     /* scroll existing data */
     for (i = 0; i < n; ++i) {
@@ -457,9 +1036,40 @@ void SpectrogramVisualizer::scrollSpectrogram() {
     }
 
     /* add new data */
+    float columnPower = 0.0f;
+    if (colorMode == 3) refreshBaseline();
+    if (autoLevel) updateAutoLevel(newSpectrogramData);
     for (j = 0; j < AudioInput::N_FREQUENCIES; ++j) {
         spectrogramFloat[j * n + n - 1] = newSpectrogramData[j];
-        spectrogramBytes[j * n + n - 1] = colorByteMap(newSpectrogramData[j]);
+        spectrogramBytes[j * n + n - 1] = colorMode == 3 ? zScoreByteMap(newSpectrogramData[j], j)
+                                                         : colorByteMap(newSpectrogramData[j]);
+        columnPower += newSpectrogramData[j];
+    }
+    latestColumnPower = columnPower / AudioInput::N_FREQUENCIES;
+
+    if (chromaMapper) {
+        float chroma[ChromaFrame::N_CLASSES];
+        chromaMapper->getLatest(chroma);
+        float loudest = *std::max_element(chroma, chroma + ChromaFrame::N_CLASSES);
+        for (unsigned int c = 0; c < ChromaFrame::N_CLASSES; ++c) {
+            uint8_t* row = &chromaBytes[c * n];
+            memmove(row, row + 1, n - 1);
+            row[n - 1] = (uint8_t) (loudest > 0.0f ? 255.0f * chroma[c] / loudest : 0.0f);
+        }
+    }
+
+    if (onsetDetector) {
+        unsigned long detected = onsetDetector->getDetected();
+        onsetMarks.erase(onsetMarks.begin());
+        onsetMarks.push_back(detected != markedOnsets);
+        markedOnsets = detected;
+    }
+
+    if (pitchTracker) {
+        float frequency, salience;
+        pitchTracker->getLatest(frequency, salience);
+        pitchTrack.erase(pitchTrack.begin());
+        pitchTrack.push_back(frequency);
     }
 }
 
@@ -484,12 +1094,15 @@ void SpectrogramVisualizer::display() {
     glColor4f(0.7, 1.0, 1.0, 1);
 #endif
 
+    bool renderAuxiliaryPlots = audioInput->getGovernor().current().renderAuxiliaryPlots;
+
 #ifdef DISPLAY_TIME
-    plotTimeDomain();
+    if (renderAuxiliaryPlots && !(octaveView && octaveFilterBank)) plotTimeDomain();
 #endif
+    if (renderAuxiliaryPlots && octaveView && octaveFilterBank) plotOctaveBands();
 
 #ifdef DISPLAY_SPECMAG
-    plotSpectralMagnitude();
+    if (renderAuxiliaryPlots) plotSpectralMagnitude();
 #endif
 
 #ifdef DISPLAY_SPECTROGRAM
@@ -515,10 +1128,34 @@ void SpectrogramVisualizer::displayText() {
     char str[50];
     sprintf(str, "%d FPS", fps);
     Display::smallText(0.92, 0.96, str);
-    sprintf(str, "gain offset %.0f dB", colorScale[0]);
+    sprintf(str, autoLevel ? "gain offset %.0f dB (auto)" : "gain offset %.0f dB", colorScale[0]);
     Display::smallText(0.02, 0.04, str);
     sprintf(str, "dyn range  %.1f dB", 255.0 / colorScale[1]);
     Display::smallText(0.02, 0.02, str);
+    if (colorMode == 3 && binStatistics) {
+        sprintf(str, "z > %.0f over %s baseline", Z_SCORE_THRESHOLD, binStatistics->isLearning() ? "learning" : "held");
+        Display::smallText(0.02, 0.06, str);
+    }
+    if (glassLatency.getCount()) {
+        sprintf(str, "latency p50 %.1f p99 %.1f ms", 1e3f * glassLatency.percentile(50),
+                1e3f * glassLatency.percentile(99));
+        Display::smallText(0.68, 0.96, str);
+    }
+    if (clickLatency.getCount()) {
+        sprintf(str, "click p50 %.1f p99 %.1f ms (n=%lu)", 1e3f * clickLatency.percentile(50),
+                1e3f * clickLatency.percentile(99), clickLatency.getCount());
+        Display::smallText(0.68, 0.94, str);
+    }
+    if (!label.empty()) {
+        Display::smallText(0.40, 0.96, (char*) label.c_str());
+    }
+    if (replay) {
+        char stamp[32];
+        time_t position = (time_t) replay->getPositionUnixTime();
+        strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", localtime(&position));
+        sprintf(str, "replay %s x%.3g", stamp, replay->getSpeed());
+        Display::smallText(0.02, 0.96, str);
+    }
 
     if (diagnose) {  // show diagnosis
         glColor4f(.2, .2, .2, 0.8);  // transparent box
@@ -541,14 +1178,42 @@ void SpectrogramVisualizer::displayText() {
 }
 
 void SpectrogramVisualizer::idle() {
-    ++frameCount;        // compute FPS...
-    time_t now = time(NULL);     // integer in seconds
+    time_t now = time(NULL);     // integer in seconds, frames are counted in swapped()
     if (now > fpsTick) {    // advanced by at least 1 sec?
         fps = frameCount;
         frameCount = 0;
         fpsTick = now;
+        sprintf(diagnosis, "level %u (%s)  overflows %lu  dropped hops %lu  backlog %lu  dsp %.0f%%",
+                audioInput->getGovernor().getLevel(), audioInput->getGovernor().current().name,
+                audioInput->getInputOverflows(), audioInput->getDroppedHops(), renderBacklog,
+                100.0f * audioInput->getGovernor().getDspLoad());
+        size_t length = strlen(diagnosis);
+        if (audioInput->getWindowType() == AudioInput::MULTITAPER_WINDOW) {
+            snprintf(diagnosis + length, sizeof(diagnosis) - length, "  multitaper");
+        } else if (audioInput->getWindowType() == AudioInput::POLYPHASE_WINDOW) {
+            snprintf(diagnosis + length, sizeof(diagnosis) - length, "  %u tap polyphase filterbank",
+                     PolyphaseFilterbank::TAPS);
+        } else if (audioInput->getWindowType() == AudioInput::MULTIRESOLUTION_WINDOW) {
+            snprintf(diagnosis + length, sizeof(diagnosis) - length, "  multi-resolution, %s windows",
+                     WindowLibrary::name(audioInput->getWindow()->type));
+        } else {
+            const WindowLibrary::Table* window = audioInput->getWindow();
+            snprintf(diagnosis + length, sizeof(diagnosis) - length, "  %s window, noise bandwidth %.2f bins",
+                     WindowLibrary::name(window->type), window->noiseBandwidth);
+        }
+        if (dspGraph) {
+            std::string edges;
+            dspGraph->describe(edges);
+            size_t length = strlen(diagnosis);
+            if (!edges.empty()) snprintf(diagnosis + length, sizeof(diagnosis) - length, "  %s", edges.c_str());
+        }
     }
 
+    /* let the governor adapt to the load */
+    audioInput->getGovernor().update(Trace::now() * 1e-9);
+
+    if (flightRecorder) flightRecorder->triggerIfRequested();
+
     /* if not paused, scroll every scrollFactor vSyncs */
     if (!audioInput->isPause()) {
         timeval nowe;  // update runtime
@@ -571,8 +1236,7 @@ void SpectrogramVisualizer::pause() {
 
 void SpectrogramVisualizer::keyboard(unsigned char key, int xPos, int yPos) {
     if (key == KEYBOARD_SHORTCUTS.ESCAPE || key == KEYBOARD_SHORTCUTS.QUIT) {  // esc or q to quit
-        audioInput->quitNow();
-        exit(0);
+        Display::quit();  // quits every tile's source, not only this one
     } else if (key == KEYBOARD_SHORTCUTS.PAUSE) {
         pause();
     } else if (key == KEYBOARD_SHORTCUTS.DIAGNOSE) {
@@ -590,14 +1254,82 @@ void SpectrogramVisualizer::keyboard(unsigned char key, int xPos, int yPos) {
             OUT("scrollFactor: " << scrollFactor);
         }
     } else if (key == KEYBOARD_SHORTCUTS.CHANGE_COLOR_SCHEME) {
-        colorMode = (colorMode + 1) % 3;     // spectrogram color scheme
+        colorMode = (colorMode + 1) % (binStatistics ? 4 : 3);     // spectrogram color scheme
         recomputeSpectrogramBytes();
+    } else if (key == KEYBOARD_SHORTCUTS.FLUSH_TRACE) {
+        if (Trace::getInstance()->isEnabled()) {
+            Trace::getInstance()->flush();
+        } else {
+            OUT("tracing not enabled (-t)");
+        }
+    } else if (key == KEYBOARD_SHORTCUTS.DUMP_FLIGHT_RECORDER) {
+        if (flightRecorder) flightRecorder->trigger("key");
+    } else if (replay && key == KEYBOARD_SHORTCUTS.REPLAY_SEEK_BACK) {
+        replay->seek(replay->getStreamTime() - REPLAY_SEEK_SECONDS);
+    } else if (replay && key == KEYBOARD_SHORTCUTS.REPLAY_SEEK_FORWARD) {
+        replay->seek(replay->getStreamTime() + REPLAY_SEEK_SECONDS);
+    } else if (replay && key == KEYBOARD_SHORTCUTS.REPLAY_SLOWER) {
+        replay->setSpeed(replay->getSpeed() / 2);
+    } else if (replay && key == KEYBOARD_SHORTCUTS.REPLAY_FASTER) {
+        replay->setSpeed(replay->getSpeed() * 2);
+    } else if (pitchTracker && key == KEYBOARD_SHORTCUTS.PITCH_VIEW) {
+        pitchView = !pitchView;
+    } else if (!replay && key == KEYBOARD_SHORTCUTS.NEXT_WINDOW
+               && audioInput->getWindowType() != AudioInput::MULTITAPER_WINDOW
+               && audioInput->getWindowType() != AudioInput::POLYPHASE_WINDOW
+               && audioInput->getWindowType() != AudioInput::MULTIRESOLUTION_WINDOW) {
+        audioInput->setWindow(WindowLibrary::next(audioInput->getWindow()->type));
+        OUT("window: " << WindowLibrary::name(audioInput->getWindow()->type));
+    } else if (onsetDetector && key == KEYBOARD_SHORTCUTS.ONSET_VIEW) {
+        onsetView = !onsetView;
+    } else if (toneTracker && frequencyReadOff && key == KEYBOARD_SHORTCUTS.TRACK_TONE) {
+        float frequency = readOffFrequency();
+        if (!toneTracker->addTone(frequency, INFINITY)) OUT("cannot track " << frequency << " Hz");
+    } else if (toneTracker && key == KEYBOARD_SHORTCUTS.CLEAR_TONES) {
+        toneTracker->clearTones();
+    } else if (!delayEstimators.empty() && key == KEYBOARD_SHORTCUTS.CORRELATION_VIEW) {
+        correlationView = !correlationView;
+    } else if (octaveFilterBank && key == KEYBOARD_SHORTCUTS.OCTAVE_VIEW) {
+        octaveView = !octaveView;
+    } else if (welchAverager && key == KEYBOARD_SHORTCUTS.WELCH_VIEW) {
+        welchView = !welchView;
+    } else if (welchAverager && key == KEYBOARD_SHORTCUTS.WELCH_EXPORT) {
+        char path[40];
+        time_t now = time(NULL);
+        strftime(path, sizeof(path), "welch_%Y%m%d_%H%M%S.csv", localtime(&now));
+        welchAverager->write(path, audioInput->getDensityScale(), highestFrequency / AudioInput::N_FREQUENCIES);
+    } else if (key == KEYBOARD_SHORTCUTS.AUTO_LEVEL) {
+        setAutoLevel(!autoLevel);
+    } else if (binStatistics && key == KEYBOARD_SHORTCUTS.BASELINE_LEARN) {
+        binStatistics->setLearning(!binStatistics->isLearning());
+    } else if (binStatistics && key == KEYBOARD_SHORTCUTS.BASELINE_SAVE) {
+        char path[40];
+        time_t now = time(NULL);
+        strftime(path, sizeof(path), "baseline_%Y%m%d_%H%M%S.bin", localtime(&now));
+        binStatistics->save(path);
+    } else if (chromaMapper && key == KEYBOARD_SHORTCUTS.CHROMA_VIEW) {
+        chromaView = !chromaView;
+    } else if (history && key == KEYBOARD_SHORTCUTS.HISTORY_VIEW) {
+        historyView = !historyView;
+        historyEnd = -1;
+    } else if (history && key == KEYBOARD_SHORTCUTS.HISTORY_ZOOM_OUT) {
+        historyLevel = std::min(historyLevel + 1, HistoryPyramid::N_LEVELS - 1);
+    } else if (history && key == KEYBOARD_SHORTCUTS.HISTORY_ZOOM_IN) {
+        if (historyLevel > 0) historyLevel--;
+    } else if (history && (key == KEYBOARD_SHORTCUTS.HISTORY_BACK || key == KEYBOARD_SHORTCUTS.HISTORY_FORWARD)) {
+        /* pan by half a screen, returning to the live end when panning past it, stopping at the oldest retained */
+        int64_t live = (int64_t) history->getColumns(0);
+        int64_t oldest = (int64_t) history->getOldestColumn(historyLevel) << historyLevel;
+        int64_t step = (int64_t) (AudioInput::N_TIME_WINDOWS / 2) << historyLevel;
+        int64_t end = (historyEnd < 0 ? live : historyEnd) + (key == KEYBOARD_SHORTCUTS.HISTORY_BACK ? -step : step);
+        historyEnd = end >= live ? -1 : std::max<int64_t>(end, oldest);
     } else {
         fprintf(stderr, "pressed key %d\n", (int) key);
     }
 }
 
 void SpectrogramVisualizer::special(int key, int xPos, int yPos) {
+    if (key >= 100 && key <= 103) autoLevel = false;  // adjusted by hand
     if (key == 102) { // rt
         colorScale[1] *= 1.5;
         recomputeSpectrogramBytes(); // contrast
@@ -640,13 +1372,128 @@ void SpectrogramVisualizer::mouse(int button, int state, int x, int y) {
     }
 }
 
+void SpectrogramVisualizer::swapped() {
+    ++frameCount;
+
+    /* report swap-to-swap frame times to the governor */
+    DegradationGovernor& governor = audioInput->getGovernor();
+    uint64_t nowNs = Trace::now();
+    if (lastSwapNs) {
+        governor.reportFrameTime((nowNs - lastSwapNs) * 1e-9f, governor.current().frameInterval / FPS);
+    }
+    lastSwapNs = nowNs;
+
+    /* only measure each column once, even if the display repeats it */
+    if (uploadedColumnTime <= measuredColumnTime) return;
+    measuredColumnTime = uploadedColumnTime;
+    double now = audioInput->getStreamTime();
+    glassLatency.record(now - uploadedColumnTime);
+
+    if (!audioInput->isLatencySelfTest()) return;
+    double clickTime = audioInput->getClickAdcTime();
+    bool clickPending = clickTime > detectedClickTime && uploadedColumnTime >= clickTime;
+    if (clickPending && columnPowerBaseline > 0.0f &&
+        uploadedColumnPower > CLICK_DETECTION_RATIO * columnPowerBaseline) {
+        clickLatency.record(now - clickTime);
+        detectedClickTime = clickTime;
+    } else if (!clickPending) {
+        /* track the background level between clicks */
+        columnPowerBaseline = columnPowerBaseline > 0.0f ?
+                              0.95f * columnPowerBaseline + 0.05f * uploadedColumnPower : uploadedColumnPower;
+    }
+}
+
 void SpectrogramVisualizer::motion(int x, int y) {
     auto dx = (int) (x - mouseHandle[0]);
     auto dy = (int) (y - mouseHandle[1]);
     if (mouseHandle[2] == GLUT_MIDDLE_BUTTON) {   // controls color scale
+        autoLevel = false;
         colorScale[0] += dx / 5.0;  // brightness
         colorScale[1] *= exp(-dy / 200.0); // contrast
     }
     mouseHandle[0] = x;
     mouseHandle[1] = y;
 }
+
+AudioInput* SpectrogramVisualizer::getAudioInput() const {
+    return audioInput;
+}
+
+unsigned int SpectrogramVisualizer::frameInterval() {
+    return audioInput->getGovernor().current().frameInterval;
+}
+
+void SpectrogramVisualizer::quit() {
+    audioInput->quitNow();
+    audioInput->waitForDsp();
+}
+
+void SpectrogramVisualizer::setFlightRecorder(FlightRecorder* flightRecorder) {
+    this->flightRecorder = flightRecorder;
+}
+
+void SpectrogramVisualizer::setReplay(SpectrogramReplay* replay) {
+    this->replay = replay;
+}
+
+void SpectrogramVisualizer::setHistory(HistoryPyramid* history) {
+    this->history = history;
+}
+
+void SpectrogramVisualizer::setDspGraph(DspGraph* dspGraph) {
+    this->dspGraph = dspGraph;
+}
+
+void SpectrogramVisualizer::setPitchTracker(PitchTracker* pitchTracker) {
+    this->pitchTracker = pitchTracker;
+    pitchView = pitchTracker != nullptr;
+}
+
+void SpectrogramVisualizer::setChromaMapper(ChromaMapper* chromaMapper) {
+    this->chromaMapper = chromaMapper;
+    chromaView = chromaMapper != nullptr;
+}
+
+void SpectrogramVisualizer::setOnsetDetector(OnsetDetector* onsetDetector) {
+    this->onsetDetector = onsetDetector;
+    onsetView = onsetDetector != nullptr;
+}
+
+void SpectrogramVisualizer::setWelchAverager(WelchAverager* welchAverager) {
+    this->welchAverager = welchAverager;
+    welchView = welchAverager != nullptr;
+}
+
+void SpectrogramVisualizer::setBinStatistics(BinStatistics* binStatistics) {
+    this->binStatistics = binStatistics;
+    if (!binStatistics && colorMode == 3) {
+        colorMode = 2;
+        recomputeSpectrogramBytes();
+    }
+}
+
+void SpectrogramVisualizer::setToneTracker(ToneTracker* toneTracker) {
+    this->toneTracker = toneTracker;
+}
+
+void SpectrogramVisualizer::setOctaveFilterBank(OctaveFilterBank* octaveFilterBank) {
+    this->octaveFilterBank = octaveFilterBank;
+    octaveView = octaveFilterBank != nullptr;
+}
+
+void SpectrogramVisualizer::setDelayEstimators(const std::vector<DelayEstimator*>& delayEstimators) {
+    this->delayEstimators = delayEstimators;
+    correlationView = !delayEstimators.empty();
+}
+
+void SpectrogramVisualizer::setAutoLevel(bool autoLevel) {
+    this->autoLevel = autoLevel;
+    lowLevel.reset();
+    highLevel.reset();
+    autoLevelSettled = false;
+    OUT("auto-level: " << (autoLevel ? "on" : "off"));
+}
+
+void SpectrogramVisualizer::setLabel(const std::string& label) {
+    this->label = label;
+}
@@ -14,6 +14,7 @@
 #include <pthread.h>
 #include <sys/time.h>
 #include <math.h>
+#include <string>
 #include <fftw3.h>
 #include "common.h"
 #include "AudioInput.hpp"
@@ -21,6 +22,21 @@
 #include "Display.hpp"
 #include "GraphicsItem.hpp"
 #include "shared.hpp"
+#include "Trace.hpp"
+#include "LatencyMonitor.hpp"
+#include "FlightRecorder.hpp"
+#include "SpectrogramReplay.hpp"
+#include "HistoryPyramid.hpp"
+#include "DspGraph.hpp"
+#include "PitchTracker.hpp"
+#include "ChromaMapper.hpp"
+#include "OnsetDetector.hpp"
+#include "WelchAverager.hpp"
+#include "BinStatistics.hpp"
+#include "StreamingQuantile.hpp"
+#include "ToneTracker.hpp"
+#include "DelayEstimator.hpp"
+#include "OctaveFilterBank.hpp"
 
 class SpectrogramVisualizer : public GraphicsItem {
 public:
@@ -39,6 +55,30 @@ public:
         char SAMPLE_RATE_UP;
         char SAMPLE_RATE_DOWN;
         char CHANGE_COLOR_SCHEME;
+        char FLUSH_TRACE;
+        char DUMP_FLIGHT_RECORDER;
+        char REPLAY_SEEK_BACK;
+        char REPLAY_SEEK_FORWARD;
+        char REPLAY_SLOWER;
+        char REPLAY_FASTER;
+        char HISTORY_VIEW;
+        char HISTORY_ZOOM_OUT;
+        char HISTORY_ZOOM_IN;
+        char HISTORY_BACK;
+        char HISTORY_FORWARD;
+        char PITCH_VIEW;
+        char CHROMA_VIEW;
+        char ONSET_VIEW;
+        char NEXT_WINDOW;
+        char WELCH_VIEW;
+        char WELCH_EXPORT;
+        char BASELINE_LEARN;
+        char BASELINE_SAVE;
+        char AUTO_LEVEL;
+        char TRACK_TONE;
+        char CLEAR_TONES;
+        char CORRELATION_VIEW;
+        char OCTAVE_VIEW;
     };
 
     /**
@@ -59,9 +99,49 @@ public:
     static const unsigned int N_SEMITONES_PER_OCTAVE;
 
     /**
-     * Overloaded constructor to initialize various member parameters.
+     * Power ratio over the running column power by which a displayed column counts as the detection of a synthetic
+     * click in the latency self-test mode.
      */
-    SpectrogramVisualizer(int, int);
+    static const float CLICK_DETECTION_RATIO;
+
+    /**
+     * Seconds jumped by the REPLAY_SEEK_BACK and REPLAY_SEEK_FORWARD keys.
+     */
+    static const double REPLAY_SEEK_SECONDS;
+
+    /**
+     * z-score from which the z-score colour map highlights a deviation, and at which its highlight saturates.
+     */
+    static const float Z_SCORE_THRESHOLD;
+    static const float Z_SCORE_SATURATION;
+
+    /**
+     * Auto-level: quantiles of the levels of recent columns mapped to the darkest and brightest colours, number of
+     * columns per quantile estimate, fraction of the way to the latest estimate moved per column, and least range.
+     */
+    static const double AUTO_LEVEL_LOW_QUANTILE;
+    static const double AUTO_LEVEL_HIGH_QUANTILE;
+    static const unsigned int AUTO_LEVEL_COLUMNS;
+    static const float AUTO_LEVEL_RATE;
+    static const float AUTO_LEVEL_MIN_RANGE_DB;
+
+    /**
+     * Readings kept for the trace of every tracked tone, and the range of levels shown below full scale.
+     */
+    static const unsigned int TONE_TRACE_READINGS;
+    static const float TONE_TRACE_RANGE_DB;
+
+    /**
+     * Range of band levels shown by the octave band bars, below full scale.
+     */
+    static const float OCTAVE_RANGE_DB;
+
+    /**
+     * Overloaded constructor to initialize various member parameters, and start capturing from audioInput.
+     * @param scrollFactor number of vSyncs per scroll.
+     * @param audioInput audio source of the visualization, e.g. PortAudio or SpectrogramReplay.
+     */
+    SpectrogramVisualizer(int scrollFactor, AudioInput* audioInput);
 
     SpectrogramVisualizer(const SpectrogramVisualizer&);
     SpectrogramVisualizer& operator=(const SpectrogramVisualizer&);
@@ -135,6 +215,117 @@ public:
      */
     virtual void motion(int x, int y);
 
+    /**
+     * Measures the ADC-to-screen latency of the newest spectrogram column once its frame has been swapped to the
+     * screen, and in the latency self-test mode detects synthetic clicks in it.
+     */
+    virtual void swapped();
+
+    /**
+     * @return number of vSyncs between redisplays at the current degradation level.
+     */
+    virtual unsigned int frameInterval();
+
+    /**
+     * Stops the audio source and waits for its last block to leave the DSP thread pool.
+     */
+    virtual void quit();
+
+    /**
+     * @return the audio source of the visualization.
+     */
+    AudioInput* getAudioInput() const;
+
+    /**
+     * Sets the flight recorder dumped by the DUMP_FLIGHT_RECORDER key and by SIGUSR2.
+     * @param flightRecorder flight recorder listening to the audio input, or nullptr.
+     */
+    void setFlightRecorder(FlightRecorder* flightRecorder);
+
+    /**
+     * Sets the replay controlled by the REPLAY_* keys, which must also be the audio source.
+     * @param replay replay passed to the constructor, or nullptr.
+     */
+    void setReplay(SpectrogramReplay* replay);
+
+    /**
+     * Sets the history pyramid shown by the HISTORY_VIEW key, fed by a sink of the DSP graph.
+     * @param history history pyramid, or nullptr.
+     */
+    void setHistory(HistoryPyramid* history);
+
+    /**
+     * Sets the DSP graph whose edge occupancy is appended to the diagnosis overlay.
+     * @param dspGraph DSP graph, or nullptr.
+     */
+    void setDspGraph(DspGraph* dspGraph);
+
+    /**
+     * Sets the pitch tracker whose estimates are overlaid on the spectrogram, toggled by the PITCH_VIEW key.
+     * @param pitchTracker pitch tracker, or nullptr.
+     */
+    void setPitchTracker(PitchTracker* pitchTracker);
+
+    /**
+     * Sets the chroma stage whose columns scroll in a 12-row strip over the top of the spectrogram, toggled by the
+     * CHROMA_VIEW key.
+     * @param chromaMapper chroma stage, or nullptr.
+     */
+    void setChromaMapper(ChromaMapper* chromaMapper);
+
+    /**
+     * Sets the onset detector whose onsets are marked on the spectrogram, toggled by the ONSET_VIEW key.
+     * @param onsetDetector onset stage, or nullptr.
+     */
+    void setOnsetDetector(OnsetDetector* onsetDetector);
+
+    /**
+     * Sets the averager whose long-term power spectral density is traced over the spectral magnitude plot, toggled
+     * by the WELCH_VIEW key and written to a CSV file by the WELCH_EXPORT key.
+     * @param welchAverager averaging sink, or nullptr.
+     */
+    void setWelchAverager(WelchAverager* welchAverager);
+
+    /**
+     * Sets the per-frequency baseline used by colour mode 3, whose learning is toggled by the BASELINE_LEARN key and
+     * which is written to a file by the BASELINE_SAVE key.
+     * @param binStatistics baseline sink, or nullptr.
+     */
+    void setBinStatistics(BinStatistics* binStatistics);
+
+    /**
+     * Switches the auto-level mode, which sets the colour scale from the levels of recent columns; also toggled by the
+     * AUTO_LEVEL key, and left by adjusting the colour scale by hand.
+     */
+    void setAutoLevel(bool autoLevel);
+
+    /**
+     * Sets the tone tracker whose levels are traced over the bottom of the spectrogram while it tracks tones. The
+     * TRACK_TONE key adds the frequency of the read-off line, and the CLEAR_TONES key stops tracking all tones.
+     * @param toneTracker tone tracker listening to audioInput, or nullptr.
+     */
+    void setToneTracker(ToneTracker* toneTracker);
+
+    /**
+     * Sets the delay estimators whose correlations and latest delays are drawn in a panel at the top right of the
+     * spectrogram, toggled by the CORRELATION_VIEW key.
+     * @param delayEstimators one estimator per pair of inputs, or none.
+     */
+    void setDelayEstimators(const std::vector<DelayEstimator*>& delayEstimators);
+
+    /**
+     * Sets the octave filter bank whose band levels are drawn as bars in place of the time domain plot, beside the
+     * spectral magnitude plot, toggled by the OCTAVE_VIEW key.
+     * @param octaveFilterBank filter bank listening to audioInput, or nullptr.
+     */
+    void setOctaveFilterBank(OctaveFilterBank* octaveFilterBank);
+
+    /**
+     * Sets the name of the audio source shown above the spectrogram, to tell the tiles of a grid apart.
+     * @param label name of the source, or empty for none.
+     */
+    void setLabel(const std::string& label);
+
 private:
     /**
      * Flag to show medical info.
@@ -152,6 +343,21 @@ private:
      * Spectrogram image log color mapping parameters.
      */
     float colorScale[2];
+    /**
+     * Whether colorScale follows the levels of recent columns.
+     */
+    bool autoLevel;
+    /**
+     * Quantile sketches of the levels of the columns since the last estimate.
+     */
+    StreamingQuantile lowLevel;
+    StreamingQuantile highLevel;
+    /**
+     * Low and high levels of the last estimate, and those colorScale currently maps, which move towards them.
+     */
+    float autoLevelTarget[2];
+    float autoLevelCurrent[2];
+    bool autoLevelSettled;
     /**
      * Handle for mouse activity on the spectrogram.
      */
@@ -173,6 +379,18 @@ private:
      * Frames per second tick reference.
      */
     time_t fpsTick;
+    /**
+     * Time of the previous swapped() call, from Trace::now(), for reporting frame times to the governor.
+     */
+    uint64_t lastSwapNs;
+    /**
+     * Value of AudioInput::getColumnsProduced() at the previous scroll.
+     */
+    unsigned long scrolledColumns;
+    /**
+     * Number of spectrogram columns computed but never displayed because rendering fell behind.
+     */
+    unsigned long renderBacklog;
     /**
      * Holds the start time of the program for runtime information.
      */
@@ -201,6 +419,7 @@ private:
      * 0 -> black background with white spectral information
      * 1 -> white background with black spectral information
      * 2 -> black background with RGB spectral information
+     * 3 -> dim grey levels, with red to yellow where a frequency deviates from its baseline (needs bin statistics)
      */
     int colorMode;
     /**
@@ -229,6 +448,170 @@ private:
     float highestFrequency;
     // TODO
     GLuint specId;
+    /**
+     * ADC time of the newest column added to the spectrogram by scrollSpectrogram().
+     */
+    double latestColumnTime;
+    /**
+     * Mean power of the newest column added to the spectrogram by scrollSpectrogram().
+     */
+    float latestColumnPower;
+    /**
+     * ADC time of the newest column in the most recently uploaded spectrogram texture.
+     */
+    double uploadedColumnTime;
+    /**
+     * Mean power of the newest column in the most recently uploaded spectrogram texture.
+     */
+    float uploadedColumnPower;
+    /**
+     * ADC time of the newest column for which a latency was measured, so that repeated columns are not re-counted.
+     */
+    double measuredColumnTime;
+    /**
+     * Running mean power of displayed columns, against which synthetic clicks are detected.
+     */
+    float columnPowerBaseline;
+    /**
+     * ADC time of the most recent synthetic click that was detected.
+     */
+    double detectedClickTime;
+    /**
+     * Distribution of the latency from the ADC time of the newest sample of a column to the buffer swap showing it.
+     */
+    LatencyMonitor glassLatency;
+    /**
+     * Distribution of the latency from a synthetic click to its detection on screen, in the latency self-test mode.
+     */
+    LatencyMonitor clickLatency;
+    /**
+     * Optional flight recorder listening to audioInput.
+     */
+    FlightRecorder *flightRecorder;
+    /**
+     * The audio source if it is a replay of a recording.
+     */
+    SpectrogramReplay *replay;
+    /**
+     * Optional long-term store of computed columns.
+     */
+    HistoryPyramid *history;
+    /**
+     * Optional DSP graph shown in the diagnosis overlay.
+     */
+    DspGraph *dspGraph;
+    /**
+     * Whether the history view replaces the live spectrogram.
+     */
+    bool historyView;
+    /**
+     * Pyramid level shown by the history view, each level doubling the time span.
+     */
+    unsigned int historyLevel;
+    /**
+     * Level 0 column one past the newest column shown by the history view, or negative to follow the live end.
+     */
+    int64_t historyEnd;
+    /**
+     * Colour bytes of the history view, N_TIME_WINDOWS columns of HistoryPyramid::N_BINS.
+     */
+    uint8_t *historyBytes;
+    /**
+     * Optional pitch tracker of the DSP graph.
+     */
+    PitchTracker *pitchTracker;
+    /**
+     * Whether the pitch track is overlaid.
+     */
+    bool pitchView;
+    /**
+     * Fundamental frequency at every displayed column, scrolled with the spectrogram, 0 where unvoiced.
+     */
+    std::vector<float> pitchTrack;
+    /**
+     * Optional chroma stage of the DSP graph.
+     */
+    ChromaMapper *chromaMapper;
+    /**
+     * Whether the chroma strip is shown.
+     */
+    bool chromaView;
+    /**
+     * Luminance of every pitch class at every displayed column, N_CLASSES rows of N_TIME_WINDOWS, each column
+     * normalized to its loudest class.
+     */
+    std::vector<uint8_t> chromaBytes;
+    GLuint chromaId;
+    /**
+     * Optional onset stage of the DSP graph.
+     */
+    OnsetDetector *onsetDetector;
+    /**
+     * Whether onsets are marked.
+     */
+    bool onsetView;
+    /**
+     * Whether an onset was detected by the time each displayed column was scrolled in.
+     */
+    std::vector<uint8_t> onsetMarks;
+    /**
+     * Onsets counted by the time of the last scroll.
+     */
+    unsigned long markedOnsets;
+    /**
+     * Optional long-term averaging sink of the DSP graph.
+     */
+    WelchAverager *welchAverager;
+    /**
+     * Whether the long-term density is traced.
+     */
+    bool welchView;
+    /**
+     * Mean powers and variances read from the averager for drawing.
+     */
+    std::vector<float> welchMean;
+    std::vector<float> welchVariance;
+    /**
+     * Optional per-frequency baseline of the DSP graph.
+     */
+    BinStatistics *binStatistics;
+    /**
+     * Baseline read from binStatistics when colour mapping in mode 3.
+     */
+    std::vector<float> baselineMean;
+    std::vector<float> baselineInverseDeviation;
+    /**
+     * Optional tone tracker listening to audioInput.
+     */
+    ToneTracker *toneTracker;
+    /**
+     * Levels of every tone in the latest TONE_TRACE_READINGS readings, a ring per tone with the next reading at
+     * toneTraceEnd, the latest reading, and the generation of the tones traced.
+     */
+    std::vector<float> toneTrace;
+    unsigned int toneTraceEnd;
+    ToneReading latestTone;
+    unsigned int toneGeneration;
+    /**
+     * Optional delay estimators of the DSP graph, one per pair of inputs.
+     */
+    std::vector<DelayEstimator*> delayEstimators;
+    /**
+     * Whether the correlation panel is shown.
+     */
+    bool correlationView;
+    /**
+     * Optional octave filter bank listening to audioInput.
+     */
+    OctaveFilterBank *octaveFilterBank;
+    /**
+     * Whether the octave band bars replace the time domain plot.
+     */
+    bool octaveView;
+    /**
+     * Name of the audio source shown above the spectrogram.
+     */
+    std::string label;
 
     /**
      * Displays the time domain representation of the signal.
@@ -240,11 +623,70 @@ private:
      */
     void plotSpectralMagnitude();
 
+    /**
+     * Traces the long-term power spectral density over the spectral magnitude plot, on a dB/Hz scale of its own
+     * spanning 100 dB below its peak.
+     */
+    void plotWelch();
+
     /**
      * Displays the spectrogram representation of the signal.
      */
     void plotSpectrogram();
 
+    /**
+     * Draws the pitch track and the note of the latest pitch, in the time and frequency coordinates of the axes.
+     * @param startTime time of the left edge of the spectrogram.
+     * @param secondsPerPixel time per displayed column.
+     */
+    void plotPitchTrack(float startTime, float secondsPerPixel);
+
+    /**
+     * Draws the chroma strip over the top of the spectrogram.
+     */
+    void plotChroma();
+
+    /**
+     * Draws a vertical line over every column at which an onset was detected.
+     * @param startTime run time of the oldest column.
+     * @param secondsPerPixel time per column.
+     */
+    void plotOnsets(float startTime, float secondsPerPixel);
+
+    /**
+     * Takes the queued tone readings and draws the level traces of the tracked tones over the bottom of the
+     * spectrogram, with their thresholds and latest levels and phases.
+     */
+    void plotToneTraces();
+
+    /**
+     * Draws the latest correlation of every pair of inputs at the top right of the spectrogram, labelled with its delay
+     * and peak.
+     */
+    void plotCorrelations();
+
+    /**
+     * Draws the octave band levels as bars, lowest band on the left, labelled every other octave.
+     */
+    void plotOctaveBands();
+
+    /**
+     * @return frequency in Hz at the height of the pointer, the one the read-off line shows.
+     */
+    float readOffFrequency() const;
+
+    /**
+     * Formats the name of the note nearest to a frequency, e.g. "A4".
+     * @param frequency frequency in Hz.
+     * @param buffer receives the name, at least 8 bytes.
+     */
+    static void noteLabel(float frequency, char* buffer);
+
+    /**
+     * Displays the history view in place of the spectrogram.
+     */
+    void plotHistory();
+
     /**
      * Draws the various plot axes onto the display.
      * @param xStart starting coordinate for x axis
@@ -267,12 +709,33 @@ private:
      */
     char colorByteMap(float x);
 
+    /**
+     * Converts a float spectrogram value to its 8-bit 3_3_2 colour by its z-score against the baseline, as of the last
+     * refreshBaseline().
+     * @param x float spectrogram value.
+     * @param frequency index of the frequency of x.
+     * @return 8-bit color char representation of x.
+     */
+    char zScoreByteMap(float x, unsigned int frequency);
+
+    /**
+     * Reads the baseline from binStatistics for zScoreByteMap().
+     */
+    void refreshBaseline();
+
     /**
      * Converts the entire spectrogram array from float values to 8-bit color char values
      * using SpectrogramVisualizer::colorByteMap().
      */
     void recomputeSpectrogramBytes();
 
+    /**
+     * Adds the levels of a new column to the quantile sketches and moves colorScale a step towards the latest
+     * estimate, so that only new columns use the new scale and it changes too gradually to leave a visible seam.
+     * @param column N_FREQUENCIES powers.
+     */
+    void updateAutoLevel(const float* column);
+
     /**
      * Computes the number of tick marks for the x-axis of the spectrogram.
      * Returns the zero-indexed locations of the tick marks via the tics parameter.
@@ -0,0 +1,43 @@
+#include "SpectrumTap.hpp"
+#include <algorithm>
+#include <string.h>
+#include <time.h>
+
+/* static member declarations and initializations */
+const unsigned int SpectrumFrame::MAX_FREQUENCIES;
+
+void SpectrumFrame::maxCoalesce(SpectrumFrame& into, const SpectrumFrame& from)
+{
+    unsigned int n = std::min(into.nFrequencies, from.nFrequencies);
+    for (unsigned int j = 0; j < n; ++j) into.power[j] = std::max(into.power[j], from.power[j]);
+    into.endSampleIndex = from.endSampleIndex;
+    into.adcTime = from.adcTime;
+    into.unixTime = from.unixTime;
+}
+
+SpectrumTap::SpectrumTap()
+{
+    memset(&frame, 0, sizeof(frame));
+}
+
+void SpectrumTap::samplesCaptured(const float* samples, unsigned long numSamples, uint64_t firstSampleIndex,
+                                  double firstAdcTime)
+{
+    (void) samples;
+    (void) numSamples;
+    (void) firstSampleIndex;
+    (void) firstAdcTime;
+}
+
+void SpectrumTap::sliceComputed(const float* slice, unsigned int nFrequencies, uint64_t endSampleIndex,
+                                double adcTime)
+{
+    timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    frame.endSampleIndex = endSampleIndex;
+    frame.adcTime = adcTime;
+    frame.unixTime = now.tv_sec + now.tv_nsec * 1e-9;
+    frame.nFrequencies = std::min(nFrequencies, SpectrumFrame::MAX_FREQUENCIES);
+    memcpy(frame.power, slice, frame.nFrequencies * sizeof(float));
+    emit(frame);
+}
@@ -0,0 +1,53 @@
+/**
+ * Entry point of the DSP graph: an AudioListener that copies every computed spectrogram slice into a SpectrumFrame
+ * and emits it into the connected edges, so that analyses run as graph stages instead of inside the DSP task.
+ */
+
+#ifndef OPENGL_SPECTROGRAM_SPECTRUMTAP_HPP
+#define OPENGL_SPECTROGRAM_SPECTRUMTAP_HPP
+
+#include <stdint.h>
+#include "AudioListener.hpp"
+#include "DspGraph.hpp"
+
+/**
+ * One spectrogram slice as it travels through the DSP graph.
+ */
+struct SpectrumFrame {
+  /**
+   * Maximum number of frequencies per frame.
+   */
+  static const unsigned int MAX_FREQUENCIES = 2048;
+
+  uint64_t endSampleIndex;
+  double adcTime;
+  double unixTime;
+  unsigned int nFrequencies;
+  float power[MAX_FREQUENCIES];
+
+  /**
+   * Coalesce function keeping the loudest power of each frequency and the times of the newer frame.
+   */
+  static void maxCoalesce(SpectrumFrame& into, const SpectrumFrame& from);
+};
+
+class SpectrumTap : public AudioListener, public DspProducer<SpectrumFrame> {
+public:
+  SpectrumTap();
+
+  /**
+   * Ignores samples.
+   */
+  virtual void samplesCaptured(const float* samples, unsigned long numSamples, uint64_t firstSampleIndex,
+                               double firstAdcTime);
+
+  /**
+   * Emits the slice as a frame, truncated to MAX_FREQUENCIES. Realtime safe as long as no connected edge blocks.
+   */
+  virtual void sliceComputed(const float* slice, unsigned int nFrequencies, uint64_t endSampleIndex, double adcTime);
+
+private:
+  SpectrumFrame frame;
+};
+
+#endif /* OPENGL_SPECTROGRAM_SPECTRUMTAP_HPP */
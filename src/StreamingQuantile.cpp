@@ -0,0 +1,98 @@
+#include "StreamingQuantile.hpp"
+#include <algorithm>
+
+StreamingQuantile::StreamingQuantile(double p)
+  : p(p)
+{
+    reset();
+}
+
+void StreamingQuantile::reset()
+{
+    count = 0;
+    for (int i = 0; i < 5; ++i) {
+        heights[i] = 0.0;
+        positions[i] = i + 1;
+    }
+    desired[0] = 1.0;
+    desired[1] = 1.0 + 2.0 * p;
+    desired[2] = 1.0 + 4.0 * p;
+    desired[3] = 3.0 + 2.0 * p;
+    desired[4] = 5.0;
+    increments[0] = 0.0;
+    increments[1] = p / 2.0;
+    increments[2] = p;
+    increments[3] = (1.0 + p) / 2.0;
+    increments[4] = 1.0;
+}
+
+unsigned long StreamingQuantile::getCount() const
+{
+    return count;
+}
+
+double StreamingQuantile::get() const
+{
+    if (count >= 5) return heights[2];
+    if (count == 0) return 0.0;
+
+    /* the first values are kept sorted in the heights */
+    int rank = (int) (p * (count - 1) + 0.5);
+    return heights[rank];
+}
+
+void StreamingQuantile::add(double x)
+{
+    if (count < 5) {
+        /* insertion sort of the first five values, which become the initial markers */
+        int i = (int) count++;
+        while (i > 0 && heights[i - 1] > x) {
+            heights[i] = heights[i - 1];
+            --i;
+        }
+        heights[i] = x;
+        return;
+    }
+    ++count;
+
+    /* the cell of x, widening the extreme markers if needed */
+    int k;
+    if (x < heights[0]) {
+        heights[0] = x;
+        k = 0;
+    } else if (x >= heights[4]) {
+        heights[4] = x;
+        k = 3;
+    } else {
+        k = 0;
+        while (x >= heights[k + 1]) ++k;
+    }
+    for (int i = k + 1; i < 5; ++i) positions[i] += 1.0;
+    for (int i = 0; i < 5; ++i) desired[i] += increments[i];
+
+    /* move the middle markers towards their desired positions */
+    for (int i = 1; i <= 3; ++i) {
+        double offset = desired[i] - positions[i];
+        if ((offset >= 1.0 && positions[i + 1] - positions[i] > 1.0) ||
+            (offset <= -1.0 && positions[i - 1] - positions[i] < -1.0)) {
+            double d = offset > 0.0 ? 1.0 : -1.0;
+            double height = parabolic(i, d);
+            if (heights[i - 1] < height && height < heights[i + 1]) {
+                heights[i] = height;
+            } else {
+                /* linear prediction where the parabola overshoots a neighbour */
+                int j = i + (int) d;
+                heights[i] += d * (heights[j] - heights[i]) / (positions[j] - positions[i]);
+            }
+            positions[i] += d;
+        }
+    }
+}
+
+double StreamingQuantile::parabolic(int i, double d) const
+{
+    double below = positions[i] - positions[i - 1], above = positions[i + 1] - positions[i];
+    return heights[i] + d / (positions[i + 1] - positions[i - 1]) *
+                        ((below + d) * (heights[i + 1] - heights[i]) / above +
+                         (above - d) * (heights[i] - heights[i - 1]) / below);
+}
@@ -0,0 +1,55 @@
+/**
+ * Streaming estimate of one quantile by the P-square algorithm of Jain and Chlamtac (1985): five markers track the
+ * minimum, the p/2, p and (1+p)/2 quantiles and the maximum, their heights adjusted by piecewise parabolic
+ * interpolation as values arrive. Constant memory and time per value, and no values are stored.
+ */
+
+#ifndef OPENGL_SPECTROGRAM_STREAMINGQUANTILE_HPP
+#define OPENGL_SPECTROGRAM_STREAMINGQUANTILE_HPP
+
+class StreamingQuantile {
+public:
+  /**
+   * @param p quantile to estimate, in (0, 1).
+   */
+  StreamingQuantile(double p = 0.5);
+
+  /**
+   * Adds a value.
+   */
+  void add(double x);
+
+  /**
+   * @return the estimated quantile, exact while fewer than five values were added, 0 before the first.
+   */
+  double get() const;
+
+  /**
+   * @return number of values added since the last reset.
+   */
+  unsigned long getCount() const;
+
+  /**
+   * Forgets all values.
+   */
+  void reset();
+
+private:
+  double p;
+  unsigned long count;
+
+  /**
+   * Marker heights, actual and desired positions (1-based), and increments of the desired positions.
+   */
+  double heights[5];
+  double positions[5];
+  double desired[5];
+  double increments[5];
+
+  /**
+   * Piecewise parabolic prediction of marker i moved by d (+1 or -1).
+   */
+  double parabolic(int i, double d) const;
+};
+
+#endif /* OPENGL_SPECTROGRAM_STREAMINGQUANTILE_HPP */
@@ -0,0 +1,81 @@
+#include "SyntheticInput.hpp"
+#include <time.h>
+#include "Log.hpp"
+#include "Trace.hpp"
+
+/* static member declarations and initializations */
+const unsigned int SyntheticInput::BLOCK_SAMPLES = 441;
+
+SyntheticInput::SyntheticInput(float frequency)
+  : AudioInput(), frequency(frequency), phase(0.0), noiseState(0x9e3779b9u), block(BLOCK_SAMPLES)
+{
+    samplingRate = 44100;
+    samplingPeriod = 1.0f / samplingRate;
+    nChannels = 1;
+    bufferMemorySeconds = 5;
+    bufferSizeSamples = bufferMemorySeconds * samplingRate;
+    audioBuffer = new float[bufferSizeSamples];
+    for (int i = 0; i < bufferSizeSamples; ++i) audioBuffer[i] = 0.0f;
+    bufferIndex = 0;
+}
+
+SyntheticInput::~SyntheticInput()
+{
+    quit = true;
+    if (generator.joinable()) generator.join();
+}
+
+int SyntheticInput::startCapture()
+{
+    Log::getInstance()->logger() << "Synthesizing a " << frequency << " Hz tone." << std::endl;
+    generator = std::thread(&SyntheticInput::generatorLoop, this);
+    return 0;
+}
+
+void SyntheticInput::quitNow()
+{
+    quit = true;
+    if (generator.joinable()) generator.join();
+}
+
+double SyntheticInput::getStreamTime()
+{
+    return Trace::now() * 1e-9;
+}
+
+void SyntheticInput::generatorLoop()
+{
+    Trace::getInstance()->setThreadName("synthetic input");
+    timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    const long blockNs = (long) (1e9 * BLOCK_SAMPLES / samplingRate);
+    while (!quit) {
+        next.tv_nsec += blockNs;
+        if (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            ++next.tv_sec;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr);
+        if (pause) continue;
+
+        TraceScope traceScope("synthetic block");
+        double step = 2 * M_PI * frequency / samplingRate;
+        for (unsigned int i = 0; i < BLOCK_SAMPLES; ++i) {
+            /* xorshift noise about 40 dB below the tone */
+            noiseState ^= noiseState << 13;
+            noiseState ^= noiseState >> 17;
+            noiseState ^= noiseState << 5;
+            float noise = (noiseState * (1.0f / 4294967296.0f) - 0.5f) * 0.006f;
+            block[i] = 0.3f * (float) sin(phase) + noise;
+            audioBuffer[mod(bufferIndex + i, bufferSizeSamples)] = block[i];
+            phase = fmod(phase + step, 2 * M_PI);
+        }
+
+        double lastAdcTime = next.tv_sec + next.tv_nsec * 1e-9;
+        double firstAdcTime = lastAdcTime - (BLOCK_SAMPLES - 1) * samplingPeriod;
+        injectSelfTestClick(bufferIndex, BLOCK_SAMPLES, firstAdcTime);
+        bufferIndex = mod(bufferIndex + BLOCK_SAMPLES, bufferSizeSamples);
+        notifySamplesCaptured(block.data(), BLOCK_SAMPLES, firstAdcTime);
+        submitHops(BLOCK_SAMPLES, lastAdcTime);
+    }
+}
@@ -0,0 +1,67 @@
+/**
+ * Audio source that synthesizes a steady tone in faint noise, paced by the monotonic clock, for exercising many streams
+ * without as many devices, e.g. when sizing a wall display.
+ */
+
+#ifndef OPENGL_SPECTROGRAM_SYNTHETICINPUT_HPP
+#define OPENGL_SPECTROGRAM_SYNTHETICINPUT_HPP
+
+#include <thread>
+#include <vector>
+#include "AudioInput.hpp"
+
+class SyntheticInput : public AudioInput {
+public:
+  /**
+   * Number of samples synthesized per block.
+   */
+  static const unsigned int BLOCK_SAMPLES;
+
+  /**
+   * @param frequency frequency of the tone, in Hz.
+   */
+  SyntheticInput(float frequency);
+
+  SyntheticInput(const SyntheticInput&) = delete;
+  SyntheticInput& operator=(const SyntheticInput&) = delete;
+
+  /**
+   * Stops the generator thread.
+   */
+  ~SyntheticInput();
+
+  /**
+   * Starts the generator thread.
+   * @return 0 on success.
+   */
+  virtual int startCapture();
+
+  /**
+   * Stops the generator thread.
+   */
+  virtual void quitNow();
+
+  /**
+   * @return seconds of the monotonic clock, on which the block times are given.
+   */
+  virtual double getStreamTime();
+
+private:
+  /**
+   * Body of the generator thread, which delivers one block every BLOCK_SAMPLES sampling periods like an audio
+   * callback would.
+   */
+  void generatorLoop();
+
+  float frequency;
+  double phase;
+  uint32_t noiseState;
+
+  /**
+   * The block being synthesized, as passed to the listeners.
+   */
+  std::vector<float> block;
+  std::thread generator;
+};
+
+#endif /* OPENGL_SPECTROGRAM_SYNTHETICINPUT_HPP */
@@ -0,0 +1,36 @@
+#include "ToneAlarmWriter.hpp"
+#include "Log.hpp"
+
+ToneAlarmWriter::ToneAlarmWriter(const char* path, FlightRecorder* flightRecorder)
+  : DspSink<ToneAlarm>("tone alarm log"), file(nullptr), flightRecorder(flightRecorder)
+{
+    if (path) {
+        file = fopen(path, "w");
+        if (!file) {
+            Log::getInstance()->logger() << "Could not create " << path << std::endl;
+            throw 99;
+        }
+        fprintf(file, "unix_time,adc_time,sample,frequency_hz,level_db,threshold_db,raised\n");
+        fflush(file);
+        Log::getInstance()->logger() << "Writing tone alarms to " << path << std::endl;
+    }
+}
+
+ToneAlarmWriter::~ToneAlarmWriter()
+{
+    if (file) fclose(file);
+}
+
+void ToneAlarmWriter::consume(const ToneAlarm& alarm)
+{
+    Log::getInstance()->logger() << "Tone " << alarm.frequency << " Hz at " << alarm.level << " dB "
+                                 << (alarm.raised ? "above" : "back below") << " " << alarm.threshold << " dB"
+                                 << std::endl;
+    if (file) {
+        fprintf(file, "%.6f,%.6f,%llu,%.2f,%.2f,%.2f,%d\n", alarm.unixTime, alarm.adcTime,
+                (unsigned long long) alarm.sampleIndex, alarm.frequency, alarm.level, alarm.threshold,
+                alarm.raised ? 1 : 0);
+        fflush(file);
+    }
+    if (flightRecorder && alarm.raised) flightRecorder->trigger("tone alarm");
+}
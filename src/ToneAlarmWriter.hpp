@@ -0,0 +1,41 @@
+/**
+ * DSP graph sink handling tone alarms: logs them, appends them to a CSV event log, one line per crossing:
+ *    unix_time,adc_time,sample,frequency_hz,level_db,threshold_db,raised
+ * flushed after every line so that other tools can follow it, and/or triggers a flight recorder dump when an alarm is
+ * raised.
+ */
+
+#ifndef OPENGL_SPECTROGRAM_TONEALARMWRITER_HPP
+#define OPENGL_SPECTROGRAM_TONEALARMWRITER_HPP
+
+#include <stdio.h>
+#include "DspGraph.hpp"
+#include "FlightRecorder.hpp"
+#include "ToneTracker.hpp"
+
+class ToneAlarmWriter : public DspSink<ToneAlarm> {
+public:
+  /**
+   * Creates the log and writes its header line. Throws 99 on failure.
+   * @param path path of the CSV file, or nullptr for no log.
+   * @param flightRecorder flight recorder to trigger on every raised alarm, or nullptr.
+   */
+  ToneAlarmWriter(const char* path, FlightRecorder* flightRecorder);
+
+  ToneAlarmWriter(const ToneAlarmWriter&) = delete;
+  ToneAlarmWriter& operator=(const ToneAlarmWriter&) = delete;
+
+  /**
+   * Closes the log.
+   */
+  ~ToneAlarmWriter();
+
+protected:
+  virtual void consume(const ToneAlarm& alarm);
+
+private:
+  FILE* file;
+  FlightRecorder* flightRecorder;
+};
+
+#endif /* OPENGL_SPECTROGRAM_TONEALARMWRITER_HPP */
@@ -0,0 +1,233 @@
+#include "ToneTracker.hpp"
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+#include "Log.hpp"
+#include "Trace.hpp"
+#include "VectorOps.hpp"
+
+/* static member declarations and initializations */
+const unsigned int ToneTracker::READOUT_INTERVAL = 32;
+const float ToneTracker::ALARM_HYSTERESIS_DB = 3.0f;
+const unsigned int ToneTracker::READING_QUEUE = 2048;
+
+/* amplitude floor of the levels, -200 dB */
+static const double AMPLITUDE_FLOOR = 1e-10;
+
+/* bins per tone: at its frequency, one spacing above and one below */
+static const unsigned int BINS_PER_TONE = 3;
+
+bool ToneTracker::parseTones(const char* text, std::vector<Tone>& tones)
+{
+    tones.clear();
+    while (*text) {
+        Tone tone;
+        tone.threshold = INFINITY;
+        int consumed;
+        if (sscanf(text, "%f%n", &tone.frequency, &consumed) != 1 || tone.frequency <= 0.0f) return false;
+        text += consumed;
+        if (*text == ':') {
+            if (sscanf(text + 1, "%f%n", &tone.threshold, &consumed) != 1) return false;
+            text += 1 + consumed;
+        }
+        tones.push_back(tone);
+        if (*text == ',') ++text;
+        else if (*text) return false;
+    }
+    return !tones.empty() && tones.size() <= ToneReading::MAX_TONES;
+}
+
+ToneTracker::ToneTracker(unsigned int samplingRate, unsigned int windowLength)
+  : samplingRate(samplingRate), windowLength(windowLength), nTones(0), generation(0), activeGeneration(0),
+    activeTones(0), window(windowLength, 0.0f), position(0), sinceReadout(0),
+    stepRe(BINS_PER_TONE * ToneReading::MAX_TONES), stepIm(BINS_PER_TONE * ToneReading::MAX_TONES),
+    rotationRe(BINS_PER_TONE * ToneReading::MAX_TONES), rotationIm(BINS_PER_TONE * ToneReading::MAX_TONES),
+    phasorRe(BINS_PER_TONE * ToneReading::MAX_TONES), phasorIm(BINS_PER_TONE * ToneReading::MAX_TONES),
+    sumRe(BINS_PER_TONE * ToneReading::MAX_TONES), sumIm(BINS_PER_TONE * ToneReading::MAX_TONES),
+    readings(READING_QUEUE), alarms(0)
+{
+    for (unsigned int t = 0; t < ToneReading::MAX_TONES; ++t) {
+        frequencies[t].store(0.0f, std::memory_order_relaxed);
+        thresholds[t].store(INFINITY, std::memory_order_relaxed);
+        alarmed[t] = false;
+    }
+    Log::getInstance()->logger() << "Tracking tones over " << windowLength << " samples, read every "
+                                 << READOUT_INTERVAL << " samples" << std::endl;
+}
+
+bool ToneTracker::addTone(float frequency, float threshold)
+{
+    unsigned int n = nTones.load(std::memory_order_relaxed);
+    if (n >= ToneReading::MAX_TONES || frequency <= 0.0f || frequency >= samplingRate / 2.0f) return false;
+    frequencies[n].store(frequency, std::memory_order_relaxed);
+    thresholds[n].store(threshold, std::memory_order_relaxed);
+    nTones.store(n + 1, std::memory_order_relaxed);
+    generation.fetch_add(1, std::memory_order_release);
+    Log::getInstance()->logger() << "Tracking " << frequency << " Hz" << std::endl;
+    return true;
+}
+
+void ToneTracker::clearTones()
+{
+    nTones.store(0, std::memory_order_relaxed);
+    generation.fetch_add(1, std::memory_order_release);
+}
+
+unsigned int ToneTracker::getNTones() const
+{
+    return nTones.load(std::memory_order_relaxed);
+}
+
+float ToneTracker::getFrequency(unsigned int tone) const
+{
+    return frequencies[tone].load(std::memory_order_relaxed);
+}
+
+float ToneTracker::getThreshold(unsigned int tone) const
+{
+    return thresholds[tone].load(std::memory_order_relaxed);
+}
+
+unsigned long ToneTracker::getAlarms() const
+{
+    return alarms.load(std::memory_order_relaxed);
+}
+
+bool ToneTracker::readReading(ToneReading& reading)
+{
+    return readings.pop(reading);
+}
+
+void ToneTracker::configure()
+{
+    activeGeneration = generation.load(std::memory_order_acquire);
+    activeTones = nTones.load(std::memory_order_relaxed);
+    const double spacing = 2.0 * M_PI / windowLength;
+    for (unsigned int t = 0; t < activeTones; ++t) {
+        activeFrequencies[t] = frequencies[t].load(std::memory_order_relaxed);
+        activeThresholds[t] = thresholds[t].load(std::memory_order_relaxed);
+        alarmed[t] = false;
+        for (unsigned int b = 0; b < BINS_PER_TONE; ++b) {
+            unsigned int i = BINS_PER_TONE * t + b;
+            double w = 2.0 * M_PI * activeFrequencies[t] / samplingRate + (b == 1 ? spacing : b == 2 ? -spacing : 0.0);
+            stepRe[i] = cos(w);
+            stepIm[i] = -sin(w);
+            rotationRe[i] = cos(w * windowLength);
+            rotationIm[i] = sin(w * windowLength);
+
+            /* phase 0 at the newest sample, so a sample of age k enters with e^(j w k) */
+            phasorRe[i] = 1.0;
+            phasorIm[i] = 0.0;
+            double re = 0.0, im = 0.0, factorRe = 1.0, factorIm = 0.0;
+            for (unsigned int k = 0; k < windowLength; ++k) {
+                double x = window[(position + windowLength - 1 - k) % windowLength];
+                re += x * factorRe;
+                im += x * factorIm;
+                double nextRe = factorRe * stepRe[i] + factorIm * stepIm[i];
+                factorIm = factorIm * stepRe[i] - factorRe * stepIm[i];
+                factorRe = nextRe;
+            }
+            sumRe[i] = re;
+            sumIm[i] = im;
+        }
+    }
+}
+
+void ToneTracker::samplesCaptured(const float* samples, unsigned long numSamples, uint64_t firstSampleIndex,
+                                  double firstAdcTime)
+{
+    (void) samples;
+    (void) numSamples;
+    (void) firstSampleIndex;
+    (void) firstAdcTime;
+}
+
+void ToneTracker::samplesProcessed(const float* samples, unsigned long numSamples, uint64_t firstSampleIndex,
+                                   double firstAdcTime)
+{
+    TraceScope traceScope("tone tracker");
+    if (generation.load(std::memory_order_acquire) != activeGeneration) configure();
+    unsigned int nBins = BINS_PER_TONE * activeTones;
+    for (unsigned long s = 0; s < numSamples; ++s) {
+        float x = samples[s];
+        float removed = window[position];
+        window[position] = x;
+        position = position + 1 == windowLength ? 0 : position + 1;
+        VectorOps::slidingDft(x, removed, stepRe.data(), stepIm.data(), rotationRe.data(), rotationIm.data(),
+                              phasorRe.data(), phasorIm.data(), sumRe.data(), sumIm.data(), nBins);
+        if (++sinceReadout == READOUT_INTERVAL) {
+            sinceReadout = 0;
+            readOut(firstSampleIndex + s, firstAdcTime + (double) s / samplingRate);
+        }
+    }
+}
+
+void ToneTracker::sliceComputed(const float* slice, unsigned int nFrequencies, uint64_t endSampleIndex,
+                                double adcTime)
+{
+    (void) slice;
+    (void) nFrequencies;
+    (void) endSampleIndex;
+    (void) adcTime;
+}
+
+void ToneTracker::readOut(uint64_t sampleIndex, double adcTime)
+{
+    ToneReading reading;
+    reading.sampleIndex = sampleIndex;
+    reading.generation = activeGeneration;
+    reading.nTones = activeTones;
+    double shiftRe = cos(2.0 * M_PI / windowLength), shiftIm = sin(2.0 * M_PI / windowLength);
+    for (unsigned int t = 0; t < activeTones; ++t) {
+        double re[BINS_PER_TONE], im[BINS_PER_TONE];
+        for (unsigned int b = 0; b < BINS_PER_TONE; ++b) {
+            unsigned int i = BINS_PER_TONE * t + b;
+
+            /* keep the phasors on the unit circle against rounding */
+            double norm = 1.0 / sqrt(phasorRe[i] * phasorRe[i] + phasorIm[i] * phasorIm[i]);
+            phasorRe[i] *= norm;
+            phasorIm[i] *= norm;
+
+            /* refer the sum to the newest sample, sum times conj(phasor) */
+            re[b] = sumRe[i] * phasorRe[i] + sumIm[i] * phasorIm[i];
+            im[b] = sumIm[i] * phasorRe[i] - sumRe[i] * phasorIm[i];
+        }
+
+        /* Hann window in the frequency domain: 0.5 X(w) - 0.25 (X(w + d) e^(j d) + X(w - d) e^(-j d)) */
+        double hannRe = 0.5 * re[0] - 0.25 * (re[1] * shiftRe - im[1] * shiftIm + re[2] * shiftRe + im[2] * shiftIm);
+        double hannIm = 0.5 * im[0] - 0.25 * (im[1] * shiftRe + re[1] * shiftIm + im[2] * shiftRe - re[2] * shiftIm);
+
+        /* a cosine of amplitude A sums to A / 2 times the N / 2 sum of the Hann window */
+        double amplitude = 4.0 * sqrt(hannRe * hannRe + hannIm * hannIm) / windowLength;
+        float level = (float) (20.0 * log10(std::max(amplitude, AMPLITUDE_FLOOR)));
+        reading.level[t] = level;
+        reading.phase[t] = (float) atan2(hannIm, hannRe);
+
+        bool raise = !alarmed[t] && level > activeThresholds[t];
+        bool clear = alarmed[t] && level < activeThresholds[t] - ALARM_HYSTERESIS_DB;
+        if (raise || clear) {
+            alarmed[t] = raise;
+            if (raise) alarms.fetch_add(1, std::memory_order_relaxed);
+            timespec now;
+            clock_gettime(CLOCK_REALTIME, &now);
+            ToneAlarm alarm;
+            alarm.sampleIndex = sampleIndex;
+            alarm.adcTime = adcTime;
+            alarm.unixTime = now.tv_sec + now.tv_nsec * 1e-9;
+            alarm.tone = t;
+            alarm.frequency = activeFrequencies[t];
+            alarm.level = level;
+            alarm.threshold = activeThresholds[t];
+            alarm.raised = raise;
+            emit(alarm);
+        }
+    }
+
+    /* a display that stopped reading gets the newest readings when it resumes */
+    if (!readings.push(reading)) {
+        ToneReading stale;
+        readings.pop(stale);
+        readings.push(reading);
+    }
+}
@@ -0,0 +1,220 @@
+/**
+ * Tracks the level and phase of a few selected frequencies at a rate far above the column rate: a sliding DFT bank
+ * updated on every captured sample on the DSP thread pool, read out every READOUT_INTERVAL samples. Each tone has three bins, at its
+ * frequency and one bin spacing (samplingRate / windowLength) on either side, combined into a Hann windowed estimate,
+ * so a reading lags the signal by about half a window instead of a whole FFT hop plus window. Tones may lie anywhere,
+ * not only on the bins of the FFT.
+ *
+ * Readings are queued for the display. A tone with a threshold raises a ToneAlarm, emitted into the DSP graph, when its
+ * level exceeds the threshold, and clears it when the level falls ALARM_HYSTERESIS_DB below.
+ */
+
+#ifndef OPENGL_SPECTROGRAM_TONETRACKER_HPP
+#define OPENGL_SPECTROGRAM_TONETRACKER_HPP
+
+#include <atomic>
+#include <vector>
+#include <stdint.h>
+#include "AudioListener.hpp"
+#include "BoundedQueue.hpp"
+#include "DspGraph.hpp"
+
+/**
+ * Levels and phases of all tones at one sample.
+ */
+struct ToneReading {
+  static const unsigned int MAX_TONES = 8;
+
+  /**
+   * Index of the newest sample included.
+   */
+  uint64_t sampleIndex;
+
+  /**
+   * Incremented whenever the tones change, so that readings of different tones are not joined.
+   */
+  unsigned int generation;
+  unsigned int nTones;
+
+  /**
+   * Amplitude in dB re full scale, and phase of the cosine at sampleIndex in radians, of each tone.
+   */
+  float level[MAX_TONES];
+  float phase[MAX_TONES];
+};
+
+/**
+ * A tone crossing its threshold.
+ */
+struct ToneAlarm {
+  uint64_t sampleIndex;
+  double adcTime;
+  double unixTime;
+  unsigned int tone;
+  float frequency;
+
+  /**
+   * Level of the reading that crossed, and the threshold, in dB re full scale.
+   */
+  float level;
+  float threshold;
+
+  /**
+   * Whether the level rose above the threshold, rather than fell back below it.
+   */
+  bool raised;
+};
+
+class ToneTracker : public AudioListener, public DspProducer<ToneAlarm> {
+public:
+  /**
+   * Samples between readings.
+   */
+  static const unsigned int READOUT_INTERVAL;
+
+  /**
+   * Drop below the threshold that clears an alarm.
+   */
+  static const float ALARM_HYSTERESIS_DB;
+
+  /**
+   * Readings queued for the display.
+   */
+  static const unsigned int READING_QUEUE;
+
+  /**
+   * A tone to track.
+   */
+  struct Tone {
+    float frequency;
+
+    /**
+     * Alarm threshold in dB re full scale, INFINITY for none.
+     */
+    float threshold;
+  };
+
+  /**
+   * Parses a comma separated list of frequencies in Hz, each optionally with an alarm threshold in dB re full scale,
+   * such as "50,120:-20,3000:-40".
+   * @param text list to parse.
+   * @param tones receives the tones.
+   * @return false on a syntax error.
+   */
+  static bool parseTones(const char* text, std::vector<Tone>& tones);
+
+  /**
+   * @param samplingRate sampling rate of the audio.
+   * @param windowLength samples per sliding window, setting both the bandwidth and the lag of the readings.
+   */
+  ToneTracker(unsigned int samplingRate, unsigned int windowLength);
+
+  ToneTracker(const ToneTracker&) = delete;
+  ToneTracker& operator=(const ToneTracker&) = delete;
+
+  /**
+   * Adds a tone, tracked from the next captured block on. Not realtime safe; call from one thread only.
+   * @param frequency frequency in Hz, below the Nyquist frequency.
+   * @param threshold alarm threshold in dB re full scale, or INFINITY for none.
+   * @return false if MAX_TONES are tracked already or the frequency is out of range.
+   */
+  bool addTone(float frequency, float threshold);
+
+  /**
+   * Stops tracking all tones. Not realtime safe; call from the thread adding tones.
+   */
+  void clearTones();
+
+  /**
+   * @return number of tracked tones.
+   */
+  unsigned int getNTones() const;
+
+  /**
+   * @return frequency of a tone in Hz.
+   */
+  float getFrequency(unsigned int tone) const;
+
+  /**
+   * @return alarm threshold of a tone in dB re full scale, INFINITY for none.
+   */
+  float getThreshold(unsigned int tone) const;
+
+  /**
+   * @return number of alarms raised so far. Safe to call from any thread.
+   */
+  unsigned long getAlarms() const;
+
+  /**
+   * Takes the oldest queued reading.
+   * @return false if there is none.
+   */
+  bool readReading(ToneReading& reading);
+
+  /**
+   * Ignores samples on the capture thread; the bins are updated on the DSP thread instead.
+   */
+  virtual void samplesCaptured(const float* samples, unsigned long numSamples, uint64_t firstSampleIndex,
+                               double firstAdcTime);
+
+  /**
+   * Updates the bins with the samples, on the DSP thread, setting them up again first if the tones changed.
+   */
+  virtual void samplesProcessed(const float* samples, unsigned long numSamples, uint64_t firstSampleIndex,
+                                double firstAdcTime);
+
+  /**
+   * Ignores slices.
+   */
+  virtual void sliceComputed(const float* slice, unsigned int nFrequencies, uint64_t endSampleIndex, double adcTime);
+
+private:
+  /**
+   * Sets up the bins of the current tones, their sums computed from the samples in the window. Takes of the order of
+   * windowLength times the number of bins operations, so it runs on the DSP thread, never in the audio callback.
+   */
+  void configure();
+
+  /**
+   * Queues a reading of all tones and raises or clears their alarms.
+   */
+  void readOut(uint64_t sampleIndex, double adcTime);
+
+  unsigned int samplingRate;
+  unsigned int windowLength;
+
+  /**
+   * Tones as set by addTone(), published by incrementing generation.
+   */
+  std::atomic<float> frequencies[ToneReading::MAX_TONES];
+  std::atomic<float> thresholds[ToneReading::MAX_TONES];
+  std::atomic<unsigned int> nTones;
+  std::atomic<unsigned int> generation;
+
+  /**
+   * Tones the bins were set up for, as seen by the DSP thread.
+   */
+  unsigned int activeGeneration;
+  unsigned int activeTones;
+  float activeFrequencies[ToneReading::MAX_TONES];
+  float activeThresholds[ToneReading::MAX_TONES];
+  bool alarmed[ToneReading::MAX_TONES];
+
+  /**
+   * Ring of the samples in the window, the oldest at position.
+   */
+  std::vector<float> window;
+  unsigned int position;
+  unsigned int sinceReadout;
+
+  /**
+   * Bins 3 t, 3 t + 1 and 3 t + 2 of tone t lie at its frequency, one bin spacing above and one below, as arrays of
+   * their real and imaginary parts for VectorOps::slidingDft().
+   */
+  std::vector<double> stepRe, stepIm, rotationRe, rotationIm, phasorRe, phasorIm, sumRe, sumIm;
+
+  BoundedQueue<ToneReading> readings;
+  std::atomic<unsigned long> alarms;
+};
+
+#endif /* OPENGL_SPECTROGRAM_TONETRACKER_HPP */
@@ -0,0 +1,186 @@
+#include "Trace.hpp"
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include "Log.hpp"
+
+/* static member declarations and initializations */
+const unsigned int Trace::EVENTS_PER_THREAD = 1 << 16;
+const unsigned int Trace::RESERVED_BUFFERS = 8;
+Trace* Trace::instance;
+volatile sig_atomic_t Trace::flushRequested = 0;
+
+Trace::Trace()
+  : enabled(false), path("trace.json"), reserved(RESERVED_BUFFERS)
+{
+  for (std::atomic<ThreadBuffer*>& slot : reserved) slot = nullptr;
+}
+
+Trace* Trace::getInstance()
+{
+  if (!instance) {
+    Trace::instance = new Trace();
+  }
+  return Trace::instance;
+}
+
+uint64_t Trace::now()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+void Trace::enable(const std::string& path)
+{
+  std::lock_guard<std::mutex> lock(buffersMutex);
+  this->path = path;
+  enabled = true;
+}
+
+bool Trace::isEnabled() const
+{
+  return enabled.load(std::memory_order_relaxed);
+}
+
+Trace::ThreadBuffer* Trace::newBuffer(const char* name)
+{
+  ThreadBuffer* buffer = new ThreadBuffer();
+  buffer->events.resize(EVENTS_PER_THREAD);
+  buffer->written = 0;
+  buffer->threadName = name;
+  std::lock_guard<std::mutex> lock(buffersMutex);
+  buffer->threadId = buffers.size() + 1;
+  buffers.push_back(buffer);
+  return buffer;
+}
+
+Trace::ThreadBuffer* Trace::threadBuffer(bool adopt)
+{
+  static thread_local ThreadBuffer* buffer = nullptr;
+  if (!buffer && adopt) {
+    for (unsigned int i = 0; i < RESERVED_BUFFERS && !buffer; ++i) {
+      buffer = reserved[i].exchange(nullptr, std::memory_order_acquire);
+    }
+  }
+  if (!buffer) {
+    /* first event of this thread: the only allocation a recording thread ever does */
+    buffer = newBuffer(nullptr);
+  }
+  return buffer;
+}
+
+void Trace::record(const Event& event)
+{
+  ThreadBuffer* buffer = threadBuffer(true);
+  uint64_t n = buffer->written.load(std::memory_order_relaxed);
+  buffer->events[n % EVENTS_PER_THREAD] = event;
+  buffer->written.store(n + 1, std::memory_order_release);
+}
+
+void Trace::complete(const char* name, uint64_t startNs, uint64_t durationNs)
+{
+  if (!isEnabled()) return;
+  record({name, startNs, durationNs, 'X'});
+}
+
+void Trace::instant(const char* name)
+{
+  if (!isEnabled()) return;
+  record({name, now(), 0, 'i'});
+}
+
+void Trace::setThreadName(const char* name)
+{
+  if (!isEnabled()) return;
+  threadBuffer(false)->threadName = name;
+}
+
+void Trace::reserveThread(const char* name)
+{
+  if (!isEnabled()) return;
+  ThreadBuffer* buffer = newBuffer(name);
+  for (std::atomic<ThreadBuffer*>& slot : reserved) {
+    ThreadBuffer* expected = nullptr;
+    if (slot.compare_exchange_strong(expected, buffer, std::memory_order_release)) return;
+  }
+  /* every slot is still waiting for its thread; the extra thread will allocate on its first event instead */
+}
+
+int Trace::flush()
+{
+  std::lock_guard<std::mutex> lock(buffersMutex);
+  FILE* out = fopen(path.c_str(), "w");
+  if (!out) {
+    Log::getInstance()->logger() << "Could not open trace file " << path << std::endl;
+    return -1;
+  }
+
+  int pid = (int) getpid();
+  int nEvents = 0;
+  std::vector<Event> snapshot;
+  fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  for (ThreadBuffer* buffer : buffers) {
+    fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%lu,\"args\":{\"name\":\"%s\"}}",
+            buffer == buffers.front() ? "" : ",\n", pid, buffer->threadId,
+            buffer->threadName ? buffer->threadName : "thread");
+
+    /* copy the retained events while the owning thread may keep writing */
+    uint64_t end = buffer->written.load(std::memory_order_acquire);
+    uint64_t begin = end > EVENTS_PER_THREAD ? end - EVENTS_PER_THREAD : 0;
+    snapshot.clear();
+    for (uint64_t i = begin; i < end; ++i) {
+      snapshot.push_back(buffer->events[i % EVENTS_PER_THREAD]);
+    }
+
+    /* discard whatever the owning thread overwrote (or is overwriting) during the copy */
+    uint64_t after = buffer->written.load(std::memory_order_acquire);
+    uint64_t firstValid = after + 1 > EVENTS_PER_THREAD ? after + 1 - EVENTS_PER_THREAD : 0;
+    for (uint64_t i = begin; i < end; ++i) {
+      if (i < firstValid) continue;
+      const Event& e = snapshot[i - begin];
+      if (e.phase == 'X') {
+        fprintf(out, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%lu,\"ts\":%.3f,\"dur\":%.3f}",
+                e.name, pid, buffer->threadId, e.startNs / 1000.0, e.durationNs / 1000.0);
+      } else {
+        fprintf(out, ",\n{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"pid\":%d,\"tid\":%lu,\"ts\":%.3f}",
+                e.name, pid, buffer->threadId, e.startNs / 1000.0);
+      }
+      ++nEvents;
+    }
+  }
+  fprintf(out, "\n]}\n");
+  fclose(out);
+
+  Log::getInstance()->logger() << "Wrote " << nEvents << " trace events to " << path << std::endl;
+  return nEvents;
+}
+
+void Trace::requestFlush(int signum)
+{
+  (void) signum;
+  flushRequested = 1;
+}
+
+void Trace::flushIfRequested()
+{
+  if (flushRequested) {
+    flushRequested = 0;
+    flush();
+  }
+}
+
+TraceScope::TraceScope(const char* name)
+  : name(name), startNs(0)
+{
+  if (Trace::getInstance()->isEnabled()) {
+    startNs = Trace::now();
+  }
+}
+
+TraceScope::~TraceScope()
+{
+  if (startNs) {
+    Trace::getInstance()->complete(name, startNs, Trace::now() - startNs);
+  }
+}
@@ -0,0 +1,196 @@
+/**
+ * Scoped trace events for the capture, DSP and render pipeline, exported in the Chrome trace event format so that
+ * individual stalls can be inspected in Perfetto (https://ui.perfetto.dev) or chrome://tracing.
+ *
+ * Every thread records into its own fixed-size ring buffer, so recording never locks and never allocates after the
+ * first event of a thread. Realtime threads adopt a buffer reserved for them beforehand, so they never allocate at all. The rings are only read when a flush is requested, e.g. by a key press or a signal.
+ */
+
+#ifndef OPENGL_SPECTROGRAM_TRACE_HPP
+#define OPENGL_SPECTROGRAM_TRACE_HPP
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <signal.h>
+#include <stdint.h>
+
+class Trace {
+public:
+  /**
+   * Number of events retained per thread. Older events are overwritten.
+   */
+  static const unsigned int EVENTS_PER_THREAD;
+
+  /**
+   * Number of ring buffers that can be reserved for realtime threads at a time.
+   */
+  static const unsigned int RESERVED_BUFFERS;
+
+  /**
+   * A single complete ("X") or instant ("i") trace event.
+   */
+  struct Event {
+    const char* name;
+    uint64_t startNs;
+    uint64_t durationNs;
+    char phase;
+  };
+
+  /**
+   * Accessor method for the singleton instance of the class, following Log::getInstance().
+   * @return the process-wide Trace instance.
+   */
+  static Trace* getInstance();
+
+  /**
+   * Monotonic clock used for all trace timestamps.
+   * @return nanoseconds since an arbitrary epoch.
+   */
+  static uint64_t now();
+
+  /**
+   * Enables recording, and sets the file written by flush().
+   * @param path output path of the Chrome trace JSON file.
+   */
+  void enable(const std::string& path);
+
+  /**
+   * @return whether events are currently being recorded.
+   */
+  bool isEnabled() const;
+
+  /**
+   * Records a complete event into the calling thread's ring buffer.
+   * @param name static string naming the event; the pointer is stored, not the contents.
+   * @param startNs start time, from Trace::now().
+   * @param durationNs duration of the event.
+   */
+  void complete(const char* name, uint64_t startNs, uint64_t durationNs);
+
+  /**
+   * Records an instant event into the calling thread's ring buffer.
+   * @param name static string naming the event; the pointer is stored, not the contents.
+   */
+  void instant(const char* name);
+
+  /**
+   * Names the calling thread in the exported trace. Registers the thread's ring buffer if it has none yet, so it must
+   * not be called from a realtime thread; those use reserveThread() instead.
+   * @param name static string naming the thread.
+   */
+  void setThreadName(const char* name);
+
+  /**
+   * Allocates and registers a named ring buffer ahead of time for a realtime thread that is not created by us, e.g.
+   * an audio callback thread. The next thread that records an event without having named itself adopts the buffer,
+   * without allocating or locking. Does nothing unless tracing is enabled.
+   * @param name static string naming the thread.
+   */
+  void reserveThread(const char* name);
+
+  /**
+   * Writes the contents of all ring buffers to the configured file as Chrome trace JSON.
+   * Safe to call while other threads keep recording.
+   * @return number of events written, or -1 if the file could not be written.
+   */
+  int flush();
+
+  /**
+   * Signal handler which requests a flush at the next call of flushIfRequested().
+   * @param signum signal number (unused).
+   */
+  static void requestFlush(int signum);
+
+  /**
+   * Flushes if a flush was requested by requestFlush(). Meant to be polled from a non-realtime thread.
+   */
+  void flushIfRequested();
+
+private:
+  /**
+   * Ring buffer of events owned by a single recording thread.
+   */
+  struct ThreadBuffer {
+    std::vector<Event> events;
+    std::atomic<uint64_t> written;
+    unsigned long threadId;
+    const char* threadName;
+  };
+
+  Trace();
+
+  /**
+   * Returns the calling thread's ring buffer, registering a new one on first use.
+   * @param adopt whether a thread without a buffer may adopt one reserved by reserveThread().
+   */
+  ThreadBuffer* threadBuffer(bool adopt);
+
+  /**
+   * Allocates and registers a ring buffer.
+   */
+  ThreadBuffer* newBuffer(const char* name);
+
+  /**
+   * Appends an event to the calling thread's ring buffer.
+   */
+  void record(const Event& event);
+
+  /**
+   * Private Trace instance pointer to implement the singleton design pattern.
+   */
+  static Trace* instance;
+
+  /**
+   * Set asynchronously by requestFlush().
+   */
+  static volatile sig_atomic_t flushRequested;
+
+  /**
+   * Whether events are recorded at all.
+   */
+  std::atomic<bool> enabled;
+
+  /**
+   * Output file of flush().
+   */
+  std::string path;
+
+  /**
+   * All ring buffers registered so far, one per thread that has recorded an event.
+   */
+  std::vector<ThreadBuffer*> buffers;
+
+  /**
+   * Registered buffers waiting to be adopted by a realtime thread, or nullptr.
+   */
+  std::vector<std::atomic<ThreadBuffer*>> reserved;
+
+  /**
+   * Guards buffers and path.
+   */
+  std::mutex buffersMutex;
+};
+
+/**
+ * Records a complete trace event spanning the lifetime of the instance.
+ */
+class TraceScope {
+public:
+  /**
+   * @param name static string naming the event.
+   */
+  explicit TraceScope(const char* name);
+
+  ~TraceScope();
+
+  TraceScope(const TraceScope&) = delete;
+  TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+  const char* name;
+  uint64_t startNs;
+};
+
+#endif /* OPENGL_SPECTROGRAM_TRACE_HPP */
@@ -0,0 +1,233 @@
+#include "VectorOps.hpp"
+#include <string.h>
+#include <stdint.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/* least squares polynomial (Chebyshev weighted) for log2 on the mantissa in [1, 2); with the rounding of the sum the
+ * result is within 2.3e-5 of log2f (measured over every mantissa at exponents from -100 to 100) */
+static const float LOG2_C0 = -2.79908649f;
+static const float LOG2_C1 = 5.08495632f;
+static const float LOG2_C2 = -3.53839178f;
+static const float LOG2_C3 = 1.62066953f;
+static const float LOG2_C4 = -0.412380661f;
+static const float LOG2_C5 = 0.0442336152f;
+
+static inline float log2Scalar(float x)
+{
+    uint32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    float exponent = (float) ((int) ((bits >> 23) & 0xff) - 127);
+    bits = (bits & 0x007fffff) | 0x3f800000;
+    float m;
+    memcpy(&m, &bits, sizeof(m));
+    return exponent + LOG2_C0 + m * (LOG2_C1 + m * (LOG2_C2 + m * (LOG2_C3 + m * (LOG2_C4 + m * LOG2_C5))));
+}
+
+void VectorOps::log2Approx(const float* in, float* out, unsigned int n, float floor)
+{
+    unsigned int i = 0;
+#ifdef __SSE2__
+    const __m128 floors = _mm_set1_ps(floor);
+    const __m128i mantissaMask = _mm_set1_epi32(0x007fffff);
+    const __m128i one = _mm_set1_epi32(0x3f800000);
+    const __m128i bias = _mm_set1_epi32(127);
+    for (; i + 4 <= n; i += 4) {
+        __m128 x = _mm_max_ps(_mm_loadu_ps(in + i), floors);
+        __m128i bits = _mm_castps_si128(x);
+        __m128 exponent = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), bias));
+        __m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, mantissaMask), one));
+        __m128 p = _mm_add_ps(_mm_set1_ps(LOG2_C4), _mm_mul_ps(m, _mm_set1_ps(LOG2_C5)));
+        p = _mm_add_ps(_mm_set1_ps(LOG2_C3), _mm_mul_ps(m, p));
+        p = _mm_add_ps(_mm_set1_ps(LOG2_C2), _mm_mul_ps(m, p));
+        p = _mm_add_ps(_mm_set1_ps(LOG2_C1), _mm_mul_ps(m, p));
+        p = _mm_add_ps(_mm_set1_ps(LOG2_C0), _mm_mul_ps(m, p));
+        _mm_storeu_ps(out + i, _mm_add_ps(exponent, p));
+    }
+#endif
+    for (; i < n; ++i) out[i] = log2Scalar(in[i] > floor ? in[i] : floor);
+}
+
+unsigned int VectorOps::argmax(const float* in, unsigned int n)
+{
+    if (n == 0) return 0;
+    float best = in[0];
+    unsigned int i = 0;
+#ifdef __SSE2__
+    /* find the maximum four lanes at a time, then its first position */
+    if (n >= 4) {
+        __m128 maxima = _mm_loadu_ps(in);
+        for (i = 4; i + 4 <= n; i += 4) maxima = _mm_max_ps(maxima, _mm_loadu_ps(in + i));
+        float lanes[4];
+        _mm_storeu_ps(lanes, maxima);
+        for (float lane : lanes) best = lane > best ? lane : best;
+    }
+#endif
+    for (; i < n; ++i) best = in[i] > best ? in[i] : best;
+    for (i = 0; i < n; ++i) if (in[i] == best) return i;
+    return 0;
+}
+
+float VectorOps::sum(const float* in, unsigned int n)
+{
+    unsigned int i = 0;
+    float total = 0.0f;
+#ifdef __SSE2__
+    __m128 sums = _mm_setzero_ps();
+    for (; i + 4 <= n; i += 4) sums = _mm_add_ps(sums, _mm_loadu_ps(in + i));
+    float lanes[4];
+    _mm_storeu_ps(lanes, sums);
+    total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+    for (; i < n; ++i) total += in[i];
+    return total;
+}
+
+float VectorOps::dot(const float* a, const float* b, unsigned int n)
+{
+    unsigned int i = 0;
+    float total = 0.0f;
+#ifdef __SSE2__
+    __m128 sums = _mm_setzero_ps();
+    for (; i + 4 <= n; i += 4) sums = _mm_add_ps(sums, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    float lanes[4];
+    _mm_storeu_ps(lanes, sums);
+    total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+    for (; i < n; ++i) total += a[i] * b[i];
+    return total;
+}
+
+void VectorOps::multiply(const float* a, const float* b, float* out, unsigned int n)
+{
+    unsigned int i = 0;
+#ifdef __SSE2__
+    for (; i + 4 <= n; i += 4) _mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+#endif
+    for (; i < n; ++i) out[i] = a[i] * b[i];
+}
+
+void VectorOps::multiplyAdd(const float* a, const float* b, float* out, unsigned int n)
+{
+    unsigned int i = 0;
+#ifdef __SSE2__
+    for (; i + 4 <= n; i += 4) {
+        __m128 product = _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), product));
+    }
+#endif
+    for (; i < n; ++i) out[i] += a[i] * b[i];
+}
+
+void VectorOps::add(const float* a, const float* b, float* out, unsigned int n)
+{
+    unsigned int i = 0;
+#ifdef __SSE2__
+    for (; i + 4 <= n; i += 4) _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+#endif
+    for (; i < n; ++i) out[i] = a[i] + b[i];
+}
+
+void VectorOps::welford(const float* x, float* mean, float* variance, unsigned int n, float weight)
+{
+    /* with w = 1 / count, variance += w (delta (x - new mean) - variance) is Welford's M2 update divided by count */
+    unsigned int i = 0;
+#ifdef __SSE2__
+    __m128 w = _mm_set1_ps(weight);
+    for (; i + 4 <= n; i += 4) {
+        __m128 value = _mm_loadu_ps(x + i);
+        __m128 average = _mm_loadu_ps(mean + i);
+        __m128 spread = _mm_loadu_ps(variance + i);
+        __m128 delta = _mm_sub_ps(value, average);
+        average = _mm_add_ps(average, _mm_mul_ps(w, delta));
+        __m128 product = _mm_mul_ps(delta, _mm_sub_ps(value, average));
+        spread = _mm_add_ps(spread, _mm_mul_ps(w, _mm_sub_ps(product, spread)));
+        _mm_storeu_ps(mean + i, average);
+        _mm_storeu_ps(variance + i, spread);
+    }
+#endif
+    for (; i < n; ++i) {
+        float delta = x[i] - mean[i];
+        mean[i] += weight * delta;
+        variance[i] += weight * (delta * (x[i] - mean[i]) - variance[i]);
+    }
+}
+
+float VectorOps::rectifiedDifferenceSum(const float* a, const float* b, unsigned int n)
+{
+    unsigned int i = 0;
+    float total = 0.0f;
+#ifdef __SSE2__
+    __m128 sums = _mm_setzero_ps();
+    __m128 zero = _mm_setzero_ps();
+    for (; i + 4 <= n; i += 4) {
+        sums = _mm_add_ps(sums, _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)), zero));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, sums);
+    total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+    for (; i < n; ++i) total += a[i] > b[i] ? a[i] - b[i] : 0.0f;
+    return total;
+}
+
+void VectorOps::slidingDft(double added, double removed, const double* stepRe, const double* stepIm,
+                           const double* rotationRe, const double* rotationIm, double* phasorRe, double* phasorIm,
+                           double* sumRe, double* sumIm, unsigned int n)
+{
+    /* sum += phasor (added - removed rotation), with the phasor already advanced to the newest sample */
+    unsigned int i = 0;
+#ifdef __SSE2__
+    __m128d in = _mm_set1_pd(added);
+    __m128d out = _mm_set1_pd(removed);
+    for (; i + 2 <= n; i += 2) {
+        __m128d pr = _mm_loadu_pd(phasorRe + i), pi = _mm_loadu_pd(phasorIm + i);
+        __m128d sr = _mm_loadu_pd(stepRe + i), si = _mm_loadu_pd(stepIm + i);
+        __m128d nr = _mm_sub_pd(_mm_mul_pd(pr, sr), _mm_mul_pd(pi, si));
+        __m128d ni = _mm_add_pd(_mm_mul_pd(pr, si), _mm_mul_pd(pi, sr));
+        __m128d ar = _mm_sub_pd(in, _mm_mul_pd(out, _mm_loadu_pd(rotationRe + i)));
+        __m128d ai = _mm_sub_pd(_mm_setzero_pd(), _mm_mul_pd(out, _mm_loadu_pd(rotationIm + i)));
+        _mm_storeu_pd(phasorRe + i, nr);
+        _mm_storeu_pd(phasorIm + i, ni);
+        _mm_storeu_pd(sumRe + i, _mm_add_pd(_mm_loadu_pd(sumRe + i),
+                                            _mm_sub_pd(_mm_mul_pd(nr, ar), _mm_mul_pd(ni, ai))));
+        _mm_storeu_pd(sumIm + i, _mm_add_pd(_mm_loadu_pd(sumIm + i),
+                                            _mm_add_pd(_mm_mul_pd(nr, ai), _mm_mul_pd(ni, ar))));
+    }
+#endif
+    for (; i < n; ++i) {
+        double nr = phasorRe[i] * stepRe[i] - phasorIm[i] * stepIm[i];
+        double ni = phasorRe[i] * stepIm[i] + phasorIm[i] * stepRe[i];
+        double ar = added - removed * rotationRe[i];
+        double ai = -removed * rotationIm[i];
+        phasorRe[i] = nr;
+        phasorIm[i] = ni;
+        sumRe[i] += nr * ar - ni * ai;
+        sumIm[i] += nr * ai + ni * ar;
+    }
+}
+
+void VectorOps::biquads(const float* in, float* out, const float* b0, const float* b1, const float* b2,
+                        const float* a1, const float* a2, float* z1, float* z2, unsigned int n)
+{
+    unsigned int i = 0;
+#ifdef __SSE2__
+    for (; i + 4 <= n; i += 4) {
+        __m128 x = _mm_loadu_ps(in + i);
+        __m128 y = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(b0 + i), x), _mm_loadu_ps(z1 + i));
+        __m128 s1 = _mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(b1 + i), x), _mm_mul_ps(_mm_loadu_ps(a1 + i), y));
+        __m128 s2 = _mm_sub_ps(_mm_mul_ps(_mm_loadu_ps(b2 + i), x), _mm_mul_ps(_mm_loadu_ps(a2 + i), y));
+        _mm_storeu_ps(z1 + i, _mm_add_ps(s1, _mm_loadu_ps(z2 + i)));
+        _mm_storeu_ps(z2 + i, s2);
+        _mm_storeu_ps(out + i, y);
+    }
+#endif
+    for (; i < n; ++i) {
+        float x = in[i];
+        float y = b0[i] * x + z1[i];
+        z1[i] = b1[i] * x - a1[i] * y + z2[i];
+        z2[i] = b2[i] * x - a2[i] * y;
+        out[i] = y;
+    }
+}
@@ -0,0 +1,109 @@
+/**
+ * Small vector kernels for per-column analyses, using SSE2 where the compiler targets it (always on x86-64) and
+ * plain loops elsewhere. Arrays need no particular alignment.
+ */
+
+#ifndef OPENGL_SPECTROGRAM_VECTOROPS_HPP
+#define OPENGL_SPECTROGRAM_VECTOROPS_HPP
+
+namespace VectorOps {
+
+/**
+ * Approximate base 2 logarithm of values clamped to a floor, within 2.3e-5 of log2f (measured over every mantissa at
+ * exponents from -100 to 100).
+ * @param in input values.
+ * @param out receives log2(max(in[i], floor)), may be in.
+ * @param n number of values.
+ * @param floor smallest value, must be positive and normal.
+ */
+void log2Approx(const float* in, float* out, unsigned int n, float floor);
+
+/**
+ * @return index of the first largest value, 0 if n is 0.
+ */
+unsigned int argmax(const float* in, unsigned int n);
+
+/**
+ * @return sum of the values.
+ */
+float sum(const float* in, unsigned int n);
+
+/**
+ * @return dot product of two arrays of n values.
+ */
+float dot(const float* a, const float* b, unsigned int n);
+
+/**
+ * Multiplies two arrays element by element.
+ * @param a first factors.
+ * @param b second factors.
+ * @param out receives a[i] * b[i], may be a or b.
+ * @param n number of values.
+ */
+void multiply(const float* a, const float* b, float* out, unsigned int n);
+
+/**
+ * Accumulates the element by element product of two arrays, e.g. one tap of a polyphase FIR filter.
+ * @param a first factors.
+ * @param b second factors.
+ * @param out receives out[i] + a[i] * b[i].
+ * @param n number of values.
+ */
+void multiplyAdd(const float* a, const float* b, float* out, unsigned int n);
+
+/**
+ * Adds two arrays element by element.
+ * @param a first terms.
+ * @param b second terms.
+ * @param out receives a[i] + b[i], may be a or b.
+ * @param n number of values.
+ */
+void add(const float* a, const float* b, float* out, unsigned int n);
+
+/**
+ * One step of Welford's running mean and variance for n independent series. A weight of 1 / count gives the
+ * population statistics of all count values; a fixed weight gives exponentially weighted ones.
+ * @param x new values.
+ * @param mean running means, updated.
+ * @param variance running variances, updated.
+ * @param n number of series.
+ * @param weight weight of the new values, in (0, 1].
+ */
+void welford(const float* x, float* mean, float* variance, unsigned int n, float weight);
+
+/**
+ * @return sum of the positive parts of a[i] - b[i], e.g. the half-wave rectified change between two columns.
+ */
+float rectifiedDifferenceSum(const float* a, const float* b, unsigned int n);
+
+/**
+ * One sample of a bank of sliding DFT bins at arbitrary frequencies w: every phasor is advanced by its step, then the
+ * newest sample enters each sum and the sample leaving the window, at the phase it entered with, leaves it. In double
+ * precision, so that the sums do not drift over hours of add and remove.
+ * @param added newest sample.
+ * @param removed sample leaving the window of N samples.
+ * @param stepRe, stepIm rotation of each phasor per sample, e^(-j w).
+ * @param rotationRe, rotationIm e^(j w N), the phase of the leaving sample relative to the newest one.
+ * @param phasorRe, phasorIm phasors e^(-j w t), updated.
+ * @param sumRe, sumIm sums of the samples times their phasors, updated.
+ * @param n number of bins.
+ */
+void slidingDft(double added, double removed, const double* stepRe, const double* stepIm, const double* rotationRe,
+                const double* rotationIm, double* phasorRe, double* phasorIm, double* sumRe, double* sumIm,
+                unsigned int n);
+
+/**
+ * One sample of n independent biquads in transposed direct form II, y = b0 x + z1, z1 = b1 x - a1 y + z2,
+ * z2 = b2 x - a2 y, e.g. one section of every filter of a bank, so that a cascade is one call per section.
+ * @param in input sample of each biquad.
+ * @param out receives the output sample of each biquad, may be in.
+ * @param b0, b1, b2, a1, a2 coefficients of each biquad, a0 being 1.
+ * @param z1, z2 states of each biquad, updated.
+ * @param n number of biquads.
+ */
+void biquads(const float* in, float* out, const float* b0, const float* b1, const float* b2, const float* a1,
+             const float* a2, float* z1, float* z2, unsigned int n);
+
+}
+
+#endif /* OPENGL_SPECTROGRAM_VECTOROPS_HPP */
@@ -0,0 +1,103 @@
+#include "WelchAverager.hpp"
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include "Log.hpp"
+#include "Trace.hpp"
+#include "VectorOps.hpp"
+
+/* static member declarations and initializations */
+const unsigned int WelchAverager::N_BLOCKS = 16;
+
+/**
+ * Adds sign times a block to a total.
+ */
+static void accumulate(std::vector<double>& total, const float* block, double sign)
+{
+    for (size_t i = 0; i < total.size(); ++i) total[i] += sign * block[i];
+}
+
+WelchAverager::WelchAverager(unsigned int nFrequencies, unsigned int spanColumns)
+  : DspSink<SpectrumFrame>("welch averager"), nFrequencies(std::min(nFrequencies, SpectrumFrame::MAX_FREQUENCIES)),
+    blockColumns(std::max(1u, (spanColumns + N_BLOCKS - 1) / N_BLOCKS)),
+    blockSums(N_BLOCKS * this->nFrequencies, 0.0f), blockSquares(N_BLOCKS * this->nFrequencies, 0.0f),
+    nextBlock(0), filledBlocks(0), totalSums(this->nFrequencies, 0.0f), totalSquares(this->nFrequencies, 0.0f),
+    currentSums(this->nFrequencies, 0.0f), currentSquares(this->nFrequencies, 0.0f), currentColumns(0),
+    squares(this->nFrequencies)
+{
+}
+
+unsigned long WelchAverager::read(std::vector<float>& mean, std::vector<float>& variance) const
+{
+    mean.assign(nFrequencies, 0.0f);
+    variance.assign(nFrequencies, 0.0f);
+    std::lock_guard<std::mutex> lock(mutex);
+    unsigned long columns = (unsigned long) filledBlocks * blockColumns + currentColumns;
+    if (columns == 0) return 0;
+
+    double correction = columns > 1 ? (double) columns / (columns - 1) : 0.0;
+    for (unsigned int i = 0; i < nFrequencies; ++i) {
+        double average = (totalSums[i] + currentSums[i]) / columns;
+        double squares = (totalSquares[i] + currentSquares[i]) / columns;
+        mean[i] = (float) average;
+        variance[i] = (float) std::max(0.0, (squares - average * average) * correction);
+    }
+    return columns;
+}
+
+unsigned long WelchAverager::write(const std::string& path, double densityScale, float hzPerFrequency) const
+{
+    std::vector<float> mean, variance;
+    unsigned long columns = read(mean, variance);
+    if (columns == 0) return 0;
+    FILE* out = fopen(path.c_str(), "w");
+    if (!out) {
+        Log::getInstance()->logger() << "Could not create " << path << std::endl;
+        return 0;
+    }
+    fprintf(out, "frequency_hz,density_db,density,deviation\n");
+    for (unsigned int i = 0; i < nFrequencies; ++i) {
+        double density = densityScale * mean[i];
+        fprintf(out, "%.3f,%.2f,%.6e,%.6e\n", i * hzPerFrequency, 10.0 * log10(std::max(density, 1e-30)), density,
+                densityScale * sqrt((double) variance[i]));
+    }
+    fclose(out);
+    Log::getInstance()->logger() << "Wrote the mean of " << columns << " columns to " << path << std::endl;
+    return columns;
+}
+
+unsigned int WelchAverager::getSpanColumns() const
+{
+    return N_BLOCKS * blockColumns;
+}
+
+void WelchAverager::consume(const SpectrumFrame& frame)
+{
+    if (frame.nFrequencies < nFrequencies) return;
+    TraceScope traceScope("welch averager");
+    unsigned int n = nFrequencies;
+    VectorOps::multiply(frame.power, frame.power, squares.data(), n);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    VectorOps::add(currentSums.data(), frame.power, currentSums.data(), n);
+    VectorOps::add(currentSquares.data(), squares.data(), currentSquares.data(), n);
+    if (++currentColumns < blockColumns) return;
+
+    /* retire the oldest block and file the current one in its place */
+    float* sums = &blockSums[nextBlock * n];
+    float* sumSquares = &blockSquares[nextBlock * n];
+    if (filledBlocks == N_BLOCKS) {
+        accumulate(totalSums, sums, -1.0);
+        accumulate(totalSquares, sumSquares, -1.0);
+    } else {
+        ++filledBlocks;
+    }
+    std::copy(currentSums.begin(), currentSums.end(), sums);
+    std::copy(currentSquares.begin(), currentSquares.end(), sumSquares);
+    accumulate(totalSums, sums, 1.0);
+    accumulate(totalSquares, sumSquares, 1.0);
+    std::fill(currentSums.begin(), currentSums.end(), 0.0f);
+    std::fill(currentSquares.begin(), currentSquares.end(), 0.0f);
+    currentColumns = 0;
+    nextBlock = (nextBlock + 1) % N_BLOCKS;
+}
@@ -0,0 +1,89 @@
+/**
+ * DSP graph sink averaging power spectra over a sliding span of columns, Welch's method applied to the overlapping
+ * windowed frames of the spectrogram, for a long-term power spectral density with a per-frequency variance.
+ *
+ * The span is split into N_BLOCKS blocks. Columns are summed into the block being filled; a filled block enters a
+ * ring and a running total, from which the block it replaces is subtracted. Each column thus costs a few vector
+ * additions whatever the span, and the average covers between spanColumns and spanColumns plus one block. The total
+ * is kept in double precision, so that subtracting a loud block leaves no noticeable residue in a quiet average.
+ */
+
+#ifndef OPENGL_SPECTROGRAM_WELCHAVERAGER_HPP
+#define OPENGL_SPECTROGRAM_WELCHAVERAGER_HPP
+
+#include <mutex>
+#include <string>
+#include <vector>
+#include "DspGraph.hpp"
+#include "SpectrumTap.hpp"
+
+class WelchAverager : public DspSink<SpectrumFrame> {
+public:
+  /**
+   * Blocks per span, the granularity at which old columns leave the average.
+   */
+  static const unsigned int N_BLOCKS;
+
+  /**
+   * @param nFrequencies number of frequencies per frame; smaller frames are ignored.
+   * @param spanColumns number of columns to average, rounded up to a multiple of N_BLOCKS. The time this covers
+   * stretches with the hop, e.g. while DegradationGovernor has multiplied it.
+   */
+  WelchAverager(unsigned int nFrequencies, unsigned int spanColumns);
+
+  /**
+   * Reads the average. Safe to call from any thread.
+   * @param mean receives nFrequencies mean powers.
+   * @param variance receives nFrequencies unbiased variances of the powers of single columns.
+   * @return number of columns averaged, 0 before the first frame.
+   */
+  unsigned long read(std::vector<float>& mean, std::vector<float>& variance) const;
+
+  /**
+   * Writes the average as a CSV table of frequency, mean density in dB and in full scale^2 / Hz, and the standard
+   * deviation of single columns in full scale^2 / Hz.
+   * @param path file to create.
+   * @param densityScale factor converting powers into densities, see AudioInput::getDensityScale().
+   * @param hzPerFrequency frequency spacing of the frames.
+   * @return number of columns averaged, 0 if none or the file could not be written.
+   */
+  unsigned long write(const std::string& path, double densityScale, float hzPerFrequency) const;
+
+  /**
+   * @return number of columns in a full span.
+   */
+  unsigned int getSpanColumns() const;
+
+protected:
+  virtual void consume(const SpectrumFrame& frame);
+
+private:
+  unsigned int nFrequencies;
+  unsigned int blockColumns;
+
+  /**
+   * Sums and sums of squares of the filled blocks, N_BLOCKS times nFrequencies each.
+   */
+  std::vector<float> blockSums;
+  std::vector<float> blockSquares;
+  unsigned int nextBlock;
+  unsigned int filledBlocks;
+
+  /**
+   * Sums over the filled blocks.
+   */
+  std::vector<double> totalSums;
+  std::vector<double> totalSquares;
+
+  /**
+   * Sums over the block being filled.
+   */
+  std::vector<float> currentSums;
+  std::vector<float> currentSquares;
+  unsigned int currentColumns;
+
+  std::vector<float> squares;
+  mutable std::mutex mutex;
+};
+
+#endif /* OPENGL_SPECTROGRAM_WELCHAVERAGER_HPP */
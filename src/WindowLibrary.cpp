@@ -0,0 +1,175 @@
+#include "WindowLibrary.hpp"
+#include <algorithm>
+#include <math.h>
+#include "Log.hpp"
+
+/* static member declarations and initializations */
+WindowLibrary* WindowLibrary::instance;
+
+static const WindowLibrary::Type TYPES[] = {
+    WindowLibrary::RECTANGULAR, WindowLibrary::HANN, WindowLibrary::GAUSSIAN, WindowLibrary::BLACKMAN_HARRIS,
+    WindowLibrary::KAISER, WindowLibrary::FLAT_TOP, WindowLibrary::NUTTALL, WindowLibrary::TUKEY
+};
+static const unsigned int N_TYPES = sizeof(TYPES) / sizeof(TYPES[0]);
+
+/* cosine-sum coefficients a_k of w = sum_k (-1)^k a_k cos(2 pi k i / N) */
+static const double BLACKMAN_HARRIS_TERMS[] = {0.35875, 0.48829, 0.14128, 0.01168};
+static const double NUTTALL_TERMS[] = {0.355768, 0.487396, 0.144232, 0.012604};
+static const double FLAT_TOP_TERMS[] = {0.21557895, 0.41663158, 0.277263158, 0.083578947, 0.006947368};
+
+/**
+ * Modified Bessel function of the first kind of order 0, by its power series.
+ */
+static double besselI0(double x)
+{
+    double sum = 1.0, term = 1.0, quarter = x * x / 4.0;
+    for (int k = 1; term > 1e-12 * sum; ++k) {
+        term *= quarter / ((double) k * k);
+        sum += term;
+    }
+    return sum;
+}
+
+static void cosineSum(std::vector<float>& window, const double* terms, unsigned int nTerms)
+{
+    unsigned int n = (unsigned int) window.size();
+    for (unsigned int i = 0; i < n; ++i) {
+        double value = 0.0;
+        for (unsigned int k = 0; k < nTerms; ++k) {
+            value += (k % 2 ? -1.0 : 1.0) * terms[k] * cos(2.0 * M_PI * k * i / n);
+        }
+        window[i] = (float) value;
+    }
+}
+
+WindowLibrary* WindowLibrary::getInstance()
+{
+    if (!instance) {
+        WindowLibrary::instance = new WindowLibrary();
+    }
+    return WindowLibrary::instance;
+}
+
+WindowLibrary::WindowLibrary()
+{
+}
+
+const WindowLibrary::Table* WindowLibrary::get(Type type, unsigned int length, float parameter)
+{
+    if (!isType(type)) return nullptr;
+    if (type != KAISER && type != TUKEY) parameter = 0.0f;
+    else if (parameter <= 0.0f) parameter = defaultParameter(type);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::unique_ptr<Table>& table = tables[std::make_tuple((int) type, length, parameter)];
+    if (!table) {
+        table.reset(new Table());
+        table->type = type;
+        table->parameter = parameter;
+        table->coefficients.resize(length);
+        compute(*table);
+        Log::getInstance()->logger() << "Computed a " << length << " point " << name(type) << " window "
+                                     << parameter << ", noise bandwidth " << table->noiseBandwidth << " bins"
+                                     << std::endl;
+    }
+    return table.get();
+}
+
+float WindowLibrary::defaultParameter(Type type)
+{
+    if (type == KAISER) return 8.6f;
+    if (type == TUKEY) return 0.5f;
+    return 0.0f;
+}
+
+const char* WindowLibrary::name(Type type)
+{
+    switch (type) {
+        case RECTANGULAR: return "rectangular";
+        case HANN: return "Hann";
+        case GAUSSIAN: return "Gaussian";
+        case BLACKMAN_HARRIS: return "Blackman-Harris";
+        case KAISER: return "Kaiser";
+        case FLAT_TOP: return "flat-top";
+        case NUTTALL: return "Nuttall";
+        case TUKEY: return "Tukey";
+    }
+    return "unknown";
+}
+
+bool WindowLibrary::isType(unsigned int type)
+{
+    for (Type known : TYPES) {
+        if ((unsigned int) known == type) return true;
+    }
+    return false;
+}
+
+WindowLibrary::Type WindowLibrary::next(Type type)
+{
+    for (unsigned int t = 0; t < N_TYPES; ++t) {
+        if (TYPES[t] == type) return TYPES[(t + 1) % N_TYPES];
+    }
+    return TYPES[0];
+}
+
+void WindowLibrary::compute(Table& table)
+{
+    std::vector<float>& window = table.coefficients;
+    int n = (int) window.size();
+    double width;
+    switch (table.type) {
+        case RECTANGULAR:
+            /* no window (crappy frequency spillover) */
+            for (int i = 0; i < n; ++i) window[i] = 1.0f;
+            break;
+        case HANN:
+            /* Hann window (C^1 cont, so third-order tails) */
+            width = n / 2.0;
+            for (int i = 0; i < n; ++i) window[i] = (float) ((1.0 + cos(M_PI * (i - width) / width)) / 2);
+            break;
+        case GAUSSIAN:
+            /* truncated Gaussian window (Gaussian tails + exp small error), wide to not waste FFT */
+            width = n / 5.0;
+            for (int i = 0; i < n; ++i) {
+                window[i] = (float) exp(-(double) (i - n / 2) * (i - n / 2) / (2 * width * width));
+            }
+            break;
+        case BLACKMAN_HARRIS:
+            /* 4-term Blackman-Harris, -92 dB sidelobes */
+            cosineSum(window, BLACKMAN_HARRIS_TERMS, 4);
+            break;
+        case KAISER:
+            /* Kaiser-Bessel, sidelobes falling with beta */
+            for (int i = 0; i < n; ++i) {
+                double r = 2.0 * i / n - 1.0;
+                window[i] = (float) (besselI0(table.parameter * sqrt(1.0 - r * r)) / besselI0(table.parameter));
+            }
+            break;
+        case FLAT_TOP:
+            /* 5-term flat-top, scalloping loss below 0.01 dB for amplitude readings */
+            cosineSum(window, FLAT_TOP_TERMS, 5);
+            break;
+        case NUTTALL:
+            /* 4-term Nuttall with a continuous first derivative, -93 dB sidelobes */
+            cosineSum(window, NUTTALL_TERMS, 4);
+            break;
+        case TUKEY:
+            /* flat with Hann tapers over the parameter fraction of the length */
+            width = table.parameter * n / 2.0;
+            for (int i = 0; i < n; ++i) {
+                double edge = std::min(i, n - i);
+                window[i] = edge < width ? (float) ((1.0 - cos(M_PI * edge / width)) / 2) : 1.0f;
+            }
+            break;
+    }
+
+    double sum = 0.0, squares = 0.0;
+    for (float w : window) {
+        sum += w;
+        squares += (double) w * w;
+    }
+    table.coherentGain = sum / n;
+    table.noiseGain = squares / n;
+    table.noiseBandwidth = table.noiseGain / (table.coherentGain * table.coherentGain);
+}
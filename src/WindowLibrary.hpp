@@ -0,0 +1,111 @@
+/**
+ * Process-wide cache of window tables, so that every channel and stream using a window of some type, length and
+ * parameter shares one table, computed on first use. Tables are never freed, so a pointer to one stays valid and
+ * switching windows at runtime only swaps a pointer.
+ *
+ * Cosine-sum windows are DFT-even (periodic), like the Hann window this program always used.
+ */
+
+#ifndef OPENGL_SPECTROGRAM_WINDOWLIBRARY_HPP
+#define OPENGL_SPECTROGRAM_WINDOWLIBRARY_HPP
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+class WindowLibrary {
+public:
+  /**
+   * Window types, numbered as recorded in spectrogram files. 3, 9 and 10 are reserved for multitaper estimates, the
+   * polyphase filterbank and multi-resolution spectra.
+   */
+  enum Type {
+    RECTANGULAR = 0,
+    HANN = 1,
+    GAUSSIAN = 2,
+    BLACKMAN_HARRIS = 4,
+    KAISER = 5,
+    FLAT_TOP = 6,
+    NUTTALL = 7,
+    TUKEY = 8
+  };
+
+  /**
+   * Coefficients of a window with its gains.
+   */
+  struct Table {
+    Type type;
+    float parameter;
+    std::vector<float> coefficients;
+
+    /**
+     * Mean coefficient: the amplitude of a bin-centred tone relative to a rectangular window.
+     */
+    double coherentGain;
+
+    /**
+     * Mean squared coefficient: the power of white noise relative to a rectangular window.
+     */
+    double noiseGain;
+
+    /**
+     * Equivalent noise bandwidth in bins, noiseGain / coherentGain^2.
+     */
+    double noiseBandwidth;
+  };
+
+  /**
+   * Accessor method for the singleton instance of the class, following Log::getInstance().
+   * @return the process-wide WindowLibrary instance.
+   */
+  static WindowLibrary* getInstance();
+
+  WindowLibrary(const WindowLibrary&) = delete;
+  WindowLibrary& operator=(const WindowLibrary&) = delete;
+
+  /**
+   * Returns a window table, computing it on first use. Not realtime safe.
+   * @param type window type.
+   * @param length number of coefficients.
+   * @param parameter Kaiser beta or Tukey taper fraction, ignored by the other types; 0 for the default.
+   * @return the table, owned by the library, or nullptr for an unknown type.
+   */
+  const Table* get(Type type, unsigned int length, float parameter = 0.0f);
+
+  /**
+   * @return the parameter used for 0, e.g. a Kaiser beta of 8.6, with sidelobes comparable to Blackman-Harris.
+   */
+  static float defaultParameter(Type type);
+
+  /**
+   * @return a short name of a window type, e.g. "Kaiser".
+   */
+  static const char* name(Type type);
+
+  /**
+   * @return whether a number is a known window type.
+   */
+  static bool isType(unsigned int type);
+
+  /**
+   * @return the next window type after type, in the order of the enumeration, wrapping around.
+   */
+  static Type next(Type type);
+
+private:
+  WindowLibrary();
+
+  /**
+   * Fills a table with the coefficients and gains of its type, length and parameter.
+   */
+  static void compute(Table& table);
+
+  static WindowLibrary* instance;
+
+  std::mutex mutex;
+  std::map<std::tuple<int, unsigned int, float>, std::unique_ptr<Table>> tables;
+};
+
+#endif /* OPENGL_SPECTROGRAM_WINDOWLIBRARY_HPP */
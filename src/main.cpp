@@ -4,32 +4,175 @@
 #include "Display.hpp"
 #include "GraphicsItem.hpp"
 #include "SpectrogramVisualizer.hpp"
+#include "SpectrogramRecorder.hpp"
+#include "SpectrogramReplay.hpp"
+#include "SyntheticInput.hpp"
+#include "DspThreadPool.hpp"
+#include "DspGraph.hpp"
+#include "HistorySink.hpp"
+#include "SpectrumTap.hpp"
+#include "SharedColumnRing.hpp"
+#include "ChromaMapper.hpp"
+#include "ColumnEmitter.hpp"
+#include "OnsetDetector.hpp"
+#include "OnsetLogWriter.hpp"
+#include "WelchAverager.hpp"
+#include "BinStatistics.hpp"
+#include "PitchCsvWriter.hpp"
+#include "PitchTracker.hpp"
+#include "ToneAlarmWriter.hpp"
+#include "ToneTracker.hpp"
+#include "BandMeter.hpp"
+#include "MetricsExporter.hpp"
+#include "OctaveFilterBank.hpp"
+#include "ChannelSpectrumTap.hpp"
+#include "DelayCsvWriter.hpp"
+#include "DelayEstimator.hpp"
 #include "AudioVisualizationConfig.h"
 #include "Log.hpp"
+#include "Trace.hpp"
+#include <signal.h>
+#include <memory>
+#include <string>
+#include <vector>
 
 int screenMode;
 unsigned int verbosity;
 int scrollFactor;
+bool latencySelfTest;
+unsigned int hopSize;
+float flightRecorderMinutes;
+const char* recordPath;
+const char* replayPath;
+const char* historyDirectory;
+HistoryPyramid::Pooling historyPooling;
+unsigned int historyMegabytes;
+std::vector<BandSummaryIndex::Band> summaryBands;
+float replaySpeed;
+const char* shmName;
+float shmPcmSeconds;
+const char* emitTarget;
+ColumnEmitter::Format emitFormat;
+bool pitchTracking;
+const char* pitchCsvPath;
+bool chromaView;
+float welchSeconds;
+bool zScoreColors;
+bool autoLevel;
+const char* baselinePath;
+bool multitaper;
+bool polyphase;
+bool multiResolution;
+WindowLibrary::Type windowType;
+float windowParameter;
+bool onsetDetection;
+const char* onsetLogPath;
+std::vector<ToneTracker::Tone> trackedTones;
+const char* toneLogPath;
+float maxDelayMs;
+const char* delayLogPath;
+const char* metricsTarget;
+float metricsSeconds;
+unsigned int octaveBandsPerOctave;
+std::vector<std::string> inputSpecs;
+
+/* listeners live until exit(), which runs after the audio stream has been closed by quitNow() */
+std::unique_ptr<FlightRecorder> flightRecorder;
+std::unique_ptr<SpectrogramRecorder> spectrogramRecorder;
+std::unique_ptr<HistoryPyramid> historyPyramid;
+std::unique_ptr<SharedColumnPublisher> sharedColumnPublisher;
+std::unique_ptr<SpectrumTap> spectrumTap;
+std::unique_ptr<ToneTracker> toneTracker;
+std::unique_ptr<BandMeter> bandMeter;
+std::unique_ptr<OctaveFilterBank> octaveFilterBank;
+std::vector<std::unique_ptr<ChannelSpectrumTap>> channelTaps;
+
+/* analyses downstream of the first input; destroyed first, which stops its stages before what they write to */
+std::unique_ptr<DspGraph> dspGraph;
 
 const char* const helptext[] = {
     "Real Time Audio Visualization\n",
     "Author: Anthony Agnone, Alex Barnett\n\n",
-    "Usage: audio_visualization [-f] [-v] [-V] [-sf <scroll_factor>] [-w <windowType>]\n\n",
+    "Usage: audio_visualization [-f] [-v] [-V] [-sf <scroll_factor>] [-autolevel] [-w <windowType>[:<parameter>]] [-mt] [-pfb] [-mr] [-t <trace_file>] [-L] [-hop <samples>] [-fr <minutes>] [-rec <file>] [-replay <file>] [-speed <x>] [-hist <dir>] [-histmean] [-histmb <megabytes>] [-bands <list>] [-shm <name>] [-shmpcm <seconds>] [-emit <target>] [-emitbytes] [-pitch] [-pitchcsv <file>] [-chroma] [-welch <seconds>] [-zscore] [-baseline <file>] [-onsets] [-onsetlog <file>] [-tones <list>] [-tonelog <file>] [-gcc <max_delay_ms>] [-gcclog <file>] [-metrics <target>] [-metricsint <seconds>] [-octave <1|3>] [-i <input>]...\n\n",
     "\t[-f] enables full-screen-mode\n",
     "\t[-v] print version and exit\n",
     "\t[-V] set verbosity int\n",
     "\t[-w] short-time window function type, default: 2\n",
-              "\t\t0: no window (or equivalently a rectangular window\n",
+              "\t\t0: no window (or equivalently a rectangular window)\n",
               "\t\t1: Hann window\n",
-              "\t\t2: Gaussian truncated at +-4sigma)\n",
-    "\t\t[-sf] scroll_factor = 1,2,... # vSyncs (60Hz) to wait per scroll pixel (default 1)\n\n",
-    "Keys & Mouse Controls\n",
+              "\t\t2: Gaussian truncated at +-4sigma\n",
+              "\t\t4: Blackman-Harris\n",
+              "\t\t5: Kaiser, parameter beta, default 8.6, e.g. -w 5:12\n",
+              "\t\t6: flat-top, for amplitude readings\n",
+              "\t\t7: Nuttall\n",
+              "\t\t8: Tukey, parameter taper fraction, default 0.5\n",
+    "\t[-mt] multitaper spectra: the mean of 5 DPSS-tapered FFTs, lower variance for noise floor measurements\n",
+    "\t[-pfb] 8 tap polyphase filterbank: flat-topped bins with little scalloping and leakage for tone levels\n",
+    "\t[-mr] multi-resolution spectra: 4x the FFT length below 500 Hz, 1/8 of it above 4 kHz, computed in parallel\n",
+    "\t\t[-sf] scroll_factor = 1,2,... # vSyncs (60Hz) to wait per scroll pixel (default 1)\n",
+    "\t[-t] record trace events, written as Chrome trace JSON to trace_file on 't' or SIGUSR1\n",
+    "\t[-L] latency self-test: inject a synthetic click every second and measure click-to-screen latency\n",
+    "\t[-hop] samples between spectrogram frames before degradation, 1 to the FFT length (4096), default: 512\n",
+    "\t[-fr] keep the last minutes of audio and spectrogram, dumped to flight_*.{wav,cols} on 'r' or SIGUSR2\n",
+    "\t[-rec] record the spectrogram to file, with per-second band energies in file.bands\n",
+    "\t[-bands] bands of file.bands and -metrics in Hz, e.g. 0-250,250-500,2000-4000, default: octaves up to 16 kHz\n",
+    "\t[-replay] show a recorded spectrogram instead of capturing audio\n",
+    "\t[-speed] replay speed, default: 1\n",
+    "\t[-hist] keep every computed column in a history pyramid in dir\n",
+    "\t[-histmean] mean-pool the history pyramid instead of max-pooling it\n",
+    "\t[-histmb] size cap in MB of each history pyramid level file, the oldest columns are overwritten beyond it,\n",
+    "\t\tdefault: 1024\n",
+    "\t[-shm] publish the columns to other local processes in shared memory /name, see shm_columns\n",
+    "\t[-shmpcm] also publish the last seconds of audio in the shared memory\n",
+    "\t[-emit] run without display and write binary column frames to target: - for stdout (logs then go to\n",
+    "\t\tstderr) or unix:<path> for a Unix domain socket, see ColumnEmitter.hpp for the frame layout\n",
+    "\t[-emitbytes] emit one byte dB levels instead of float powers\n",
+    "\t[-pitch] track the fundamental frequency and overlay it with its note name\n",
+    "\t[-pitchcsv] track the fundamental frequency and write it to a CSV file\n",
+    "\t[-chroma] show a 12-row chromagram strip over the top of the spectrogram\n",
+    "\t[-welch] trace the power spectral density averaged over the given span in dB/Hz; e writes it to a CSV file\n",
+    "\t[-autolevel] set brightness and contrast from the 5th and 99.5th percentiles of recent levels\n",
+    "\t[-zscore] learn every frequency's level and add a colour map of z-scores against it, to spot new tones\n",
+    "\t[-baseline] start from a baseline saved with the v key, held until b is pressed; implies -zscore\n",
+    "\t[-onsets] detect onsets by their spectral flux and mark them; with -fr, each onset dumps the recorder\n",
+    "\t[-onsetlog] detect onsets and append them to a CSV event log\n",
+    "\t[-tones] trace the level and phase of tones at a sub-hop rate, e.g. 50,120:-20 for 50 Hz and 120 Hz with an\n",
+    "\t\talarm above -20 dB re full scale; with -fr, each alarm dumps the recorder\n",
+    "\t[-tonelog] append the tone alarms to a CSV event log (with -tones)\n",
+    "\t[-gcc] estimate the time delay between every pair of inputs up to the given number of ms by GCC-PHAT and\n",
+    "\t\tshow their correlations; needs the FFT of a window or -pfb, not -mt or -mr, and the display, not -emit\n",
+    "\t[-gcclog] also write the time delays to a CSV file (with -gcc)\n",
+    "\t[-metrics] export the energy of the -bands as OpenMetrics text to a file, replaced after every interval, or to\n",
+    "\t\tunix:<path> for a Unix domain socket answering every connection with the latest interval\n",
+    "\t[-metricsint] seconds per metrics interval, default 10\n",
+    "\t[-octave] show Fast weighted octave (1) or one-third octave (3) band levels as bars beside the spectral\n",
+    "\t\tmagnitude plot, filtered with IEC 61260 bands; needs the display, not -emit\n",
+    "\t[-i] add an input shown in its own tile, repeatable: dev:<device id>, synth:<tone Hz> or replay:<file>;\n",
+    "\t\t-rec, -fr, -hist, -shm, -emit, -pitch, -chroma, -onsets, -tones, -metrics and -octave apply to the first\n",
+    "\t\tinput\n\n",
+    "Keys & Mouse Controls (in a grid, for the tile under the pointer)\n",
     "\t\tarrows or middle button drag - brightness/contrast\n",
     "\t\tleft button shows horizontal frequency readoff line\n",
     "\t\tright button shows horizontal frequency readoff with multiples\n",
-    "\t\ti - cycles through color maps (B/W, inverse B/W, color)\n",
+    "\t\tg - toggles the auto-level, which the arrows and middle button drag turn off\n",
+    "\t\ti - cycles through color maps (B/W, inverse B/W, color, and z-scores with -zscore)\n",
+    "\t\td - toggles diagnosis (degradation level, overflows, dropped hops, render backlog)\n",
     "\t\tq or Esc - quit\n",
-    "\t\t[ and ] - control horizontal scroll factor (samplingRate)\n"
+    "\t\t[ and ] - control horizontal scroll factor (samplingRate)\n",
+    "\t\tt - write trace events (with -t)\n",
+    "\t\tr - dump the flight recorder (with -fr)\n",
+    "\t\t, and . - seek back and forward 10 s (with -replay)\n",
+    "\t\t- and = - halve and double the replay speed (with -replay)\n",
+    "\t\th - toggles the history view (with -hist), z and x - zoom out and in, a and s - pan\n",
+    "\t\tp - toggles the pitch track (with -pitch)\n",
+    "\t\tw - cycles through the window functions\n",
+    "\t\tc - toggles the chromagram strip (with -chroma)\n",
+    "\t\to - toggles the onset marks (with -onsets)\n",
+    "\t\tb - holds or resumes learning the baseline, v - writes it to baseline_<time>.bin (with -zscore)\n",
+    "\t\tl - toggles the averaged density, e - writes it to welch_<time>.csv (with -welch)\n",
+    "\t\tk - tracks the frequency of the read-off line, j - stops tracking all tones (with -tones)\n",
+    "\t\tu - toggles the correlation panel (with -gcc)\n",
+    "\t\tn - toggles the octave band bars and the time domain plot (with -octave)\n"
 };
 
 
@@ -40,12 +183,282 @@ int getInputDeviceId(const char *fn)
     return 7;
 } 
 
+/**
+ * Creates the audio source of an input specification.
+ * @param spec "dev:<device id>", "synth:<tone Hz>" or "replay:<file>".
+ * @param replay receives the source if it is a replay, else nullptr.
+ * @return the source, or nullptr if the specification is malformed.
+ */
+AudioInput* createAudioInput(const std::string& spec, SpectrogramReplay*& replay)
+{
+  replay = nullptr;
+  if (!spec.compare(0, 4, "dev:")) return new PortAudio(atoi(spec.c_str() + 4));
+  if (!spec.compare(0, 6, "synth:")) return new SyntheticInput((float) atof(spec.c_str() + 6));
+  if (!spec.compare(0, 7, "replay:")) return replay = new SpectrogramReplay(spec.substr(7));
+  return nullptr;
+}
+
+/**
+ * Attaches the outputs that do not depend on the display (-shm, -rec) to the first input.
+ */
+void attachOutputs(AudioInput* audioInput)
+{
+  if (shmName) {
+    std::string name = shmName[0] == '/' ? shmName : std::string("/") + shmName;
+    unsigned int columnSlots = 1024;  /* about 12 s at the default hop */
+    sharedColumnPublisher.reset(new SharedColumnPublisher(
+            name, AudioInput::N_FREQUENCIES, audioInput->getSamplingRate(), columnSlots,
+            (uint64_t) (shmPcmSeconds * audioInput->getSamplingRate())));
+    audioInput->addListener(sharedColumnPublisher.get());
+  }
+  if (recordPath) {
+    spectrogramRecorder.reset(new SpectrogramRecorder(recordPath, *audioInput, summaryBands));
+    audioInput->addListener(spectrogramRecorder.get());
+  }
+}
+
+/**
+ * Adds the pitch tracker (-pitch, -pitchcsv) and its CSV export to the DSP graph.
+ * @return the tracker, or nullptr if not requested.
+ */
+PitchTracker* addPitchTracker(AudioInput* audioInput)
+{
+  if (!pitchTracking && !pitchCsvPath) return nullptr;
+  PitchTracker* pitchTracker = dspGraph->add(new PitchTracker(audioInput->getSamplingRate()), DspStageBase::POOLED);
+  dspGraph->connect(spectrumTap.get(), pitchTracker, "pitch", 64, DspEdgeBase::DROP_OLDEST);
+  if (pitchCsvPath) {
+    PitchCsvWriter* pitchCsvWriter = dspGraph->add(new PitchCsvWriter(pitchCsvPath), DspStageBase::POOLED);
+    dspGraph->connect(pitchTracker, pitchCsvWriter, "pitch csv", 1024, DspEdgeBase::DROP_OLDEST);
+  }
+  return pitchTracker;
+}
+
+/**
+ * Adds the onset detector (-onsets, -onsetlog) to the DSP graph, with its event log and flight recorder trigger.
+ * Must be called before the spectrum tap listens to the input, so that the detector has the samples of every frame.
+ * @return the detector, or nullptr if not requested.
+ */
+OnsetDetector* addOnsetDetector(AudioInput* audioInput)
+{
+  if (!onsetDetection && !onsetLogPath) return nullptr;
+  OnsetDetector* onsetDetector = dspGraph->add(new OnsetDetector(audioInput->getSamplingRate(),
+                                                                 audioInput->getFftLength()),
+                                               DspStageBase::POOLED);
+  audioInput->addListener(onsetDetector);
+
+  /* keep a backlog rather than miss onsets; late frames still find their samples in the ring for a while */
+  dspGraph->connect(spectrumTap.get(), onsetDetector, "onsets", 256, DspEdgeBase::DROP_OLDEST);
+  if (onsetLogPath || flightRecorder) {
+    OnsetLogWriter* onsetLogWriter = dspGraph->add(new OnsetLogWriter(onsetLogPath, flightRecorder.get()),
+                                                   DspStageBase::POOLED);
+    dspGraph->connect(onsetDetector, onsetLogWriter, "onset log", 1024, DspEdgeBase::DROP_OLDEST);
+  }
+  return onsetDetector;
+}
+
+/**
+ * Adds the tone tracker (-tones, -tonelog) to the input, with its alarm log and flight recorder trigger.
+ * @return the tracker, or nullptr if not requested.
+ */
+ToneTracker* addToneTracker(AudioInput* audioInput)
+{
+  if (trackedTones.empty()) return nullptr;
+
+  /* a quarter of the FFT length lags by an eighth of it, e.g. 11 ms at 48 kHz */
+  toneTracker.reset(new ToneTracker(audioInput->getSamplingRate(), audioInput->getFftLength() / 4));
+  for (const ToneTracker::Tone& tone : trackedTones) {
+    if (!toneTracker->addTone(tone.frequency, tone.threshold)) {
+      Log::getInstance()->logger() << "Cannot track " << tone.frequency << " Hz" << std::endl;
+      throw 99;
+    }
+  }
+
+  /* the writer also logs the alarms, so it is added without -tonelog or -fr as well */
+  ToneAlarmWriter* toneAlarmWriter = dspGraph->add(new ToneAlarmWriter(toneLogPath, flightRecorder.get()),
+                                                   DspStageBase::POOLED);
+  dspGraph->connect(toneTracker.get(), toneAlarmWriter, "tone alarms", 256, DspEdgeBase::DROP_OLDEST);
+  audioInput->addListener(toneTracker.get());
+  return toneTracker.get();
+}
+
+/**
+ * Adds the band meter (-metrics) to the input, with its OpenMetrics exporter.
+ */
+void addBandMeter(AudioInput* audioInput)
+{
+  if (!metricsTarget) return;
+  bandMeter.reset(new BandMeter(summaryBands, audioInput->getSamplingRate(), AudioInput::N_FREQUENCIES,
+                                metricsSeconds));
+
+  /* every interval replaces the last, so only the newest matters */
+  MetricsExporter* metricsExporter = dspGraph->add(new MetricsExporter(metricsTarget, summaryBands),
+                                                   DspStageBase::POOLED);
+  dspGraph->connect(bandMeter.get(), metricsExporter, "metrics", 4, DspEdgeBase::DROP_OLDEST);
+  audioInput->addListener(bandMeter.get());
+}
+
+/**
+ * Adds a GCC-PHAT delay estimator (-gcc, -gcclog) for every pair of inputs to the DSP graph, fed by a channel spectrum
+ * tap per input; see attachChannelTap(). The estimators run pooled, so that the pairs spread over the DSP threads.
+ * @param audioInput the first input, whose sampling rate and FFT length all inputs must share.
+ * @return the estimators, none if not requested.
+ */
+std::vector<DelayEstimator*> addDelayEstimators(AudioInput* audioInput)
+{
+  std::vector<DelayEstimator*> delayEstimators;
+  if (maxDelayMs <= 0 || inputSpecs.size() < 2) return delayEstimators;
+  for (size_t c = 0; c < inputSpecs.size(); ++c) {
+    channelTaps.emplace_back(new ChannelSpectrumTap(c, audioInput->getSamplingRate()));
+  }
+  DspEdge<DelayEstimate>* logEdge = nullptr;
+  DelayCsvWriter* delayCsvWriter = delayLogPath ? dspGraph->add(new DelayCsvWriter(delayLogPath),
+                                                                DspStageBase::POOLED) : nullptr;
+  for (size_t first = 0; first < inputSpecs.size(); ++first) {
+    for (size_t second = first + 1; second < inputSpecs.size(); ++second) {
+      DelayEstimator* delayEstimator = dspGraph->add(new DelayEstimator(first, second, maxDelayMs * 1e-3,
+                                                                        audioInput->getFftLength()),
+                                                     DspStageBase::POOLED);
+
+      /* both channels feed one edge, and only their latest frames are matched */
+      DspEdge<ChannelSpectrum>* edge = dspGraph->connect(channelTaps[first].get(), delayEstimator, "delay", 8,
+                                                         DspEdgeBase::DROP_OLDEST);
+      channelTaps[second]->addOutput(edge);
+      if (delayCsvWriter && !logEdge) {
+        logEdge = dspGraph->connect(delayEstimator, delayCsvWriter, "delay csv", 1024, DspEdgeBase::DROP_OLDEST);
+      } else if (delayCsvWriter) {
+        delayEstimator->addOutput(logEdge);
+      }
+      delayEstimators.push_back(delayEstimator);
+    }
+  }
+  return delayEstimators;
+}
+
+/**
+ * Starts tapping the spectra of an input for the delay estimators, once the DSP graph runs. Inputs sampled at
+ * another rate than the first are not correlated.
+ * @param channel index of the input.
+ */
+void attachChannelTap(size_t channel, AudioInput* audioInput)
+{
+  if (channel >= channelTaps.size()) return;
+  if (audioInput->getSamplingRate() != channelTaps[0]->getSamplingRate()) {
+    Log::getInstance()->logger() << "Input " << channel + 1 << " is sampled at another rate than input 1 and is not "
+                                 << "correlated." << std::endl;
+    return;
+  }
+  audioInput->addListener(channelTaps[channel].get());
+}
+
+volatile sig_atomic_t headlessQuit = 0;
+
+void requestHeadlessQuit(int signal)
+{
+  (void) signal;
+  headlessQuit = 1;
+}
+
+/**
+ * Runs without a display (-emit): emits the columns of the first input until SIGINT or SIGTERM, or until the reader
+ * of stdout goes away.
+ * @return exit status.
+ */
+int runHeadless()
+{
+  if (inputSpecs.size() > 1) {
+    Log::getInstance()->logger() << "Only the first input is emitted." << std::endl;
+  }
+  SpectrogramReplay* replay;
+  AudioInput* audioInput = createAudioInput(inputSpecs[0], replay);
+  if (!audioInput) {
+    fprintf(stderr, "bad input %s\n", inputSpecs[0].c_str());
+    return 1;
+  }
+  if (replay) {
+    replay->setSpeed(replaySpeed);
+  } else {
+    audioInput->setHopSize(hopSize);
+    audioInput->setWindow(windowType, windowParameter);
+    audioInput->setMultitaper(multitaper);
+    if (!audioInput->setPolyphase(polyphase)) return 1;
+    if (!audioInput->setMultiResolution(multiResolution)) return 1;
+  }
+
+  /* the emitter blocks on slow readers, so it gets its own thread and sheds the oldest columns */
+  dspGraph.reset(new DspGraph());
+  spectrumTap.reset(new SpectrumTap());
+  ColumnEmitter* emitter = dspGraph->add(new ColumnEmitter(emitTarget, emitFormat, AudioInput::N_FREQUENCIES),
+                                         DspStageBase::PINNED);
+  DspEdge<SpectrumFrame>* edge = dspGraph->connect(spectrumTap.get(), emitter, "emit", 256,
+                                                   DspEdgeBase::DROP_OLDEST);
+  attachOutputs(audioInput);
+  addPitchTracker(audioInput);
+  addOnsetDetector(audioInput);
+  addToneTracker(audioInput);
+  addBandMeter(audioInput);
+  dspGraph->start();
+  audioInput->addListener(spectrumTap.get());
+
+  signal(SIGINT, requestHeadlessQuit);
+  signal(SIGTERM, requestHeadlessQuit);
+  signal(SIGPIPE, SIG_IGN);
+  if (audioInput->startCapture() != 0) {
+    Log::getInstance()->logger() << "Failed to start capturing audio." << std::endl;
+    return 1;
+  }
+  while (!headlessQuit && !emitter->isClosed()) usleep(100000);
+
+  audioInput->quitNow();
+  audioInput->waitForDsp();
+  dspGraph->stop();
+  Log::getInstance()->logger() << "Emitted " << emitter->getEmitted() << " columns, dropped " << edge->getDropped()
+                               << " for a slow reader." << std::endl;
+  return 0;
+}
+
 int main(int argc, char** argv)
 {
   /* set default values, and change as specified by the user via command line options */
   screenMode = 0;  /* default to windowed unless user specifies full via -f */
   verbosity = 0;  /* default to std::cout */
   scrollFactor = 2;  /* how many vSyncs to wait before scrolling spectrogram */
+  latencySelfTest = false;
+  hopSize = AudioInput::DEFAULT_HOP_SIZE;
+  flightRecorderMinutes = 0;
+  recordPath = nullptr;
+  replayPath = nullptr;
+  replaySpeed = 1.0f;
+  shmName = nullptr;
+  shmPcmSeconds = 0.0f;
+  emitTarget = nullptr;
+  emitFormat = ColumnEmitter::FLOAT_BINS;
+  pitchTracking = false;
+  pitchCsvPath = nullptr;
+  chromaView = false;
+  welchSeconds = 0.0f;
+  zScoreColors = false;
+  autoLevel = false;
+  baselinePath = nullptr;
+  multitaper = false;
+  polyphase = false;
+  multiResolution = false;
+  windowType = WindowLibrary::GAUSSIAN;
+  windowParameter = 0.0f;
+  onsetDetection = false;
+  onsetLogPath = nullptr;
+  toneLogPath = nullptr;
+  maxDelayMs = 0.0f;
+  delayLogPath = nullptr;
+  metricsTarget = nullptr;
+  metricsSeconds = 10.0f;
+  octaveBandsPerOctave = 0;
+  historyDirectory = nullptr;
+  historyPooling = HistoryPyramid::MAX_POOLING;
+  historyMegabytes = (unsigned int) (HistoryPyramid::DEFAULT_MAX_LEVEL_BYTES >> 20);
+  summaryBands = BandSummaryIndex::DEFAULT_BANDS;
+
+  /* create the trace singleton before any audio or render thread can record into it */
+  Trace::getInstance();
 
   /* parse command line options from the user */
   for (int i = 1; i<argc; ++i) {
@@ -59,6 +472,144 @@ int main(int argc, char** argv)
       fprintf(stdout, "Version: %d.%d\n\n", AudioVisualization_VERSION_MAJOR, AudioVisualization_VERSION_MINOR);
       exit(1);
     }
+    else if (!strcmp(argv[i], "-t")) {
+      Trace::getInstance()->enable(argv[++i]);
+      signal(SIGUSR1, Trace::requestFlush);
+    }
+    else if (!strcmp(argv[i], "-L")) {
+      latencySelfTest = true;
+    }
+    else if (!strcmp(argv[i], "-hop")) {
+      char* end;
+      unsigned long hop = strtoul(argv[++i], &end, 10);
+      if (end == argv[i] || *end || strchr(argv[i], '-') || hop < 1 || hop > AudioInput::FFT_LENGTH) {
+        fprintf(stderr, "bad hop size %s, expected 1 to %u samples\n\n", argv[i], AudioInput::FFT_LENGTH);
+        for (int j = 0; helptext[j]; j++) {
+          fprintf(stderr, "%s", helptext[j]);
+        }
+        exit(1);
+      }
+      hopSize = (unsigned int) hop;
+    }
+    else if (!strcmp(argv[i], "-fr")) {
+      sscanf(argv[++i], "%f", &flightRecorderMinutes);
+    }
+    else if (!strcmp(argv[i], "-rec")) {
+      recordPath = argv[++i];
+    }
+    else if (!strcmp(argv[i], "-replay")) {
+      replayPath = argv[++i];
+    }
+    else if (!strcmp(argv[i], "-speed")) {
+      sscanf(argv[++i], "%f", &replaySpeed);
+    }
+    else if (!strcmp(argv[i], "-bands")) {
+      if (!BandSummaryIndex::parseBands(argv[++i], summaryBands)) {
+        fprintf(stderr, "bad band list %s\n", argv[i]);
+        exit(1);
+      }
+    }
+    else if (!strcmp(argv[i], "-hist")) {
+      historyDirectory = argv[++i];
+    }
+    else if (!strcmp(argv[i], "-histmean")) {
+      historyPooling = HistoryPyramid::MEAN_POOLING;
+    }
+    else if (!strcmp(argv[i], "-histmb")) {
+      if (sscanf(argv[++i], "%u", &historyMegabytes) != 1 || historyMegabytes == 0) {
+        fprintf(stderr, "bad history level size %s\n", argv[i]);
+        exit(1);
+      }
+    }
+    else if (!strcmp(argv[i], "-shm")) {
+      shmName = argv[++i];
+    }
+    else if (!strcmp(argv[i], "-shmpcm")) {
+      sscanf(argv[++i], "%f", &shmPcmSeconds);
+    }
+    else if (!strcmp(argv[i], "-emit") || !strcmp(argv[i], "--emit")) {
+      emitTarget = argv[++i];
+    }
+    else if (!strcmp(argv[i], "-emitbytes")) {
+      emitFormat = ColumnEmitter::BYTE_BINS;
+    }
+    else if (!strcmp(argv[i], "-pitch")) {
+      pitchTracking = true;
+    }
+    else if (!strcmp(argv[i], "-pitchcsv")) {
+      pitchCsvPath = argv[++i];
+    }
+    else if (!strcmp(argv[i], "-w")) {
+      unsigned int type = 0;
+      if (sscanf(argv[++i], "%u:%f", &type, &windowParameter) < 1 || !WindowLibrary::isType(type)) {
+        fprintf(stderr, "bad window type %s\n", argv[i]);
+        exit(1);
+      }
+      windowType = (WindowLibrary::Type) type;
+    }
+    else if (!strcmp(argv[i], "-mt")) {
+      multitaper = true;
+    }
+    else if (!strcmp(argv[i], "-pfb")) {
+      polyphase = true;
+    }
+    else if (!strcmp(argv[i], "-mr")) {
+      multiResolution = true;
+    }
+    else if (!strcmp(argv[i], "-chroma")) {
+      chromaView = true;
+    }
+    else if (!strcmp(argv[i], "-welch")) {
+      welchSeconds = (float) atof(argv[++i]);
+    }
+    else if (!strcmp(argv[i], "-autolevel")) {
+      autoLevel = true;
+    }
+    else if (!strcmp(argv[i], "-zscore")) {
+      zScoreColors = true;
+    }
+    else if (!strcmp(argv[i], "-baseline")) {
+      zScoreColors = true;
+      baselinePath = argv[++i];
+    }
+    else if (!strcmp(argv[i], "-onsets")) {
+      onsetDetection = true;
+    }
+    else if (!strcmp(argv[i], "-onsetlog")) {
+      onsetLogPath = argv[++i];
+    }
+    else if (!strcmp(argv[i], "-tones")) {
+      if (!ToneTracker::parseTones(argv[++i], trackedTones)) {
+        fprintf(stderr, "bad tone list %s\n", argv[i]);
+        exit(1);
+      }
+    }
+    else if (!strcmp(argv[i], "-tonelog")) {
+      toneLogPath = argv[++i];
+    }
+    else if (!strcmp(argv[i], "-gcc")) {
+      sscanf(argv[++i], "%f", &maxDelayMs);
+    }
+    else if (!strcmp(argv[i], "-gcclog")) {
+      delayLogPath = argv[++i];
+    }
+    else if (!strcmp(argv[i], "-metrics")) {
+      metricsTarget = argv[++i];
+    }
+    else if (!strcmp(argv[i], "-octave")) {
+      if (sscanf(argv[++i], "%u", &octaveBandsPerOctave) != 1
+          || (octaveBandsPerOctave != 1 && octaveBandsPerOctave != 3)) {
+        fprintf(stderr, "bad bands per octave %s\n", argv[i]);
+        exit(1);
+      }
+    }
+    else if (!strcmp(argv[i], "-metricsint")) {
+      sscanf(argv[++i], "%f", &metricsSeconds);
+      metricsSeconds = std::max(metricsSeconds, 1.0f);
+    }
+    else if (!strcmp(argv[i], "-i")) {
+      inputSpecs.push_back(argv[++i]);
+    }
     else if (!strcmp(argv[i], "-sf")) {
       sscanf(argv[++i], "%d", &scrollFactor);
       scrollFactor = std::min(scrollFactor, 1);  /* ensure value <= 1 */
@@ -74,12 +625,154 @@ int main(int argc, char** argv)
     }
   }
   Log::OUTPUT_DIRECTION = verbosity;
+  if (multitaper && polyphase) {
+    fprintf(stderr, "-mt and -pfb cannot be combined\n");
+    exit(1);
+  }
+  if (multiResolution && (multitaper || polyphase)) {
+    fprintf(stderr, "-mr cannot be combined with -mt or -pfb\n");
+    exit(1);
+  }
+  if (maxDelayMs > 0 && (multitaper || multiResolution)) {
+    /* only spectra of a single FFT are tapped for the correlation */
+    fprintf(stderr, "-gcc cannot be combined with -mt or -mr\n");
+    exit(1);
+  }
+  if (delayLogPath && maxDelayMs <= 0) {
+    fprintf(stderr, "-gcclog needs -gcc\n");
+    exit(1);
+  }
+  if (emitTarget && (maxDelayMs > 0 || octaveBandsPerOctave)) {
+    /* the headless mode runs the first input only, and the octave bands are only shown */
+    fprintf(stderr, "-gcc and -octave cannot be combined with -emit\n");
+    exit(1);
+  }
+  if (emitTarget && !strcmp(emitTarget, "-") && verbosity == 0) {
+    /* keep stdout for the column frames */
+    Log::OUTPUT_DIRECTION = 3;
+  }
+
+  /* start the DSP workers before any audio callback submits to them */
+  DspThreadPool::getInstance();
+
+  /* without -i, show the single source chosen by the older options */
+  if (inputSpecs.empty()) {
+    inputSpecs.push_back(replayPath ? std::string("replay:") + replayPath
+                                    : "dev:" + std::to_string(getInputDeviceId("cfg.yaml")));
+  }
+  if (maxDelayMs > 0 && inputSpecs.size() < 2) {
+    fprintf(stderr, "-gcc needs at least two inputs\n");
+    exit(1);
+  }
+
+  if (emitTarget) {
+    try {
+      return runHeadless();
+    } catch (int e) {
+      fprintf(stderr, "Error starting the column output. Exiting.\n");
+      return 1;
+    }
+  }
   Display display(argc, argv, screenMode);
 
-  /* create GraphicsItem observers and add them to the display's observer list */
+  /* create GraphicsItem observers and add them to the display's observer list, one tile per input */
   try {
-      SpectrogramVisualizer spectrogramVisualizer(scrollFactor, getInputDeviceId("cfg.yaml"));
-      display.addGraphicsItem(&spectrogramVisualizer);
+      std::vector<std::unique_ptr<SpectrogramVisualizer>> visualizers;
+      for (size_t s = 0; s < inputSpecs.size(); ++s) {
+          SpectrogramReplay* replay;
+          AudioInput* audioInput = createAudioInput(inputSpecs[s], replay);
+          if (!audioInput) {
+              fprintf(stderr, "bad input %s\n", inputSpecs[s].c_str());
+              exit(1);
+          }
+          if (replay) {
+              replay->setSpeed(replaySpeed);
+          } else {
+              audioInput->setHopSize(hopSize);
+              audioInput->setWindow(windowType, windowParameter);
+              audioInput->setMultitaper(multitaper);
+              if (!audioInput->setPolyphase(polyphase)) throw 99;
+              if (!audioInput->setMultiResolution(multiResolution)) throw 99;
+          }
+          audioInput->setLatencySelfTest(latencySelfTest && !replay);
+          visualizers.emplace_back(new SpectrogramVisualizer(scrollFactor, audioInput));
+          SpectrogramVisualizer& spectrogramVisualizer = *visualizers.back();
+          spectrogramVisualizer.setReplay(replay);
+          if (inputSpecs.size() > 1) spectrogramVisualizer.setLabel(inputSpecs[s]);
+          if (autoLevel) spectrogramVisualizer.setAutoLevel(true);
+          display.addGraphicsItem(&spectrogramVisualizer);
+          if (s > 0) {
+              attachChannelTap(s, audioInput);
+              continue;
+          }
+
+          dspGraph.reset(new DspGraph());
+          spectrumTap.reset(new SpectrumTap());
+          spectrogramVisualizer.setDspGraph(dspGraph.get());
+          if (historyDirectory) {
+              historyPyramid.reset(new HistoryPyramid(historyDirectory, historyPooling,
+                                                        (uint64_t) historyMegabytes << 20));
+              spectrogramVisualizer.setHistory(historyPyramid.get());
+
+              /* merge columns rather than lose them if the disk stalls */
+              HistorySink* historySink = dspGraph->add(new HistorySink(historyPyramid.get()), DspStageBase::POOLED);
+              dspGraph->connect(spectrumTap.get(), historySink, "history", 64, DspEdgeBase::COALESCE,
+                                SpectrumFrame::maxCoalesce);
+          }
+          attachOutputs(audioInput);
+          if (flightRecorderMinutes > 0) {
+              /* sized for the nominal hop; degraded levels produce fewer columns, which then cover a longer span */
+              flightRecorder.reset(new FlightRecorder(flightRecorderMinutes, audioInput->getSamplingRate(),
+                                                      AudioInput::N_FREQUENCIES,
+                                                      (float) audioInput->getSamplingRate() / hopSize, "."));
+              audioInput->addListener(flightRecorder.get());
+              spectrogramVisualizer.setFlightRecorder(flightRecorder.get());
+              signal(SIGUSR2, FlightRecorder::requestTrigger);
+          }
+          spectrogramVisualizer.setPitchTracker(addPitchTracker(audioInput));
+          spectrogramVisualizer.setOnsetDetector(addOnsetDetector(audioInput));
+          spectrogramVisualizer.setToneTracker(addToneTracker(audioInput));
+          addBandMeter(audioInput);
+          if (octaveBandsPerOctave) {
+              octaveFilterBank.reset(new OctaveFilterBank(audioInput->getSamplingRate(), octaveBandsPerOctave));
+              audioInput->addListener(octaveFilterBank.get());
+              spectrogramVisualizer.setOctaveFilterBank(octaveFilterBank.get());
+          }
+          if (chromaView) {
+              /* only the latest column is shown, so older ones may go */
+              ChromaMapper* chromaMapper = dspGraph->add(new ChromaMapper(audioInput->getSamplingRate(),
+                                                                          AudioInput::N_FREQUENCIES,
+                                                                          SpectrogramVisualizer::MIDDLE_C_FREQUENCY),
+                                                         DspStageBase::POOLED);
+              dspGraph->connect(spectrumTap.get(), chromaMapper, "chroma", 4, DspEdgeBase::DROP_OLDEST);
+              spectrogramVisualizer.setChromaMapper(chromaMapper);
+          }
+          if (welchSeconds > 0) {
+              /* dropping a column shortens the span, merging columns by their peak would bias the mean; the span is
+               * counted in columns of the nominal hop, so it stretches by the hop multiplier while degraded */
+              unsigned int spanColumns = (unsigned int) (welchSeconds * audioInput->getSamplingRate() / hopSize);
+              WelchAverager* welchAverager = dspGraph->add(new WelchAverager(AudioInput::N_FREQUENCIES, spanColumns),
+                                                           DspStageBase::POOLED);
+              dspGraph->connect(spectrumTap.get(), welchAverager, "welch", 256, DspEdgeBase::DROP_OLDEST);
+              spectrogramVisualizer.setWelchAverager(welchAverager);
+          }
+          if (zScoreColors) {
+              BinStatistics* binStatistics = dspGraph->add(new BinStatistics(AudioInput::N_FREQUENCIES,
+                                                                             audioInput->getSamplingRate(),
+                                                                             audioInput->getFftLength()),
+                                                           DspStageBase::POOLED);
+              if (baselinePath) {
+                  if (!binStatistics->load(baselinePath)) throw 99;
+                  binStatistics->setLearning(false);
+              }
+              dspGraph->connect(spectrumTap.get(), binStatistics, "bin statistics", 64, DspEdgeBase::DROP_OLDEST);
+              spectrogramVisualizer.setBinStatistics(binStatistics);
+          }
+          spectrogramVisualizer.setDelayEstimators(addDelayEstimators(audioInput));
+          dspGraph->start();
+          audioInput->addListener(spectrumTap.get());
+          attachChannelTap(s, audioInput);
+      }
 
       display.loop();  /* main loop */
   } catch (int e) {
@@ -0,0 +1,89 @@
+/**
+ * Answers band energy queries against a band summary index written next to a spectrogram recording (-rec), e.g.
+ *    band_query night.spec.bands 2000 4000 03:00 04:00
+ * Times are Unix seconds, "YYYY-mm-dd HH:MM[:SS]", or "HH:MM[:SS]" on the first day of the index (local time).
+ */
+
+#include <iostream>
+#include <cstring>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../BandSummaryIndex.hpp"
+
+/**
+ * Parses a time argument.
+ * @param text time to parse.
+ * @param day any Unix time on the day that times of day refer to.
+ * @param unixTime receives the parsed time.
+ * @return false on a syntax error.
+ */
+bool parseTime(const char* text, time_t day, double& unixTime)
+{
+    char* end;
+    double seconds = strtod(text, &end);
+    if (*end == '\0') {
+        unixTime = seconds;
+        return true;
+    }
+
+    struct tm parsed;
+    localtime_r(&day, &parsed);
+    parsed.tm_sec = 0;
+    const char* rest = strptime(text, "%Y-%m-%d %H:%M", &parsed);
+    if (!rest) {
+        localtime_r(&day, &parsed);
+        parsed.tm_sec = 0;
+        rest = strptime(text, "%H:%M", &parsed);
+    }
+    if (!rest) return false;
+    if (*rest == ':' && !(rest = strptime(rest + 1, "%S", &parsed))) return false;
+    if (*rest != '\0') return false;
+    parsed.tm_isdst = -1;
+    unixTime = (double) mktime(&parsed);
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 6) {
+        std::cerr << "Usage: band_query <index.bands> <low Hz> <high Hz> <from> <to>" << std::endl;
+        return 1;
+    }
+
+    try {
+        BandSummaryIndex index(argv[1]);
+        int band = index.findBand((float) atof(argv[2]), (float) atof(argv[3]));
+        if (band < 0) {
+            std::cerr << "No band " << argv[2] << "-" << argv[3] << " Hz in the index. Available bands:";
+            for (const BandSummaryIndex::Band& b : index.getBands()) std::cerr << " " << b.lowHz << "-" << b.highHz;
+            std::cerr << std::endl;
+            return 1;
+        }
+
+        double from, to;
+        if (!parseTime(argv[4], (time_t) index.getFirstSecond(), from) ||
+            !parseTime(argv[5], (time_t) index.getFirstSecond(), to)) {
+            std::cerr << "Bad time, expected Unix seconds, YYYY-mm-dd HH:MM[:SS] or HH:MM[:SS]." << std::endl;
+            return 1;
+        }
+        /* a range of times of day may cross midnight */
+        if (to <= from) to += 24 * 3600;
+
+        BandSummaryIndex::Summary summary;
+        if (!index.query((unsigned int) band, from, to, summary)) {
+            std::cout << "No data in the range." << std::endl;
+            return 0;
+        }
+        printf("band %g-%g Hz, %lu s with data (%lu columns)\n", index.getBands()[band].lowHz,
+               index.getBands()[band].highHz, summary.seconds, summary.columns);
+        printf("energy min %g (%.1f dB), mean %g (%.1f dB), max %g (%.1f dB)\n",
+               summary.energy.min, 10 * log10(summary.energy.min + 1e-30),
+               summary.energy.mean, 10 * log10(summary.energy.mean + 1e-30),
+               summary.energy.max, 10 * log10(summary.energy.max + 1e-30));
+    } catch (int e) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,86 @@
+/**
+ * Follows the spectrogram columns that a running opengl_spectrogram publishes in shared memory (-shm), e.g.
+ *    shm_columns /spectrogram
+ * and prints the loudest frequency of every column, plus the RMS of the latest PCM if it is published as well. Shows
+ * how a local detector or logger attaches without capturing audio or computing FFTs itself.
+ */
+
+#include <iostream>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "../SharedColumnRing.hpp"
+
+int main(int argc, char** argv)
+{
+    if (argc < 2 || argc > 3) {
+        std::cerr << "Usage: shm_columns <name> [<seconds>]" << std::endl;
+        return 1;
+    }
+    double seconds = argc == 3 ? atof(argv[2]) : 0.0;
+
+    try {
+        SharedColumnReader reader(argv[1]);
+        const SharedColumnRing::Header& header = reader.getHeader();
+        float hzPerBin = header.samplingRate / 2.0f / header.nFrequencies;
+        std::cout << "Attached to " << argv[1] << " of process " << header.publisherPid << ": "
+                  << header.nFrequencies << " frequencies, " << header.columnSlots << " column slots, "
+                  << header.pcmSamples << " PCM samples" << std::endl;
+
+        /* start with the newest column */
+        uint32_t sequence = 0;
+        uint64_t next = reader.getColumnsWritten();
+        next = next ? next - 1 : 0;
+        uint64_t skipped = 0;
+        double firstTime = -1.0;
+        std::vector<float> pcm(1024);
+        while (true) {
+            if (next >= reader.getColumnsWritten()) {
+                if (!reader.wait(sequence, 1000)) continue;
+            }
+
+            /* columns overwritten before we got to them are skipped */
+            uint64_t token;
+            const SharedColumnRing::Slot* slot = reader.peek(next, token);
+            uint64_t written = reader.getColumnsWritten();
+            if (!slot) {
+                if (next + header.columnSlots <= written) {
+                    skipped += written - header.columnSlots / 2 - next;
+                    next = written - header.columnSlots / 2;
+                }
+                continue;
+            }
+
+            /* zero copy: scan the column in place, then check that it was not overwritten meanwhile */
+            const float* power = reader.power(slot);
+            unsigned int loudest = 0;
+            for (unsigned int j = 1; j < header.nFrequencies; ++j) {
+                if (power[j] > power[loudest]) loudest = j;
+            }
+            float loudestPower = power[loudest];
+            double adcTime = slot->adcTime;
+            uint64_t endSampleIndex = slot->endSampleIndex;
+            if (!reader.validate(slot, token)) continue;
+
+            printf("column %8llu  t %10.3f  loudest %7.1f Hz %6.1f dB", (unsigned long long) next, adcTime,
+                   loudest * hzPerBin, 10.0f * log10f(loudestPower + 1e-20f));
+            if (header.pcmSamples && endSampleIndex >= pcm.size()
+                && reader.readSamples(endSampleIndex - pcm.size(), pcm.size(), pcm.data())) {
+                double sum = 0.0;
+                for (float sample : pcm) sum += sample * sample;
+                printf("  rms %6.1f dB", 10.0 * log10(sum / pcm.size() + 1e-20));
+            }
+            if (skipped) printf("  (skipped %llu)", (unsigned long long) skipped);
+            printf("\n");
+            skipped = 0;
+            ++next;
+
+            if (firstTime < 0.0) firstTime = adcTime;
+            if (seconds > 0.0 && adcTime - firstTime >= seconds) break;
+        }
+    } catch (int e) {
+        return 1;
+    }
+    return 0;
+}
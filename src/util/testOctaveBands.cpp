@@ -0,0 +1,101 @@
+/**
+ * Checks the octave and one-third octave band filters at 44.1 kHz against IEC 61260-1: every band is driven with a
+ * full scale sine at its exact midband frequency and at both exact band edges, and its level is compared with 0 dB
+ * and -3 dB. The lowest bands run below many decimation stages, so a decimation lowpass without unit gain at DC
+ * shows up as a midband error there. Also checks the nominal midband frequencies the bars are labelled with.
+ * Exits with 1 if any check fails.
+ */
+
+#include <iostream>
+#include <cstring>
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+#include "../OctaveFilterBank.hpp"
+
+static const unsigned int SAMPLING_RATE = 44100;
+static const unsigned long BLOCK_SAMPLES = 512;
+
+/* the filters and the Fast mean square settle before this, and the levels are averaged over the next second, in
+ * power, which cancels the ripple of the mean square at twice the frequency of the sine */
+static const double SETTLE_SECONDS = 2.0;
+static const double MEASURE_SECONDS = 1.0;
+
+/* class 1 limits of the relative attenuation at the midband frequency; the edges are held to the -3 dB of the
+ * Butterworth design, tighter than the class 1 limits there */
+static const double MIDBAND_TOLERANCE_DB = 0.4;
+static const double EDGE_TOLERANCE_DB = 0.3;
+
+/* nominal midband frequencies of the bands that fit below 0.9 times the Nyquist frequency at 44.1 kHz */
+static const char* THIRD_OCTAVE_LABELS[] = {
+    "20", "25", "31.5", "40", "50", "63", "80", "100", "125", "160", "200", "250", "315", "400", "500", "630", "800",
+    "1k", "1.25k", "1.6k", "2k", "2.5k", "3.15k", "4k", "5k", "6.3k", "8k", "10k", "12.5k", "16k"
+};
+static const char* OCTAVE_LABELS[] = {"31.5", "63", "125", "250", "500", "1k", "2k", "4k", "8k"};
+
+/**
+ * Drives a fresh filter bank with a full scale sine.
+ * @return level of a band in dB, averaged in power over MEASURE_SECONDS after SETTLE_SECONDS.
+ */
+double measure(unsigned int bandsPerOctave, unsigned int band, double frequency)
+{
+    OctaveFilterBank bank(SAMPLING_RATE, bandsPerOctave);
+    std::vector<float> block(BLOCK_SAMPLES);
+    unsigned long settle = (unsigned long) (SETTLE_SECONDS * SAMPLING_RATE);
+    unsigned long end = settle + (unsigned long) (MEASURE_SECONDS * SAMPLING_RATE);
+    double phaseStep = 2.0 * M_PI * frequency / SAMPLING_RATE;
+    double power = 0.0;
+    unsigned int nReadings = 0;
+    for (unsigned long start = 0; start < end; start += BLOCK_SAMPLES) {
+        for (unsigned long i = 0; i < BLOCK_SAMPLES; ++i) block[i] = (float) sin(phaseStep * (start + i));
+        bank.samplesProcessed(block.data(), BLOCK_SAMPLES, start, 0.0);
+        if (start < settle) continue;
+        power += pow(10.0, bank.getLevel(band) / 10.0);
+        ++nReadings;
+    }
+    return 10.0 * log10(power / nReadings);
+}
+
+/**
+ * Checks every band of one bank.
+ * @return number of failed checks.
+ */
+unsigned int checkBank(unsigned int bandsPerOctave, const char** labels, unsigned int nLabels)
+{
+    unsigned int failures = 0;
+    OctaveFilterBank bank(SAMPLING_RATE, bandsPerOctave);
+    if (bank.getNBands() != nLabels) {
+        printf("%u bands per octave: %u bands, expected %u\n", bandsPerOctave, bank.getNBands(), nLabels);
+        return 1;
+    }
+
+    /* exact band edges are G^(1 / 2b) either side of the exact midband frequency, G = 10^(3 / 10) */
+    double halfBand = pow(10.0, 0.3 * 0.5 / bandsPerOctave);
+    for (unsigned int band = 0; band < bank.getNBands(); ++band) {
+        char label[8];
+        bank.nominalLabel(band, label);
+        double frequency = bank.getFrequency(band);
+        double midband = measure(bandsPerOctave, band, frequency);
+        double lower = measure(bandsPerOctave, band, frequency / halfBand);
+        double upper = measure(bandsPerOctave, band, frequency * halfBand);
+        bool pass = !strcmp(label, labels[band]) && fabs(midband) <= MIDBAND_TOLERANCE_DB
+                    && fabs(lower + 3.0) <= EDGE_TOLERANCE_DB && fabs(upper + 3.0) <= EDGE_TOLERANCE_DB;
+        printf("%s %6s (%9.3f Hz): lower edge %+6.2f dB, midband %+6.2f dB, upper edge %+6.2f dB\n",
+               pass ? "ok  " : "FAIL", label, frequency, lower, midband, upper);
+        if (!pass) ++failures;
+    }
+    return failures;
+}
+
+int main()
+{
+    unsigned int failures = 0;
+    failures += checkBank(3, THIRD_OCTAVE_LABELS, sizeof(THIRD_OCTAVE_LABELS) / sizeof(THIRD_OCTAVE_LABELS[0]));
+    failures += checkBank(1, OCTAVE_LABELS, sizeof(OCTAVE_LABELS) / sizeof(OCTAVE_LABELS[0]));
+    if (failures) {
+        std::cout << failures << " band checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All band checks passed" << std::endl;
+    return 0;
+}